@@ -9,6 +9,24 @@
  */
 class ArrayUtils {
 public:
+  /**
+   * Instruction set used by the dispatching routines below (`and_values`, `exclude_values`, `and_many`).
+   * Picked at startup from the CPU's capabilities.
+   */
+  enum simd_level_t {
+    SCALAR,
+    SSE41,
+    AVX2
+  };
+
+  // lists that are at least this many times larger than the other list are galloped through
+  static constexpr size_t GALLOP_RATIO = 32;
+
+  static simd_level_t get_simd_level();
+
+  // Overrides the kernels, e.g. for benchmarking: a level that the CPU does not support falls back to the best one.
+  static void set_simd_level(simd_level_t level);
+
   // Fast scalar scheme designed by N. Kurz. Returns the size of out (intersected set)
   static size_t and_scalar(const uint32_t *A, const size_t lenA, const uint32_t *B, const size_t lenB, uint32_t **out);
 
@@ -16,4 +34,23 @@ public:
 
   static size_t exclude_scalar(const uint32_t *src, const size_t lenSrc, const uint32_t *filter, const size_t lenFilter,
                               uint32_t **out);
-};
\ No newline at end of file
+
+  // Same contract as `and_scalar`: uses SIMD block comparisons, or gallops when the sizes are very skewed.
+  static size_t and_values(const uint32_t *A, const size_t lenA, const uint32_t *B, const size_t lenB, uint32_t **out);
+
+  // Same contract as `exclude_scalar`: uses SIMD block comparisons, or gallops when the sizes are very skewed.
+  static size_t exclude_values(const uint32_t *src, const size_t lenSrc, const uint32_t *filter,
+                               const size_t lenFilter, uint32_t **out);
+
+  // Intersects `num_lists` sorted lists in one pass, without materializing intermediate results:
+  // the smallest list drives the search and the others are galloped through.
+  static size_t and_many(const uint32_t *const *lists, const size_t *lens, const size_t num_lists, uint32_t **out);
+
+  // Minimum, maximum and sum of `len` (> 0) values, with the kernels of the current SIMD level. Sums of 32-bit
+  // integers are exact, while those of 64-bit integers and of floats are accumulated as doubles.
+  static void stats_int32(const int32_t *values, const size_t len, int32_t &min, int32_t &max, int64_t &sum);
+
+  static void stats_int64(const int64_t *values, const size_t len, int64_t &min, int64_t &max, double &sum);
+
+  static void stats_float(const float *values, const size_t len, float &min, float &max, double &sum);
+};
@@ -4,8 +4,11 @@
 #include <stdint.h>
 #include <stdbool.h>
 #include <vector>
+#include <memory>
 #include "array.h"
 #include "sorted_array.h"
+#include "block_sorted_array.h"
+#include "impact_ids.h"
 
 #define IGNORE_PRINTF 1
 
@@ -83,13 +86,34 @@ typedef struct {
     art_node *children[256];
 } art_node256;
 
+#define ART_ARENA_SLAB_SIZE (64 * 1024)
+#define ART_ARENA_ALIGN 16
+
+// large enough to hold an art_node256: blocks bigger than this (leaves with very long keys) bypass the slabs
+#define ART_ARENA_MAX_BLOCK_SIZE 2080
+#define ART_ARENA_NUM_CLASSES (ART_ARENA_MAX_BLOCK_SIZE / ART_ARENA_ALIGN + 1)
+
+/**
+ * Per-tree slab allocator for nodes and leaves. Blocks are carved out of large slabs
+ * and recycled through free lists bucketed by size class, so that the nodes of a tree
+ * stay close together and the whole tree can be released in bulk.
+ */
+typedef struct {
+    void* free_lists[ART_ARENA_NUM_CLASSES];
+    void* slabs;                // singly linked list of slabs, most recent first
+    uint8_t* slab_pos;          // next unused byte of the current slab
+    uint8_t* slab_end;
+    uint64_t reserved_bytes;    // bytes held by slabs and by oversized blocks
+} art_arena;
+
 /**
  * Container for holding the documents that belong to a leaf.
  */
 typedef struct {
-    sorted_array ids;
+    block_sorted_array ids;
     sorted_array offset_index;
     array offsets;
+    std::unique_ptr<impact_ids_t> impact_ids;   // only held by the fields of impact ordered collections
 } art_values;
 
 /**
@@ -109,6 +133,7 @@ typedef struct {
 typedef struct {
     art_node *root;
     uint64_t size;
+    art_arena arena;
 } art_tree;
 
 /*
@@ -139,6 +164,28 @@ enum NUM_COMPARATOR {
     RANGE_INCLUSIVE
 };
 
+enum fuzzy_search_engine {
+    LEVENSHTEIN_ROWS,
+    LEVENSHTEIN_AUTOMATON
+};
+
+/**
+ * Instruction set used for matching node keys and partial prefixes during lookups.
+ * Picked at startup from the CPU's capabilities.
+ */
+enum art_simd_level {
+    ART_SIMD_SCALAR,
+    ART_SIMD_SSE2
+};
+
+art_simd_level art_get_simd_level();
+
+/**
+ * Overrides the lookup kernels, e.g. for benchmarking: a level that the CPU
+ * does not support falls back to the best supported one.
+ */
+void art_set_simd_level(art_simd_level level);
+
 /**
  * Initializes an ART tree
  * @return 0 on success.
@@ -176,6 +223,11 @@ inline uint64_t art_size(art_tree *t) {
 }
 #endif
 
+/**
+ * Returns the number of bytes reserved by the tree's node and leaf arena.
+ */
+uint64_t art_arena_bytes(const art_tree *t);
+
 /**
  * Inserts a new value into the ART tree
  * @arg t The tree
@@ -197,6 +249,25 @@ void* art_insert(art_tree *t, const unsigned char *key, int key_len, art_documen
  */
 void* art_delete(art_tree *t, const unsigned char *key, int key_len);
 
+/**
+ * Removes a leaf from the ART tree without freeing it, for readers
+ * that found it earlier to keep using it. It is freed later on with
+ * art_free_leaf(), along with its values.
+ * @arg t The tree
+ * @arg key The key
+ * @arg key_len The length of the key
+ * @return NULL if the item was not found, otherwise
+ * the removed leaf is returned.
+ */
+art_leaf* art_detach(art_tree *t, const unsigned char *key, int key_len);
+
+/**
+ * Frees a leaf that was removed with art_detach(), along with its values
+ * @arg t The tree that the leaf was removed from
+ * @arg l The leaf
+ */
+void art_free_leaf(art_tree *t, art_leaf *l);
+
 /**
  * Searches for a value in the ART tree
  * @arg t The tree
@@ -247,15 +318,27 @@ int art_iter_prefix(art_tree *t, const unsigned char *prefix, int prefix_len, ar
 
 /**
  * Returns leaves that match a given string within a fuzzy distance of max_cost.
+ * Both engines return identical results: LEVENSHTEIN_AUTOMATON replaces the per-edge matrix row computation with
+ * transitions of an automaton that is compiled lazily for the term, which pays off for typo (max_cost > 0) lookups.
  */
 int art_fuzzy_search(art_tree *t, const unsigned char *term, const int term_len, const int min_cost, const int max_cost,
                      const int max_words, const token_ordering token_order, const bool prefix,
                      const uint32_t *filter_ids, size_t filter_ids_length,
-                     std::vector<art_leaf *> &results);
+                     std::vector<art_leaf *> &results, const fuzzy_search_engine engine = LEVENSHTEIN_ROWS);
 
 int art_topk_iter(const art_node *root, token_ordering token_order, size_t max_results,
                          std::vector<art_leaf *> &results);
 
+/**
+ * Orders leaves by their number of documents (or their max score) and then by key, so that ties come out in the
+ * same order whichever lookup found the leaves.
+ */
+bool compare_art_leaf_frequency(const art_leaf *a, const art_leaf *b);
+
+bool compare_art_leaf_key(const art_leaf *a, const art_leaf *b);
+
+bool compare_art_leaf_score(const art_leaf *a, const art_leaf *b);
+
 void encode_int32(int32_t n, unsigned char *chars);
 
 void encode_int64(int64_t n, unsigned char *chars);
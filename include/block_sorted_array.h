@@ -0,0 +1,88 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "sorted_array.h"
+
+/**
+ * Sorted array of ids that is stored as a sequence of independently compressed blocks of at most
+ * BLOCK_SIZE ids each, with a skip index holding the largest id and the starting position of every block.
+ *
+ * Lookups use the skip index to pick a single block, and updates only re-encode the block that they touch,
+ * so large posting lists do not have to be rewritten in whole on every insertion or deletion.
+ *
+ * Exposes the same interface as `sorted_array`: indices are positions within the whole array and a missing
+ * value is reported with an index of `getLength()`.
+ */
+class block_sorted_array {
+private:
+    struct block_t {
+        uint32_t max_id;        // largest id in the block
+        uint32_t offset;        // position of the block's first id within the whole array
+        sorted_array* ids;
+    };
+
+    std::vector<block_t> blocks;
+    uint32_t length = 0;
+
+    // first block whose `max_id` is >= `value`, or `blocks.size()` when `value` is larger than every id
+    size_t block_of_value(uint32_t value) const;
+
+    // block holding the id at position `index`
+    size_t block_of_index(uint32_t index) const;
+
+    void shift_offsets(size_t from_block, int64_t delta);
+
+    // splits an overflowing block into two halves
+    void split_block(size_t block_index);
+
+    // drops an emptied block, or merges it into the next one when both have become sparse
+    void compact_block(size_t block_index);
+
+    void clear();
+
+public:
+    static constexpr uint32_t BLOCK_SIZE = 256;
+
+    block_sorted_array() = default;
+
+    block_sorted_array(const block_sorted_array&) = delete;
+
+    block_sorted_array& operator=(const block_sorted_array&) = delete;
+
+    ~block_sorted_array() {
+        clear();
+    }
+
+    void load(const uint32_t *sorted_ids, const uint32_t array_length);
+
+    uint32_t at(uint32_t index);
+
+    bool contains(uint32_t value);
+
+    uint32_t indexOf(uint32_t value);
+
+    void indexOf(const uint32_t *values, size_t values_len, uint32_t* indices);
+
+    size_t numFoundOf(const uint32_t *values, const size_t values_len);
+
+    size_t append(uint32_t value);
+
+    bool insert(size_t index, uint32_t value);
+
+    void remove_value(uint32_t value);
+
+    void remove_values(uint32_t *sorted_values, uint32_t sorted_values_length);
+
+    // len determines length of output buffer (default: length of input)
+    uint32_t* uncompress(uint32_t len=0) const;
+
+    // writes all ids to `out`, which must have room for `getLength()` ids
+    void uncompress(uint32_t* out) const;
+
+    uint32_t getSizeInBytes();
+
+    uint32_t getLength() const;
+
+    size_t num_blocks() const;
+};
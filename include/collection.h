@@ -18,6 +18,7 @@
 #include <field.h>
 #include <option.h>
 #include "tokenizer.h"
+#include "threadpool.h"
 
 
 struct override_t {
@@ -297,6 +298,14 @@ private:
 
     std::atomic<size_t> num_documents;
 
+    // changes whenever the documents, overrides or synonyms of the collection change: the values are drawn from a
+    // clock shared by all collections, so that a recreated collection never reuses the generation of an earlier one
+    std::atomic<uint64_t> write_generation;
+
+    static inline std::atomic<uint64_t> write_clock{0};
+
+    void bump_write_generation();
+
     // Auto incrementing record ID used internally for indexing - not exposed to the client
     std::atomic<uint32_t> next_seq_id;
 
@@ -323,6 +332,9 @@ private:
 
     const std::string fallback_field_type;
 
+    // whether the ids of string field tokens are also kept ordered on the default sorting field
+    const bool impact_ordered_ids;
+
     std::vector<field> dynamic_fields;
 
     const std::vector<Index*> indices;
@@ -370,8 +382,6 @@ private:
         return std::tie(a_count, a_value_size) > std::tie(b_count, b_value_size);
     }
 
-    void free_leaf_indices(std::vector<uint32_t*>& leaf_to_indices) const;
-
     Option<bool> parse_filter_query(const std::string& simple_filter_query, std::vector<filter>& filters) const;
 
     static Option<bool> parse_geopoint_filter_value(std::string& raw_value,
@@ -413,6 +423,7 @@ public:
     static constexpr const char* COLLECTION_CREATED = "created_at";
     static constexpr const char* COLLECTION_NUM_MEMORY_SHARDS = "num_memory_shards";
     static constexpr const char* COLLECTION_FALLBACK_FIELD_TYPE = "fallback_field_type";
+    static constexpr const char* COLLECTION_IMPACT_ORDERED_IDS = "impact_ordered_ids";
 
     // DON'T CHANGE THESE VALUES!
     // this key is used as namespace key to store metadata about the document
@@ -426,7 +437,8 @@ public:
     Collection(const std::string& name, const uint32_t collection_id, const uint64_t created_at,
                const uint32_t next_seq_id, Store *store, const std::vector<field>& fields,
                const std::string& default_sorting_field, const size_t num_memory_shards,
-               const float max_memory_ratio, const std::string& fallback_field_type);
+               const float max_memory_ratio, const std::string& fallback_field_type,
+               const bool impact_ordered_ids = false);
 
     ~Collection();
 
@@ -446,6 +458,8 @@ public:
 
     uint32_t get_collection_id() const;
 
+    uint64_t get_write_generation() const;
+
     uint32_t get_next_seq_id();
 
     Option<uint32_t> doc_id_to_seq_id(const std::string & doc_id) const;
@@ -484,6 +498,16 @@ public:
 
     static void aggregate_topster(size_t query_index, Topster &topster, Topster *index_topster);
 
+    // shifts the query indices of the kvs, whose searched queries are appended after those of other indices
+    static void offset_query_index(Topster* topster, size_t query_index);
+
+    // accumulates the counts of the facet of every index into `acc_facet`, moving the entries that it lacks
+    static void merge_facet(facet& acc_facet, size_t facet_index, const std::vector<search_args*>& search_args_vec);
+
+    // merges the topsters of every index into those of the first index, pairwise and in parallel, in
+    // ceil(log2(indices)) rounds
+    static void reduce_topsters(const std::vector<search_args*>& search_args_vec, ThreadPool* thread_pool);
+
     static void populate_result_kvs(Topster *topster, std::vector<std::vector<KV *>> &result_kvs);
 
     void batch_index(std::vector<std::vector<index_record>> &index_batches, std::vector<std::string>& json_out,
@@ -499,6 +523,8 @@ public:
 
     nlohmann::json get_summary_json() const;
 
+    nlohmann::json get_memory_stats_json() const;
+
     size_t par_index_in_memory(std::vector<std::vector<index_record>> & iter_batch, std::vector<size_t>& indexed_counts);
 
     Option<nlohmann::json> add(const std::string & json_str,
@@ -530,7 +556,10 @@ public:
                                   const std::string& highlight_start_tag="<mark>",
                                   const std::string& highlight_end_tag="</mark>",
                                   std::vector<size_t> query_by_weights={},
-                                  size_t limit_hits=UINT32_MAX) const;
+                                  size_t limit_hits=UINT32_MAX,
+                                  bool explain_filters=false,
+                                  size_t facet_sample_percent=100,
+                                  size_t facet_sample_threshold=0) const;
 
     Option<bool> get_filter_ids(const std::string & simple_filter_query,
                                 std::vector<std::pair<size_t, uint32_t*>>& index_ids);
@@ -8,6 +8,7 @@
 #include "collection.h"
 #include "auth_manager.h"
 #include "threadpool.h"
+#include "search_cache.h"
 
 template<typename ResourceType>
 struct locked_resource_view_t {
@@ -71,6 +72,11 @@ private:
 
     std::atomic<float> max_memory_ratio;
 
+    SearchCache search_cache;
+
+    // memory that the filter cache of each collection can take up, split between its memory shards
+    std::atomic<size_t> filter_cache_max_bytes;
+
     CollectionManager();
 
     ~CollectionManager() = default;
@@ -134,7 +140,8 @@ public:
                                           const std::vector<field> & fields,
                                           const std::string & default_sorting_field="",
                                           const uint64_t created_at = static_cast<uint64_t>(std::time(nullptr)),
-                                          const std::string& fallback_field_type = "");
+                                          const std::string& fallback_field_type = "",
+                                          const bool impact_ordered_ids = false);
 
     locked_resource_view_t<Collection> get_collection(const std::string & collection_name) const;
 
@@ -154,6 +161,13 @@ public:
 
     AuthManager& getAuthManager();
 
+    SearchCache& get_search_cache();
+
+    // only applies to the collections that are created or loaded after it is set
+    void set_filter_cache_max_bytes(size_t max_bytes);
+
+    size_t get_filter_cache_max_bytes() const;
+
     static Option<bool> do_search(std::map<std::string, std::string>& req_params, std::string& results_json_str);
 
     static bool parse_sort_by_str(std::string sort_by_str, std::vector<sort_by>& sort_fields);
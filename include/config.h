@@ -46,6 +46,20 @@ private:
 
     uint32_t thread_pool_size;
 
+    // admission control of requests, per scheduling class
+    uint32_t interactive_concurrency;
+    uint32_t interactive_queue_depth;
+    uint32_t bulk_write_concurrency;
+    uint32_t bulk_write_queue_depth;
+    uint32_t background_concurrency;
+    uint32_t background_queue_depth;
+
+    // search result cache
+    uint32_t cache_size_mb;
+    uint32_t cache_ttl_seconds;
+
+    uint32_t filter_cache_size_mb;
+
 protected:
 
     Config() {
@@ -61,6 +75,15 @@ protected:
         this->num_collections_parallel_load = 0;  // will be set dynamically if not overridden
         this->num_documents_parallel_load = 1000;
         this->thread_pool_size = 0; // will be set dynamically if not overridden
+        this->interactive_concurrency = 0;  // will be set dynamically if not overridden
+        this->interactive_queue_depth = 1000;
+        this->bulk_write_concurrency = 0;  // will be set dynamically if not overridden
+        this->bulk_write_queue_depth = 1000;
+        this->background_concurrency = 0;  // will be set dynamically if not overridden
+        this->background_queue_depth = 100;
+        this->cache_size_mb = 0;  // disabled
+        this->cache_ttl_seconds = 60;
+        this->filter_cache_size_mb = 16;
         this->ssl_refresh_interval_seconds = 8 * 60 * 60;
     }
 
@@ -215,6 +238,42 @@ public:
         return this->thread_pool_size;
     }
 
+    size_t get_interactive_concurrency() const {
+        return this->interactive_concurrency;
+    }
+
+    size_t get_interactive_queue_depth() const {
+        return this->interactive_queue_depth;
+    }
+
+    size_t get_bulk_write_concurrency() const {
+        return this->bulk_write_concurrency;
+    }
+
+    size_t get_bulk_write_queue_depth() const {
+        return this->bulk_write_queue_depth;
+    }
+
+    size_t get_background_concurrency() const {
+        return this->background_concurrency;
+    }
+
+    size_t get_background_queue_depth() const {
+        return this->background_queue_depth;
+    }
+
+    size_t get_cache_size_mb() const {
+        return this->cache_size_mb;
+    }
+
+    size_t get_cache_ttl_seconds() const {
+        return this->cache_ttl_seconds;
+    }
+
+    size_t get_filter_cache_size_mb() const {
+        return this->filter_cache_size_mb;
+    }
+
     size_t get_ssl_refresh_interval_seconds() const {
         return this->ssl_refresh_interval_seconds;
     }
@@ -303,6 +362,42 @@ public:
             this->thread_pool_size = std::stoi(get_env("TYPESENSE_THREAD_POOL_SIZE"));
         }
 
+        if(!get_env("TYPESENSE_INTERACTIVE_CONCURRENCY").empty()) {
+            this->interactive_concurrency = std::stoi(get_env("TYPESENSE_INTERACTIVE_CONCURRENCY"));
+        }
+
+        if(!get_env("TYPESENSE_INTERACTIVE_QUEUE_DEPTH").empty()) {
+            this->interactive_queue_depth = std::stoi(get_env("TYPESENSE_INTERACTIVE_QUEUE_DEPTH"));
+        }
+
+        if(!get_env("TYPESENSE_BULK_WRITE_CONCURRENCY").empty()) {
+            this->bulk_write_concurrency = std::stoi(get_env("TYPESENSE_BULK_WRITE_CONCURRENCY"));
+        }
+
+        if(!get_env("TYPESENSE_BULK_WRITE_QUEUE_DEPTH").empty()) {
+            this->bulk_write_queue_depth = std::stoi(get_env("TYPESENSE_BULK_WRITE_QUEUE_DEPTH"));
+        }
+
+        if(!get_env("TYPESENSE_BACKGROUND_CONCURRENCY").empty()) {
+            this->background_concurrency = std::stoi(get_env("TYPESENSE_BACKGROUND_CONCURRENCY"));
+        }
+
+        if(!get_env("TYPESENSE_BACKGROUND_QUEUE_DEPTH").empty()) {
+            this->background_queue_depth = std::stoi(get_env("TYPESENSE_BACKGROUND_QUEUE_DEPTH"));
+        }
+
+        if(!get_env("TYPESENSE_CACHE_SIZE_MB").empty()) {
+            this->cache_size_mb = std::stoi(get_env("TYPESENSE_CACHE_SIZE_MB"));
+        }
+
+        if(!get_env("TYPESENSE_CACHE_TTL_SECONDS").empty()) {
+            this->cache_ttl_seconds = std::stoi(get_env("TYPESENSE_CACHE_TTL_SECONDS"));
+        }
+
+        if(!get_env("TYPESENSE_FILTER_CACHE_SIZE_MB").empty()) {
+            this->filter_cache_size_mb = std::stoi(get_env("TYPESENSE_FILTER_CACHE_SIZE_MB"));
+        }
+
         if(!get_env("TYPESENSE_SSL_REFRESH_INTERVAL_SECONDS").empty()) {
             this->ssl_refresh_interval_seconds = std::stoi(get_env("TYPESENSE_SSL_REFRESH_INTERVAL_SECONDS"));
         }
@@ -420,6 +515,42 @@ public:
             this->thread_pool_size = (int) reader.GetInteger("server", "thread-pool-size", 0);
         }
 
+        if(reader.Exists("server", "interactive-concurrency")) {
+            this->interactive_concurrency = (int) reader.GetInteger("server", "interactive-concurrency", 0);
+        }
+
+        if(reader.Exists("server", "interactive-queue-depth")) {
+            this->interactive_queue_depth = (int) reader.GetInteger("server", "interactive-queue-depth", 1000);
+        }
+
+        if(reader.Exists("server", "bulk-write-concurrency")) {
+            this->bulk_write_concurrency = (int) reader.GetInteger("server", "bulk-write-concurrency", 0);
+        }
+
+        if(reader.Exists("server", "bulk-write-queue-depth")) {
+            this->bulk_write_queue_depth = (int) reader.GetInteger("server", "bulk-write-queue-depth", 1000);
+        }
+
+        if(reader.Exists("server", "background-concurrency")) {
+            this->background_concurrency = (int) reader.GetInteger("server", "background-concurrency", 0);
+        }
+
+        if(reader.Exists("server", "background-queue-depth")) {
+            this->background_queue_depth = (int) reader.GetInteger("server", "background-queue-depth", 100);
+        }
+
+        if(reader.Exists("server", "cache-size-mb")) {
+            this->cache_size_mb = (int) reader.GetInteger("server", "cache-size-mb", 0);
+        }
+
+        if(reader.Exists("server", "cache-ttl-seconds")) {
+            this->cache_ttl_seconds = (int) reader.GetInteger("server", "cache-ttl-seconds", 60);
+        }
+
+        if(reader.Exists("server", "filter-cache-size-mb")) {
+            this->filter_cache_size_mb = (int) reader.GetInteger("server", "filter-cache-size-mb", 16);
+        }
+
         if(reader.Exists("server", "ssl-refresh-interval-seconds")) {
             this->ssl_refresh_interval_seconds = (int) reader.GetInteger("server", "ssl-refresh-interval-seconds", 8 * 60 * 60);
         }
@@ -519,6 +650,42 @@ public:
             this->thread_pool_size = options.get<uint32_t>("thread-pool-size");
         }
 
+        if(options.exist("interactive-concurrency")) {
+            this->interactive_concurrency = options.get<uint32_t>("interactive-concurrency");
+        }
+
+        if(options.exist("interactive-queue-depth")) {
+            this->interactive_queue_depth = options.get<uint32_t>("interactive-queue-depth");
+        }
+
+        if(options.exist("bulk-write-concurrency")) {
+            this->bulk_write_concurrency = options.get<uint32_t>("bulk-write-concurrency");
+        }
+
+        if(options.exist("bulk-write-queue-depth")) {
+            this->bulk_write_queue_depth = options.get<uint32_t>("bulk-write-queue-depth");
+        }
+
+        if(options.exist("background-concurrency")) {
+            this->background_concurrency = options.get<uint32_t>("background-concurrency");
+        }
+
+        if(options.exist("background-queue-depth")) {
+            this->background_queue_depth = options.get<uint32_t>("background-queue-depth");
+        }
+
+        if(options.exist("cache-size-mb")) {
+            this->cache_size_mb = options.get<uint32_t>("cache-size-mb");
+        }
+
+        if(options.exist("cache-ttl-seconds")) {
+            this->cache_ttl_seconds = options.get<uint32_t>("cache-ttl-seconds");
+        }
+
+        if(options.exist("filter-cache-size-mb")) {
+            this->filter_cache_size_mb = options.get<uint32_t>("filter-cache-size-mb");
+        }
+
         if(options.exist("ssl-refresh-interval-seconds")) {
             this->ssl_refresh_interval_seconds = options.get<uint32_t>("ssl-refresh-interval-seconds");
         }
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <vector>
+
+/**
+ * Defers the freeing of objects that writers have unlinked from a shared structure until no reader that could
+ * still hold them is left.
+ *
+ * Readers enter an epoch for as long as they use what they found, and writers retire what they unlink instead of
+ * freeing it. A retired object is reclaimed once every reader that entered before it was retired has exited.
+ * Reclamation is only run by writers, so it can touch data that is guarded by their write lock.
+ */
+class epoch_reclaimer_t {
+private:
+    struct retired_t {
+        uint64_t epoch;
+        std::function<void()> reclaim;
+    };
+
+    std::mutex mutex;
+
+    uint64_t current_epoch = 0;
+
+    // epoch => number of readers that entered at it
+    std::map<uint64_t, size_t> reader_epochs;
+
+    // in ascending order of epochs
+    std::vector<retired_t> retired;
+
+    uint64_t enter();
+
+    void exit(uint64_t epoch);
+
+public:
+    // keeps the objects that are retired while it is alive from being reclaimed
+    class guard_t {
+    private:
+        epoch_reclaimer_t* reclaimer;
+        uint64_t epoch;
+
+    public:
+        explicit guard_t(epoch_reclaimer_t* reclaimer): reclaimer(reclaimer), epoch(reclaimer->enter()) {
+
+        }
+
+        guard_t(guard_t&& other) noexcept: reclaimer(other.reclaimer), epoch(other.epoch) {
+            other.reclaimer = nullptr;
+        }
+
+        guard_t(const guard_t&) = delete;
+        guard_t& operator=(const guard_t&) = delete;
+        guard_t& operator=(guard_t&&) = delete;
+
+        ~guard_t() {
+            if(reclaimer != nullptr) {
+                reclaimer->exit(epoch);
+            }
+        }
+    };
+
+    ~epoch_reclaimer_t();
+
+    void retire(std::function<void()> reclaim);
+
+    // runs the reclamation of the retired objects that no reader can still hold, and returns their number
+    size_t reclaim();
+
+    // runs the reclamation of every retired object, regardless of readers
+    void reclaim_all();
+
+    size_t num_retired();
+};
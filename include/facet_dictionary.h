@@ -0,0 +1,93 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <sparsepp.h>
+
+/**
+ * Values of a facet field, keyed on the hash that faceting counts them under (the combination of the hashes of their
+ * tokens). Every distinct value is held once, with the number of document values referring to it, so that facet
+ * counts are labelled without fetching the representative document of every value.
+ *
+ * Tokens are normalized before they are hashed, so differently spelled values (e.g. "Apple" and "apple!") share a
+ * hash. Each spelling is counted on its own, so that a value is only ever labelled with a spelling that some
+ * document still holds.
+ *
+ * Every distinct value also gets a dense ordinal, and the ordinals of the values of every document are stored in a
+ * column indexed by `seq_id / stride` (like `sort_column_t`), so that facets can be counted into a flat array of
+ * ordinals instead of a hash map. Ordinals of values that no document holds anymore are reused.
+ */
+class facet_dictionary_t {
+private:
+    struct variant_t {
+        std::string value;
+        uint32_t ref_count;
+    };
+
+    struct entry_t {
+        // spellings of the value, with a `ref_count` of 0 for free ones
+        std::vector<variant_t> variants;
+        uint64_t value_hash;
+        uint32_t ref_count;
+    };
+
+    // ordinal => value, with a `ref_count` of 0 for free ordinals
+    std::vector<entry_t> entries;
+
+    // value hash => ordinal
+    spp::sparse_hash_map<uint64_t, uint32_t> ordinals;
+
+    std::vector<uint32_t> free_ordinals;
+
+    uint32_t stride;
+
+    // ordinals of the values of the document of a slot are at [doc_offsets[slot], doc_offsets[slot] + doc_lengths[slot])
+    std::vector<uint32_t> doc_offsets;
+    std::vector<uint32_t> doc_lengths;
+    std::vector<uint32_t> doc_ordinals;
+
+    // index of the spelling of every value of `doc_ordinals` within the variants of its entry
+    std::vector<uint32_t> doc_variants;
+
+    // ordinals of removed documents that are still held in `doc_ordinals`
+    size_t num_stale_ordinals = 0;
+
+    uint32_t add_value(uint64_t value_hash, const std::string& value, uint32_t& variant);
+
+    void remove_ordinal(uint32_t ordinal, uint32_t variant);
+
+    void compact();
+
+public:
+    explicit facet_dictionary_t(uint32_t stride = 1): stride(stride == 0 ? 1 : stride) {
+
+    }
+
+    // `value_hashes` and `values` are the values of the document, in order
+    void add(uint32_t seq_id, const std::vector<uint64_t>& value_hashes, const std::vector<std::string>& values);
+
+    void remove(uint32_t seq_id);
+
+    bool get(uint64_t value_hash, std::string& value) const;
+
+    // number of distinct values
+    size_t size() const;
+
+    // upper bound of the ordinals, for sizing count arrays
+    size_t num_ordinals() const;
+
+    uint64_t get_value_hash(uint32_t ordinal) const;
+
+    inline void get_ordinals(uint32_t seq_id, const uint32_t*& doc_ordinals_out, uint32_t& num_ordinals_out) const {
+        const uint32_t slot = seq_id / stride;
+
+        if(slot >= doc_lengths.size()) {
+            num_ordinals_out = 0;
+            return ;
+        }
+
+        doc_ordinals_out = doc_ordinals.data() + doc_offsets[slot];
+        num_ordinals_out = doc_lengths[slot];
+    }
+};
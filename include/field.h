@@ -35,6 +35,7 @@ namespace fields {
     static const std::string index = "index";
     static const std::string geo_resolution = "geo_resolution";
     static const std::string locale = "locale";
+    static const std::string typo_index = "typo_index";
 }
 
 static const uint8_t DEFAULT_GEO_RESOLUTION = 7;
@@ -51,11 +52,14 @@ struct field {
 
     std::string locale;
 
+    // maintain a symmetric delete dictionary of the field's tokens for faster typo lookups
+    bool typo_index;
+
     field(const std::string &name, const std::string &type, const bool facet, const bool optional = false,
           bool index = true, const uint8_t geo_resolution = DEFAULT_GEO_RESOLUTION,
-          std::string locale = "") :
+          std::string locale = "", const bool typo_index = false) :
             name(name), type(type), facet(facet), optional(optional), index(index),
-            geo_resolution(geo_resolution), locale(locale) {
+            geo_resolution(geo_resolution), locale(locale), typo_index(typo_index) {
 
     }
 
@@ -210,6 +214,10 @@ struct field {
 
             field_val[fields::locale] = field.locale;
 
+            if(field.typo_index) {
+                field_val[fields::typo_index] = true;
+            }
+
             fields_json.push_back(field_val);
 
             if(!field.has_valid_type()) {
@@ -249,6 +257,10 @@ struct field {
             if(!field.index && field.is_auto()) {
                 return Option<bool>(400, "Field `" + field.name + "` cannot be marked as non-indexable.");
             }
+
+            if(field.typo_index && !field.is_string()) {
+                return Option<bool>(400, "Field `" + field.name + "` must be a string field to have a typo index.");
+            }
         }
 
         if(!default_sorting_field.empty() && !found_default_sorting_field) {
@@ -289,6 +301,11 @@ struct field {
                                          field_json[fields::name].get<std::string>() + std::string("` should be a boolean."));
             }
 
+            if(field_json.count(fields::typo_index) != 0 && !field_json.at(fields::typo_index).is_boolean()) {
+                return Option<bool>(400, std::string("The `typo_index` property of the field `") +
+                                         field_json[fields::name].get<std::string>() + std::string("` should be a boolean."));
+            }
+
             if(field_json.count(fields::geo_resolution) != 0) {
                 if(!field_json.at(fields::geo_resolution).is_number_integer()) {
                     return Option<bool>(400, std::string("The `geo_resolution` property of the field `") +
@@ -337,6 +354,10 @@ struct field {
                     return Option<bool>(400, "Field `.*` cannot contain a geo resolution.");
                 }
 
+                if(field_json.count(fields::typo_index) != 0) {
+                    return Option<bool>(400, "Field `.*` cannot have a typo index.");
+                }
+
                 if(field_json[fields::optional] == false) {
                     return Option<bool>(400, "Field `.*` must be an optional field.");
                 }
@@ -386,10 +407,13 @@ struct field {
                 field_json[fields::geo_resolution] = DEFAULT_GEO_RESOLUTION;
             }
 
+            const bool typo_index = field_json.count(fields::typo_index) != 0 &&
+                                    field_json[fields::typo_index].get<bool>();
+
             fields.emplace_back(
                 field(field_json[fields::name], field_json[fields::type], field_json[fields::facet],
                       field_json[fields::optional], field_json[fields::index],
-                      field_json[fields::geo_resolution], field_json[fields::locale])
+                      field_json[fields::geo_resolution], field_json[fields::locale], typo_index)
             );
         }
 
@@ -529,6 +553,9 @@ struct facet {
     std::unordered_map<uint64_t, facet_count_t> result_map;
     facet_stats_t stats;
 
+    // counts and stats were estimated from a sample of the results
+    bool sampled = false;
+
     facet(const std::string & field_name): field_name(field_name) {
 
     }
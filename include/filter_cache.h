@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include <sparsepp.h>
+#include "field.h"
+#include "sorted_array.h"
+
+/**
+ * Cache of evaluated filter clauses, and of the combinations of clauses of a filter query, for the documents of an
+ * index, bounded by the memory that the entries take up. The ids are held compressed, and an entry is counted by the
+ * compressed size of its ids.
+ *
+ * Every entry depends on the fields that its clauses refer to, and adding or removing a document drops the entries
+ * of the fields of that document, so that a cached result is always the one that evaluating the clauses would give.
+ */
+class filter_cache_t {
+private:
+    struct entry_t {
+        std::string key;
+        std::vector<std::string> field_names;
+        sorted_array ids;
+        size_t num_bytes = 0;
+    };
+
+    mutable std::mutex mutex;
+
+    size_t max_bytes;
+    size_t num_bytes = 0;
+
+    // most recently used entries first
+    std::list<entry_t> entries;
+    std::unordered_map<std::string, std::list<entry_t>::iterator> entry_map;
+
+    // field => keys of the entries that depend on it
+    std::unordered_map<std::string, std::unordered_set<std::string>> field_keys;
+
+    size_t num_hits = 0;
+
+    void erase(std::list<entry_t>::iterator entry_it);
+
+public:
+    static constexpr size_t DEFAULT_MAX_BYTES = 16 * 1024 * 1024;
+
+    // a size of 0 disables the cache
+    explicit filter_cache_t(size_t max_bytes = DEFAULT_MAX_BYTES);
+
+    // copies the cached ids of the key into a new array that the caller owns
+    bool get(const std::string& key, uint32_t** ids, size_t& ids_len);
+
+    // ids that take up more memory than the whole cache are not cached
+    void insert(const std::string& key, const std::vector<std::string>& field_names,
+                const uint32_t* ids, size_t ids_len);
+
+    void invalidate(const std::string& field_name);
+
+    void clear();
+
+    size_t size() const;
+
+    size_t size_bytes() const;
+
+    size_t get_num_hits() const;
+
+    static std::string get_key(const filter& a_filter);
+
+    static std::string get_key(const std::vector<filter>& filters);
+};
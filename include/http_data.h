@@ -11,6 +11,7 @@
 #include "logger.h"
 #include "app_metrics.h"
 #include "config.h"
+#include "request_scheduler.h"
 
 #define H2O_USE_LIBUV 0
 extern "C" {
@@ -111,6 +112,7 @@ struct http_res {
             case 422: return "Unprocessable Entity";
             case 429: return "Too Many Requests";
             case 500: return "Internal Server Error";
+            case 503: return "Service Unavailable";
             default: return "";
         }
     }
@@ -210,6 +212,8 @@ struct http_req {
     std::condition_variable cv;
     bool ready;
 
+    // admission of a write or of an async response, which is released once the request is done with
+    std::unique_ptr<schedule_slot_t> schedule_slot;
 
     http_req(): _req(nullptr), route_hash(1),
                 first_chunk_aggregate(true), last_chunk_aggregate(false),
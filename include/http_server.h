@@ -15,6 +15,7 @@ extern "C" {
 #include "http_data.h"
 #include "option.h"
 #include "threadpool.h"
+#include "request_scheduler.h"
 
 class ReplicationState;
 class HttpServer;
@@ -106,6 +107,8 @@ private:
 
     ThreadPool* thread_pool;
 
+    RequestScheduler* request_scheduler;
+
     bool (*auth_handler)(std::map<std::string, std::string>& params, const std::string& body, const route_path& rpath,
                          const std::string& auth_key);
 
@@ -161,6 +164,8 @@ public:
     void set_auth_handler(bool (*handler)(std::map<std::string, std::string>& params, const std::string& body,
                                           const route_path & rpath, const std::string & auth_key));
 
+    void set_request_scheduler(RequestScheduler* scheduler);
+
     void get(const std::string & path, bool (*handler)(const std::shared_ptr<http_req>& req, const std::shared_ptr<http_res>& res), bool async_req=false, bool async_res=false);
 
     void post(const std::string & path, bool (*handler)(const std::shared_ptr<http_req>& req, const std::shared_ptr<http_res>& res), bool async_req=false, bool async_res=false);
@@ -207,6 +212,8 @@ public:
 
     ThreadPool* get_thread_pool() const;
 
+    RequestScheduler* get_request_scheduler() const;
+
     static constexpr const char* STOP_SERVER_MESSAGE = "STOP_SERVER";
     static constexpr const char* STREAM_RESPONSE_MESSAGE = "STREAM_RESPONSE";
     static constexpr const char* REQUEST_PROCEED_MESSAGE = "REQUEST_PROCEED";
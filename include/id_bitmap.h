@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * Immutable compressed bitmap of document ids, in the style of Roaring bitmaps: ids are partitioned by their upper
+ * 16 bits, and every partition is stored in whichever container is the smallest for its ids:
+ *
+ *  - ARRAY: sorted lower 16 bits, for sparse partitions (up to MAX_ARRAY_SIZE ids)
+ *  - BITMAP: a fixed 2^16 bit map, for dense partitions
+ *  - RUN: (start, length - 1) pairs of consecutive ids, for partitions made of a few long runs
+ *
+ * Membership checks do not depend on the number of ids, which makes intersecting a short list of ids with a large
+ * filter result much cheaper than merging the two arrays.
+ */
+class id_bitmap_t {
+private:
+    enum container_type_t: uint8_t {
+        ARRAY,
+        BITMAP,
+        RUN
+    };
+
+    struct container_t {
+        uint16_t key;                   // upper 16 bits shared by the ids of the container
+        container_type_t type;
+        std::vector<uint16_t> values;   // ARRAY: lower 16 bits, RUN: (start, length - 1) pairs
+        std::vector<uint64_t> words;    // BITMAP: one bit per lower 16 bits value
+    };
+
+    std::vector<container_t> containers;
+    size_t num_ids = 0;
+
+    static void load_container(container_t& container, const uint32_t* ids, size_t len);
+
+    static bool container_contains(const container_t& container, uint16_t low);
+
+    void clear();
+
+public:
+    static constexpr size_t MAX_ARRAY_SIZE = 4096;
+
+    // a filter result is held in a bitmap only when it has at least this many ids ...
+    static constexpr size_t MIN_BITMAP_IDS = 4096;
+
+    // ... and when at least 1 / MAX_SPARSITY of the ids in its range are present
+    static constexpr size_t MAX_SPARSITY = 64;
+
+    id_bitmap_t() = default;
+
+    id_bitmap_t(const id_bitmap_t&) = delete;
+
+    id_bitmap_t& operator=(const id_bitmap_t&) = delete;
+
+    static bool is_dense(const uint32_t* sorted_ids, size_t len);
+
+    void load(const uint32_t* sorted_ids, size_t len);
+
+    bool contains(uint32_t id) const;
+
+    // writes the ids of `sorted_ids` that are present in the bitmap to `out` and returns their count
+    size_t intersect(const uint32_t* sorted_ids, size_t len, uint32_t* out) const;
+
+    size_t size() const;
+
+    size_t num_containers() const;
+
+    uint64_t memory_bytes() const;
+};
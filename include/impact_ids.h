@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * Ids of the documents of a token, ordered on the default sorting field points of the documents: highest points
+ * first and, among equal points, highest id first. It is held next to the id ordered posting list of the token.
+ *
+ * Queries that only rank the documents of a token on those points walk its ids in this order and stop after the
+ * first K valid ids, instead of scoring every document of the token.
+ *
+ * Entries are stored in blocks of at most BLOCK_SIZE, so that an insertion or a deletion only shifts one block.
+ */
+class impact_ids_t {
+private:
+    struct entry_t {
+        int64_t points;
+        uint32_t id;
+    };
+
+    std::vector<std::vector<entry_t>> blocks;
+    size_t num_ids = 0;
+
+    // whether `a` is ordered before `b`
+    static bool precedes(const entry_t& a, const entry_t& b) {
+        return a.points > b.points || (a.points == b.points && a.id > b.id);
+    }
+
+    // first block whose last entry is not ordered before `entry`, or the last block
+    size_t block_of(const entry_t& entry) const;
+
+    void erase_entry(size_t block_index, size_t entry_index);
+
+public:
+    static constexpr size_t BLOCK_SIZE = 256;
+
+    void insert(int64_t points, uint32_t id);
+
+    // `points` must be the points that the id was inserted with: when they are not, every entry is scanned
+    void remove(int64_t points, uint32_t id);
+
+    // calls `fn(id)` on the ids in order, for as long as it returns true
+    template<typename F>
+    void for_each(F fn) const {
+        for(const auto& block: blocks) {
+            for(const entry_t& entry: block) {
+                if(!fn(entry.id)) {
+                    return ;
+                }
+            }
+        }
+    }
+
+    size_t size() const;
+
+    uint64_t memory_bytes() const;
+};
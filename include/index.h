@@ -18,6 +18,15 @@
 #include <h3api.h>
 #include "string_utils.h"
 #include "num_tree.h"
+#include "typo_index.h"
+#include "id_bitmap.h"
+#include "sort_column.h"
+#include "match_score.h"
+#include "epoch_reclaimer.h"
+#include "filter_cache.h"
+#include "facet_dictionary.h"
+#include "threadpool.h"
+#include "rw_mutex.h"
 #include "magic_enum.hpp"
 
 struct token_t {
@@ -42,6 +51,34 @@ struct query_tokens_t {
     std::vector<std::vector<std::string>> q_synonyms;
 };
 
+// Reusable buffers holding the positions of the query tokens in a single document. Buffers are only cleared
+// between documents, so that gathering positions does not allocate once they have grown large enough.
+struct token_positions_buffer_t {
+    struct run_t {
+        uint32_t array_index;   // array element of the positions (always 0 for plain string fields)
+        uint32_t token_index;   // index of the token in the query suggestion
+        uint32_t start;         // range of the positions in `positions`
+        uint32_t end;
+    };
+
+    std::vector<uint16_t> positions;
+    std::vector<run_t> runs;    // sorted on array element, then on token
+
+    void clear() {
+        positions.clear();
+        runs.clear();
+    }
+};
+
+// how a clause of a filter query was evaluated, to explain a search
+struct filter_explain_t {
+    std::string field_name;
+    size_t estimated_ids;       // documents that the clause alone was estimated to match
+    std::string strategy;       // "cached", "materialized" (over all documents) or "probed" (only the ids so far)
+    size_t num_ids;             // ids left after this and the previous clauses
+    uint64_t time_us;
+};
+
 struct search_args {
     std::vector<query_tokens_t> field_query_tokens;
     std::vector<search_field_t> search_fields;
@@ -69,6 +106,13 @@ struct search_args {
     Topster* curated_topster;
     std::vector<std::vector<KV*>> raw_result_kvs;
     std::vector<std::vector<KV*>> override_result_kvs;
+    bool explain_filters = false;
+    std::vector<filter_explain_t> filter_explain;
+    size_t facet_sample_percent = 100;
+    size_t facet_sample_threshold = 0;
+
+    // for counting the facets of large result sets in parallel
+    ThreadPool* thread_pool = nullptr;
 
     search_args() {
 
@@ -150,10 +194,14 @@ struct index_record {
 
 class Index {
 private:
-    mutable std::shared_mutex mutex;
+    // writers are not starved by a steady stream of searches
+    mutable rw_mutex_t mutex;
 
     const uint64_t FACET_ARRAY_DELIMETER = std::numeric_limits<uint64_t>::max();
 
+    // number of results ahead of the one being scored whose sort values are prefetched
+    static constexpr size_t SORT_PREFETCH_DISTANCE = 8;
+
     std::string name;
 
     size_t num_documents;
@@ -164,19 +212,37 @@ private:
 
     std::unordered_map<std::string, field> sort_schema;
 
+    // documents of a collection are spread across its indices by `seq_id % num_memory_shards`
+    uint32_t num_memory_shards;
+
+    // default sorting field that the ids of string field tokens are also ordered on (empty when not opted in)
+    std::string impact_sorting_field;
+
     spp::sparse_hash_map<std::string, art_tree*> search_index;
 
     spp::sparse_hash_map<std::string, num_tree_t*> numerical_index;
 
+    // string fields that opted into a symmetric delete dictionary
+    spp::sparse_hash_map<std::string, typo_index_t*> typo_index;
+
     // facet_field => (seq_id => values)
     spp::sparse_hash_map<std::string, spp::sparse_hash_map<uint32_t, facet_hash_values_t>*> facet_index_v3;
 
+    // facet_field => (value hash => value, and the values of each document as ordinals)
+    spp::sparse_hash_map<std::string, facet_dictionary_t*> facet_dictionaries;
+
     // sort_field => (seq_id => value)
-    spp::sparse_hash_map<std::string, spp::sparse_hash_map<uint32_t, int64_t>*> sort_index;
+    spp::sparse_hash_map<std::string, sort_column_t*> sort_index;
 
     // this is used for wildcard queries
     sorted_array seq_ids;
 
+    // art leaves removed from `search_index` are only freed once no search that could have found them is running
+    epoch_reclaimer_t reclaimer;
+
+    // evaluated filter clauses, dropped whenever a document with a value for their fields is indexed or removed
+    mutable filter_cache_t filter_cache;
+
     StringUtils string_utils;
 
     // Internal utility functions
@@ -189,9 +255,46 @@ private:
 
     void log_leaves(const int cost, const std::string &token, const std::vector<art_leaf *> &leaves) const;
 
+    struct facet_info_t {
+        // facet hash => token position in the query
+        std::unordered_map<uint64_t, token_pos_cost_t> fhash_qtoken_pos;
+
+        bool use_facet_query = false;
+        bool should_compute_stats = false;
+        field facet_field{"", "", false};
+    };
+
+    // when `facet_sample_percent` is below 100 and there are more than `facet_sample_threshold` results, the facets
+    // are counted over a sample of the results and the counts are scaled up to all of them.
+    // Given a thread pool, the fields of large result sets are counted in parallel, in chunks of the results.
     void do_facets(std::vector<facet> & facets, facet_query_t & facet_query,
                    size_t group_limit, const std::vector<std::string>& group_by_fields,
-                   const uint32_t* result_ids, size_t results_size) const;
+                   const uint32_t* result_ids, size_t results_size,
+                   size_t facet_sample_percent = 100, size_t facet_sample_threshold = 0,
+                   ThreadPool* thread_pool = nullptr) const;
+
+    // adds the counts of the values of the results to the facet
+    void compute_facet(facet& a_facet, const facet_info_t& facet_info,
+                       size_t group_limit, const std::vector<std::string>& group_by_fields,
+                       const uint32_t* result_ids, size_t results_size) const;
+
+    void compute_facet_chunks(facet& a_facet, const facet_info_t& facet_info,
+                              size_t group_limit, const std::vector<std::string>& group_by_fields,
+                              const uint32_t* result_ids, size_t results_size,
+                              size_t num_chunks, ThreadPool* thread_pool) const;
+
+    // adds the counts of the other facet, which were counted over results that come after those of the facet
+    static void merge_facet_counts(facet& a_facet, facet& other_facet, size_t group_limit);
+
+    // uniform sample of `facet_sample_percent` of the ids, in their original order
+    static void sample_result_ids(const uint32_t* result_ids, size_t results_size, size_t facet_sample_percent,
+                                  std::vector<uint32_t>& sampled_ids);
+
+    static void scale_facet(facet& a_facet, double scale);
+
+    // adds the stats of a block of raw values of a numeric field, which are computed over the values as a column
+    static void compute_facet_stats(facet &a_facet, const uint64_t* raw_values, size_t num_values,
+                                    const std::string & field_type);
 
     void search_field(const uint8_t & field_id,
                       std::vector<token_t>& query_tokens,
@@ -200,6 +303,7 @@ private:
                       size_t exclude_token_ids_size,
                       size_t& num_tokens_dropped,
                       const std::string & field, uint32_t *filter_ids, size_t filter_ids_length,
+                      const id_bitmap_t* filter_bitmap,
                       const std::vector<uint32_t>& curated_ids,
                       std::vector<facet> & facets, const std::vector<sort_by> & sort_fields,
                       const int num_typos, std::vector<std::vector<art_leaf*>> & searched_queries,
@@ -208,12 +312,13 @@ private:
                       size_t& field_num_results,
                       const size_t group_limit,
                       const std::vector<std::string>& group_by_fields,
+                      const std::string& default_sorting_field,
                       const token_ordering token_order = FREQUENCY, const bool prefix = false,
                       const size_t drop_tokens_threshold = Index::DROP_TOKENS_THRESHOLD,
                       const size_t typo_tokens_threshold = Index::TYPO_TOKENS_THRESHOLD) const;
 
     void search_candidates(const uint8_t & field_id,
-                           uint32_t* filter_ids, size_t filter_ids_length,
+                           uint32_t* filter_ids, size_t filter_ids_length, const id_bitmap_t* filter_bitmap,
                            const uint32_t* exclude_token_ids, size_t exclude_token_ids_size,
                            const std::vector<uint32_t>& curated_ids,
                            const std::vector<sort_by> & sort_fields, std::vector<token_candidates> & token_to_candidates,
@@ -223,10 +328,16 @@ private:
                            size_t & all_result_ids_len,
                            size_t& field_num_results,
                            const size_t typo_tokens_threshold,
-                           const size_t group_limit, const std::vector<std::string>& group_by_fields) const;
+                           const size_t group_limit, const std::vector<std::string>& group_by_fields,
+                           const bool is_array_field, const std::string& default_sorting_field) const;
+
+    bool suggestion_can_enter_topster(const std::vector<sort_by>& sort_fields, const std::string& default_sorting_field,
+                                      const std::vector<art_leaf*>& query_suggestion, const uint32_t total_cost,
+                                      const Topster* topster) const;
 
     void insert_doc(const int64_t score, art_tree *t, uint32_t seq_id,
-                    const std::unordered_map<std::string, std::vector<uint32_t>> &token_to_offsets) const;
+                    const std::unordered_map<std::string, std::vector<uint32_t>> &token_to_offsets,
+                    typo_index_t* field_typo_index = nullptr, const bool impact_ordered = false) const;
 
     void index_string_field(const std::string & text, const int64_t score, art_tree *t, uint32_t seq_id,
                             bool is_facet, const field & a_field);
@@ -234,9 +345,55 @@ private:
     void index_string_array_field(const std::vector<std::string> & strings, const int64_t score, art_tree *t,
                                   uint32_t seq_id, bool is_facet, const field & a_field);
 
+    // returns nullptr when the field has not opted into a typo index
+    typo_index_t* get_typo_index(const field& a_field) const;
+
+    bool is_impact_ordered(const field& a_field) const;
+
+    // whether ranking the documents of a single token only depends on the impact sorting field
+    bool is_impact_ordered_sort(const std::vector<sort_by>& sort_fields) const;
+
+    // writes to `top_ids` (in ascending order) the first `max_ids` ids of the leaf's impact order present in
+    // `result_ids`, and returns false when the leaf has no impact ordered ids
+    static bool get_top_impact_ids(const art_leaf* leaf, const uint32_t* result_ids, const size_t result_size,
+                                   const size_t max_ids, std::vector<uint32_t>& top_ids);
+
+    // default sorting field points of an indexed document, as stored in the art leaves
+    int64_t get_impact_points(const uint32_t seq_id) const;
+
     void remove_and_shift_offset_index(sorted_array& offset_index, const uint32_t* indices_sorted,
                                        const uint32_t indices_length);
 
+    // the callers of these two hold the unique lock on `mutex`
+    Option<uint32_t> do_index_in_memory(const nlohmann::json & document, uint32_t seq_id,
+                                        const std::string & default_sorting_field);
+
+    void do_remove(const uint32_t seq_id, const nlohmann::json & document);
+
+    // drops the cached filter clauses on the fields of the document
+    void invalidate_filter_cache(const nlohmann::json& document);
+
+    // value of a numerical filter in the representation of the numerical index and of the sort columns
+    static int64_t get_filter_value(const field& f, const std::string& filter_value);
+
+    // inclusive ranges of the values matched by a numerical filter clause
+    static void get_filter_ranges(const filter& a_filter, const field& f,
+                                  std::vector<std::pair<int64_t, int64_t>>& ranges);
+
+    // upper bound of the number of documents matched by the clause, from the lengths of the id lists
+    size_t estimate_filter(const filter& a_filter, const field& f) const;
+
+    // evaluates the clause over all documents
+    void evaluate_filter(const filter& a_filter, const field& f,
+                         uint32_t** result_ids_out, size_t& result_ids_len_out) const;
+
+    // keeps those of the `ids` that match the clause, or returns false when the clause can't be checked by document
+    bool probe_filter(const filter& a_filter, const field& f, const uint32_t* ids, size_t ids_len,
+                      uint32_t** result_ids_out, size_t& result_ids_len) const;
+
+    // whether a value of the facet field of the document is made of exactly the tokens
+    bool is_exact_facet_match(const field& f, uint32_t seq_id, const std::vector<std::string>& str_tokens) const;
+
     void collate_included_ids(const std::vector<std::string>& q_included_tokens,
                               const std::string & field, const uint8_t field_id,
                               const std::map<size_t, std::map<size_t, uint32_t>> & included_ids_map,
@@ -244,7 +401,21 @@ private:
 
     static uint64_t facet_token_hash(const field & a_field, const std::string &token);
 
-    static void compute_facet_stats(facet &a_facet, uint64_t raw_value, const std::string & field_type);
+    // hashes that faceting counts the values of a document under, in the order of the values
+    void get_facet_value_hashes(const facet_hash_values_t& fvalues, std::vector<uint64_t>& value_hashes) const;
+
+    // adds the values of a document to the facet dictionary of the field, given the text that they were indexed as
+    void add_facet_values(const field& a_field, uint32_t seq_id, const facet_hash_values_t& fvalues,
+                          const std::vector<std::string>& values);
+
+    static bool use_facet_ordinals(size_t num_ordinals, size_t results_size);
+
+    // counts the values of the results into flat arrays indexed by the ordinals of the values
+    static void count_facet_ordinals(facet& a_facet, const facet_dictionary_t& facet_dictionary,
+                                     const uint32_t* result_ids, size_t results_size);
+
+    // value of a facet field as facet counts show it
+    static std::string get_facet_display_value(const field& a_field, const std::string& text);
 
     static void get_doc_changes(const nlohmann::json &document, nlohmann::json &old_doc,
                                 nlohmann::json &new_doc, nlohmann::json &del_doc);
@@ -283,10 +454,32 @@ public:
     // in the query that have the least individual hits one by one until enough results are found.
     static const int DROP_TOKENS_THRESHOLD = 10;
 
+    // facets are counted over the ordinals of their values when the field has at most this many distinct values,
+    // and at most FACET_ORDINALS_PER_RESULT times as many as there are results to count
+    static const size_t MAX_FACET_ORDINALS = 65536;
+    static const size_t FACET_ORDINALS_PER_RESULT = 4;
+
+    // facets of fewer results are counted on the searching thread, and larger result sets are split into chunks of
+    // at least this many results
+    static const size_t FACET_PARALLEL_MIN_RESULTS = 10000;
+
+    // stats of numeric facets are computed over blocks of this many values, so that no buffer grows with the results
+    static constexpr size_t FACET_STATS_BLOCK_SIZE = 1024;
+
+    // a filter clause is checked against the ids matched by the previous clauses, instead of being evaluated over
+    // all documents, when it is estimated to match at least this many times as many documents
+    static const size_t FILTER_PROBE_RATIO = 4;
+
+    // a batch of documents is indexed while holding the write lock for up to this long at a time, after which
+    // waiting searches are let in
+    static const uint64_t WRITE_LOCK_BUDGET_US = 1000;
+
     Index() = delete;
 
     Index(const std::string name, const std::unordered_map<std::string, field> & search_schema,
-          std::map<std::string, field> facet_schema, std::unordered_map<std::string, field> sort_schema);
+          std::map<std::string, field> facet_schema, std::unordered_map<std::string, field> sort_schema,
+          uint32_t num_memory_shards = 1, const std::string& impact_sorting_field = "",
+          size_t filter_cache_max_bytes = filter_cache_t::DEFAULT_MAX_BYTES);
 
     ~Index();
 
@@ -303,14 +496,19 @@ public:
                        spp::sparse_hash_set<uint64_t>& groups_processed,
                        const uint32_t *result_ids, const size_t result_size,
                        const size_t group_limit, const std::vector<std::string>& group_by_fields,
-                       uint32_t token_bits) const;
+                       uint32_t token_bits, const bool is_array_field = false) const;
 
     static int64_t get_points_from_doc(const nlohmann::json &document, const std::string & default_sorting_field);
 
+    static int64_t float_to_points(float n);
+
     const spp::sparse_hash_map<std::string, art_tree *>& _get_search_index() const;
 
     const spp::sparse_hash_map<std::string, num_tree_t*>& _get_numerical_index() const;
 
+    // accumulates per-field memory usage of the in-memory structures into `stats`
+    void get_memory_stats(nlohmann::json& stats) const;
+
     static int get_bounded_typo_cost(const size_t max_cost, const size_t token_len);
 
     static int64_t float_to_in64_t(float n);
@@ -349,7 +547,11 @@ public:
                 const size_t typo_tokens_threshold,
                 const size_t group_limit,
                 const std::vector<std::string>& group_by_fields,
-                const std::string& default_sorting_field) const;
+                const std::string& default_sorting_field,
+                std::vector<filter_explain_t>* filter_explain = nullptr,
+                size_t facet_sample_percent = 100,
+                size_t facet_sample_threshold = 0,
+                ThreadPool* thread_pool = nullptr) const;
 
     Option<uint32_t> remove(const uint32_t seq_id, const nlohmann::json & document);
 
@@ -368,6 +570,14 @@ public:
                                          const size_t result_index,
                                          std::unordered_map<size_t, std::vector<std::vector<uint16_t>>> &array_token_positions);
 
+    static void populate_token_positions(const std::vector<art_leaf *> &query_suggestion,
+                                         const std::vector<uint32_t*>& leaf_to_indices,
+                                         const size_t result_index,
+                                         token_positions_buffer_t& positions_buffer);
+
+    // sum of the match scores of every array element (or of the plain field) found in `positions_buffer`
+    static uint64_t get_match_score(const token_positions_buffer_t& positions_buffer, const uint32_t total_cost);
+
     static bool is_point_in_polygon(const Geofence& poly, const GeoCoord& point);
 
     static double transform_for_180th_meridian(Geofence& poly);
@@ -376,9 +586,34 @@ public:
 
     art_leaf* get_token_leaf(const std::string & field_name, const unsigned char* token, uint32_t token_len);
 
+    // positions of the tokens in the field of the document, for highlighting: the searched tokens are always
+    // looked up, while the other query tokens are only used when the document contains them. Returns false when
+    // none of the tokens are found on the field.
+    bool populate_highlight_positions(const std::string& field_name, const std::vector<std::string>& searched_tokens,
+                                      const std::vector<std::string>& q_tokens, const uint32_t seq_id,
+                                      std::unordered_map<size_t, std::vector<std::vector<uint16_t>>>& array_token_positions) const;
+
+    // art leaves handed out by searches (e.g. `searched_queries`) stay valid for as long as the guard is alive,
+    // even when concurrent writes remove them from the index
+    epoch_reclaimer_t::guard_t enter_epoch();
+
+    uint32_t do_filtering_with_lock(uint32_t** filter_ids_out, const std::vector<filter> & filters) const;
+
+    const filter_cache_t& get_filter_cache() const;
+
+    // value of a facet field behind the hash that facet counts are keyed on
+    bool get_facet_value(const std::string& field_name, uint64_t value_hash, std::string& value) const;
+
+    size_t get_facet_dictionary_size(const std::string& field_name) const;
+
     // the following methods are not synchronized because their parent calls are synchronized
 
-    uint32_t do_filtering(uint32_t** filter_ids_out, const std::vector<filter> & filters) const;
+    // When `filter_bitmap_out` is given and the filtered ids are dense, they are also returned as a bitmap.
+    // Clauses are evaluated from the one estimated to match the fewest documents, and are recorded in
+    // `filter_explain` when it is given.
+    uint32_t do_filtering(uint32_t** filter_ids_out, const std::vector<filter> & filters,
+                          id_bitmap_t** filter_bitmap_out = nullptr,
+                          std::vector<filter_explain_t>* filter_explain = nullptr) const;
 
     static Option<uint32_t> validate_index_in_memory(nlohmann::json &document, uint32_t seq_id,
                                                      const std::string & default_sorting_field,
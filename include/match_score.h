@@ -1,6 +1,7 @@
 #pragma once
 
 #include <stdint.h>
+#include <algorithm>
 #include <vector>
 #include <queue>
 #include <stdlib.h>
@@ -36,6 +37,12 @@ struct TokenOffset {
     }
 };
 
+// positions of a single token within a document, held in a buffer owned by the caller
+struct token_positions_t {
+    const uint16_t* positions;
+    size_t size;
+};
+
 struct Match {
     uint8_t words_present;
     uint8_t distance;
@@ -82,6 +89,11 @@ struct Match {
 
     template<typename T>
     void sort3(std::vector<T>& a) {
+        sort3(a.data());
+    }
+
+    template<typename T>
+    void sort3(T* a) {
         if (a[0] > a[1]) {
             if (a[1] > a[2]) {
                 return;
@@ -123,6 +135,80 @@ struct Match {
         Until queue size is 1.
     */
 
+    /*
+        Same scoring as the constructor below, without a best window: the sliding window is held in a fixed array,
+        so that scoring does not allocate. Only the first WINDOW_SIZE tokens are considered.
+    */
+
+    Match(const token_positions_t* token_positions, const size_t num_tokens) {
+        const size_t tokens_size = std::min(num_tokens, WINDOW_SIZE);
+
+        TokenOffset window[WINDOW_SIZE];
+        size_t window_size = tokens_size;
+
+        for (size_t token_id = 0; token_id < tokens_size; token_id++) {
+            window[token_id] = TokenOffset{static_cast<uint8_t>(token_id), token_positions[token_id].positions[0], 0};
+        }
+
+        size_t best_num_match = 1;
+        size_t best_displacement = MAX_DISPLACEMENT;
+
+        while (window_size > 1) {
+            if(window_size == 3) {
+                sort3<TokenOffset>(window);
+            } else {
+                std::sort(window, window + window_size, std::greater<TokenOffset>());  // descending comparator
+            }
+
+            const size_t min_offset = window[window_size - 1].offset;
+
+            // offsets within the window form a suffix of the descending window, so their displacements add up
+            // to the distance between the largest of them and the smallest offset
+            size_t this_num_match = 0;
+            size_t this_displacement = 0;
+
+            for (size_t i = 0; i < window_size; i++) {
+                if ((window[i].offset - min_offset) <= WINDOW_SIZE) {
+                    if(this_num_match == 0) {
+                        this_displacement = window[i].offset - min_offset;
+                    }
+                    this_num_match++;
+                }
+            }
+
+            if ( (this_num_match > best_num_match) ||
+                 (this_num_match == best_num_match && this_displacement < best_displacement)) {
+                best_displacement = this_displacement;
+                best_num_match = this_num_match;
+            }
+
+            if (best_num_match == tokens_size && best_displacement == (window_size - 1)) {
+                // this is the best we can get, so quit early!
+                break;
+            }
+
+            // replace the smallest offset with the next offset of the same token, if any
+            const TokenOffset smallest_offset = window[--window_size];
+            const token_positions_t& this_token_positions = token_positions[smallest_offset.token_id];
+            const uint16_t next_offset_index = (smallest_offset.offset_index + 1);
+
+            if (next_offset_index == this_token_positions.size) {
+                // no more offsets for this token
+                continue;
+            }
+
+            window[window_size++] = TokenOffset{smallest_offset.token_id,
+                                                this_token_positions.positions[next_offset_index], next_offset_index};
+        }
+
+        if (best_displacement == MAX_DISPLACEMENT) {
+            best_displacement = 0;
+        }
+
+        words_present = best_num_match;
+        distance = uint8_t(best_displacement);
+    }
+
     Match(uint32_t doc_id, const std::vector<std::vector<uint16_t>> &token_offsets, bool populate_window=true) {
         // in case if number of tokens in query is greater than max window
         const size_t tokens_size = std::min(token_offsets.size(), WINDOW_SIZE);
@@ -1,20 +1,72 @@
 #pragma once
 
-#include <map>
+#include <vector>
 #include "sparsepp.h"
 #include "sorted_array.h"
+#include "block_sorted_array.h"
 #include "array_utils.h"
 #include "art.h"
 
+/**
+ * Index of numerical values to the ids of the documents holding them.
+ *
+ * Distinct values are kept sorted in contiguous pages of at most MAX_PAGE_VALUES values, with a directory of the
+ * largest value of every page (a two-level B+-tree). Alongside the ids of each value, every page also keeps the
+ * merged ids of all its values, so a range filter takes the ids of the pages that it fully covers in one go and
+ * only looks at individual values on the two boundary pages.
+ */
 class num_tree_t {
 private:
-    std::map<int64_t, sorted_array*> int64map;
+    struct page_t {
+        std::vector<int64_t> values;            // sorted, distinct values
+        std::vector<sorted_array*> value_ids;   // ids of every value
+        block_sorted_array ids;                 // ids of all the values of the page
+
+        ~page_t() {
+            for(sorted_array* arr: value_ids) {
+                delete arr;
+            }
+        }
+    };
+
+    // values of a page are all smaller than those of the next page
+    std::vector<page_t*> pages;
+
+    // largest value of every page
+    std::vector<int64_t> page_max_values;
+
+    size_t num_values = 0;
+
+    // first page whose largest value is >= `value`, or `pages.size()` when `value` is larger than every value
+    size_t page_of(int64_t value) const;
+
+    void split_page(size_t page_index);
+
+    static void load_page_ids(page_t* page);
+
+    // appends the ids of all values within [start, end] to `ids`, unsorted
+    void collect_range(int64_t start, int64_t end, std::vector<uint32_t>& ids) const;
+
+    // number of ids of all values within [start, end], counting a document once per page that it has values in
+    size_t count_range(int64_t start, int64_t end) const;
+
+    static void merge_ids(std::vector<uint32_t>& consolidated_ids, uint32_t** ids, size_t& ids_len);
 
 public:
+    static constexpr size_t MAX_PAGE_VALUES = 64;
+
+    num_tree_t() = default;
+
+    // inclusive range of the values matched by the comparator, or false when it matches no value
+    static bool get_range(NUM_COMPARATOR comparator, int64_t value, int64_t& start, int64_t& end);
+
+    num_tree_t(const num_tree_t&) = delete;
+
+    num_tree_t& operator=(const num_tree_t&) = delete;
 
     ~num_tree_t() {
-        for(auto& kv: int64map) {
-            delete kv.second;
+        for(page_t* page: pages) {
+            delete page;
         }
     }
 
@@ -26,7 +78,13 @@ public:
 
     void search(NUM_COMPARATOR comparator, int64_t value, uint32_t** ids, size_t& ids_len);
 
+    // cheap upper bound of the number of ids that `range_inclusive_search()` would return, from the lengths of the
+    // id lists
+    size_t estimate_range(int64_t start, int64_t end) const;
+
     void remove(uint64_t value, uint32_t id);
 
     size_t size();
-};
\ No newline at end of file
+
+    size_t num_pages() const;
+};
@@ -0,0 +1,121 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "json.hpp"
+#include "threadpool.h"
+
+enum schedule_class_t {
+    // searches and other reads that a client is waiting on
+    INTERACTIVE = 0,
+    // imports, writes and deletes, including deletes by filter
+    BULK_WRITE = 1,
+    // snapshots, exports and other maintenance operations
+    BACKGROUND = 2,
+};
+
+struct schedule_limits_t {
+    // number of requests of the class that are processed at the same time
+    size_t max_concurrency;
+    // number of requests of the class that wait for a free slot, beyond which requests are rejected
+    size_t max_queue_depth;
+};
+
+class RequestScheduler;
+
+// held by a request that runs outside of the scheduler's thread pool, and frees its slot when destroyed
+class schedule_slot_t {
+private:
+    RequestScheduler* scheduler;
+    schedule_class_t schedule_class;
+
+public:
+    schedule_slot_t(RequestScheduler* scheduler, schedule_class_t schedule_class):
+            scheduler(scheduler), schedule_class(schedule_class) {
+
+    }
+
+    schedule_slot_t(const schedule_slot_t&) = delete;
+    schedule_slot_t& operator=(const schedule_slot_t&) = delete;
+
+    ~schedule_slot_t();
+};
+
+/**
+ * Admission control of requests by scheduling class. Each class has its own concurrency limit and queue depth cap:
+ * requests beyond the limit wait in the queue of their class, and requests that would go beyond the queue depth cap
+ * are rejected right away, so that a saturated class answers with a 503 instead of queueing forever.
+ *
+ * Interactive requests are dispatched to the thread pool at a high priority, ahead of the other classes.
+ */
+class RequestScheduler {
+public:
+    // task that is handed the slot it runs in: the slot is freed when the task returns, unless the task takes it over
+    typedef std::function<void(std::unique_ptr<schedule_slot_t>&)> slot_task_t;
+
+private:
+    struct queued_task_t {
+        slot_task_t task;
+        uint64_t enqueued_us;
+    };
+
+    struct class_state_t {
+        schedule_limits_t limits;
+        size_t num_running = 0;
+        std::deque<queued_task_t> queue;
+
+        uint64_t num_rejected = 0;
+        uint64_t num_started = 0;
+        uint64_t total_wait_us = 0;
+    };
+
+    mutable std::mutex mutex;
+
+    ThreadPool* thread_pool;
+
+    // slots and dispatched tasks both count as running
+    std::array<class_state_t, 3> states;
+
+    // runs the task on the thread pool, and then hands its slot over to the next queued task of the class
+    void dispatch(schedule_class_t schedule_class, slot_task_t&& task);
+
+    void on_task_done(schedule_class_t schedule_class);
+
+    static uint64_t now_us();
+
+public:
+    static constexpr size_t NUM_SCHEDULE_CLASSES = 3;
+
+    RequestScheduler(ThreadPool* thread_pool, const std::array<schedule_limits_t, NUM_SCHEDULE_CLASSES>& limits);
+
+    // returns false when the class is saturated, in which case the task is not run
+    bool submit(schedule_class_t schedule_class, std::function<void()> task);
+
+    // like `submit()`, for requests that go on after the task returns (e.g. exports that stream their response in
+    // chunks): the task can keep its slot for as long as the request lives
+    bool submit_with_slot(schedule_class_t schedule_class, slot_task_t task);
+
+    // for requests that are not run on the thread pool (e.g. writes that are applied by the raft thread): they
+    // only count against the limits of their class for as long as the returned slot is alive, which is nullptr
+    // when the class is saturated
+    std::unique_ptr<schedule_slot_t> acquire(schedule_class_t schedule_class);
+
+    void release(schedule_class_t schedule_class);
+
+    size_t get_num_running(schedule_class_t schedule_class) const;
+
+    size_t get_queue_depth(schedule_class_t schedule_class) const;
+
+    // queue depth, running requests, rejections and average queue wait of every class
+    void get_metrics(nlohmann::json& result) const;
+
+    static schedule_class_t get_schedule_class(const std::vector<std::string>& path_parts, bool is_write);
+
+    static std::string get_schedule_class_name(schedule_class_t schedule_class);
+};
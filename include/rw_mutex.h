@@ -0,0 +1,46 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+
+/**
+ * Reader/writer lock that lets neither side starve, as a drop-in for `std::shared_mutex` (it works with
+ * `std::shared_lock` and `std::unique_lock`).
+ *
+ * The `std::shared_mutex` of glibc prefers readers, so a writer only gets in once no reader holds the lock: under
+ * steady search traffic, that never happens. Here, a waiting writer keeps new readers out, and gets the lock once
+ * the readers that hold it are done. When a writer releases the lock, the readers that were waiting for it are let
+ * in ahead of the next writer, so that writers that take turns can't hold back readers either.
+ *
+ * The lock is not reentrant: a thread that holds it in shared mode must not take it again.
+ */
+class rw_mutex_t {
+private:
+    std::mutex mutex;
+    std::condition_variable readers_cv;
+    std::condition_variable writers_cv;
+
+    size_t num_readers = 0;
+    bool writer = false;
+
+    size_t num_waiting_readers = 0;
+    size_t num_waiting_writers = 0;
+
+    // readers that were waiting when the last writer released the lock, and go ahead of waiting writers
+    size_t num_admitted_readers = 0;
+
+public:
+    rw_mutex_t() = default;
+
+    rw_mutex_t(const rw_mutex_t&) = delete;
+    rw_mutex_t& operator=(const rw_mutex_t&) = delete;
+
+    void lock();
+
+    void unlock();
+
+    void lock_shared();
+
+    void unlock_shared();
+};
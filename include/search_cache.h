@@ -0,0 +1,74 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <list>
+#include <map>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include "json.hpp"
+
+/**
+ * LRU cache of search results, bounded by the memory that the results take up. Every entry is stamped with the write
+ * generation of its collection at the time the search started, and is only served while the collection is still at
+ * that generation and the entry has not outlived the TTL, so that no write to the collection has to look for the
+ * entries that it makes stale.
+ *
+ * The cache is disabled until it is given a size.
+ */
+class SearchCache {
+private:
+    struct entry_t {
+        std::string key;
+        uint64_t generation;
+        uint64_t inserted_ms;
+        nlohmann::json value;
+        size_t num_bytes;
+    };
+
+    mutable std::mutex mutex;
+
+    // most recently used entries first
+    std::list<entry_t> entries;
+    std::unordered_map<std::string, std::list<entry_t>::iterator> entry_map;
+
+    size_t max_bytes;
+    size_t num_bytes;
+    uint64_t ttl_ms;
+
+    std::atomic<uint64_t> num_hits;
+    std::atomic<uint64_t> num_misses;
+
+    static uint64_t now_ms();
+
+    void evict_until_within_limit();
+
+public:
+    SearchCache();
+
+    // a size of 0 disables the cache
+    void set_limits(size_t max_bytes, uint64_t ttl_ms);
+
+    bool is_enabled() const;
+
+    bool get(const std::string& key, uint64_t generation, nlohmann::json& value);
+
+    // a value that is larger than the whole cache is not cached
+    void insert(const std::string& key, uint64_t generation, const nlohmann::json& value);
+
+    void clear();
+
+    size_t size() const;
+
+    size_t size_bytes() const;
+
+    void get_metrics(nlohmann::json& result) const;
+
+    // canonical key of a search on the collection: the params are ordered by name, and are length prefixed so that
+    // the values can hold any character
+    static std::string get_key(uint32_t collection_id, const std::map<std::string, std::string>& params);
+
+    // heap memory held by the value, including the allocations of the containers and strings nested in it
+    static size_t get_num_bytes(const nlohmann::json& value);
+};
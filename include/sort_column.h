@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * Values of a sort field, stored in a dense array indexed by seq_id, with a bitmap of the documents that have
+ * a value (fields can be optional). Lookups while scoring are plain array loads instead of hash table probes.
+ *
+ * Documents are spread across the indices of a collection by `seq_id % stride`, so an index only ever sees every
+ * `stride`-th seq_id and stores the value of a seq_id at `seq_id / stride`.
+ */
+class sort_column_t {
+private:
+    uint32_t stride;
+    std::vector<int64_t> values;
+    std::vector<uint64_t> present;
+    size_t num_values = 0;
+
+public:
+    explicit sort_column_t(uint32_t stride = 1): stride(stride == 0 ? 1 : stride) {
+
+    }
+
+    void set(uint32_t seq_id, int64_t value);
+
+    void erase(uint32_t seq_id);
+
+    inline bool contains(uint32_t seq_id) const {
+        const uint32_t slot = seq_id / stride;
+        return (slot >> 6) < present.size() && ((present[slot >> 6] >> (slot & 63)) & 1);
+    }
+
+    // returns `default_value` when the document has no value
+    inline int64_t get(uint32_t seq_id, int64_t default_value) const {
+        return contains(seq_id) ? values[seq_id / stride] : default_value;
+    }
+
+    inline void prefetch(uint32_t seq_id) const {
+        const uint32_t slot = seq_id / stride;
+        if(slot < values.size()) {
+            __builtin_prefetch(&values[slot]);
+        }
+    }
+
+    size_t size() const;
+};
@@ -2,63 +2,259 @@
 
 #pragma once
 
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
 #include <functional>
 #include <future>
-#include <queue>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
 
+/**
+ * Work stealing thread pool: every worker has its own deques of tasks (one per priority), so that enqueueing and
+ * dequeueing tasks does not contend on a single queue lock. Tasks that are enqueued from a worker go to the deque of
+ * that worker, while the ones that are enqueued from other threads are spread across the workers. Workers take the
+ * tasks of their own deques in order, and steal from the back of the deques of other workers when theirs are empty.
+ *
+ * High priority tasks are always picked up before normal priority ones, and a thread that waits on the result of a
+ * task with `wait()` runs pending tasks in the meantime, so that nested fork/join does not tie up a worker. Only the
+ * tasks that the waiting thread itself enqueued are run that way: the waiter may hold locks that unrelated tasks
+ * (e.g. indexing batches) take, and a long unrelated task would hold up the waiter's own reply. Every thread keeps
+ * the tasks it enqueued on a list of its own, so that it finds them without going through the deques of the workers,
+ * and it blocks on the future once all of them have been taken by a worker or by itself.
+ */
 class ThreadPool {
 public:
+    enum priority_t {
+        HIGH = 0,
+        NORMAL = 1,
+    };
+
     explicit ThreadPool(size_t);
+
     template<class F, class... Args>
     decltype(auto) enqueue(F&& f, Args&&... args);
+
+    template<class F, class... Args>
+    decltype(auto) enqueue_with_priority(priority_t priority, F&& f, Args&&... args);
+
+    // runs pending tasks that the calling thread enqueued until none of them is left, and then blocks until the
+    // future is ready: since only the calling thread could enqueue more of its own tasks, none can turn up meanwhile
+    template<class T>
+    void wait(std::future<T>& future);
+
+    // runs a single pending task that the calling thread enqueued, returns false when there was none
+    bool run_own_pending_task();
+
+    size_t get_num_threads() const;
+
     void shutdown();
+
 private:
+    static constexpr size_t NUM_PRIORITIES = 2;
+
+    // a task is on the deque of a worker and on the own list of the thread that enqueued it: whichever of them
+    // claims it first runs it, while the other one just drops it
+    struct queued_task_t {
+        std::packaged_task<void()> task;
+        std::atomic<bool> claimed{false};
+    };
+
+    struct worker_queue_t {
+        std::mutex mutex;
+        std::deque<std::shared_ptr<queued_task_t>> tasks[NUM_PRIORITIES];
+    };
+
+    struct own_tasks_t {
+        std::deque<std::shared_ptr<queued_task_t>> tasks[NUM_PRIORITIES];
+    };
+
     // need to keep track of threads so we can join them
     std::vector< std::thread > workers;
-    // the task queue
-    std::queue< std::packaged_task<void()> > tasks;
+    std::vector< std::unique_ptr<worker_queue_t> > queues;
+
+    // for spreading the tasks that are enqueued from outside of the pool
+    std::atomic<size_t> next_queue;
+
+    std::atomic<size_t> num_pending;
 
-    // synchronization
-    std::mutex queue_mutex;
+    // idle workers sleep on the condition, which is only notified when some of them are sleeping
+    std::atomic<size_t> num_sleeping;
+    std::mutex sleep_mutex;
     std::condition_variable condition;
-    bool stop;
+    std::atomic<bool> stop;
+
+    // the pool and the index of the worker that the current thread runs, if any
+    static inline thread_local ThreadPool* current_pool = nullptr;
+    static inline thread_local size_t current_worker = 0;
+
+    // tasks that the current thread enqueued, by pool: only the current thread touches them, so they need no lock
+    static inline thread_local std::unordered_map<const ThreadPool*, own_tasks_t> own_tasks;
+
+    void push_task(priority_t priority, std::packaged_task<void()>&& task);
+
+    bool pop_task(size_t queue_index, std::packaged_task<void()>& task);
+
+    bool pop_own_task(std::packaged_task<void()>& task);
+
+    bool claim_task(queued_task_t& queued_task, std::packaged_task<void()>& task);
 };
 
 // the constructor just launches some amount of workers
 inline ThreadPool::ThreadPool(size_t threads)
-        :   stop(false)
+        :   next_queue(0), num_pending(0), num_sleeping(0), stop(false)
 {
+    for(size_t i = 0;i<threads;++i)
+        queues.emplace_back(new worker_queue_t);
+
     for(size_t i = 0;i<threads;++i)
         workers.emplace_back(
-                [this]
+                [this, i]
                 {
+                    current_pool = this;
+                    current_worker = i;
+
                     for(;;)
                     {
                         std::packaged_task<void()> task;
-                        {
-                            std::unique_lock<std::mutex> lock(this->queue_mutex);
-                            this->condition.wait(lock,
-                                                 [this]{ return this->stop || !this->tasks.empty(); });
-                            if(this->stop) {
-                                return;
-                            }
-
-                            if(this->tasks.empty()) {
-                                continue;
-                            }
-                            task = std::move(this->tasks.front());
-                            this->tasks.pop();
+
+                        if(pop_task(i, task)) {
+                            task();
+                            continue;
                         }
 
-                        task();
+                        std::unique_lock<std::mutex> lock(this->sleep_mutex);
+                        this->num_sleeping++;
+                        this->condition.wait(lock,
+                                             [this]{ return this->stop || this->num_pending > 0; });
+                        this->num_sleeping--;
+
+                        // tasks that were enqueued before the pool was stopped are still run
+                        if(this->stop && this->num_pending == 0) {
+                            return;
+                        }
                     }
                 }
         );
 }
 
+inline void ThreadPool::push_task(priority_t priority, std::packaged_task<void()>&& task) {
+    // don't allow enqueueing after stopping the pool
+    if(stop) {
+        return ;
+    }
+
+    const size_t queue_index = (current_pool == this) ? current_worker : (next_queue++ % queues.size());
+    worker_queue_t& queue = *queues[queue_index];
+
+    auto queued_task = std::make_shared<queued_task_t>();
+    queued_task->task = std::move(task);
+
+    // threads that never wait (e.g. the http thread) only drop the tasks that workers have claimed here
+    auto& own_list = own_tasks[this].tasks[priority];
+    while(!own_list.empty() && own_list.front()->claimed) {
+        own_list.pop_front();
+    }
+
+    own_list.push_back(queued_task);
+
+    {
+        std::unique_lock<std::mutex> lock(queue.mutex);
+        queue.tasks[priority].push_back(std::move(queued_task));
+        num_pending++;
+    }
+
+    if(num_sleeping > 0) {
+        // a worker that is about to sleep holds the lock until it waits, so the notification can't be missed
+        { std::unique_lock<std::mutex> lock(sleep_mutex); }
+        condition.notify_one();
+    }
+}
+
+inline bool ThreadPool::pop_task(size_t queue_index, std::packaged_task<void()>& task) {
+    if(num_pending == 0) {
+        return false;
+    }
+
+    for(size_t priority = 0; priority < NUM_PRIORITIES; priority++) {
+        // own tasks are taken in order, from the front
+        {
+            worker_queue_t& queue = *queues[queue_index];
+            std::unique_lock<std::mutex> lock(queue.mutex);
+            auto& tasks = queue.tasks[priority];
+
+            while(!tasks.empty()) {
+                std::shared_ptr<queued_task_t> queued_task = std::move(tasks.front());
+                tasks.pop_front();
+                if(claim_task(*queued_task, task)) {
+                    return true;
+                }
+            }
+        }
+
+        // other workers' tasks are stolen from the back
+        for(size_t i = 1; i < queues.size(); i++) {
+            worker_queue_t& queue = *queues[(queue_index + i) % queues.size()];
+            std::unique_lock<std::mutex> lock(queue.mutex);
+            auto& tasks = queue.tasks[priority];
+
+            while(!tasks.empty()) {
+                std::shared_ptr<queued_task_t> queued_task = std::move(tasks.back());
+                tasks.pop_back();
+                if(claim_task(*queued_task, task)) {
+                    return true;
+                }
+            }
+        }
+    }
+
+    return false;
+}
+
+inline bool ThreadPool::claim_task(queued_task_t& queued_task, std::packaged_task<void()>& task) {
+    if(queued_task.claimed.exchange(true)) {
+        // already run by the thread that enqueued it
+        return false;
+    }
+
+    task = std::move(queued_task.task);
+    num_pending--;
+    return true;
+}
+
+inline bool ThreadPool::pop_own_task(std::packaged_task<void()>& task) {
+    auto own_tasks_it = own_tasks.find(this);
+    if(own_tasks_it == own_tasks.end()) {
+        return false;
+    }
+
+    // the tasks that a worker has claimed already are dropped on the way, so that every task is looked at once
+    for(auto& tasks: own_tasks_it->second.tasks) {
+        while(!tasks.empty()) {
+            std::shared_ptr<queued_task_t> queued_task = std::move(tasks.front());
+            tasks.pop_front();
+            if(claim_task(*queued_task, task)) {
+                return true;
+            }
+        }
+    }
+
+    return false;
+}
+
 // add new work item to the pool
 template<class F, class... Args>
 decltype(auto) ThreadPool::enqueue(F&& f, Args&&... args)
+{
+    return enqueue_with_priority(NORMAL, std::forward<F>(f), std::forward<Args>(args)...);
+}
+
+template<class F, class... Args>
+decltype(auto) ThreadPool::enqueue_with_priority(priority_t priority, F&& f, Args&&... args)
 {
     using return_type = std::invoke_result_t<F, Args...>;
 
@@ -67,21 +263,38 @@ decltype(auto) ThreadPool::enqueue(F&& f, Args&&... args)
     );
 
     std::future<return_type> res = task.get_future();
-    {
-        std::unique_lock<std::mutex> lock(queue_mutex);
+    push_task(priority, std::packaged_task<void()>(std::move(task)));
+    return res;
+}
 
-        // don't allow enqueueing after stopping the pool
-        if(!stop) {
-            tasks.emplace(std::move(task));
+template<class T>
+void ThreadPool::wait(std::future<T>& future) {
+    while(future.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+        if(!run_own_pending_task()) {
+            // every task of this thread is running on a worker
+            future.wait();
+            return ;
         }
     }
-    condition.notify_one();
-    return res;
+}
+
+inline bool ThreadPool::run_own_pending_task() {
+    std::packaged_task<void()> task;
+    if(!pop_own_task(task)) {
+        return false;
+    }
+
+    task();
+    return true;
+}
+
+inline size_t ThreadPool::get_num_threads() const {
+    return workers.size();
 }
 
 inline void ThreadPool::shutdown() {
     {
-        std::unique_lock<std::mutex> lock(queue_mutex);
+        std::unique_lock<std::mutex> lock(sleep_mutex);
         stop = true;
     }
     condition.notify_all();
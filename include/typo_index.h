@@ -0,0 +1,47 @@
+#pragma once
+
+#include <vector>
+#include "sparsepp.h"
+#include "art.h"
+
+/**
+ * Symmetric delete (SymSpell style) dictionary over the tokens of a field's art_tree.
+ *
+ * Every token is indexed under the variants obtained by deleting up to MAX_COST of its bytes. Two tokens within an
+ * edit distance of `k` always share a variant that needs at most `k` deletions on either side, so typo candidates of
+ * a query token are found with a few hash lookups, and then verified against the same Damerau-Levenshtein (optimal
+ * string alignment) distance that art_fuzzy_search() uses.
+ *
+ * Only tokens of up to MAX_TOKEN_LEN bytes are indexed, which bounds the number of variants per token. Lookups that
+ * could match longer tokens are refused, so that the caller can fall back to art_fuzzy_search().
+ */
+class typo_index_t {
+private:
+    // hash of a delete variant => leaves of the tokens that produce the variant
+    spp::sparse_hash_map<uint64_t, std::vector<art_leaf*>> variant_leaves;
+
+    size_t num_postings = 0;
+
+    static void get_variants(const unsigned char* token, size_t token_len, int max_deletes,
+                             std::vector<uint64_t>& variant_hashes);
+
+public:
+    static constexpr int MAX_COST = 2;
+    static constexpr size_t MAX_TOKEN_LEN = 10;
+
+    void insert(art_leaf* leaf);
+
+    void remove(const art_leaf* leaf);
+
+    bool can_search(int term_len, int max_cost) const;
+
+    // `term_len` excludes the terminating \0 char. Returns false when the lookup is not supported by the index.
+    // The leaves and their order are the same as those of a non prefix art_fuzzy_search().
+    bool search(const unsigned char* term, int term_len, int min_cost, int max_cost, size_t max_words,
+                token_ordering token_order, const uint32_t* filter_ids, size_t filter_ids_length,
+                std::vector<art_leaf*>& results) const;
+
+    size_t size() const;
+
+    uint64_t memory_bytes() const;
+};
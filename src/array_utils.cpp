@@ -1,5 +1,9 @@
 #include "array_utils.h"
 #include <memory.h>
+#include <algorithm>
+#include <numeric>
+#include <vector>
+#include <immintrin.h>
 
 size_t ArrayUtils::and_scalar(const uint32_t *A, const size_t lenA,
                               const uint32_t *B, const size_t lenB, uint32_t **results) {
@@ -149,4 +153,571 @@ size_t ArrayUtils::exclude_scalar(const uint32_t *A, const size_t lenA,
   delete[] results;
 
   return res_index;
-}
\ No newline at end of file
+}
+
+// SIMD kernels store whole vectors, so their output buffers are padded by this many elements
+static constexpr size_t SIMD_PADDING = 8;
+
+static ArrayUtils::simd_level_t detect_simd_level() {
+  __builtin_cpu_init();
+  if(__builtin_cpu_supports("avx2")) {
+    return ArrayUtils::AVX2;
+  }
+
+  if(__builtin_cpu_supports("sse4.1")) {
+    return ArrayUtils::SSE41;
+  }
+
+  return ArrayUtils::SCALAR;
+}
+
+static ArrayUtils::simd_level_t simd_level = detect_simd_level();
+
+ArrayUtils::simd_level_t ArrayUtils::get_simd_level() {
+  return simd_level;
+}
+
+void ArrayUtils::set_simd_level(simd_level_t level) {
+  simd_level = std::min(level, detect_simd_level());
+}
+
+// For every 4 bit mask of matching 32-bit lanes: byte shuffle that packs the matching lanes to the front
+struct sse_pack_table_t {
+  alignas(16) uint8_t shuffles[16][16];
+
+  sse_pack_table_t() {
+    for(size_t mask = 0; mask < 16; mask++) {
+      size_t num_packed = 0;
+      memset(shuffles[mask], 0x80, 16);
+
+      for(size_t lane = 0; lane < 4; lane++) {
+        if(mask & (1 << lane)) {
+          for(size_t b = 0; b < 4; b++) {
+            shuffles[mask][num_packed * 4 + b] = lane * 4 + b;
+          }
+          num_packed++;
+        }
+      }
+    }
+  }
+};
+
+// For every 8 bit mask of matching 32-bit lanes: lane permutation that packs the matching lanes to the front
+struct avx2_pack_table_t {
+  alignas(32) uint32_t permutations[256][8];
+
+  avx2_pack_table_t() {
+    for(size_t mask = 0; mask < 256; mask++) {
+      size_t num_packed = 0;
+      memset(permutations[mask], 0, sizeof(permutations[mask]));
+
+      for(uint32_t lane = 0; lane < 8; lane++) {
+        if(mask & (1 << lane)) {
+          permutations[mask][num_packed++] = lane;
+        }
+      }
+    }
+  }
+};
+
+static const sse_pack_table_t sse_pack_table;
+static const avx2_pack_table_t avx2_pack_table;
+
+// first position at or after `pos` whose value is >= `target`
+static size_t gallop(const uint32_t *list, size_t pos, const size_t len, const uint32_t target) {
+  if(pos >= len || list[pos] >= target) {
+    return pos;
+  }
+
+  // list[low] < target <= list[high]
+  size_t low = pos;
+  size_t step = 1;
+  size_t high = pos + step;
+
+  while(high < len && list[high] < target) {
+    low = high;
+    step <<= 1;
+    high = pos + step;
+  }
+
+  high = std::min(high, len);
+  return std::lower_bound(list + low + 1, list + high, target) - list;
+}
+
+static size_t and_merge(const uint32_t *A, size_t i, const size_t lenA,
+                        const uint32_t *B, size_t j, const size_t lenB, uint32_t *out) {
+  size_t count = 0;
+
+  while(i < lenA && j < lenB) {
+    if(A[i] < B[j]) {
+      i++;
+    } else if(A[i] > B[j]) {
+      j++;
+    } else {
+      out[count++] = A[i];
+      i++;
+      j++;
+    }
+  }
+
+  return count;
+}
+
+// `small` is expected to be much shorter than `large`
+static size_t and_gallop(const uint32_t *small, const size_t lenSmall,
+                         const uint32_t *large, const size_t lenLarge, uint32_t *out) {
+  size_t count = 0;
+  size_t j = 0;
+
+  for(size_t i = 0; i < lenSmall; i++) {
+    j = gallop(large, j, lenLarge, small[i]);
+    if(j == lenLarge) {
+      break;
+    }
+
+    if(large[j] == small[i]) {
+      out[count++] = small[i];
+    }
+  }
+
+  return count;
+}
+
+// Compares every value of a block of 4 from A with every value of a block of 4 from B, and then moves on from the
+// block(s) with the smaller maximum. Matches are packed with a byte shuffle and stored as a whole vector.
+__attribute__((target("sse4.1,popcnt")))
+static size_t and_sse41(const uint32_t *A, const size_t lenA, const uint32_t *B, const size_t lenB, uint32_t *out) {
+  const size_t blocksA = lenA & ~size_t(3);
+  const size_t blocksB = lenB & ~size_t(3);
+  size_t i = 0, j = 0, count = 0;
+
+  while(i < blocksA && j < blocksB) {
+    const __m128i a = _mm_loadu_si128((const __m128i *) (A + i));
+    const __m128i b = _mm_loadu_si128((const __m128i *) (B + j));
+
+    const __m128i cmp0 = _mm_cmpeq_epi32(a, b);
+    const __m128i cmp1 = _mm_cmpeq_epi32(a, _mm_shuffle_epi32(b, _MM_SHUFFLE(0, 3, 2, 1)));
+    const __m128i cmp2 = _mm_cmpeq_epi32(a, _mm_shuffle_epi32(b, _MM_SHUFFLE(1, 0, 3, 2)));
+    const __m128i cmp3 = _mm_cmpeq_epi32(a, _mm_shuffle_epi32(b, _MM_SHUFFLE(2, 1, 0, 3)));
+    const __m128i cmp = _mm_or_si128(_mm_or_si128(cmp0, cmp1), _mm_or_si128(cmp2, cmp3));
+
+    const int mask = _mm_movemask_ps(_mm_castsi128_ps(cmp));
+    const __m128i shuffle = _mm_load_si128((const __m128i *) sse_pack_table.shuffles[mask]);
+    _mm_storeu_si128((__m128i *) (out + count), _mm_shuffle_epi8(a, shuffle));
+    count += _mm_popcnt_u32(mask);
+
+    const uint32_t maxA = A[i + 3];
+    const uint32_t maxB = B[j + 3];
+
+    if(maxA <= maxB) {
+      i += 4;
+    }
+
+    if(maxB <= maxA) {
+      j += 4;
+    }
+  }
+
+  return count + and_merge(A, i, lenA, B, j, lenB, out + count);
+}
+
+// Same scheme as `and_sse41()` on blocks of 8: the 8x8 comparisons are done against the 4 in-lane rotations of
+// B's block and of its swapped halves.
+__attribute__((target("avx2,popcnt")))
+static size_t and_avx2(const uint32_t *A, const size_t lenA, const uint32_t *B, const size_t lenB, uint32_t *out) {
+  const size_t blocksA = lenA & ~size_t(7);
+  const size_t blocksB = lenB & ~size_t(7);
+  size_t i = 0, j = 0, count = 0;
+
+  while(i < blocksA && j < blocksB) {
+    const __m256i a = _mm256_loadu_si256((const __m256i *) (A + i));
+    const __m256i b = _mm256_loadu_si256((const __m256i *) (B + j));
+    const __m256i b_swapped = _mm256_permute2x128_si256(b, b, 1);
+
+    const __m256i cmp0 = _mm256_or_si256(
+        _mm256_or_si256(_mm256_cmpeq_epi32(a, b),
+                        _mm256_cmpeq_epi32(a, _mm256_shuffle_epi32(b, _MM_SHUFFLE(0, 3, 2, 1)))),
+        _mm256_or_si256(_mm256_cmpeq_epi32(a, _mm256_shuffle_epi32(b, _MM_SHUFFLE(1, 0, 3, 2))),
+                        _mm256_cmpeq_epi32(a, _mm256_shuffle_epi32(b, _MM_SHUFFLE(2, 1, 0, 3)))));
+
+    const __m256i cmp1 = _mm256_or_si256(
+        _mm256_or_si256(_mm256_cmpeq_epi32(a, b_swapped),
+                        _mm256_cmpeq_epi32(a, _mm256_shuffle_epi32(b_swapped, _MM_SHUFFLE(0, 3, 2, 1)))),
+        _mm256_or_si256(_mm256_cmpeq_epi32(a, _mm256_shuffle_epi32(b_swapped, _MM_SHUFFLE(1, 0, 3, 2))),
+                        _mm256_cmpeq_epi32(a, _mm256_shuffle_epi32(b_swapped, _MM_SHUFFLE(2, 1, 0, 3)))));
+
+    const int mask = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_or_si256(cmp0, cmp1)));
+    const __m256i permutation = _mm256_load_si256((const __m256i *) avx2_pack_table.permutations[mask]);
+    _mm256_storeu_si256((__m256i *) (out + count), _mm256_permutevar8x32_epi32(a, permutation));
+    count += _mm_popcnt_u32(mask);
+
+    const uint32_t maxA = A[i + 7];
+    const uint32_t maxB = B[j + 7];
+
+    if(maxA <= maxB) {
+      i += 8;
+    }
+
+    if(maxB <= maxA) {
+      j += 8;
+    }
+  }
+
+  return count + and_merge(A, i, lenA, B, j, lenB, out + count);
+}
+
+// values of A[i..] not in B[j..], skipping the first 4 values of A whose bit is set in `skip_mask`
+static size_t exclude_merge(const uint32_t *A, const size_t i, const size_t lenA,
+                            const uint32_t *B, size_t j, const size_t lenB, uint32_t skip_mask, uint32_t *out) {
+  size_t count = 0;
+
+  for(size_t k = i; k < lenA; k++) {
+    if(k - i < 4 && (skip_mask & (1 << (k - i)))) {
+      continue;
+    }
+
+    j = gallop(B, j, lenB, A[k]);
+    if(j == lenB || B[j] != A[k]) {
+      out[count++] = A[k];
+    }
+  }
+
+  return count;
+}
+
+// Matches of a block of A are accumulated over all the blocks of B that overlap with it, and the values that
+// were never matched are emitted when moving on to the next block of A.
+__attribute__((target("sse4.1,popcnt")))
+static size_t exclude_sse41(const uint32_t *A, const size_t lenA, const uint32_t *B, const size_t lenB, uint32_t *out) {
+  const size_t blocksA = lenA & ~size_t(3);
+  const size_t blocksB = lenB & ~size_t(3);
+  size_t i = 0, j = 0, count = 0;
+  uint32_t matched_mask = 0;
+
+  while(i < blocksA && j < blocksB) {
+    const __m128i a = _mm_loadu_si128((const __m128i *) (A + i));
+    const __m128i b = _mm_loadu_si128((const __m128i *) (B + j));
+
+    const __m128i cmp0 = _mm_cmpeq_epi32(a, b);
+    const __m128i cmp1 = _mm_cmpeq_epi32(a, _mm_shuffle_epi32(b, _MM_SHUFFLE(0, 3, 2, 1)));
+    const __m128i cmp2 = _mm_cmpeq_epi32(a, _mm_shuffle_epi32(b, _MM_SHUFFLE(1, 0, 3, 2)));
+    const __m128i cmp3 = _mm_cmpeq_epi32(a, _mm_shuffle_epi32(b, _MM_SHUFFLE(2, 1, 0, 3)));
+    const __m128i cmp = _mm_or_si128(_mm_or_si128(cmp0, cmp1), _mm_or_si128(cmp2, cmp3));
+    matched_mask |= _mm_movemask_ps(_mm_castsi128_ps(cmp));
+
+    const uint32_t maxA = A[i + 3];
+    const uint32_t maxB = B[j + 3];
+
+    if(maxA <= maxB) {
+      const uint32_t keep_mask = ~matched_mask & 0xF;
+      const __m128i shuffle = _mm_load_si128((const __m128i *) sse_pack_table.shuffles[keep_mask]);
+      _mm_storeu_si128((__m128i *) (out + count), _mm_shuffle_epi8(a, shuffle));
+      count += _mm_popcnt_u32(keep_mask);
+      matched_mask = 0;
+      i += 4;
+    }
+
+    if(maxB <= maxA) {
+      j += 4;
+    }
+  }
+
+  return count + exclude_merge(A, i, lenA, B, j, lenB, matched_mask, out + count);
+}
+
+size_t ArrayUtils::and_values(const uint32_t *A, const size_t lenA,
+                              const uint32_t *B, const size_t lenB, uint32_t **results) {
+  if(A == nullptr || B == nullptr || lenA == 0 || lenB == 0) {
+    return 0;
+  }
+
+  if(lenA > lenB) {
+    return and_values(B, lenB, A, lenA, results);
+  }
+
+  *results = new uint32_t[lenA + SIMD_PADDING];
+
+  if(lenB / lenA >= GALLOP_RATIO) {
+    return and_gallop(A, lenA, B, lenB, *results);
+  }
+
+  switch(simd_level) {
+    case AVX2:
+      return and_avx2(A, lenA, B, lenB, *results);
+    case SSE41:
+      return and_sse41(A, lenA, B, lenB, *results);
+    default:
+      return and_merge(A, 0, lenA, B, 0, lenB, *results);
+  }
+}
+
+size_t ArrayUtils::exclude_values(const uint32_t *A, const size_t lenA,
+                                  const uint32_t *B, const size_t lenB, uint32_t **out) {
+  if(A == nullptr) {
+    *out = nullptr;
+    return 0;
+  }
+
+  if(lenB == 0 || B == nullptr) {
+    *out = new uint32_t[lenA];
+    memcpy(*out, A, lenA * sizeof(uint32_t));
+    return lenA;
+  }
+
+  *out = new uint32_t[lenA + SIMD_PADDING];
+
+  if(lenA >= GALLOP_RATIO * lenB) {
+    // copy the runs of A between the values of B
+    size_t count = 0;
+    size_t i = 0;
+
+    for(size_t j = 0; j < lenB && i < lenA; j++) {
+      const size_t pos = gallop(A, i, lenA, B[j]);
+      memcpy(*out + count, A + i, (pos - i) * sizeof(uint32_t));
+      count += pos - i;
+      i = (pos < lenA && A[pos] == B[j]) ? pos + 1 : pos;
+    }
+
+    memcpy(*out + count, A + i, (lenA - i) * sizeof(uint32_t));
+    return count + (lenA - i);
+  }
+
+  if(lenB >= GALLOP_RATIO * lenA || simd_level == SCALAR) {
+    return exclude_merge(A, 0, lenA, B, 0, lenB, 0, *out);
+  }
+
+  return exclude_sse41(A, lenA, B, lenB, *out);
+}
+
+size_t ArrayUtils::and_many(const uint32_t *const *lists, const size_t *lens, const size_t num_lists,
+                            uint32_t **out) {
+  if(num_lists == 0) {
+    return 0;
+  }
+
+  for(size_t k = 0; k < num_lists; k++) {
+    if(lists[k] == nullptr || lens[k] == 0) {
+      return 0;
+    }
+  }
+
+  if(num_lists == 1) {
+    *out = new uint32_t[lens[0]];
+    memcpy(*out, lists[0], lens[0] * sizeof(uint32_t));
+    return lens[0];
+  }
+
+  std::vector<size_t> order(num_lists);
+  std::iota(order.begin(), order.end(), 0);
+  std::sort(order.begin(), order.end(), [lens](size_t a, size_t b) { return lens[a] < lens[b]; });
+
+  // the two smallest lists are intersected directly into the output buffer, which is then narrowed down in place
+  size_t count = and_values(lists[order[0]], lens[order[0]], lists[order[1]], lens[order[1]], out);
+
+  for(size_t k = 2; k < num_lists && count != 0; k++) {
+    const uint32_t *list = lists[order[k]];
+    const size_t len = lens[order[k]];
+    size_t pos = 0;
+    size_t num_kept = 0;
+
+    for(size_t i = 0; i < count; i++) {
+      pos = gallop(list, pos, len, (*out)[i]);
+      if(pos == len) {
+        break;
+      }
+
+      if(list[pos] == (*out)[i]) {
+        (*out)[num_kept++] = (*out)[i];
+      }
+    }
+
+    count = num_kept;
+  }
+
+  return count;
+}
+
+template<class T, class S>
+static void stats_scalar(const T *values, size_t i, const size_t len, T &min, T &max, S &sum) {
+  for(; i < len; i++) {
+    min = std::min(min, values[i]);
+    max = std::max(max, values[i]);
+    sum += values[i];
+  }
+}
+
+// 32-bit lanes are widened to 64 bits for summing, so that the sum can not overflow
+__attribute__((target("sse4.1")))
+static void stats_int32_sse41(const int32_t *values, const size_t len, int32_t &min, int32_t &max, int64_t &sum) {
+  __m128i vmin = _mm_set1_epi32(values[0]);
+  __m128i vmax = vmin;
+  __m128i vsum = _mm_setzero_si128();
+
+  size_t i = 0;
+  for(; i + 4 <= len; i += 4) {
+    const __m128i v = _mm_loadu_si128((const __m128i *) (values + i));
+    vmin = _mm_min_epi32(vmin, v);
+    vmax = _mm_max_epi32(vmax, v);
+    vsum = _mm_add_epi64(vsum, _mm_cvtepi32_epi64(v));
+    vsum = _mm_add_epi64(vsum, _mm_cvtepi32_epi64(_mm_srli_si128(v, 8)));
+  }
+
+  alignas(16) int32_t mins[4], maxs[4];
+  alignas(16) int64_t sums[2];
+  _mm_store_si128((__m128i *) mins, vmin);
+  _mm_store_si128((__m128i *) maxs, vmax);
+  _mm_store_si128((__m128i *) sums, vsum);
+
+  min = *std::min_element(mins, mins + 4);
+  max = *std::max_element(maxs, maxs + 4);
+  sum = sums[0] + sums[1];
+
+  stats_scalar(values, i, len, min, max, sum);
+}
+
+__attribute__((target("avx2")))
+static void stats_int32_avx2(const int32_t *values, const size_t len, int32_t &min, int32_t &max, int64_t &sum) {
+  __m256i vmin = _mm256_set1_epi32(values[0]);
+  __m256i vmax = vmin;
+  __m256i vsum = _mm256_setzero_si256();
+
+  size_t i = 0;
+  for(; i + 8 <= len; i += 8) {
+    const __m256i v = _mm256_loadu_si256((const __m256i *) (values + i));
+    vmin = _mm256_min_epi32(vmin, v);
+    vmax = _mm256_max_epi32(vmax, v);
+    vsum = _mm256_add_epi64(vsum, _mm256_cvtepi32_epi64(_mm256_castsi256_si128(v)));
+    vsum = _mm256_add_epi64(vsum, _mm256_cvtepi32_epi64(_mm256_extracti128_si256(v, 1)));
+  }
+
+  alignas(32) int32_t mins[8], maxs[8];
+  alignas(32) int64_t sums[4];
+  _mm256_store_si256((__m256i *) mins, vmin);
+  _mm256_store_si256((__m256i *) maxs, vmax);
+  _mm256_store_si256((__m256i *) sums, vsum);
+
+  min = *std::min_element(mins, mins + 8);
+  max = *std::max_element(maxs, maxs + 8);
+  sum = sums[0] + sums[1] + sums[2] + sums[3];
+
+  stats_scalar(values, i, len, min, max, sum);
+}
+
+// 64-bit lanes are only compared from AVX2 onwards (SSE4.1 has no 64-bit compare), and are summed as scalar
+// doubles, since there is no conversion of 64-bit integer lanes to doubles before AVX-512
+__attribute__((target("avx2")))
+static void stats_int64_avx2(const int64_t *values, const size_t len, int64_t &min, int64_t &max, double &sum) {
+  __m256i vmin = _mm256_set1_epi64x(values[0]);
+  __m256i vmax = vmin;
+
+  size_t i = 0;
+  for(; i + 4 <= len; i += 4) {
+    const __m256i v = _mm256_loadu_si256((const __m256i *) (values + i));
+    vmin = _mm256_blendv_epi8(vmin, v, _mm256_cmpgt_epi64(vmin, v));
+    vmax = _mm256_blendv_epi8(vmax, v, _mm256_cmpgt_epi64(v, vmax));
+    sum += double(values[i]) + double(values[i + 1]) + double(values[i + 2]) + double(values[i + 3]);
+  }
+
+  alignas(32) int64_t mins[4], maxs[4];
+  _mm256_store_si256((__m256i *) mins, vmin);
+  _mm256_store_si256((__m256i *) maxs, vmax);
+
+  min = *std::min_element(mins, mins + 4);
+  max = *std::max_element(maxs, maxs + 4);
+
+  stats_scalar(values, i, len, min, max, sum);
+}
+
+// float lanes are widened to doubles for summing
+static void stats_float_sse2(const float *values, const size_t len, float &min, float &max, double &sum) {
+  __m128 vmin = _mm_set1_ps(values[0]);
+  __m128 vmax = vmin;
+  __m128d vsum = _mm_setzero_pd();
+
+  size_t i = 0;
+  for(; i + 4 <= len; i += 4) {
+    const __m128 v = _mm_loadu_ps(values + i);
+    vmin = _mm_min_ps(vmin, v);
+    vmax = _mm_max_ps(vmax, v);
+    vsum = _mm_add_pd(vsum, _mm_cvtps_pd(v));
+    vsum = _mm_add_pd(vsum, _mm_cvtps_pd(_mm_movehl_ps(v, v)));
+  }
+
+  alignas(16) float mins[4], maxs[4];
+  alignas(16) double sums[2];
+  _mm_store_ps(mins, vmin);
+  _mm_store_ps(maxs, vmax);
+  _mm_store_pd(sums, vsum);
+
+  min = *std::min_element(mins, mins + 4);
+  max = *std::max_element(maxs, maxs + 4);
+  sum = sums[0] + sums[1];
+
+  stats_scalar(values, i, len, min, max, sum);
+}
+
+__attribute__((target("avx2")))
+static void stats_float_avx2(const float *values, const size_t len, float &min, float &max, double &sum) {
+  __m256 vmin = _mm256_set1_ps(values[0]);
+  __m256 vmax = vmin;
+  __m256d vsum = _mm256_setzero_pd();
+
+  size_t i = 0;
+  for(; i + 8 <= len; i += 8) {
+    const __m256 v = _mm256_loadu_ps(values + i);
+    vmin = _mm256_min_ps(vmin, v);
+    vmax = _mm256_max_ps(vmax, v);
+    vsum = _mm256_add_pd(vsum, _mm256_cvtps_pd(_mm256_castps256_ps128(v)));
+    vsum = _mm256_add_pd(vsum, _mm256_cvtps_pd(_mm256_extractf128_ps(v, 1)));
+  }
+
+  alignas(32) float mins[8], maxs[8];
+  alignas(32) double sums[4];
+  _mm256_store_ps(mins, vmin);
+  _mm256_store_ps(maxs, vmax);
+  _mm256_store_pd(sums, vsum);
+
+  min = *std::min_element(mins, mins + 8);
+  max = *std::max_element(maxs, maxs + 8);
+  sum = (sums[0] + sums[1]) + (sums[2] + sums[3]);
+
+  stats_scalar(values, i, len, min, max, sum);
+}
+
+void ArrayUtils::stats_int32(const int32_t *values, const size_t len, int32_t &min, int32_t &max, int64_t &sum) {
+  switch(simd_level) {
+    case AVX2:
+      return stats_int32_avx2(values, len, min, max, sum);
+    case SSE41:
+      return stats_int32_sse41(values, len, min, max, sum);
+    default:
+      min = max = values[0];
+      sum = 0;
+      return stats_scalar(values, 0, len, min, max, sum);
+  }
+}
+
+void ArrayUtils::stats_int64(const int64_t *values, const size_t len, int64_t &min, int64_t &max, double &sum) {
+  sum = 0;
+
+  if(simd_level == AVX2) {
+    return stats_int64_avx2(values, len, min, max, sum);
+  }
+
+  min = max = values[0];
+  stats_scalar(values, 0, len, min, max, sum);
+}
+
+void ArrayUtils::stats_float(const float *values, const size_t len, float &min, float &max, double &sum) {
+  switch(simd_level) {
+    case AVX2:
+      return stats_float_avx2(values, len, min, max, sum);
+    case SSE41:
+      // SSE2 is part of x86-64, and the float kernel needs nothing beyond it
+      return stats_float_sse2(values, len, min, max, sum);
+    default:
+      min = max = values[0];
+      sum = 0;
+      return stats_scalar(values, 0, len, min, max, sum);
+  }
+}
@@ -11,6 +11,9 @@
 #include <iostream>
 #include <limits>
 #include <queue>
+#include <string>
+#include <unordered_map>
+#include <vector>
 #include <stdint.h>
 #include "art.h"
 #include "logger.h"
@@ -41,12 +44,25 @@ void art_int_fuzzy_recurse(art_node *n, int depth, const unsigned char* int_str,
 
 static void insert_and_shift_offset_index(sorted_array& offset_index, const uint32_t index, const uint32_t num_offsets);
 
+bool compare_art_leaf_key(const art_leaf *a, const art_leaf *b) {
+    const int cmp = memcmp(a->key, b->key, std::min(a->key_len, b->key_len));
+    return (cmp != 0) ? (cmp < 0) : (a->key_len < b->key_len);
+}
+
 bool compare_art_leaf_frequency(const art_leaf *a, const art_leaf *b) {
-    return a->values->ids.getLength() > b->values->ids.getLength();
+    if(a->values->ids.getLength() != b->values->ids.getLength()) {
+        return a->values->ids.getLength() > b->values->ids.getLength();
+    }
+
+    return compare_art_leaf_key(a, b);
 }
 
 bool compare_art_leaf_score(const art_leaf *a, const art_leaf *b) {
-    return a->max_score > b->max_score;
+    if(a->max_score != b->max_score) {
+        return a->max_score > b->max_score;
+    }
+
+    return compare_art_leaf_key(a, b);
 }
 
 bool compare_art_node_frequency(const art_node *a, const art_node *b) {
@@ -93,33 +109,129 @@ bool compare_art_node_score_pq(const art_node* a, const art_node* b) {
     return !compare_art_node_score(a, b);
 }
 
-/**
- * Allocates a node of the given type,
- * initializes to zero and sets the type.
- */
-static art_node* alloc_node(uint8_t type) {
-    art_node* n;
+static_assert(sizeof(art_node256) <= ART_ARENA_MAX_BLOCK_SIZE, "art_node256 must fit in an arena block");
+static_assert(MAX_PREFIX_LEN == sizeof(uint64_t), "partial prefix is compared as a single word");
+
+static void arena_init(art_arena *a) {
+    memset(a, 0, sizeof(art_arena));
+}
+
+static inline size_t arena_size_class(size_t size) {
+    return (size + ART_ARENA_ALIGN - 1) / ART_ARENA_ALIGN;
+}
+
+static void arena_new_slab(art_arena *a) {
+    // recycle the unused tail of the current slab before moving on
+    size_t remaining = a->slab_end - a->slab_pos;
+    if (remaining != 0) {
+        size_t size_class = remaining / ART_ARENA_ALIGN;
+        *(void**) a->slab_pos = a->free_lists[size_class];
+        a->free_lists[size_class] = a->slab_pos;
+    }
+
+    uint8_t *slab = (uint8_t *) malloc(ART_ARENA_SLAB_SIZE);
+    if (slab == NULL) {
+        abort();
+    }
+
+    // first block of every slab links to the previous slab
+    *(void**) slab = a->slabs;
+    a->slabs = slab;
+    a->slab_pos = slab + ART_ARENA_ALIGN;
+    a->slab_end = slab + ART_ARENA_SLAB_SIZE;
+    a->reserved_bytes += ART_ARENA_SLAB_SIZE;
+}
+
+static void* arena_alloc(art_arena *a, size_t size) {
+    size_t size_class = arena_size_class(size);
+    size_t block_size = size_class * ART_ARENA_ALIGN;
+
+    if (size_class >= ART_ARENA_NUM_CLASSES) {
+        void *block = malloc(block_size);
+        if (block == NULL) {
+            abort();
+        }
+        a->reserved_bytes += block_size;
+        return block;
+    }
+
+    void *block = a->free_lists[size_class];
+    if (block) {
+        a->free_lists[size_class] = *(void**) block;
+        return block;
+    }
+
+    if ((size_t)(a->slab_end - a->slab_pos) < block_size) {
+        arena_new_slab(a);
+    }
+
+    block = a->slab_pos;
+    a->slab_pos += block_size;
+    return block;
+}
+
+static void arena_free(art_arena *a, void *block, size_t size) {
+    size_t size_class = arena_size_class(size);
+    size_t block_size = size_class * ART_ARENA_ALIGN;
+
+    if (size_class >= ART_ARENA_NUM_CLASSES) {
+        a->reserved_bytes -= block_size;
+        free(block);
+        return;
+    }
+
+    *(void**) block = a->free_lists[size_class];
+    a->free_lists[size_class] = block;
+}
+
+// Releases all slabs at once: blocks handed out from them must not be used afterwards
+static void arena_release(art_arena *a) {
+    void *slab = a->slabs;
+    while (slab) {
+        void *next = *(void**) slab;
+        free(slab);
+        slab = next;
+    }
+
+    arena_init(a);
+}
+
+static size_t node_size(uint8_t type) {
     switch (type) {
         case NODE4:
-            n = (art_node *) calloc(1, sizeof(art_node4));
-            break;
+            return sizeof(art_node4);
         case NODE16:
-            n = (art_node *) calloc(1, sizeof(art_node16));
-            break;
+            return sizeof(art_node16);
         case NODE48:
-            n = (art_node *) calloc(1, sizeof(art_node48));
-            break;
+            return sizeof(art_node48);
         case NODE256:
-            n = (art_node *) calloc(1, sizeof(art_node256));
-            break;
+            return sizeof(art_node256);
         default:
             abort();
     }
+}
+
+/**
+ * Allocates a node of the given type,
+ * initializes to zero and sets the type.
+ */
+static art_node* alloc_node(art_arena *a, uint8_t type) {
+    size_t size = node_size(type);
+    art_node* n = (art_node *) arena_alloc(a, size);
+    memset(n, 0, size);
     n->type = type;
     n->max_score = 0;
     return n;
 }
 
+static void free_node(art_arena *a, art_node *n) {
+    arena_free(a, n, node_size(n->type));
+}
+
+static void free_leaf(art_arena *a, art_leaf *l) {
+    arena_free(a, l, sizeof(art_leaf) + l->key_len);
+}
+
 /**
  * Initializes an ART tree
  * @return 0 on success.
@@ -127,11 +239,16 @@ static art_node* alloc_node(uint8_t type) {
 int art_tree_init(art_tree *t) {
     t->root = NULL;
     t->size = 0;
+    arena_init(&t->arena);
     return 0;
 }
 
+uint64_t art_arena_bytes(const art_tree *t) {
+    return t->arena.reserved_bytes;
+}
+
 // Recursively destroys the tree
-static void destroy_node(art_node *n) {
+static void destroy_node(art_arena *a, art_node *n) {
     // Break if null
     if (!n) return;
 
@@ -139,7 +256,7 @@ static void destroy_node(art_node *n) {
     if (IS_LEAF(n)) {
         art_leaf *leaf = (art_leaf *) LEAF_RAW(n);
         delete leaf->values;
-        free(leaf);
+        free_leaf(a, leaf);
         return;
     }
 
@@ -155,21 +272,21 @@ static void destroy_node(art_node *n) {
         case NODE4:
             p.p1 = (art_node4*)n;
             for (i=0;i<n->num_children;i++) {
-                destroy_node(p.p1->children[i]);
+                destroy_node(a, p.p1->children[i]);
             }
             break;
 
         case NODE16:
             p.p2 = (art_node16*)n;
             for (i=0;i<n->num_children;i++) {
-                destroy_node(p.p2->children[i]);
+                destroy_node(a, p.p2->children[i]);
             }
             break;
 
         case NODE48:
             p.p3 = (art_node48*)n;
             for (i=0;i<48;i++) {
-                destroy_node(p.p3->children[i]);
+                destroy_node(a, p.p3->children[i]);
             }
             break;
 
@@ -177,7 +294,7 @@ static void destroy_node(art_node *n) {
             p.p4 = (art_node256*)n;
             for (i=0;i<256;i++) {
                 if (p.p4->children[i])
-                    destroy_node(p.p4->children[i]);
+                    destroy_node(a, p.p4->children[i]);
             }
             break;
 
@@ -185,8 +302,7 @@ static void destroy_node(art_node *n) {
             abort();
     }
 
-    // Free ourself on the way up
-    free(n);
+    // Node memory is released in bulk along with the arena's slabs
 }
 
 /**
@@ -194,7 +310,10 @@ static void destroy_node(art_node *n) {
  * @return 0 on success.
  */
 int art_tree_destroy(art_tree *t) {
-    destroy_node(t->root);
+    destroy_node(&t->arena, t->root);
+    arena_release(&t->arena);
+    t->root = NULL;
+    t->size = 0;
     return 0;
 }
 
@@ -210,8 +329,29 @@ void compare_and_match_leaf(const unsigned char *int_str, int int_str_len, const
 
 #endif
 
+static art_simd_level detect_simd_level() {
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("sse2")) {
+        return ART_SIMD_SSE2;
+    }
+
+    return ART_SIMD_SCALAR;
+}
+
+static art_simd_level simd_level = detect_simd_level();
+
+art_simd_level art_get_simd_level() {
+    return simd_level;
+}
+
+void art_set_simd_level(art_simd_level level) {
+    simd_level = (level == ART_SIMD_SCALAR) ? ART_SIMD_SCALAR : detect_simd_level();
+}
+
 static art_node** find_child(art_node *n, unsigned char c) {
     int i, mask, bitfield;
+    int32_t keys4;
+    __m128i cmp;
     union {
         art_node4 *p1;
         art_node16 *p2;
@@ -221,35 +361,50 @@ static art_node** find_child(art_node *n, unsigned char c) {
     switch (n->type) {
         case NODE4:
             p.p1 = (art_node4*)n;
-            for (i=0;i < n->num_children; i++) {
-                if (p.p1->keys[i] == c)
-                    return &p.p1->children[i];
+            if (simd_level == ART_SIMD_SCALAR) {
+                for (i=0;i < n->num_children; i++) {
+                    if (p.p1->keys[i] == c)
+                        return &p.p1->children[i];
+                }
+                break;
             }
+
+            // Compare the key to all 4 stored keys at once
+            memcpy(&keys4, p.p1->keys, sizeof(keys4));
+            cmp = _mm_cmpeq_epi8(_mm_set1_epi8(c), _mm_cvtsi32_si128(keys4));
+            mask = (1 << n->num_children) - 1;
+            bitfield = _mm_movemask_epi8(cmp) & mask;
+            if (bitfield)
+                return &p.p1->children[__builtin_ctz(bitfield)];
             break;
 
-            {
-                __m128i cmp;
-                case NODE16:
-                    p.p2 = (art_node16*)n;
-
-                // Compare the key to all 16 stored keys
-                cmp = _mm_cmpeq_epi8(_mm_set1_epi8(c),
-                                     _mm_loadu_si128((__m128i*)p.p2->keys));
-
-                // Use a mask to ignore children that don't exist
-                mask = (1 << n->num_children) - 1;
-                bitfield = _mm_movemask_epi8(cmp) & mask;
-
-                /*
-                 * If we have a match (any bit set) then we can
-                 * return the pointer match using ctz to get
-                 * the index.
-                 */
-                if (bitfield)
-                    return &p.p2->children[__builtin_ctz(bitfield)];
+        case NODE16:
+            p.p2 = (art_node16*)n;
+            if (simd_level == ART_SIMD_SCALAR) {
+                for (i=0;i < n->num_children; i++) {
+                    if (p.p2->keys[i] == c)
+                        return &p.p2->children[i];
+                }
                 break;
             }
 
+            // Compare the key to all 16 stored keys
+            cmp = _mm_cmpeq_epi8(_mm_set1_epi8(c),
+                                 _mm_loadu_si128((__m128i*)p.p2->keys));
+
+            // Use a mask to ignore children that don't exist
+            mask = (1 << n->num_children) - 1;
+            bitfield = _mm_movemask_epi8(cmp) & mask;
+
+            /*
+             * If we have a match (any bit set) then we can
+             * return the pointer match using ctz to get
+             * the index.
+             */
+            if (bitfield)
+                return &p.p2->children[__builtin_ctz(bitfield)];
+            break;
+
         case NODE48:
             p.p3 = (art_node48*)n;
             i = p.p3->keys[c];
@@ -280,6 +435,23 @@ static inline int min(int a, int b) {
  */
 static int check_prefix(const art_node *n, const unsigned char *key, int key_len, int depth) {
     int max_cmp = min(min(n->partial_len, MAX_PREFIX_LEN), key_len - depth);
+
+    if (simd_level != ART_SIMD_SCALAR && max_cmp > 1) {
+        // Compare the whole partial prefix as a single word: the first differing
+        // byte is given by the lowest set bit of the XOR (x86 is little endian).
+        // The key is copied since it need not have MAX_PREFIX_LEN readable bytes.
+        uint64_t partial, key_word = 0;
+        memcpy(&partial, n->partial, sizeof(partial));
+        memcpy(&key_word, key + depth, max_cmp);
+
+        uint64_t diff = (partial ^ key_word);
+        if (max_cmp < MAX_PREFIX_LEN) {
+            diff &= (uint64_t(1) << (max_cmp * 8)) - 1;
+        }
+
+        return diff ? (__builtin_ctzll(diff) >> 3) : max_cmp;
+    }
+
     int idx;
     for (idx=0; idx < max_cmp; idx++) {
         if (n->partial[idx] != key[depth+idx])
@@ -451,8 +623,8 @@ void insert_and_shift_offset_index(sorted_array& offset_index, const uint32_t in
     delete [] curr_array;
 }
 
-static art_leaf* make_leaf(const unsigned char *key, uint32_t key_len, art_document *document) {
-    art_leaf *l = (art_leaf *) malloc(sizeof(art_leaf) + key_len);
+static art_leaf* make_leaf(art_arena *a, const unsigned char *key, uint32_t key_len, art_document *document) {
+    art_leaf *l = (art_leaf *) arena_alloc(a, sizeof(art_leaf) + key_len);
     l->values = new art_values;
     l->max_score = 0;
     l->key_len = key_len;
@@ -485,7 +657,7 @@ static void add_child256(art_node256 *n, art_node **ref, unsigned char c, void *
     n->n.max_score = MAX(n->n.max_score, ((art_leaf *) LEAF_RAW(child))->max_score);
 }
 
-static void add_child48(art_node48 *n, art_node **ref, unsigned char c, void *child) {
+static void add_child48(art_arena *a, art_node48 *n, art_node **ref, unsigned char c, void *child) {
     if (n->n.num_children < 48) {
         int pos = 0;
         while (n->children[pos]) pos++;
@@ -494,7 +666,7 @@ static void add_child48(art_node48 *n, art_node **ref, unsigned char c, void *ch
         n->n.num_children++;
         n->n.max_score = MAX(n->n.max_score, ((art_leaf *) LEAF_RAW(child))->max_score);
     } else {
-        art_node256 *new_n = (art_node256*)alloc_node(NODE256);
+        art_node256 *new_n = (art_node256*)alloc_node(a, NODE256);
         for (int i=0;i<256;i++) {
             if (n->keys[i]) {
                 new_n->children[i] = n->children[n->keys[i] - 1];
@@ -502,12 +674,12 @@ static void add_child48(art_node48 *n, art_node **ref, unsigned char c, void *ch
         }
         copy_header((art_node*)new_n, (art_node*)n);
         *ref = (art_node*)new_n;
-        free(n);
+        free_node(a, (art_node *) n);
         add_child256(new_n, ref, c, child);
     }
 }
 
-static void add_child16(art_node16 *n, art_node **ref, unsigned char c, void *child) {
+static void add_child16(art_arena *a, art_node16 *n, art_node **ref, unsigned char c, void *child) {
     if (n->n.num_children < 16) {
         __m128i cmp;
 
@@ -536,7 +708,7 @@ static void add_child16(art_node16 *n, art_node **ref, unsigned char c, void *ch
         n->n.max_score = MAX(n->n.max_score, ((art_leaf *) LEAF_RAW(child))->max_score);
 
     } else {
-        art_node48 *new_n = (art_node48*)alloc_node(NODE48);
+        art_node48 *new_n = (art_node48*)alloc_node(a, NODE48);
 
         // Copy the child pointers and populate the key map
         memcpy(new_n->children, n->children,
@@ -546,12 +718,12 @@ static void add_child16(art_node16 *n, art_node **ref, unsigned char c, void *ch
         }
         copy_header((art_node*)new_n, (art_node*)n);
         *ref = (art_node*)new_n;
-        free(n);
-        add_child48(new_n, ref, c, child);
+        free_node(a, (art_node *) n);
+        add_child48(a, new_n, ref, c, child);
     }
 }
 
-static void add_child4(art_node4 *n, art_node **ref, unsigned char c, void *child) {
+static void add_child4(art_arena *a, art_node4 *n, art_node **ref, unsigned char c, void *child) {
     if (n->n.num_children < 4) {
         int idx;
         for (idx=0; idx < n->n.num_children; idx++) {
@@ -569,7 +741,7 @@ static void add_child4(art_node4 *n, art_node **ref, unsigned char c, void *chil
         n->n.max_score = MAX(n->n.max_score, ((art_leaf *) LEAF_RAW(child))->max_score);
 
     } else {
-        art_node16 *new_n = (art_node16*)alloc_node(NODE16);
+        art_node16 *new_n = (art_node16*)alloc_node(a, NODE16);
 
         // Copy the child pointers and the key map
         memcpy(new_n->children, n->children,
@@ -578,19 +750,19 @@ static void add_child4(art_node4 *n, art_node **ref, unsigned char c, void *chil
                 sizeof(unsigned char)*n->n.num_children);
         copy_header((art_node*)new_n, (art_node*)n);
         *ref = (art_node*)new_n;
-        free(n);
-        add_child16(new_n, ref, c, child);
+        free_node(a, (art_node *) n);
+        add_child16(a, new_n, ref, c, child);
     }
 }
 
-static void add_child(art_node *n, art_node **ref, unsigned char c, void *child) {
+static void add_child(art_arena *a, art_node *n, art_node **ref, unsigned char c, void *child) {
     switch (n->type) {
         case NODE4:
-            return add_child4((art_node4*)n, ref, c, child);
+            return add_child4(a, (art_node4*)n, ref, c, child);
         case NODE16:
-            return add_child16((art_node16*)n, ref, c, child);
+            return add_child16(a, (art_node16*)n, ref, c, child);
         case NODE48:
-            return add_child48((art_node48*)n, ref, c, child);
+            return add_child48(a, (art_node48*)n, ref, c, child);
         case NODE256:
             return add_child256((art_node256*)n, ref, c, child);
         default:
@@ -603,10 +775,9 @@ static void add_child(art_node *n, art_node **ref, unsigned char c, void *child)
  */
 static int prefix_mismatch(const art_node *n, const unsigned char *key, int key_len, int depth) {
     int max_cmp = min(min(MAX_PREFIX_LEN, n->partial_len), key_len - depth);
-    int idx;
-    for (idx=0; idx < max_cmp; idx++) {
-        if (n->partial[idx] != key[depth+idx])
-            return idx;
+    int idx = check_prefix(n, key, key_len, depth);
+    if (idx < max_cmp) {
+        return idx;
     }
 
     // If the prefix is short we can avoid finding a leaf
@@ -622,10 +793,10 @@ static int prefix_mismatch(const art_node *n, const unsigned char *key, int key_
     return idx;
 }
 
-static void* recursive_insert(art_node *n, art_node **ref, const unsigned char *key, uint32_t key_len, art_document *document, uint32_t num_hits, int depth, int *old) {
+static void* recursive_insert(art_arena *a, art_node *n, art_node **ref, const unsigned char *key, uint32_t key_len, art_document *document, uint32_t num_hits, int depth, int *old) {
     // If we are at a NULL node, inject a leaf
     if (!n) {
-        *ref = (art_node*)SET_LEAF(make_leaf(key, key_len, document));
+        *ref = (art_node*)SET_LEAF(make_leaf(a, key, key_len, document));
         return NULL;
     }
 
@@ -647,10 +818,10 @@ static void* recursive_insert(art_node *n, art_node **ref, const unsigned char *
         }
 
         // New value, we must split the leaf into a node4
-        art_node4 *new_n = (art_node4*)alloc_node(NODE4);
+        art_node4 *new_n = (art_node4*)alloc_node(a, NODE4);
 
         // Create a new leaf
-        art_leaf *l2 = make_leaf(key, key_len, document);
+        art_leaf *l2 = make_leaf(a, key, key_len, document);
 
         uint32_t longest_prefix = longest_common_prefix(l, l2, depth);
         new_n->n.partial_len = longest_prefix;
@@ -658,8 +829,8 @@ static void* recursive_insert(art_node *n, art_node **ref, const unsigned char *
 
         // Add the leafs to the new node4
         *ref = (art_node*)new_n;
-        add_child4(new_n, ref, l->key[depth+longest_prefix], SET_LEAF(l));
-        add_child4(new_n, ref, l2->key[depth+longest_prefix], SET_LEAF(l2));
+        add_child4(a, new_n, ref, l->key[depth+longest_prefix], SET_LEAF(l));
+        add_child4(a, new_n, ref, l2->key[depth+longest_prefix], SET_LEAF(l2));
         return NULL;
     }
 
@@ -675,28 +846,28 @@ static void* recursive_insert(art_node *n, art_node **ref, const unsigned char *
         }
 
         // Create a new node
-        art_node4 *new_n = (art_node4*)alloc_node(NODE4);
+        art_node4 *new_n = (art_node4*)alloc_node(a, NODE4);
         *ref = (art_node*)new_n;
         new_n->n.partial_len = prefix_diff;
         memcpy(new_n->n.partial, n->partial, min(MAX_PREFIX_LEN, prefix_diff));
 
         // Adjust the prefix of the old node
         if (n->partial_len <= MAX_PREFIX_LEN) {
-            add_child4(new_n, ref, n->partial[prefix_diff], n);
+            add_child4(a, new_n, ref, n->partial[prefix_diff], n);
             n->partial_len -= (prefix_diff+1);
             memmove(n->partial, n->partial+prefix_diff+1,
                     min(MAX_PREFIX_LEN, n->partial_len));
         } else {
             n->partial_len -= (prefix_diff+1);
             art_leaf *l = minimum(n);
-            add_child4(new_n, ref, l->key[depth+prefix_diff], n);
+            add_child4(a, new_n, ref, l->key[depth+prefix_diff], n);
             memcpy(n->partial, l->key+depth+prefix_diff+1,
                    min(MAX_PREFIX_LEN, n->partial_len));
         }
 
         // Insert the new leaf
-        art_leaf *l = make_leaf(key, key_len, document);
-        add_child4(new_n, ref, key[depth+prefix_diff], SET_LEAF(l));
+        art_leaf *l = make_leaf(a, key, key_len, document);
+        add_child4(a, new_n, ref, key[depth+prefix_diff], SET_LEAF(l));
         return NULL;
     }
 
@@ -705,12 +876,12 @@ static void* recursive_insert(art_node *n, art_node **ref, const unsigned char *
     // Find a child to recurse to
     art_node **child = find_child(n, key[depth]);
     if (child) {
-        return recursive_insert(*child, child, key, key_len, document, num_hits, depth + 1, old);
+        return recursive_insert(a, *child, child, key, key_len, document, num_hits, depth + 1, old);
     }
 
     // No child, node goes within us
-    art_leaf *l = make_leaf(key, key_len, document);
-    add_child(n, ref, key[depth], SET_LEAF(l));
+    art_leaf *l = make_leaf(a, key, key_len, document);
+    add_child(a, n, ref, key[depth], SET_LEAF(l));
     return NULL;
 }
 
@@ -726,19 +897,19 @@ static void* recursive_insert(art_node *n, art_node **ref, const unsigned char *
 void* art_insert(art_tree *t, const unsigned char *key, int key_len, art_document* document, uint32_t num_hits) {
     int old_val = 0;
 
-    void *old = recursive_insert(t->root, &t->root, key, key_len, document, num_hits, 0, &old_val);
+    void *old = recursive_insert(&t->arena, t->root, &t->root, key, key_len, document, num_hits, 0, &old_val);
     if (!old_val) t->size++;
     return old;
 }
 
-static void remove_child256(art_node256 *n, art_node **ref, unsigned char c) {
+static void remove_child256(art_arena *a, art_node256 *n, art_node **ref, unsigned char c) {
     n->children[c] = NULL;
     n->n.num_children--;
 
     // Resize to a node48 on underflow, not immediately to prevent
     // trashing if we sit on the 48/49 boundary
     if (n->n.num_children == 37) {
-        art_node48 *new_n = (art_node48*)alloc_node(NODE48);
+        art_node48 *new_n = (art_node48*)alloc_node(a, NODE48);
         *ref = (art_node*)new_n;
         copy_header((art_node*)new_n, (art_node*)n);
 
@@ -750,18 +921,18 @@ static void remove_child256(art_node256 *n, art_node **ref, unsigned char c) {
                 pos++;
             }
         }
-        free(n);
+        free_node(a, (art_node *) n);
     }
 }
 
-static void remove_child48(art_node48 *n, art_node **ref, unsigned char c) {
+static void remove_child48(art_arena *a, art_node48 *n, art_node **ref, unsigned char c) {
     int pos = n->keys[c];
     n->keys[c] = 0;
     n->children[pos-1] = NULL;
     n->n.num_children--;
 
     if (n->n.num_children == 12) {
-        art_node16 *new_n = (art_node16*)alloc_node(NODE16);
+        art_node16 *new_n = (art_node16*)alloc_node(a, NODE16);
         *ref = (art_node*)new_n;
         copy_header((art_node*)new_n, (art_node*)n);
 
@@ -774,27 +945,27 @@ static void remove_child48(art_node48 *n, art_node **ref, unsigned char c) {
                 child++;
             }
         }
-        free(n);
+        free_node(a, (art_node *) n);
     }
 }
 
-static void remove_child16(art_node16 *n, art_node **ref, art_node **l) {
+static void remove_child16(art_arena *a, art_node16 *n, art_node **ref, art_node **l) {
     int pos = l - n->children;
     memmove(n->keys+pos, n->keys+pos+1, n->n.num_children - 1 - pos);
     memmove(n->children+pos, n->children+pos+1, (n->n.num_children - 1 - pos)*sizeof(void*));
     n->n.num_children--;
 
     if (n->n.num_children == 3) {
-        art_node4 *new_n = (art_node4*)alloc_node(NODE4);
+        art_node4 *new_n = (art_node4*)alloc_node(a, NODE4);
         *ref = (art_node*)new_n;
         copy_header((art_node*)new_n, (art_node*)n);
         memcpy(new_n->keys, n->keys, 4);
         memcpy(new_n->children, n->children, 4*sizeof(void*));
-        free(n);
+        free_node(a, (art_node *) n);
     }
 }
 
-static void remove_child4(art_node4 *n, art_node **ref, art_node **l) {
+static void remove_child4(art_arena *a, art_node4 *n, art_node **ref, art_node **l) {
     int pos = l - n->children;
     memmove(n->keys+pos, n->keys+pos+1, n->n.num_children - 1 - pos);
     memmove(n->children+pos, n->children+pos+1, (n->n.num_children - 1 - pos)*sizeof(void*));
@@ -821,26 +992,26 @@ static void remove_child4(art_node4 *n, art_node **ref, art_node **l) {
             child->partial_len += n->n.partial_len + 1;
         }
         *ref = child;
-        free(n);
+        free_node(a, (art_node *) n);
     }
 }
 
-static void remove_child(art_node *n, art_node **ref, unsigned char c, art_node **l) {
+static void remove_child(art_arena *a, art_node *n, art_node **ref, unsigned char c, art_node **l) {
     switch (n->type) {
         case NODE4:
-            return remove_child4((art_node4*)n, ref, l);
+            return remove_child4(a, (art_node4*)n, ref, l);
         case NODE16:
-            return remove_child16((art_node16*)n, ref, l);
+            return remove_child16(a, (art_node16*)n, ref, l);
         case NODE48:
-            return remove_child48((art_node48*)n, ref, c);
+            return remove_child48(a, (art_node48*)n, ref, c);
         case NODE256:
-            return remove_child256((art_node256*)n, ref, c);
+            return remove_child256(a, (art_node256*)n, ref, c);
         default:
             abort();
     }
 }
 
-static art_leaf* recursive_delete(art_node *n, art_node **ref, const unsigned char *key, int key_len, int depth) {
+static art_leaf* recursive_delete(art_arena *a, art_node *n, art_node **ref, const unsigned char *key, int key_len, int depth) {
     // Search terminated
     if (!n) return NULL;
 
@@ -876,14 +1047,14 @@ static art_leaf* recursive_delete(art_node *n, art_node **ref, const unsigned ch
     if (IS_LEAF(*child)) {
         art_leaf *l = (art_leaf *) LEAF_RAW(*child);
         if (!leaf_matches(l, key, key_len, depth)) {
-            remove_child(n, ref, key[depth], child);
+            remove_child(a, n, ref, key[depth], child);
             return l;
         }
         return NULL;
 
         // Recurse
     } else {
-        return recursive_delete(*child, child, key, key_len, depth+1);
+        return recursive_delete(a, *child, child, key, key_len, depth+1);
     }
 }
 
@@ -896,16 +1067,30 @@ static art_leaf* recursive_delete(art_node *n, art_node **ref, const unsigned ch
  * the value pointer is returned.
  */
 void* art_delete(art_tree *t, const unsigned char *key, int key_len) {
-    art_leaf *l = recursive_delete(t->root, &t->root, key, key_len, 0);
+    art_leaf *l = recursive_delete(&t->arena, t->root, &t->root, key, key_len, 0);
     if (l) {
         t->size--;
         void *old = l->values;
-        free(l);
+        free_leaf(&t->arena, l);
         return old;
     }
     return NULL;
 }
 
+art_leaf* art_detach(art_tree *t, const unsigned char *key, int key_len) {
+    art_leaf *l = recursive_delete(&t->arena, t->root, &t->root, key, key_len, 0);
+    if (l) {
+        t->size--;
+    }
+    return l;
+}
+
+void art_free_leaf(art_tree *t, art_leaf *l) {
+    delete l->values;
+    l->values = NULL;
+    free_leaf(&t->arena, l);
+}
+
 /*static uint32_t get_score(art_node* child) {
     if (IS_LEAF(child)) {
         art_leaf *l = (art_leaf *) LEAF_RAW(child);
@@ -1409,33 +1594,294 @@ static void art_fuzzy_recurse(unsigned char p, unsigned char c, const art_node *
     art_fuzzy_children(c, n, depth, term, term_len, rows[i], rows[j], min_cost, max_cost, prefix, results);
 }
 
+/*
+ * Levenshtein automaton for a single search term, compiled lazily while the tree is walked.
+ *
+ * A state stands for the last two rows of the matrix that levenshtein_dist() maintains, with every cell clipped to
+ * `2*max_cost + 1`: no decision made during traversal looks at a cost beyond `2*max_cost`, so clipping does not
+ * change any result but keeps the number of states finite. A transition only depends on which term character the
+ * incoming char is equal to and, for transpositions, which term character the previous char is equal to. Characters
+ * are therefore mapped to classes up-front and a transition computed once is a table lookup for every other edge of
+ * the tree that makes the same move.
+ */
+struct art_fuzzy_dfa {
+    const int columns;
+    const int max_cell;
+    int num_classes;
+    uint8_t char_class[256];
+    std::vector<uint8_t> term_class;
+
+    std::vector<uint8_t> state_rows;     // irow followed by jrow for each state
+    std::vector<uint8_t> state_costs;    // minimum of jrow over the term columns, i.e. levenshtein_dist()'s return
+    std::vector<int> transitions;        // `num_classes * num_classes` slots per state, -1 until computed
+    std::unordered_map<std::string, int> state_ids;
+
+    art_fuzzy_dfa(const unsigned char *term, const int term_len, const int max_cost):
+            columns(term_len + 1), max_cell(2 * max_cost + 1), num_classes(1), term_class(term_len) {
+        memset(char_class, 0, sizeof(char_class));
+
+        for(int i = 0; i < term_len; i++) {
+            if(char_class[term[i]] == 0) {
+                char_class[term[i]] = num_classes++;
+            }
+            term_class[i] = char_class[term[i]];
+        }
+
+        uint8_t cells[2 * columns];
+        for(int i = 0; i < columns; i++) {
+            cells[i] = cells[columns + i] = std::min(i, max_cell);
+        }
+
+        add_state(cells);
+    }
+
+    static bool supports(const int term_len, const int max_cost) {
+        // the empty term relies on the unbounded row minimum of levenshtein_dist()
+        return term_len > 0 && term_len < 255 && max_cost >= 0 && 2 * max_cost + 1 <= UINT8_MAX;
+    }
+
+    int add_state(const uint8_t* cells) {
+        const std::string key((const char*) cells, 2 * columns);
+        const auto it = state_ids.find(key);
+        if(it != state_ids.end()) {
+            return it->second;
+        }
+
+        const int state = state_ids.size();
+        state_ids.emplace(key, state);
+        state_rows.insert(state_rows.end(), cells, cells + 2 * columns);
+        state_costs.push_back(*std::min_element(cells + columns + 1, cells + 2 * columns));
+        transitions.resize(transitions.size() + num_classes * num_classes, -1);
+        return state;
+    }
+
+    // Equivalent of levenshtein_dist() on the rows of `state` for the class of `c` and of the previous char `p`
+    int compute(const int state, const int p_class, const int c_class) {
+        uint8_t cells[2 * columns];
+        memcpy(cells, &state_rows[(size_t(state) * 2 + 1) * columns], columns);
+
+        const uint8_t* irow = &state_rows[size_t(state) * 2 * columns];
+        const uint8_t* jrow = cells;
+        uint8_t* krow = cells + columns;
+
+        krow[0] = std::min(jrow[0] + 1, max_cell);
+
+        for(int column = 1; column < columns; column++) {
+            const int cost = (c_class == term_class[column-1]) ? 0 : 1;
+            int cell = std::min(std::min(krow[column - 1] + 1, jrow[column] + 1), jrow[column - 1] + cost);
+
+            if(p_class != 0 && column > 1 && c_class == term_class[column-2] && p_class == term_class[column-1]) {
+                cell = std::min(cell, irow[column-2] + 1);
+            }
+
+            krow[column] = std::min(cell, max_cell);
+        }
+
+        return add_state(cells);
+    }
+
+    int step(const int state, const int depth, const unsigned char p, const unsigned char c) {
+        // transposition is only considered beyond the second char, just like levenshtein_dist()
+        const int p_class = (depth > 1) ? char_class[p] : 0;
+        const size_t slot = (size_t(state) * num_classes + p_class) * num_classes + char_class[c];
+
+        int next = transitions[slot];
+        if(next == -1) {
+            next = compute(state, p_class, char_class[c]);
+            transitions[slot] = next;
+        }
+
+        return next;
+    }
+
+    int row_min(const int state) const {
+        return state_costs[state];
+    }
+
+    int final_cost(const int state) const {
+        return state_rows[(size_t(state) * 2 + 2) * columns - 1];
+    }
+};
+
+static void art_fuzzy_recurse_dfa(unsigned char p, unsigned char c, const art_node *n, int depth,
+                                  const unsigned char *term, const int term_len, art_fuzzy_dfa& dfa, int state,
+                                  const int min_cost, const int max_cost, const bool prefix,
+                                  std::vector<const art_node *> &results);
+
+static inline void art_fuzzy_children_dfa(unsigned char p, const art_node *n, int depth, const unsigned char *term,
+                                          const int term_len, art_fuzzy_dfa& dfa, const int state,
+                                          const int min_cost, const int max_cost, const bool prefix,
+                                          std::vector<const art_node *> &results) {
+    switch (n->type) {
+        case NODE4:
+            for (int i=n->num_children-1; i >= 0; i--) {
+                art_fuzzy_recurse_dfa(p, ((art_node4*)n)->keys[i], ((art_node4*)n)->children[i], depth, term,
+                                      term_len, dfa, state, min_cost, max_cost, prefix, results);
+            }
+            break;
+        case NODE16:
+            for (int i=n->num_children-1; i >= 0; i--) {
+                art_fuzzy_recurse_dfa(p, ((art_node16*)n)->keys[i], ((art_node16*)n)->children[i], depth, term,
+                                      term_len, dfa, state, min_cost, max_cost, prefix, results);
+            }
+            break;
+        case NODE48:
+            for (int i=255; i >= 0; i--) {
+                int ix = ((art_node48*)n)->keys[i];
+                if (!ix) continue;
+                art_fuzzy_recurse_dfa(p, (unsigned char) i, ((art_node48*)n)->children[ix - 1], depth, term,
+                                      term_len, dfa, state, min_cost, max_cost, prefix, results);
+            }
+            break;
+        case NODE256:
+            for (int i=255; i >= 0; i--) {
+                if (!((art_node256*)n)->children[i]) continue;
+                art_fuzzy_recurse_dfa(p, (unsigned char) i, ((art_node256*)n)->children[i], depth, term,
+                                      term_len, dfa, state, min_cost, max_cost, prefix, results);
+            }
+            break;
+        default:
+            abort();
+    }
+}
+
+// Mirrors art_fuzzy_recurse(), but steps through `dfa` instead of computing a matrix row for every char
+static void art_fuzzy_recurse_dfa(unsigned char p, unsigned char c, const art_node *n, int depth,
+                                  const unsigned char *term, const int term_len, art_fuzzy_dfa& dfa, int state,
+                                  const int min_cost, const int max_cost, const bool prefix,
+                                  std::vector<const art_node *> &results) {
+    if (!n) return ;
+
+    int temp_cost = 0;
+
+    if(depth == -1) {
+        depth = 0;
+        goto PARTIAL_CALC;
+    }
+
+    if (!((c == '\0' && depth == term_len))) {
+        state = dfa.step(state, depth, p, c);
+        temp_cost = dfa.row_min(state);
+        p = c;
+        depth++;
+
+        if(temp_cost > max_cost) {
+            return;
+        }
+    }
+
+    if(IS_LEAF(n)) {
+        art_leaf *l = (art_leaf *) LEAF_RAW(n);
+        const int iter_len = prefix ? min(l->key_len - 1, term_len) : l->key_len;
+
+        while(depth < iter_len && temp_cost <= 2 * max_cost) {
+            c = l->key[depth];
+            state = dfa.step(state, depth, p, c);
+            temp_cost = dfa.row_min(state);
+            p = c;
+            depth++;
+        }
+
+        int final_cost = dfa.final_cost(state);
+
+        if(prefix && term_len < (int) l->key_len - 1 && temp_cost >= min_cost && temp_cost <= max_cost) {
+            results.push_back(n);
+            return;
+        }
+
+        if(prefix && term_len >= (int) l->key_len - 1 && final_cost >= min_cost && final_cost <= max_cost) {
+            results.push_back(n);
+            return;
+        }
+
+        if(!prefix && final_cost >= min_cost && final_cost <= max_cost) {
+            results.push_back(n);
+            return;
+        }
+
+        return ;
+    }
+
+    if(prefix && depth >= term_len) {
+        results.push_back(n);
+        return ;
+    }
+
+    PARTIAL_CALC:
+
+    int partial_len = min(MAX_PREFIX_LEN, n->partial_len);
+    const int end_index = min(partial_len, term_len+max_cost);
+
+    for(int idx=0; idx<end_index; idx++) {
+        c = n->partial[idx];
+        state = dfa.step(state, depth+idx, p, c);
+        temp_cost = dfa.row_min(state);
+        p = c;
+
+        if(prefix && depth+idx+1 >= term_len && temp_cost <= max_cost) {
+            results.push_back(n);
+            return ;
+        }
+    }
+
+    depth += partial_len;
+
+    if(n->partial_len > MAX_PREFIX_LEN) {
+        while(partial_len++ < n->partial_len && depth < term_len) {
+            c = term[depth];
+            state = dfa.step(state, depth, p, c);
+            temp_cost = dfa.row_min(state);
+            p = c;
+            depth++;
+        }
+    }
+
+    if(temp_cost > max_cost) {
+        return;
+    }
+
+    art_fuzzy_children_dfa(c, n, depth, term, term_len, dfa, state, min_cost, max_cost, prefix, results);
+}
+
 /**
  * Returns leaves that match a given string within a fuzzy distance of max_cost.
  */
 int art_fuzzy_search(art_tree *t, const unsigned char *term, const int term_len, const int min_cost, const int max_cost,
                      const int max_words, const token_ordering token_order, const bool prefix,
                      const uint32_t *filter_ids, size_t filter_ids_length,
-                     std::vector<art_leaf *> &results) {
+                     std::vector<art_leaf *> &results, const fuzzy_search_engine engine) {
 
     std::vector<const art_node*> nodes;
-    int irow[term_len + 1];
-    int jrow[term_len + 1];
-    for (int i = 0; i <= term_len; i++){
-        irow[i] = jrow[i] = i;
+
+    if(t->root == nullptr) {
+        return 0;
     }
 
     //auto begin = std::chrono::high_resolution_clock::now();
 
-    if(IS_LEAF(t->root)) {
-        art_leaf *l = (art_leaf *) LEAF_RAW(t->root);
-        art_fuzzy_recurse(0, l->key[0], t->root, 0, term, term_len, irow, jrow, min_cost, max_cost, prefix, nodes);
+    if(engine == LEVENSHTEIN_AUTOMATON && art_fuzzy_dfa::supports(term_len, max_cost)) {
+        art_fuzzy_dfa dfa(term, term_len, max_cost);
+
+        if(IS_LEAF(t->root)) {
+            art_leaf *l = (art_leaf *) LEAF_RAW(t->root);
+            art_fuzzy_recurse_dfa(0, l->key[0], t->root, 0, term, term_len, dfa, 0, min_cost, max_cost, prefix, nodes);
+        } else {
+            art_fuzzy_recurse_dfa(0, 0, t->root, -1, term, term_len, dfa, 0, min_cost, max_cost, prefix, nodes);
+        }
     } else {
-        if(t->root == nullptr) {
-            return 0;
+        int irow[term_len + 1];
+        int jrow[term_len + 1];
+        for (int i = 0; i <= term_len; i++){
+            irow[i] = jrow[i] = i;
         }
 
-        // send depth as -1 to indicate that this is a root node
-        art_fuzzy_recurse(0, 0, t->root, -1, term, term_len, irow, jrow, min_cost, max_cost, prefix, nodes);
+        if(IS_LEAF(t->root)) {
+            art_leaf *l = (art_leaf *) LEAF_RAW(t->root);
+            art_fuzzy_recurse(0, l->key[0], t->root, 0, term, term_len, irow, jrow, min_cost, max_cost, prefix, nodes);
+        } else {
+            // send depth as -1 to indicate that this is a root node
+            art_fuzzy_recurse(0, 0, t->root, -1, term, term_len, irow, jrow, min_cost, max_cost, prefix, nodes);
+        }
     }
 
     //long long int time_micro = microseconds(std::chrono::high_resolution_clock::now() - begin).count();
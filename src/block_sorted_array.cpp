@@ -0,0 +1,286 @@
+#include "block_sorted_array.h"
+#include <algorithm>
+
+size_t block_sorted_array::block_of_value(uint32_t value) const {
+    const auto it = std::lower_bound(blocks.begin(), blocks.end(), value,
+                                     [](const block_t& block, uint32_t v) { return block.max_id < v; });
+    return it - blocks.begin();
+}
+
+size_t block_sorted_array::block_of_index(uint32_t index) const {
+    const auto it = std::upper_bound(blocks.begin(), blocks.end(), index,
+                                     [](uint32_t i, const block_t& block) { return i < block.offset; });
+    return (it - blocks.begin()) - 1;
+}
+
+void block_sorted_array::shift_offsets(size_t from_block, int64_t delta) {
+    for(size_t i = from_block; i < blocks.size(); i++) {
+        blocks[i].offset += delta;
+    }
+}
+
+void block_sorted_array::split_block(size_t block_index) {
+    sorted_array* lower = blocks[block_index].ids;
+    const uint32_t block_len = lower->getLength();
+    const uint32_t half = block_len / 2;
+
+    uint32_t* block_ids = lower->uncompress();
+
+    sorted_array* upper = new sorted_array;
+    upper->load(block_ids + half, block_len - half);
+    lower->load(block_ids, half);
+
+    const block_t upper_block{blocks[block_index].max_id, blocks[block_index].offset + half, upper};
+    blocks[block_index].max_id = block_ids[half - 1];
+    blocks.insert(blocks.begin() + block_index + 1, upper_block);
+
+    delete [] block_ids;
+}
+
+void block_sorted_array::compact_block(size_t block_index) {
+    sorted_array* ids = blocks[block_index].ids;
+
+    if(ids->getLength() == 0) {
+        delete ids;
+        blocks.erase(blocks.begin() + block_index);
+        return ;
+    }
+
+    blocks[block_index].max_id = ids->at(ids->getLength() - 1);
+
+    if(block_index + 1 == blocks.size()) {
+        return ;
+    }
+
+    sorted_array* next_ids = blocks[block_index + 1].ids;
+    const uint32_t merged_len = ids->getLength() + next_ids->getLength();
+
+    if(merged_len > BLOCK_SIZE / 2) {
+        return ;
+    }
+
+    uint32_t* merged_ids = new uint32_t[merged_len];
+    ids->uncompress(merged_ids);
+    next_ids->uncompress(merged_ids + ids->getLength());
+    ids->load(merged_ids, merged_len);
+    delete [] merged_ids;
+
+    blocks[block_index].max_id = blocks[block_index + 1].max_id;
+    delete next_ids;
+    blocks.erase(blocks.begin() + block_index + 1);
+}
+
+void block_sorted_array::clear() {
+    for(block_t& block: blocks) {
+        delete block.ids;
+        block.ids = nullptr;
+    }
+
+    blocks.clear();
+    length = 0;
+}
+
+void block_sorted_array::load(const uint32_t *sorted_ids, const uint32_t array_length) {
+    clear();
+
+    for(uint32_t offset = 0; offset < array_length; offset += BLOCK_SIZE) {
+        const uint32_t block_len = std::min(BLOCK_SIZE, array_length - offset);
+        sorted_array* ids = new sorted_array;
+        ids->load(sorted_ids + offset, block_len);
+        blocks.push_back(block_t{sorted_ids[offset + block_len - 1], offset, ids});
+    }
+
+    length = array_length;
+}
+
+uint32_t block_sorted_array::at(uint32_t index) {
+    const block_t& block = blocks[block_of_index(index)];
+    return block.ids->at(index - block.offset);
+}
+
+bool block_sorted_array::contains(uint32_t value) {
+    const size_t block_index = block_of_value(value);
+    return block_index != blocks.size() && blocks[block_index].ids->contains(value);
+}
+
+uint32_t block_sorted_array::indexOf(uint32_t value) {
+    const size_t block_index = block_of_value(value);
+    if(block_index == blocks.size()) {
+        return length;
+    }
+
+    const block_t& block = blocks[block_index];
+    const uint32_t block_pos = block.ids->indexOf(value);
+
+    return (block_pos == block.ids->getLength()) ? length : block.offset + block_pos;
+}
+
+void block_sorted_array::indexOf(const uint32_t *values, const size_t values_len, uint32_t *indices) {
+    size_t i = 0;
+
+    while(i < values_len) {
+        const size_t block_index = block_of_value(values[i]);
+        if(block_index == blocks.size()) {
+            break;
+        }
+
+        // values that can only be present in this block
+        const block_t& block = blocks[block_index];
+        const size_t end = std::upper_bound(values + i, values + values_len, block.max_id) - values;
+
+        block.ids->indexOf(values + i, end - i, indices + i);
+
+        const uint32_t block_len = block.ids->getLength();
+        for(size_t j = i; j < end; j++) {
+            indices[j] = (indices[j] == block_len) ? length : block.offset + indices[j];
+        }
+
+        i = end;
+    }
+
+    for(; i < values_len; i++) {
+        indices[i] = length;
+    }
+}
+
+size_t block_sorted_array::numFoundOf(const uint32_t *values, const size_t values_len) {
+    size_t num_found = 0;
+    size_t i = 0;
+
+    while(i < values_len) {
+        const size_t block_index = block_of_value(values[i]);
+        if(block_index == blocks.size()) {
+            break;
+        }
+
+        const block_t& block = blocks[block_index];
+        const size_t end = std::upper_bound(values + i, values + values_len, block.max_id) - values;
+
+        num_found += block.ids->numFoundOf(values + i, end - i);
+        i = end;
+    }
+
+    return num_found;
+}
+
+size_t block_sorted_array::append(uint32_t value) {
+    if(blocks.empty() || value >= blocks.back().max_id) {
+        if(blocks.empty() || blocks.back().ids->getLength() >= BLOCK_SIZE) {
+            blocks.push_back(block_t{value, length, new sorted_array});
+        }
+
+        block_t& block = blocks.back();
+        block.ids->append(value);
+        block.max_id = value;
+        return length++;
+    }
+
+    // out of order: only the block that the value falls into is re-encoded
+    const size_t block_index = block_of_value(value);
+    block_t& block = blocks[block_index];
+    const size_t index = block.offset + block.ids->append(value);
+
+    length++;
+    shift_offsets(block_index + 1, 1);
+
+    if(block.ids->getLength() > BLOCK_SIZE) {
+        split_block(block_index);
+    }
+
+    return index;
+}
+
+bool block_sorted_array::insert(size_t index, uint32_t value) {
+    if(index >= length) {
+        return false;
+    }
+
+    // the block's last id stays in place, so `max_id` does not change
+    const size_t block_index = block_of_index(index);
+    block_t& block = blocks[block_index];
+    block.ids->insert(index - block.offset, value);
+
+    length++;
+    shift_offsets(block_index + 1, 1);
+
+    if(block.ids->getLength() > BLOCK_SIZE) {
+        split_block(block_index);
+    }
+
+    return true;
+}
+
+void block_sorted_array::remove_value(uint32_t value) {
+    const size_t block_index = block_of_value(value);
+    if(block_index == blocks.size()) {
+        return ;
+    }
+
+    sorted_array* ids = blocks[block_index].ids;
+    const uint32_t block_len = ids->getLength();
+    ids->remove_value(value);
+
+    if(ids->getLength() == block_len) {
+        return ;
+    }
+
+    length--;
+    shift_offsets(block_index + 1, -1);
+    compact_block(block_index);
+}
+
+void block_sorted_array::remove_values(uint32_t *sorted_values, uint32_t sorted_values_length) {
+    size_t i = 0;
+
+    while(i < sorted_values_length) {
+        const size_t block_index = block_of_value(sorted_values[i]);
+        if(block_index == blocks.size()) {
+            break;
+        }
+
+        sorted_array* ids = blocks[block_index].ids;
+        const size_t end = std::upper_bound(sorted_values + i, sorted_values + sorted_values_length,
+                                            blocks[block_index].max_id) - sorted_values;
+
+        const uint32_t block_len = ids->getLength();
+        ids->remove_values(sorted_values + i, end - i);
+        const uint32_t num_removed = block_len - ids->getLength();
+
+        length -= num_removed;
+        shift_offsets(block_index + 1, -int64_t(num_removed));
+        compact_block(block_index);
+
+        i = end;
+    }
+}
+
+uint32_t* block_sorted_array::uncompress(uint32_t len) const {
+    uint32_t *out = new uint32_t[std::max(len, length)];
+    uncompress(out);
+    return out;
+}
+
+void block_sorted_array::uncompress(uint32_t* out) const {
+    for(const block_t& block: blocks) {
+        block.ids->uncompress(out);
+        out += block.ids->getLength();
+    }
+}
+
+uint32_t block_sorted_array::getSizeInBytes() {
+    uint32_t size_bytes = blocks.capacity() * sizeof(block_t);
+
+    for(const block_t& block: blocks) {
+        size_bytes += block.ids->getSizeInBytes();
+    }
+
+    return size_bytes;
+}
+
+uint32_t block_sorted_array::getLength() const {
+    return length;
+}
+
+size_t block_sorted_array::num_blocks() const {
+    return blocks.size();
+}
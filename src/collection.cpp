@@ -42,16 +42,18 @@ struct match_index_t {
 Collection::Collection(const std::string& name, const uint32_t collection_id, const uint64_t created_at,
                        const uint32_t next_seq_id, Store *store, const std::vector<field> &fields,
                        const std::string& default_sorting_field, const size_t num_memory_shards,
-                       const float max_memory_ratio, const std::string& fallback_field_type):
+                       const float max_memory_ratio, const std::string& fallback_field_type,
+                       const bool impact_ordered_ids):
         name(name), collection_id(collection_id), created_at(created_at),
         next_seq_id(next_seq_id), store(store),
         fields(fields), default_sorting_field(default_sorting_field),
         num_memory_shards(num_memory_shards),
         max_memory_ratio(max_memory_ratio),
-        fallback_field_type(fallback_field_type), dynamic_fields({}),
+        fallback_field_type(fallback_field_type), impact_ordered_ids(impact_ordered_ids), dynamic_fields({}),
         indices(init_indices()) {
 
     this->num_documents = 0;
+    bump_write_generation();
 }
 
 Collection::~Collection() {
@@ -165,14 +167,36 @@ nlohmann::json Collection::get_summary_json() const {
             field_json[fields::geo_resolution] = size_t(coll_field.geo_resolution);
         }
 
+        if(coll_field.typo_index) {
+            field_json[fields::typo_index] = true;
+        }
+
         fields_arr.push_back(field_json);
     }
 
     json_response["fields"] = fields_arr;
     json_response["default_sorting_field"] = default_sorting_field;
+
+    if(impact_ordered_ids) {
+        json_response["impact_ordered_ids"] = true;
+    }
+
     return json_response;
 }
 
+nlohmann::json Collection::get_memory_stats_json() const {
+    std::shared_lock lock(mutex);
+
+    nlohmann::json stats = nlohmann::json::object();
+
+    // memory shards hold the same fields, so their usage is summed per field
+    for(Index* index: indices) {
+        index->get_memory_stats(stats);
+    }
+
+    return stats;
+}
+
 Option<nlohmann::json> Collection::add(const std::string & json_str,
                                        const index_operation_t& operation, const std::string& id,
                                        const DIRTY_VALUES& dirty_values) {
@@ -346,7 +370,8 @@ void Collection::batch_index(std::vector<std::vector<index_record>> &index_batch
 
 Option<uint32_t> Collection::index_in_memory(nlohmann::json &document, uint32_t seq_id,
                                              bool is_update, const DIRTY_VALUES& dirty_values) {
-    std::unique_lock lock(mutex);
+    // the indices guard their own data, so the schema only has to be kept from changing
+    std::shared_lock lock(mutex);
 
     Option<uint32_t> validation_op = Index::validate_index_in_memory(document, seq_id, default_sorting_field,
                                                                      search_schema, facet_schema, is_update,
@@ -360,35 +385,34 @@ Option<uint32_t> Collection::index_in_memory(nlohmann::json &document, uint32_t
     index->index_in_memory(document, seq_id, default_sorting_field);
 
     num_documents += 1;
+    bump_write_generation();
     return Option<>(200);
 }
 
 size_t Collection::par_index_in_memory(std::vector<std::vector<index_record>> & iter_batch,
                                        std::vector<size_t>& indexed_counts) {
-    std::unique_lock lock(mutex);
-
-    size_t num_processed = 0;
-    std::mutex m_process;
-    std::condition_variable cv_process;
+    // schema changes take the unique lock before a batch is indexed: the batch itself only needs to keep the
+    // schema from changing, while each index takes its own write lock one document at a time, so that searches on
+    // the collection can run in between
+    std::shared_lock lock(mutex);
 
+    ThreadPool* thread_pool = CollectionManager::get_instance().get_thread_pool();
     std::vector<size_t> num_indexed_vec(indices.size());
+    std::vector<std::future<void>> index_futures;
 
     for(size_t index_id = 0; index_id < indices.size(); index_id++) {
         Index* index = indices[index_id];
-        CollectionManager::get_instance().get_thread_pool()->enqueue(
-        [index, index_id, &num_indexed_vec, &iter_batch, this, &m_process, &num_processed, &cv_process]() {
-            size_t num_indexed = Index::batch_memory_index(index, std::ref(iter_batch[index_id]), default_sorting_field,
-                                      search_schema, facet_schema, fallback_field_type);
-            std::unique_lock<std::mutex> lock(m_process);
-            num_indexed_vec[index_id] = num_indexed;
-            num_processed++;
-            cv_process.notify_one();
-        });
+        index_futures.push_back(thread_pool->enqueue(
+        [index, index_id, &num_indexed_vec, &iter_batch, this]() {
+            num_indexed_vec[index_id] = Index::batch_memory_index(index, std::ref(iter_batch[index_id]),
+                                                                  default_sorting_field, search_schema, facet_schema,
+                                                                  fallback_field_type);
+        }));
     }
 
-    const size_t num_indices = indices.size();
-    std::unique_lock<std::mutex> lock_process(m_process);
-    cv_process.wait(lock_process, [&](){ return num_processed == num_indices; });
+    for(auto& index_future: index_futures) {
+        thread_pool->wait(index_future);
+    }
 
     size_t num_indexed = 0;
 
@@ -398,6 +422,7 @@ size_t Collection::par_index_in_memory(std::vector<std::vector<index_record>> &
         indexed_counts[index_id] = num_indexed_vec[index_id];
     }
 
+    bump_write_generation();
     return num_indexed;
 }
 
@@ -503,7 +528,10 @@ Option<nlohmann::json> Collection::search(const std::string & query, const std::
                                   const std::string& highlight_start_tag,
                                   const std::string& highlight_end_tag,
                                   std::vector<size_t> query_by_weights,
-                                  size_t limit_hits) const {
+                                  size_t limit_hits,
+                                  bool explain_filters,
+                                  size_t facet_sample_percent,
+                                  size_t facet_sample_threshold) const {
 
     std::shared_lock lock(mutex);
 
@@ -521,6 +549,10 @@ Option<nlohmann::json> Collection::search(const std::string & query, const std::
                                       std::to_string(GROUP_LIMIT_MAX) + ".");
     }
 
+    if(facet_sample_percent == 0 || facet_sample_percent > 100) {
+        return Option<nlohmann::json>(400, "Value of `facet_sample_percent` must be between 1 and 100.");
+    }
+
     std::vector<uint32_t> excluded_ids;
     std::map<size_t, std::vector<uint32_t>> include_ids; // position => list of IDs
     std::map<size_t, std::vector<std::string>> pinned_hits;
@@ -814,6 +846,12 @@ Option<nlohmann::json> Collection::search(const std::string & query, const std::
         }
     }
 
+    // keeps the leaves in `searched_queries` from being freed by concurrent writes until the search is done
+    std::vector<epoch_reclaimer_t::guard_t> epoch_guards;
+    for(Index* index: indices) {
+        epoch_guards.push_back(index->enter_epoch());
+    }
+
     std::vector<std::vector<art_leaf*>> searched_queries;  // search queries used for generating the results
     std::vector<std::vector<KV*>> raw_result_kvs;
     std::vector<std::vector<KV*>> override_result_kvs;
@@ -845,9 +883,8 @@ Option<nlohmann::json> Collection::search(const std::string & query, const std::
 
     // search all indices
     std::vector<search_args*> search_args_vec;
-    size_t num_processed = 0;
-    std::mutex m_process;
-    std::condition_variable cv_process;
+    std::vector<std::future<void>> search_futures;
+    ThreadPool* thread_pool = CollectionManager::get_instance().get_thread_pool();
 
     size_t index_id = 0;
     for(Index* index: indices) {
@@ -858,71 +895,35 @@ Option<nlohmann::json> Collection::search(const std::string & query, const std::
                                    per_page, page, token_order, prefix,
                                    drop_tokens_threshold, typo_tokens_threshold,
                                    group_by_fields, group_limit, default_sorting_field);
+        search_params->explain_filters = explain_filters;
+        search_params->facet_sample_percent = facet_sample_percent;
+        search_params->facet_sample_threshold = facet_sample_threshold;
+        search_params->thread_pool = thread_pool;
 
         search_args_vec.push_back(search_params);
 
-        CollectionManager::get_instance().get_thread_pool()->enqueue(
-                [index, search_params, &m_process, &num_processed, &cv_process]() {
+        // searches are latency bound, so they are picked up ahead of indexing work
+        search_futures.push_back(thread_pool->enqueue_with_priority(ThreadPool::HIGH, [index, search_params]() {
             index->run_search(search_params);
-            std::unique_lock<std::mutex> lock(m_process);
-            num_processed++;
-            cv_process.notify_one();
-        });
+        }));
 
         index_id++;
     }
 
-    const size_t num_indices = indices.size();
-    std::unique_lock<std::mutex> lock_process(m_process);
-    cv_process.wait(lock_process, [&](){ return num_processed == num_indices; });
+    // the searches of the other indices can be run here while waiting
+    for(auto& search_future: search_futures) {
+        thread_pool->wait(search_future);
+    }
 
     // for grouping we have to re-aggregate
 
-    const size_t topster_size = std::max((size_t)1, max_hits);
-    Topster topster(topster_size, group_limit);
-    Topster curated_topster(topster_size, group_limit);
-
     for(const search_args* search_params: search_args_vec) {
-        aggregate_topster(searched_queries.size(), topster, search_params->topster);
-        aggregate_topster(searched_queries.size(), curated_topster, search_params->curated_topster);
+        offset_query_index(search_params->topster, searched_queries.size());
+        offset_query_index(search_params->curated_topster, searched_queries.size());
 
         searched_queries.insert(searched_queries.end(), search_params->searched_queries.begin(),
                                 search_params->searched_queries.end());
 
-        for(size_t fi = 0; fi < search_params->facets.size(); fi++) {
-            auto & this_facet = search_params->facets[fi];
-            auto & acc_facet = facets[fi];
-
-            for(auto & facet_kv: this_facet.result_map) {
-                if(search_params->group_limit) {
-                    // we have to add all group sets
-                    acc_facet.result_map[facet_kv.first].groups.insert(
-                        facet_kv.second.groups.begin(), facet_kv.second.groups.end()
-                    );
-                } else {
-                    size_t count = 0;
-                    if(acc_facet.result_map.count(facet_kv.first) == 0) {
-                        // not found, so set it
-                        count = facet_kv.second.count;
-                    } else {
-                        count = acc_facet.result_map[facet_kv.first].count + facet_kv.second.count;
-                    }
-                    acc_facet.result_map[facet_kv.first].count = count;
-                }
-
-                acc_facet.result_map[facet_kv.first].doc_id = facet_kv.second.doc_id;
-                acc_facet.result_map[facet_kv.first].array_pos = facet_kv.second.array_pos;
-                acc_facet.result_map[facet_kv.first].query_token_pos = facet_kv.second.query_token_pos;
-            }
-
-            if(this_facet.stats.fvcount != 0) {
-                acc_facet.stats.fvcount += this_facet.stats.fvcount;
-                acc_facet.stats.fvsum += this_facet.stats.fvsum;
-                acc_facet.stats.fvmax = std::max(acc_facet.stats.fvmax, this_facet.stats.fvmax);
-                acc_facet.stats.fvmin = std::min(acc_facet.stats.fvmin, this_facet.stats.fvmin);
-            }
-        }
-
         if(group_limit) {
             groups_processed.insert(
                 search_params->groups_processed.begin(),
@@ -933,6 +934,27 @@ Option<nlohmann::json> Collection::search(const std::string & query, const std::
         }
     }
 
+    // every facet is merged across the indices on its own, in the order of the indices, while the topsters are
+    // merged pairwise
+    std::vector<std::future<void>> facet_futures;
+    for(size_t fi = 0; fi < facets.size(); fi++) {
+        facet& acc_facet = facets[fi];
+        facet_futures.push_back(thread_pool->enqueue_with_priority(ThreadPool::HIGH,
+                                                                   [&acc_facet, fi, &search_args_vec]() {
+            merge_facet(acc_facet, fi, search_args_vec);
+        }));
+    }
+
+    reduce_topsters(search_args_vec, thread_pool);
+
+    for(auto& facet_future: facet_futures) {
+        thread_pool->wait(facet_future);
+    }
+
+    // the topsters of the first index now hold the results of all indices, and outlive the use of their kvs below
+    Topster& topster = *search_args_vec[0]->topster;
+    Topster& curated_topster = *search_args_vec[0]->curated_topster;
+
     topster.sort();
     curated_topster.sort();
 
@@ -1144,21 +1166,26 @@ Option<nlohmann::json> Collection::search(const std::string & query, const std::
             auto & kv = facet_hash_counts[fi];
             auto & facet_count = kv.second;
 
-            // fetch actual facet value from representative doc id
-            const std::string& seq_id_key = get_seq_id_key((uint32_t) facet_count.doc_id);
-            nlohmann::json document;
-            const Option<bool> & document_op = get_document_from_store(seq_id_key, document);
+            // the index of the representative doc id holds the actual facet value in its dictionary
+            std::string value;
+            const Index* facet_index = indices[facet_count.doc_id % num_memory_shards];
 
-            if(!document_op.ok()) {
-                LOG(ERROR) << "Facet fetch error. " << document_op.error();
-                continue;
-            }
+            if(!facet_index->get_facet_value(a_facet.field_name, kv.first, value)) {
+                // fetch actual facet value from representative doc id
+                const std::string& seq_id_key = get_seq_id_key((uint32_t) facet_count.doc_id);
+                nlohmann::json document;
+                const Option<bool> & document_op = get_document_from_store(seq_id_key, document);
 
-            std::string value;
-            bool facet_found = facet_value_to_string(a_facet, facet_count, document, value);
+                if(!document_op.ok()) {
+                    LOG(ERROR) << "Facet fetch error. " << document_op.error();
+                    continue;
+                }
 
-            if(!facet_found) {
-                continue;
+                bool facet_found = facet_value_to_string(a_facet, facet_count, document, value);
+
+                if(!facet_found) {
+                    continue;
+                }
             }
 
             std::vector<std::string> tokens;
@@ -1214,9 +1241,35 @@ Option<nlohmann::json> Collection::search(const std::string & query, const std::
             facet_result["stats"]["avg"] = (a_facet.stats.fvsum / a_facet.stats.fvcount);
         }
 
+        if(a_facet.sampled) {
+            // the counts and stats are estimates
+            facet_result["sampled"] = true;
+        }
+
         result["facet_counts"].push_back(facet_result);
     }
 
+    if(explain_filters) {
+        // clauses of every index, in the order that they were evaluated in
+        result["filter_explain"] = nlohmann::json::array();
+
+        for(const search_args* search_params: search_args_vec) {
+            nlohmann::json index_explain = nlohmann::json::array();
+
+            for(const filter_explain_t& clause: search_params->filter_explain) {
+                nlohmann::json clause_explain;
+                clause_explain["field"] = clause.field_name;
+                clause_explain["estimated_ids"] = clause.estimated_ids;
+                clause_explain["strategy"] = clause.strategy;
+                clause_explain["num_ids"] = clause.num_ids;
+                clause_explain["time_us"] = clause.time_us;
+                index_explain.push_back(clause_explain);
+            }
+
+            result["filter_explain"].push_back(index_explain);
+        }
+    }
+
     // free search params
     for(auto search_params: search_args_vec) {
         delete search_params;
@@ -1299,6 +1352,89 @@ void Collection::aggregate_topster(size_t query_index, Topster& agg_topster, Top
     }
 }
 
+void Collection::offset_query_index(Topster* topster, size_t query_index) {
+    if(query_index == 0) {
+        return ;
+    }
+
+    if(topster->distinct) {
+        for(auto &group_topster_entry: topster->group_kv_map) {
+            Topster* group_topster = group_topster_entry.second;
+            for(uint32_t t = 0; t < group_topster->size; t++) {
+                group_topster->getKV(t)->query_index += query_index;
+            }
+        }
+    } else {
+        for(uint32_t t = 0; t < topster->size; t++) {
+            topster->getKV(t)->query_index += query_index;
+        }
+    }
+}
+
+void Collection::merge_facet(facet& acc_facet, size_t facet_index, const std::vector<search_args*>& search_args_vec) {
+    for(search_args* search_params: search_args_vec) {
+        auto & this_facet = search_params->facets[facet_index];
+
+        for(auto & facet_kv: this_facet.result_map) {
+            auto acc_facet_it = acc_facet.result_map.find(facet_kv.first);
+
+            if(acc_facet_it == acc_facet.result_map.end()) {
+                // not found, so the count or groups are moved over along with the representative document
+                acc_facet.result_map.emplace(facet_kv.first, std::move(facet_kv.second));
+                continue;
+            }
+
+            if(search_params->group_limit) {
+                // we have to add all group sets
+                acc_facet_it->second.groups.insert(facet_kv.second.groups.begin(), facet_kv.second.groups.end());
+            } else {
+                acc_facet_it->second.count += facet_kv.second.count;
+            }
+
+            acc_facet_it->second.doc_id = facet_kv.second.doc_id;
+            acc_facet_it->second.array_pos = facet_kv.second.array_pos;
+            acc_facet_it->second.query_token_pos = std::move(facet_kv.second.query_token_pos);
+        }
+
+        acc_facet.sampled = acc_facet.sampled || this_facet.sampled;
+
+        if(this_facet.stats.fvcount != 0) {
+            acc_facet.stats.fvcount += this_facet.stats.fvcount;
+            acc_facet.stats.fvsum += this_facet.stats.fvsum;
+            acc_facet.stats.fvmax = std::max(acc_facet.stats.fvmax, this_facet.stats.fvmax);
+            acc_facet.stats.fvmin = std::min(acc_facet.stats.fvmin, this_facet.stats.fvmin);
+        }
+    }
+}
+
+void Collection::reduce_topsters(const std::vector<search_args*>& search_args_vec, ThreadPool* thread_pool) {
+    for(size_t step = 1; step < search_args_vec.size(); step *= 2) {
+        std::vector<std::future<void>> merge_futures;
+
+        for(size_t i = 0; i + step < search_args_vec.size(); i += 2 * step) {
+            search_args* acc = search_args_vec[i];
+            search_args* other = search_args_vec[i + step];
+
+            auto merge = [acc, other]() {
+                aggregate_topster(0, *acc->topster, other->topster);
+                aggregate_topster(0, *acc->curated_topster, other->curated_topster);
+            };
+
+            if(i + 2 * step >= search_args_vec.size()) {
+                // the last pair of the round is merged here instead of waiting idle
+                merge();
+                continue;
+            }
+
+            merge_futures.push_back(thread_pool->enqueue_with_priority(ThreadPool::HIGH, merge));
+        }
+
+        for(auto& merge_future: merge_futures) {
+            thread_pool->wait(merge_future);
+        }
+    }
+}
+
 Option<bool> Collection::get_filter_ids(const std::string & simple_filter_query,
                                     std::vector<std::pair<size_t, uint32_t*>>& index_ids) {
     std::shared_lock lock(mutex);
@@ -1312,7 +1448,7 @@ Option<bool> Collection::get_filter_ids(const std::string & simple_filter_query,
 
     for(auto& index: indices) {
         uint32_t* filter_ids = nullptr;
-        size_t filter_ids_len = index->do_filtering(&filter_ids, filters);
+        size_t filter_ids_len = index->do_filtering_with_lock(&filter_ids, filters);
         index_ids.emplace_back(filter_ids_len, filter_ids);
     }
 
@@ -1395,64 +1531,21 @@ void Collection::highlight_result(const field &search_field,
         return ;
     }
 
-    std::vector<uint32_t*> leaf_to_indices;
-    std::vector<art_leaf*> query_suggestion;
-    std::set<std::string> query_suggestion_tokens;
-
+    std::vector<std::string> searched_tokens;
     for (const art_leaf *token_leaf : searched_queries[field_order_kv->query_index]) {
-        // Must search for the token string fresh on that field for the given document since `token_leaf`
-        // is from the best matched field and need not be present in other fields of a document.
-        Index* index = indices[field_order_kv->key % num_memory_shards];
-        art_leaf *actual_leaf = index->get_token_leaf(search_field.name, &token_leaf->key[0], token_leaf->key_len);
-
-        //LOG(INFO) << "field: " << search_field.name << ", key: " << token_leaf->key;
-
-        if(actual_leaf != nullptr) {
-            query_suggestion.push_back(actual_leaf);
-            std::string token(reinterpret_cast<char*>(actual_leaf->key), actual_leaf->key_len-1);
-            query_suggestion_tokens.insert(token);
-            std::vector<uint16_t> positions;
-            uint32_t doc_index = actual_leaf->values->ids.indexOf(field_order_kv->key);
-            auto doc_indices = new uint32_t[1];
-            doc_indices[0] = doc_index;
-            leaf_to_indices.push_back(doc_indices);
-        }
+        searched_tokens.emplace_back(reinterpret_cast<const char*>(token_leaf->key), token_leaf->key_len-1);
     }
 
-    if(query_suggestion.size() != q_tokens.size()) {
-        // can happen for compound query matched across 2 fields when some tokens are dropped
-        for(const std::string& q_token: q_tokens) {
-            if(query_suggestion_tokens.count(q_token) != 0) {
-                continue;
-            }
-
-            Index* index = indices[field_order_kv->key % num_memory_shards];
-            art_leaf *actual_leaf = index->get_token_leaf(search_field.name,
-                                                          reinterpret_cast<const unsigned char *>(q_token.c_str()),
-                                                          q_token.size() + 1);
-            if(actual_leaf != nullptr) {
-                std::vector<uint16_t> positions;
-                uint32_t doc_index = actual_leaf->values->ids.indexOf(field_order_kv->key);
-                if(doc_index != actual_leaf->values->ids.getLength()) {
-                    auto doc_indices = new uint32_t[1];
-                    doc_indices[0] = doc_index;
-                    leaf_to_indices.push_back(doc_indices);
-                    query_suggestion.push_back(actual_leaf);
-                }
-            }
-        }
-    }
+    // positions in the field of each token in the query
+    std::unordered_map<size_t, std::vector<std::vector<uint16_t>>> array_token_positions;
 
-    if(query_suggestion.empty()) {
+    Index* index = indices[field_order_kv->key % num_memory_shards];
+    if(!index->populate_highlight_positions(search_field.name, searched_tokens, q_tokens, field_order_kv->key,
+                                            array_token_positions)) {
         // none of the tokens from the query were found on this field
-        free_leaf_indices(leaf_to_indices);
         return ;
     }
 
-    // positions in the field of each token in the query
-    std::unordered_map<size_t, std::vector<std::vector<uint16_t>>> array_token_positions;
-    Index::populate_token_positions(query_suggestion, leaf_to_indices, 0, array_token_positions);
-
     std::vector<match_index_t> match_indices;
 
     for(const auto& kv: array_token_positions) {
@@ -1474,7 +1567,6 @@ void Collection::highlight_result(const field &search_field,
 
     if(match_indices.empty()) {
         // none of the tokens from the query were found on this field
-        free_leaf_indices(leaf_to_indices);
         return ;
     }
 
@@ -1617,14 +1709,6 @@ void Collection::highlight_result(const field &search_field,
 
     highlight.field = search_field.name;
     highlight.match_score = match_indices[0].match_score;
-
-    free_leaf_indices(leaf_to_indices);
-}
-
-void Collection::free_leaf_indices(std::vector<uint32_t*>& leaf_to_indices) const {
-    for(uint32_t* leaf_indices: leaf_to_indices) {
-        delete [] leaf_indices;
-    }
 }
 
 Option<nlohmann::json> Collection::get(const std::string & id) const {
@@ -1672,6 +1756,7 @@ void Collection::remove_document(const nlohmann::json & document, const uint32_t
         Index* index = indices[seq_id % num_memory_shards];
         index->remove(seq_id, document);
         num_documents -= 1;
+        bump_write_generation();
     }
 
     if(remove_from_store) {
@@ -1749,6 +1834,7 @@ Option<uint32_t> Collection::add_override(const override_t & override) {
 
     std::unique_lock lock(mutex);
     overrides[override.id] = override;
+    bump_write_generation();
     return Option<uint32_t>(200);
 }
 
@@ -1761,6 +1847,7 @@ Option<uint32_t> Collection::remove_override(const std::string & id) {
 
         std::unique_lock lock(mutex);
         overrides.erase(id);
+        bump_write_generation();
         return Option<uint32_t>(200);
     }
 
@@ -1809,6 +1896,14 @@ uint32_t Collection::get_collection_id() const {
     return collection_id.load();
 }
 
+uint64_t Collection::get_write_generation() const {
+    return write_generation.load();
+}
+
+void Collection::bump_write_generation() {
+    write_generation = ++write_clock;
+}
+
 Option<uint32_t> Collection::doc_id_to_seq_id(const std::string & doc_id) const {
     std::string seq_id_str;
     StoreStatus status = store->get(get_doc_id_key(doc_id), seq_id_str);
@@ -2223,6 +2318,7 @@ Option<bool> Collection::add_synonym(const synonym_t& synonym) {
         }
     }
 
+    bump_write_generation();
     write_lock.unlock();
 
     bool inserted = store->insert(Collection::get_synonym_key(name, synonym.id), synonym.to_json().dump());
@@ -2360,6 +2456,7 @@ Option<bool> Collection::remove_synonym(const std::string &id) {
         }
 
         synonym_definitions.erase(id);
+        bump_write_generation();
         return Option<bool>(true);
     }
 
@@ -2530,8 +2627,13 @@ std::vector<Index *> Collection::init_indices() {
         }
     }
 
+    const size_t filter_cache_max_bytes = CollectionManager::get_instance().get_filter_cache_max_bytes() /
+                                          num_memory_shards;
+
     for(size_t i = 0; i < num_memory_shards; i++) {
-        Index* index = new Index(name+std::to_string(i), search_schema, facet_schema, sort_schema);
+        Index* index = new Index(name+std::to_string(i), search_schema, facet_schema, sort_schema,
+                                 num_memory_shards, impact_ordered_ids ? default_sorting_field : "",
+                                 filter_cache_max_bytes);
         index_list.push_back(index);
     }
 
@@ -6,7 +6,7 @@
 
 constexpr const size_t CollectionManager::DEFAULT_NUM_MEMORY_SHARDS;
 
-CollectionManager::CollectionManager() {
+CollectionManager::CollectionManager(): filter_cache_max_bytes(filter_cache_t::DEFAULT_MAX_BYTES) {
 
 }
 
@@ -40,9 +40,14 @@ Collection* CollectionManager::init_collection(const nlohmann::json & collection
             field_obj[fields::locale] = "";
         }
 
+        if(field_obj.count(fields::typo_index) == 0) {
+            field_obj[fields::typo_index] = false;
+        }
+
         fields.push_back({field_obj[fields::name], field_obj[fields::type], field_obj[fields::facet],
                           field_obj[fields::optional], field_obj[fields::index],
-                          field_obj[fields::geo_resolution], field_obj[fields::locale]});
+                          field_obj[fields::geo_resolution], field_obj[fields::locale],
+                          field_obj[fields::typo_index]});
     }
 
     std::string default_sorting_field = collection_meta[Collection::COLLECTION_DEFAULT_SORTING_FIELD_KEY].get<std::string>();
@@ -58,6 +63,9 @@ Collection* CollectionManager::init_collection(const nlohmann::json & collection
                               collection_meta[Collection::COLLECTION_FALLBACK_FIELD_TYPE].get<std::string>() :
                               "";
 
+    bool impact_ordered_ids = collection_meta.count(Collection::COLLECTION_IMPACT_ORDERED_IDS) != 0 &&
+                              collection_meta[Collection::COLLECTION_IMPACT_ORDERED_IDS].get<bool>();
+
     LOG(INFO) << "Found collection " << this_collection_name << " with " << num_memory_shards << " memory shards.";
 
     Collection* collection = new Collection(this_collection_name,
@@ -69,7 +77,8 @@ Collection* CollectionManager::init_collection(const nlohmann::json & collection
                                             default_sorting_field,
                                             num_memory_shards,
                                             max_memory_ratio,
-                                            fallback_field_type);
+                                            fallback_field_type,
+                                            impact_ordered_ids);
 
     return collection;
 }
@@ -201,6 +210,7 @@ void CollectionManager::dispose() {
     }
 
     collections.clear();
+    search_cache.clear();
     store->close();
 }
 
@@ -228,12 +238,18 @@ Option<Collection*> CollectionManager::create_collection(const std::string& name
                                                          const std::vector<field> & fields,
                                                          const std::string& default_sorting_field,
                                                          const uint64_t created_at,
-                                                         const std::string& fallback_field_type) {
+                                                         const std::string& fallback_field_type,
+                                                         const bool impact_ordered_ids) {
 
     if(store->contains(Collection::get_meta_key(name))) {
         return Option<Collection*>(409, std::string("A collection with name `") + name + "` already exists.");
     }
 
+    if(impact_ordered_ids && default_sorting_field.empty()) {
+        return Option<Collection*>(400, std::string("`") + Collection::COLLECTION_IMPACT_ORDERED_IDS +
+                                        "` requires a `default_sorting_field`.");
+    }
+
     // validated `fallback_field_type`
     if(!fallback_field_type.empty()) {
         field fallback_field_type_def("temp", fallback_field_type, false);
@@ -259,9 +275,13 @@ Option<Collection*> CollectionManager::create_collection(const std::string& name
     collection_meta[Collection::COLLECTION_NUM_MEMORY_SHARDS] = num_memory_shards;
     collection_meta[Collection::COLLECTION_FALLBACK_FIELD_TYPE] = fallback_field_type;
 
+    if(impact_ordered_ids) {
+        collection_meta[Collection::COLLECTION_IMPACT_ORDERED_IDS] = true;
+    }
+
     Collection* new_collection = new Collection(name, next_collection_id, created_at, 0, store, fields,
                                                 default_sorting_field, num_memory_shards,
-                                                this->max_memory_ratio, fallback_field_type);
+                                                this->max_memory_ratio, fallback_field_type, impact_ordered_ids);
     next_collection_id++;
 
     rocksdb::WriteBatch batch;
@@ -498,6 +518,18 @@ Option<bool> CollectionManager::do_search(std::map<std::string, std::string>& re
     const char *HIGHLIGHT_START_TAG = "highlight_start_tag";
     const char *HIGHLIGHT_END_TAG = "highlight_end_tag";
 
+    // identical searches of a collection that has not been written to since are served from the cache
+    const char *USE_CACHE = "use_cache";
+
+    // lists the order that the filter clauses were evaluated in, with their timings
+    const char *EXPLAIN_FILTERS = "explain_filters";
+
+    // facets of searches that match more than the threshold number of documents are counted over a sample of
+    // this percent of them
+    const char *FACET_SAMPLE_PERCENT = "facet_sample_percent";
+    const char *FACET_SAMPLE_THRESHOLD = "facet_sample_threshold";
+    const char *AUTH_KEY = "x-typesense-api-key";
+
     if(req_params.count(NUM_TYPOS) == 0) {
         req_params[NUM_TYPOS] = "2";
     }
@@ -534,6 +566,14 @@ Option<bool> CollectionManager::do_search(std::map<std::string, std::string>& re
         req_params[SNIPPET_THRESHOLD] = "30";
     }
 
+    if(req_params.count(FACET_SAMPLE_PERCENT) == 0) {
+        req_params[FACET_SAMPLE_PERCENT] = "100";
+    }
+
+    if(req_params.count(FACET_SAMPLE_THRESHOLD) == 0) {
+        req_params[FACET_SAMPLE_THRESHOLD] = "0";
+    }
+
     if(req_params.count(HIGHLIGHT_AFFIX_NUM_TOKENS) == 0) {
         req_params[HIGHLIGHT_AFFIX_NUM_TOKENS] = "4";
     }
@@ -638,6 +678,14 @@ Option<bool> CollectionManager::do_search(std::map<std::string, std::string>& re
         return Option<bool>(400,"Parameter `" + std::string(GROUP_LIMIT) + "` must be an unsigned integer.");
     }
 
+    if(!StringUtils::is_uint32_t(req_params[FACET_SAMPLE_PERCENT])) {
+        return Option<bool>(400,"Parameter `" + std::string(FACET_SAMPLE_PERCENT) + "` must be an unsigned integer.");
+    }
+
+    if(!StringUtils::is_uint32_t(req_params[FACET_SAMPLE_THRESHOLD])) {
+        return Option<bool>(400,"Parameter `" + std::string(FACET_SAMPLE_THRESHOLD) + "` must be an unsigned integer.");
+    }
+
     std::string filter_str = req_params.count(FILTER) != 0 ? req_params[FILTER] : "";
 
     std::vector<std::string> search_fields;
@@ -699,6 +747,45 @@ Option<bool> CollectionManager::do_search(std::map<std::string, std::string>& re
         }
     }
 
+    if(req_params.count(USE_CACHE) != 0 && req_params[USE_CACHE] != "true" && req_params[USE_CACHE] != "false") {
+        return Option<bool>(400, "Parameter `" + std::string(USE_CACHE) + "` must be a boolean.");
+    }
+
+    if(req_params.count(EXPLAIN_FILTERS) != 0 && req_params[EXPLAIN_FILTERS] != "true" &&
+       req_params[EXPLAIN_FILTERS] != "false") {
+        return Option<bool>(400, "Parameter `" + std::string(EXPLAIN_FILTERS) + "` must be a boolean.");
+    }
+
+    const bool explain_filters = (req_params.count(EXPLAIN_FILTERS) != 0 && req_params[EXPLAIN_FILTERS] == "true");
+
+    // the timings of an explained search are only meaningful when it is actually run
+    SearchCache& search_cache = collectionManager.get_search_cache();
+    const bool use_cache = search_cache.is_enabled() && !explain_filters &&
+                           (req_params.count(USE_CACHE) == 0 || req_params[USE_CACHE] == "true");
+
+    // taken before searching, so that a write that lands during the search makes the cached result stale
+    const uint64_t write_generation = collection->get_write_generation();
+    std::string cache_key;
+
+    if(use_cache) {
+        // the embedded params of a scoped API key have already been merged into the request params, so the key
+        // itself does not have to be part of the cache key
+        std::map<std::string, std::string> cache_params = req_params;
+        cache_params.erase(AUTH_KEY);
+        cache_params.erase(USE_CACHE);
+        cache_key = SearchCache::get_key(collection->get_collection_id(), cache_params);
+
+        nlohmann::json cached_result;
+
+        if(search_cache.get(cache_key, write_generation, cached_result)) {
+            uint64_t timeMillis = std::chrono::duration_cast<std::chrono::milliseconds>(
+                    std::chrono::high_resolution_clock::now() - begin).count();
+            cached_result["search_time_ms"] = timeMillis;
+            results_json_str = cached_result.dump(-1, ' ', false, nlohmann::detail::error_handler_t::ignore);
+            return Option<bool>(true);
+        }
+    }
+
     Option<nlohmann::json> result_op = collection->search(req_params[QUERY], search_fields, filter_str, facet_fields,
                                                           sort_fields, std::stoi(req_params[NUM_TYPOS]),
                                                           static_cast<size_t>(std::stol(req_params[PER_PAGE])),
@@ -718,7 +805,10 @@ Option<bool> CollectionManager::do_search(std::map<std::string, std::string>& re
                                                           req_params[HIGHLIGHT_START_TAG],
                                                           req_params[HIGHLIGHT_END_TAG],
                                                           query_by_weights,
-                                                          static_cast<size_t>(std::stol(req_params[LIMIT_HITS]))
+                                                          static_cast<size_t>(std::stol(req_params[LIMIT_HITS])),
+                                                          explain_filters,
+                                                          static_cast<size_t>(std::stol(req_params[FACET_SAMPLE_PERCENT])),
+                                                          static_cast<size_t>(std::stol(req_params[FACET_SAMPLE_THRESHOLD]))
     );
 
     uint64_t timeMillis = std::chrono::duration_cast<std::chrono::milliseconds>(
@@ -730,8 +820,14 @@ Option<bool> CollectionManager::do_search(std::map<std::string, std::string>& re
     }
 
     nlohmann::json result = result_op.get();
-    result["search_time_ms"] = timeMillis;
     result["page"] = std::stoi(req_params[PAGE]);
+
+    // the search time differs between identical searches, so it is left out of the cached result
+    if(use_cache) {
+        search_cache.insert(cache_key, write_generation, result);
+    }
+
+    result["search_time_ms"] = timeMillis;
     results_json_str = result.dump(-1, ' ', false, nlohmann::detail::error_handler_t::ignore);
 
     //LOG(INFO) << "Time taken: " << timeMillis << "ms";
@@ -743,6 +839,18 @@ ThreadPool* CollectionManager::get_thread_pool() const {
     return thread_pool;
 }
 
+SearchCache& CollectionManager::get_search_cache() {
+    return search_cache;
+}
+
+void CollectionManager::set_filter_cache_max_bytes(size_t max_bytes) {
+    filter_cache_max_bytes = max_bytes;
+}
+
+size_t CollectionManager::get_filter_cache_max_bytes() const {
+    return filter_cache_max_bytes;
+}
+
 nlohmann::json CollectionManager::get_collection_summaries() const {
     std::shared_lock lock(mutex);
 
@@ -760,6 +868,7 @@ nlohmann::json CollectionManager::get_collection_summaries() const {
 Option<Collection*> CollectionManager::create_collection(nlohmann::json& req_json) {
     const char* NUM_MEMORY_SHARDS = "num_memory_shards";
     const char* DEFAULT_SORTING_FIELD = "default_sorting_field";
+    const char* IMPACT_ORDERED_IDS = Collection::COLLECTION_IMPACT_ORDERED_IDS;
 
     // validate presence of mandatory fields
 
@@ -797,6 +906,14 @@ Option<Collection*> CollectionManager::create_collection(nlohmann::json& req_jso
         return Option<Collection*>(400, std::string("`") + NUM_MEMORY_SHARDS + "` should be a positive integer.");
     }
 
+    if(req_json.count(IMPACT_ORDERED_IDS) == 0) {
+        req_json[IMPACT_ORDERED_IDS] = false;
+    }
+
+    if(!req_json[IMPACT_ORDERED_IDS].is_boolean()) {
+        return Option<Collection*>(400, std::string("`") + IMPACT_ORDERED_IDS + "` should be a boolean.");
+    }
+
     // field specific validation
 
     if(!req_json["fields"].is_array() || req_json["fields"].empty()) {
@@ -818,7 +935,8 @@ Option<Collection*> CollectionManager::create_collection(nlohmann::json& req_jso
 
     return CollectionManager::get_instance().create_collection(req_json["name"], num_memory_shards,
                                                                 fields, default_sorting_field, created_at,
-                                                                fallback_field_type);
+                                                                fallback_field_type,
+                                                                req_json[IMPACT_ORDERED_IDS].get<bool>());
 }
 
 Option<bool> CollectionManager::load_collection(const nlohmann::json &collection_meta,
@@ -170,6 +170,12 @@ bool get_metrics_json(const std::shared_ptr<http_req>& req, const std::shared_pt
     SystemMetrics sys_metrics;
     sys_metrics.get(data_dir_path, result);
 
+    if(server->get_request_scheduler() != nullptr) {
+        server->get_request_scheduler()->get_metrics(result);
+    }
+
+    collectionManager.get_search_cache().get_metrics(result);
+
     res->set_body(200, result.dump(2));
     return true;
 }
@@ -178,6 +184,12 @@ bool get_stats_json(const std::shared_ptr<http_req>& req, const std::shared_ptr<
     nlohmann::json result;
     AppMetrics::get_instance().get("requests_per_second", "latency_ms", result);
 
+    result["collections"] = nlohmann::json::object();
+
+    for(Collection* collection: CollectionManager::get_instance().get_collections()) {
+        result["collections"][collection->get_name()] = collection->get_memory_stats_json();
+    }
+
     res->set_body(200, result.dump(2));
     return true;
 }
@@ -0,0 +1,72 @@
+#include "epoch_reclaimer.h"
+#include <iterator>
+
+epoch_reclaimer_t::~epoch_reclaimer_t() {
+    reclaim_all();
+}
+
+uint64_t epoch_reclaimer_t::enter() {
+    std::unique_lock lock(mutex);
+    reader_epochs[current_epoch]++;
+    return current_epoch;
+}
+
+void epoch_reclaimer_t::exit(uint64_t epoch) {
+    std::unique_lock lock(mutex);
+
+    auto it = reader_epochs.find(epoch);
+    if(it != reader_epochs.end() && --it->second == 0) {
+        reader_epochs.erase(it);
+    }
+}
+
+void epoch_reclaimer_t::retire(std::function<void()> reclaim) {
+    std::unique_lock lock(mutex);
+
+    // readers that entered at or before this epoch could have found the object before it was unlinked
+    retired.push_back(retired_t{current_epoch, std::move(reclaim)});
+    current_epoch++;
+}
+
+size_t epoch_reclaimer_t::reclaim() {
+    std::vector<retired_t> reclaimable;
+
+    {
+        std::unique_lock lock(mutex);
+
+        const uint64_t min_reader_epoch = reader_epochs.empty() ? current_epoch : reader_epochs.begin()->first;
+
+        size_t num_reclaimable = 0;
+        while(num_reclaimable < retired.size() && retired[num_reclaimable].epoch < min_reader_epoch) {
+            num_reclaimable++;
+        }
+
+        reclaimable.assign(std::make_move_iterator(retired.begin()),
+                           std::make_move_iterator(retired.begin() + num_reclaimable));
+        retired.erase(retired.begin(), retired.begin() + num_reclaimable);
+    }
+
+    for(retired_t& retired_object: reclaimable) {
+        retired_object.reclaim();
+    }
+
+    return reclaimable.size();
+}
+
+void epoch_reclaimer_t::reclaim_all() {
+    std::vector<retired_t> reclaimable;
+
+    {
+        std::unique_lock lock(mutex);
+        reclaimable.swap(retired);
+    }
+
+    for(retired_t& retired_object: reclaimable) {
+        retired_object.reclaim();
+    }
+}
+
+size_t epoch_reclaimer_t::num_retired() {
+    std::unique_lock lock(mutex);
+    return retired.size();
+}
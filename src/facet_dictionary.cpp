@@ -0,0 +1,161 @@
+#include "facet_dictionary.h"
+
+uint32_t facet_dictionary_t::add_value(uint64_t value_hash, const std::string& value, uint32_t& variant) {
+    auto ordinal_it = ordinals.find(value_hash);
+    uint32_t ordinal;
+
+    if(ordinal_it != ordinals.end()) {
+        ordinal = ordinal_it->second;
+    } else {
+        if(free_ordinals.empty()) {
+            ordinal = entries.size();
+            entries.push_back(entry_t{{}, value_hash, 0});
+        } else {
+            ordinal = free_ordinals.back();
+            free_ordinals.pop_back();
+            entries[ordinal].value_hash = value_hash;
+        }
+
+        ordinals.emplace(value_hash, ordinal);
+    }
+
+    entry_t& entry = entries[ordinal];
+    entry.ref_count++;
+
+    // almost every value has a single spelling, so the spellings are just scanned
+    size_t free_variant = entry.variants.size();
+
+    for(variant = 0; variant < entry.variants.size(); variant++) {
+        variant_t& entry_variant = entry.variants[variant];
+
+        if(entry_variant.ref_count != 0 && entry_variant.value == value) {
+            entry_variant.ref_count++;
+            return ordinal;
+        }
+
+        if(entry_variant.ref_count == 0 && free_variant == entry.variants.size()) {
+            free_variant = variant;
+        }
+    }
+
+    variant = free_variant;
+
+    if(variant == entry.variants.size()) {
+        entry.variants.push_back(variant_t{value, 1});
+    } else {
+        entry.variants[variant] = variant_t{value, 1};
+    }
+
+    return ordinal;
+}
+
+void facet_dictionary_t::remove_ordinal(uint32_t ordinal, uint32_t variant) {
+    entry_t& entry = entries[ordinal];
+
+    if(entry.ref_count == 0) {
+        return ;
+    }
+
+    variant_t& entry_variant = entry.variants[variant];
+
+    if(entry_variant.ref_count != 0 && --entry_variant.ref_count == 0) {
+        std::string().swap(entry_variant.value);
+    }
+
+    if(--entry.ref_count != 0) {
+        return ;
+    }
+
+    ordinals.erase(entry.value_hash);
+    std::vector<variant_t>().swap(entry.variants);
+    free_ordinals.push_back(ordinal);
+}
+
+void facet_dictionary_t::add(uint32_t seq_id, const std::vector<uint64_t>& value_hashes,
+                             const std::vector<std::string>& values) {
+    const uint32_t slot = seq_id / stride;
+
+    if(slot >= doc_lengths.size()) {
+        doc_offsets.resize(slot + 1, 0);
+        doc_lengths.resize(slot + 1, 0);
+    } else if(doc_lengths[slot] != 0) {
+        remove(seq_id);
+    }
+
+    doc_offsets[slot] = doc_ordinals.size();
+
+    for(size_t i = 0; i < value_hashes.size() && i < values.size(); i++) {
+        uint32_t variant;
+        doc_ordinals.push_back(add_value(value_hashes[i], values[i], variant));
+        doc_variants.push_back(variant);
+    }
+
+    doc_lengths[slot] = doc_ordinals.size() - doc_offsets[slot];
+}
+
+void facet_dictionary_t::remove(uint32_t seq_id) {
+    const uint32_t slot = seq_id / stride;
+
+    if(slot >= doc_lengths.size() || doc_lengths[slot] == 0) {
+        return ;
+    }
+
+    for(uint32_t i = 0; i < doc_lengths[slot]; i++) {
+        remove_ordinal(doc_ordinals[doc_offsets[slot] + i], doc_variants[doc_offsets[slot] + i]);
+    }
+
+    num_stale_ordinals += doc_lengths[slot];
+    doc_lengths[slot] = 0;
+
+    if(num_stale_ordinals > 1024 && num_stale_ordinals > doc_ordinals.size() / 2) {
+        compact();
+    }
+}
+
+void facet_dictionary_t::compact() {
+    std::vector<uint32_t> live_ordinals, live_variants;
+    live_ordinals.reserve(doc_ordinals.size() - num_stale_ordinals);
+    live_variants.reserve(doc_variants.size() - num_stale_ordinals);
+
+    for(size_t slot = 0; slot < doc_lengths.size(); slot++) {
+        const uint32_t offset = doc_offsets[slot];
+        doc_offsets[slot] = live_ordinals.size();
+        live_ordinals.insert(live_ordinals.end(), doc_ordinals.begin() + offset,
+                             doc_ordinals.begin() + offset + doc_lengths[slot]);
+        live_variants.insert(live_variants.end(), doc_variants.begin() + offset,
+                             doc_variants.begin() + offset + doc_lengths[slot]);
+    }
+
+    doc_ordinals = std::move(live_ordinals);
+    doc_variants = std::move(live_variants);
+    num_stale_ordinals = 0;
+}
+
+bool facet_dictionary_t::get(uint64_t value_hash, std::string& value) const {
+    const auto ordinal_it = ordinals.find(value_hash);
+
+    if(ordinal_it == ordinals.end()) {
+        return false;
+    }
+
+    for(const variant_t& variant: entries[ordinal_it->second].variants) {
+        if(variant.ref_count != 0) {
+            value = variant.value;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+size_t facet_dictionary_t::size() const {
+    return ordinals.size();
+}
+
+size_t facet_dictionary_t::num_ordinals() const {
+    return entries.size();
+}
+
+uint64_t facet_dictionary_t::get_value_hash(uint32_t ordinal) const {
+    return entries[ordinal].value_hash;
+}
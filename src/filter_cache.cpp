@@ -0,0 +1,150 @@
+#include "filter_cache.h"
+
+// per entry bookkeeping: the list node, the map node, and the node in the keys of every field of the entry
+static constexpr size_t ENTRY_OVERHEAD_BYTES = sizeof(void*) * 8;
+
+filter_cache_t::filter_cache_t(size_t max_bytes): max_bytes(max_bytes) {
+
+}
+
+void filter_cache_t::erase(std::list<entry_t>::iterator entry_it) {
+    for(const std::string& field_name: entry_it->field_names) {
+        auto field_keys_it = field_keys.find(field_name);
+        if(field_keys_it == field_keys.end()) {
+            continue;
+        }
+
+        field_keys_it->second.erase(entry_it->key);
+        if(field_keys_it->second.empty()) {
+            field_keys.erase(field_keys_it);
+        }
+    }
+
+    num_bytes -= entry_it->num_bytes;
+    entry_map.erase(entry_it->key);
+    entries.erase(entry_it);
+}
+
+bool filter_cache_t::get(const std::string& key, uint32_t** ids, size_t& ids_len) {
+    std::unique_lock lock(mutex);
+
+    auto entry_map_it = entry_map.find(key);
+    if(entry_map_it == entry_map.end()) {
+        return false;
+    }
+
+    auto entry_it = entry_map_it->second;
+    entries.splice(entries.begin(), entries, entry_it);
+
+    ids_len = entry_it->ids.getLength();
+    *ids = (ids_len == 0) ? nullptr : entry_it->ids.uncompress();
+    num_hits++;
+
+    return true;
+}
+
+void filter_cache_t::insert(const std::string& key, const std::vector<std::string>& field_names,
+                            const uint32_t* ids, size_t ids_len) {
+    std::unique_lock lock(mutex);
+
+    if(max_bytes == 0) {
+        return ;
+    }
+
+    auto entry_map_it = entry_map.find(key);
+    if(entry_map_it != entry_map.end()) {
+        erase(entry_map_it->second);
+    }
+
+    entries.emplace_front();
+    entry_t& entry = entries.front();
+    entry.key = key;
+    entry.field_names = field_names;
+    entry.ids.load(ids, ids_len);
+
+    entry.num_bytes = ENTRY_OVERHEAD_BYTES + key.size() * 2 + entry.ids.getSizeInBytes();
+    for(const std::string& field_name: field_names) {
+        entry.num_bytes += field_name.size() * 2 + key.size();
+    }
+
+    if(entry.num_bytes > max_bytes) {
+        entries.pop_front();
+        return ;
+    }
+
+    num_bytes += entry.num_bytes;
+
+    entry_map.emplace(key, entries.begin());
+    for(const std::string& field_name: field_names) {
+        field_keys[field_name].insert(key);
+    }
+
+    while(num_bytes > max_bytes) {
+        erase(std::prev(entries.end()));
+    }
+}
+
+void filter_cache_t::invalidate(const std::string& field_name) {
+    std::unique_lock lock(mutex);
+
+    auto field_keys_it = field_keys.find(field_name);
+    if(field_keys_it == field_keys.end()) {
+        return ;
+    }
+
+    // erasing the entries updates `field_keys`
+    const std::unordered_set<std::string> keys = field_keys_it->second;
+    for(const std::string& key: keys) {
+        auto entry_map_it = entry_map.find(key);
+        if(entry_map_it != entry_map.end()) {
+            erase(entry_map_it->second);
+        }
+    }
+}
+
+void filter_cache_t::clear() {
+    std::unique_lock lock(mutex);
+    entries.clear();
+    entry_map.clear();
+    field_keys.clear();
+    num_bytes = 0;
+}
+
+size_t filter_cache_t::size() const {
+    std::unique_lock lock(mutex);
+    return entries.size();
+}
+
+size_t filter_cache_t::size_bytes() const {
+    std::unique_lock lock(mutex);
+    return num_bytes;
+}
+
+size_t filter_cache_t::get_num_hits() const {
+    std::unique_lock lock(mutex);
+    return num_hits;
+}
+
+std::string filter_cache_t::get_key(const filter& a_filter) {
+    // length prefixed, so that the values can hold any character
+    std::string key = std::to_string(a_filter.field_name.size()) + ":" + a_filter.field_name;
+
+    for(size_t i = 0; i < a_filter.values.size(); i++) {
+        const int comparator = (i < a_filter.comparators.size()) ? int(a_filter.comparators[i]) : -1;
+        key += ":" + std::to_string(comparator);
+        key += ":" + std::to_string(a_filter.values[i].size()) + ":" + a_filter.values[i];
+    }
+
+    return key;
+}
+
+std::string filter_cache_t::get_key(const std::vector<filter>& filters) {
+    std::string key;
+
+    for(const filter& a_filter: filters) {
+        const std::string& filter_key = get_key(a_filter);
+        key += std::to_string(filter_key.size()) + "|" + filter_key;
+    }
+
+    return key;
+}
@@ -17,7 +17,7 @@ HttpServer::HttpServer(const std::string & version, const std::string & listen_a
                        SSL_REFRESH_INTERVAL_MS(ssl_refresh_interval_ms),
                        exit_loop(false), version(version), listen_address(listen_address), listen_port(listen_port),
                        ssl_cert_path(ssl_cert_path), ssl_cert_key_path(ssl_cert_key_path),
-                       cors_enabled(cors_enabled), thread_pool(thread_pool) {
+                       cors_enabled(cors_enabled), thread_pool(thread_pool), request_scheduler(nullptr) {
     accept_ctx = new h2o_accept_ctx_t();
     h2o_config_init(&config);
     hostconf = h2o_config_register_host(&config, h2o_iovec_init(H2O_STRLIT("default")), 65535);
@@ -390,8 +390,23 @@ int HttpServer::catch_all_handler(h2o_handler_t *_h2o_handler, h2o_req_t *req) {
         return send_response(req, 401, message);
     }
 
+    // writes are applied one by one by the raft thread, so their admission is capped by the number in flight
+    std::unique_ptr<schedule_slot_t> schedule_slot;
+    RequestScheduler* request_scheduler = h2o_handler->http_server->request_scheduler;
+
+    if(request_scheduler != nullptr && is_write_request(root_resource, http_method)) {
+        schedule_class_t schedule_class = RequestScheduler::get_schedule_class(rpath->path_parts, true);
+        schedule_slot = request_scheduler->acquire(schedule_class);
+
+        if(schedule_slot == nullptr) {
+            std::string message = "{ \"message\": \"Too many concurrent writes, try again later.\"}";
+            return send_response(req, 503, message);
+        }
+    }
+
     std::shared_ptr<http_req> request = std::make_shared<http_req>(req, rpath->http_method, path_without_query,
                                                                    route_hash, query_map, body);
+    request->schedule_slot = std::move(schedule_slot);
     std::shared_ptr<http_res> response = std::make_shared<http_res>();
 
     // add custom generator with a dispose function for cleaning up resources
@@ -547,8 +562,7 @@ int HttpServer::process_request(const std::shared_ptr<http_req>& request, const
     auto message_dispatcher = handler->http_server->get_message_dispatcher();
 
     // LOG(INFO) << "Before enqueue res: " << response
-    handler->http_server->get_thread_pool()->enqueue([http_server, rpath, message_dispatcher,
-                                                      request, response]() {
+    auto process = [http_server, rpath, message_dispatcher, request, response]() {
         // call the API handler
         //LOG(INFO) << "Wait for response " << response.get() << ", action: " << rpath->_get_action();
         (rpath->handler)(request, response);
@@ -560,7 +574,31 @@ int HttpServer::process_request(const std::shared_ptr<http_req>& request, const
             response->wait();
         }
         //LOG(INFO) << "Response done " << response.get();
-    });
+    };
+
+    RequestScheduler* request_scheduler = http_server->get_request_scheduler();
+
+    if(request_scheduler == nullptr) {
+        http_server->get_thread_pool()->enqueue(process);
+        return 0;
+    }
+
+    schedule_class_t schedule_class = RequestScheduler::get_schedule_class(rpath->path_parts, false);
+
+    // the later chunks of an async response (e.g. an export) are produced by `on_deferred_process_request()`, so the
+    // request keeps its slot until it is disposed of after the final chunk
+    auto process_in_slot = [process, request, async_res = rpath->async_res](std::unique_ptr<schedule_slot_t>& slot) {
+        if(async_res) {
+            request->schedule_slot = std::move(slot);
+        }
+
+        process();
+    };
+
+    if(!request_scheduler->submit_with_slot(schedule_class, process_in_slot)) {
+        response->set_503("Too many concurrent requests, try again later.");
+        http_server->send_response(request, response);
+    }
 
     return 0;
 }
@@ -785,6 +823,10 @@ void HttpServer::set_auth_handler(bool (*handler)(std::map<std::string, std::str
     auth_handler = handler;
 }
 
+void HttpServer::set_request_scheduler(RequestScheduler* scheduler) {
+    request_scheduler = scheduler;
+}
+
 void HttpServer::get(const std::string & path, bool (*handler)(const std::shared_ptr<http_req>&, const std::shared_ptr<http_res>&), bool async_req, bool async_res) {
     std::vector<std::string> path_parts;
     StringUtils::split(path, path_parts, "/");
@@ -936,6 +978,10 @@ ThreadPool* HttpServer::get_thread_pool() const {
     return thread_pool;
 }
 
+RequestScheduler* HttpServer::get_request_scheduler() const {
+    return request_scheduler;
+}
+
 bool HttpServer::initialize_ssl_ctx(const char *cert_file, const char *key_file, h2o_accept_ctx_t* accept_ctx) {
     SSL_CTX* new_ctx = SSL_CTX_new(SSLv23_server_method());
 
@@ -0,0 +1,154 @@
+#include "id_bitmap.h"
+#include <algorithm>
+
+static constexpr size_t BITMAP_WORDS = (1 << 16) / 64;
+
+void id_bitmap_t::load_container(container_t& container, const uint32_t* ids, size_t len) {
+    size_t num_runs = 1;
+    for(size_t i = 1; i < len; i++) {
+        num_runs += (ids[i] != ids[i-1] + 1);
+    }
+
+    const size_t array_bytes = len * sizeof(uint16_t);
+    const size_t bitmap_bytes = BITMAP_WORDS * sizeof(uint64_t);
+    const size_t run_bytes = num_runs * 2 * sizeof(uint16_t);
+
+    if(run_bytes < array_bytes && run_bytes < bitmap_bytes) {
+        container.type = RUN;
+        container.values.reserve(num_runs * 2);
+
+        size_t run_start = 0;
+        for(size_t i = 1; i <= len; i++) {
+            if(i == len || ids[i] != ids[i-1] + 1) {
+                container.values.push_back(uint16_t(ids[run_start]));
+                container.values.push_back(uint16_t(i - run_start - 1));
+                run_start = i;
+            }
+        }
+    } else if(len <= MAX_ARRAY_SIZE) {
+        container.type = ARRAY;
+        container.values.reserve(len);
+
+        for(size_t i = 0; i < len; i++) {
+            container.values.push_back(uint16_t(ids[i]));
+        }
+    } else {
+        container.type = BITMAP;
+        container.words.resize(BITMAP_WORDS, 0);
+
+        for(size_t i = 0; i < len; i++) {
+            const uint16_t low = uint16_t(ids[i]);
+            container.words[low >> 6] |= (uint64_t(1) << (low & 63));
+        }
+    }
+}
+
+bool id_bitmap_t::container_contains(const container_t& container, uint16_t low) {
+    switch(container.type) {
+        case ARRAY:
+            return std::binary_search(container.values.begin(), container.values.end(), low);
+        case BITMAP:
+            return (container.words[low >> 6] >> (low & 63)) & 1;
+        default: {
+            // last run starting at or before `low`
+            size_t lo = 0, hi = container.values.size() / 2;
+            while(lo < hi) {
+                const size_t mid = (lo + hi) / 2;
+                if(container.values[mid * 2] <= low) {
+                    lo = mid + 1;
+                } else {
+                    hi = mid;
+                }
+            }
+
+            if(lo == 0) {
+                return false;
+            }
+
+            const uint16_t run_start = container.values[(lo - 1) * 2];
+            const uint16_t run_length = container.values[(lo - 1) * 2 + 1];
+            return low - run_start <= run_length;
+        }
+    }
+}
+
+void id_bitmap_t::clear() {
+    containers.clear();
+    num_ids = 0;
+}
+
+bool id_bitmap_t::is_dense(const uint32_t* sorted_ids, size_t len) {
+    if(sorted_ids == nullptr || len < MIN_BITMAP_IDS) {
+        return false;
+    }
+
+    const uint64_t range = uint64_t(sorted_ids[len - 1]) - sorted_ids[0] + 1;
+    return len * MAX_SPARSITY >= range;
+}
+
+void id_bitmap_t::load(const uint32_t* sorted_ids, size_t len) {
+    clear();
+
+    size_t start = 0;
+    while(start < len) {
+        const uint16_t key = sorted_ids[start] >> 16;
+        size_t end = start + 1;
+        while(end < len && (sorted_ids[end] >> 16) == key) {
+            end++;
+        }
+
+        containers.emplace_back();
+        containers.back().key = key;
+        load_container(containers.back(), sorted_ids + start, end - start);
+        start = end;
+    }
+
+    num_ids = len;
+}
+
+bool id_bitmap_t::contains(uint32_t id) const {
+    const uint16_t key = id >> 16;
+    const auto it = std::lower_bound(containers.begin(), containers.end(), key,
+                                     [](const container_t& container, uint16_t k) { return container.key < k; });
+
+    return it != containers.end() && it->key == key && container_contains(*it, uint16_t(id));
+}
+
+size_t id_bitmap_t::intersect(const uint32_t* sorted_ids, size_t len, uint32_t* out) const {
+    size_t count = 0;
+    size_t container_index = 0;
+
+    for(size_t i = 0; i < len && container_index < containers.size(); i++) {
+        const uint16_t key = sorted_ids[i] >> 16;
+
+        // ids are sorted, so containers are only ever visited in order
+        while(container_index < containers.size() && containers[container_index].key < key) {
+            container_index++;
+        }
+
+        if(container_index < containers.size() && containers[container_index].key == key &&
+           container_contains(containers[container_index], uint16_t(sorted_ids[i]))) {
+            out[count++] = sorted_ids[i];
+        }
+    }
+
+    return count;
+}
+
+size_t id_bitmap_t::size() const {
+    return num_ids;
+}
+
+size_t id_bitmap_t::num_containers() const {
+    return containers.size();
+}
+
+uint64_t id_bitmap_t::memory_bytes() const {
+    uint64_t total = sizeof(id_bitmap_t) + containers.capacity() * sizeof(container_t);
+
+    for(const container_t& container: containers) {
+        total += container.values.capacity() * sizeof(uint16_t) + container.words.capacity() * sizeof(uint64_t);
+    }
+
+    return total;
+}
@@ -0,0 +1,82 @@
+#include "impact_ids.h"
+#include <algorithm>
+
+size_t impact_ids_t::block_of(const entry_t& entry) const {
+    const auto it = std::lower_bound(blocks.begin(), blocks.end(), entry,
+                                     [](const std::vector<entry_t>& block, const entry_t& e) {
+                                         return precedes(block.back(), e);
+                                     });
+
+    return std::min(size_t(it - blocks.begin()), blocks.size() - 1);
+}
+
+void impact_ids_t::erase_entry(size_t block_index, size_t entry_index) {
+    std::vector<entry_t>& block = blocks[block_index];
+    block.erase(block.begin() + entry_index);
+    num_ids--;
+
+    if(block.empty()) {
+        blocks.erase(blocks.begin() + block_index);
+    }
+}
+
+void impact_ids_t::insert(int64_t points, uint32_t id) {
+    const entry_t entry{points, id};
+
+    if(blocks.empty()) {
+        blocks.push_back({entry});
+        num_ids++;
+        return ;
+    }
+
+    const size_t block_index = block_of(entry);
+    std::vector<entry_t>& block = blocks[block_index];
+    block.insert(std::lower_bound(block.begin(), block.end(), entry, precedes), entry);
+    num_ids++;
+
+    if(block.size() > BLOCK_SIZE) {
+        // split the block into two halves
+        std::vector<entry_t> upper(block.begin() + block.size() / 2, block.end());
+        block.resize(block.size() / 2);
+        blocks.insert(blocks.begin() + block_index + 1, std::move(upper));
+    }
+}
+
+void impact_ids_t::remove(int64_t points, uint32_t id) {
+    if(blocks.empty()) {
+        return ;
+    }
+
+    const entry_t entry{points, id};
+    const size_t block_index = block_of(entry);
+    const std::vector<entry_t>& block = blocks[block_index];
+    const auto it = std::lower_bound(block.begin(), block.end(), entry, precedes);
+
+    if(it != block.end() && it->points == points && it->id == id) {
+        erase_entry(block_index, it - block.begin());
+        return ;
+    }
+
+    for(size_t i = 0; i < blocks.size(); i++) {
+        for(size_t j = 0; j < blocks[i].size(); j++) {
+            if(blocks[i][j].id == id) {
+                erase_entry(i, j);
+                return ;
+            }
+        }
+    }
+}
+
+size_t impact_ids_t::size() const {
+    return num_ids;
+}
+
+uint64_t impact_ids_t::memory_bytes() const {
+    uint64_t total = sizeof(impact_ids_t) + blocks.capacity() * sizeof(std::vector<entry_t>);
+
+    for(const auto& block: blocks) {
+        total += block.capacity() * sizeof(entry_t);
+    }
+
+    return total;
+}
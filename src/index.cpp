@@ -3,6 +3,7 @@
 #include <numeric>
 #include <chrono>
 #include <set>
+#include <random>
 #include <unordered_map>
 #include <array_utils.h>
 #include <match_score.h>
@@ -13,14 +14,21 @@
 #include "logger.h"
 
 Index::Index(const std::string name, const std::unordered_map<std::string, field> & search_schema,
-             std::map<std::string, field> facet_schema, std::unordered_map<std::string, field> sort_schema):
-        name(name), search_schema(search_schema), facet_schema(facet_schema), sort_schema(sort_schema) {
+             std::map<std::string, field> facet_schema, std::unordered_map<std::string, field> sort_schema,
+             uint32_t num_memory_shards, const std::string& impact_sorting_field, size_t filter_cache_max_bytes):
+        name(name), search_schema(search_schema), facet_schema(facet_schema), sort_schema(sort_schema),
+        num_memory_shards(num_memory_shards), impact_sorting_field(impact_sorting_field),
+        filter_cache(filter_cache_max_bytes) {
 
     for(const auto & fname_field: search_schema) {
         if(fname_field.second.is_string()) {
             art_tree *t = new art_tree;
             art_tree_init(t);
             search_index.emplace(fname_field.first, t);
+
+            if(fname_field.second.typo_index) {
+                typo_index.emplace(fname_field.first, new typo_index_t);
+            }
         } else {
             num_tree_t* num_tree = new num_tree_t;
             numerical_index.emplace(fname_field.first, num_tree);
@@ -35,13 +43,13 @@ Index::Index(const std::string name, const std::unordered_map<std::string, field
     }
 
     for(const auto & pair: sort_schema) {
-        spp::sparse_hash_map<uint32_t, int64_t> * doc_to_score = new spp::sparse_hash_map<uint32_t, int64_t>();
-        sort_index.emplace(pair.first, doc_to_score);
+        sort_index.emplace(pair.first, new sort_column_t(num_memory_shards));
     }
 
     for(const auto& pair: facet_schema) {
         spp::sparse_hash_map<uint32_t, facet_hash_values_t> *doc_to_values = new spp::sparse_hash_map<uint32_t, facet_hash_values_t>();
         facet_index_v3.emplace(pair.first, doc_to_values);
+        facet_dictionaries.emplace(pair.first, new facet_dictionary_t(num_memory_shards));
     }
 
     num_documents = 0;
@@ -50,6 +58,9 @@ Index::Index(const std::string name, const std::unordered_map<std::string, field
 Index::~Index() {
     std::unique_lock lock(mutex);
 
+    // retired leaves belong to the arenas of the trees
+    reclaimer.reclaim_all();
+
     for(auto & name_tree: search_index) {
         art_tree_destroy(name_tree.second);
         delete name_tree.second;
@@ -63,6 +74,13 @@ Index::~Index() {
 
     search_index.clear();
 
+    for(auto & name_typo_index: typo_index) {
+        delete name_typo_index.second;
+        name_typo_index.second = nullptr;
+    }
+
+    typo_index.clear();
+
     for(auto & name_map: sort_index) {
         delete name_map.second;
         name_map.second = nullptr;
@@ -76,17 +94,20 @@ Index::~Index() {
     }
 
     facet_index_v3.clear();
+
+    for(auto& kv: facet_dictionaries) {
+        delete kv.second;
+        kv.second = nullptr;
+    }
+
+    facet_dictionaries.clear();
 }
 
 int64_t Index::get_points_from_doc(const nlohmann::json &document, const std::string & default_sorting_field) {
     int64_t points = 0;
 
     if(document[default_sorting_field].is_number_float()) {
-        // serialize float to an integer and reverse the inverted range
-        float n = document[default_sorting_field];
-        memcpy(&points, &n, sizeof(int32_t));
-        points ^= ((points >> (std::numeric_limits<int32_t>::digits - 1)) | INT32_MIN);
-        points = -1 * (INT32_MAX - points);
+        points = float_to_points(document[default_sorting_field].get<float>());
     } else {
         points = document[default_sorting_field];
     }
@@ -94,6 +115,15 @@ int64_t Index::get_points_from_doc(const nlohmann::json &document, const std::st
     return points;
 }
 
+int64_t Index::float_to_points(float n) {
+    // serialize float to an integer and reverse the inverted range
+    int64_t points = 0;
+    memcpy(&points, &n, sizeof(int32_t));
+    points ^= ((points >> (std::numeric_limits<int32_t>::digits - 1)) | INT32_MIN);
+    points = -1 * (INT32_MAX - points);
+    return points;
+}
+
 int64_t Index::float_to_in64_t(float f) {
     // https://stackoverflow.com/questions/60530255/convert-float-to-int64-t-while-preserving-ordering
     int32_t i;
@@ -108,12 +138,18 @@ Option<uint32_t> Index::index_in_memory(const nlohmann::json &document, uint32_t
                                         const std::string & default_sorting_field) {
 
     std::unique_lock lock(mutex);
+    return do_index_in_memory(document, seq_id, default_sorting_field);
+}
+
+Option<uint32_t> Index::do_index_in_memory(const nlohmann::json &document, uint32_t seq_id,
+                                           const std::string & default_sorting_field) {
+    invalidate_filter_cache(document);
 
     int64_t points = 0;
 
     if(document.count(default_sorting_field) == 0) {
-        if(sort_index.count(default_sorting_field) != 0 && sort_index[default_sorting_field]->count(seq_id)) {
-            points = sort_index[default_sorting_field]->at(seq_id);
+        if(sort_index.count(default_sorting_field) != 0 && sort_index[default_sorting_field]->contains(seq_id)) {
+            points = sort_index[default_sorting_field]->get(seq_id, INT64_MIN);
         } else {
             points = INT64_MIN;
         }
@@ -243,20 +279,20 @@ Option<uint32_t> Index::index_in_memory(const nlohmann::json &document, uint32_t
         if(field_pair.second.type == field_types::INT32 || field_pair.second.type == field_types::INT64 ||
            field_pair.second.type == field_types::FLOAT || field_pair.second.type == field_types::BOOL ||
            field_pair.second.type == field_types::GEOPOINT) {
-            spp::sparse_hash_map<uint32_t, int64_t> *doc_to_score = sort_index.at(field_pair.first);
+            sort_column_t *doc_to_score = sort_index.at(field_pair.first);
 
             if(field_pair.second.is_integer() ) {
-                doc_to_score->emplace(seq_id, document[field_pair.first].get<int64_t>());
+                doc_to_score->set(seq_id, document[field_pair.first].get<int64_t>());
             } else if(field_pair.second.is_float()) {
                 int64_t ifloat = float_to_in64_t(document[field_pair.first].get<float>());
-                doc_to_score->emplace(seq_id, ifloat);
+                doc_to_score->set(seq_id, ifloat);
             } else if(field_pair.second.is_bool()) {
-                doc_to_score->emplace(seq_id, (int64_t) document[field_pair.first].get<bool>());
+                doc_to_score->set(seq_id, (int64_t) document[field_pair.first].get<bool>());
             } else if(field_pair.second.is_geopoint()) {
                 const std::vector<double>& latlong = document[field_pair.first];
                 GeoCoord x {degsToRads(latlong[0]), degsToRads(latlong[1])};
                 H3Index geoHash = geoToH3(&x, FINEST_GEO_RESOLUTION);
-                doc_to_score->emplace(seq_id, (int64_t)(geoHash));
+                doc_to_score->set(seq_id, (int64_t)(geoHash));
             }
         }
     }
@@ -391,6 +427,25 @@ Option<uint32_t> Index::validate_index_in_memory(nlohmann::json& document, uint3
 void Index::scrub_reindex_doc(nlohmann::json& update_doc, nlohmann::json& del_doc, nlohmann::json& old_doc) {
     std::vector<std::string> del_keys;
 
+    // impact ordered ids are sorted on the points of the documents, so when the points of a document change, its
+    // string fields have to be indexed again, even when their values have not changed
+    const bool reindex_strings = !impact_sorting_field.empty() && update_doc.count(impact_sorting_field) != 0 &&
+                                 (old_doc.count(impact_sorting_field) == 0 ||
+                                  update_doc[impact_sorting_field] != old_doc[impact_sorting_field]);
+
+    if(reindex_strings) {
+        std::shared_lock lock(mutex);
+
+        for(const auto& field_pair: search_schema) {
+            const field& search_field = field_pair.second;
+            if(is_impact_ordered(search_field) && search_field.index && old_doc.count(search_field.name) != 0 &&
+               update_doc.count(search_field.name) == 0) {
+                update_doc[search_field.name] = old_doc[search_field.name];
+                del_doc[search_field.name] = old_doc[search_field.name];
+            }
+        }
+    }
+
     for(auto it = del_doc.cbegin(); it != del_doc.cend(); it++) {
         const std::string& field_name = it.key();
 
@@ -405,6 +460,10 @@ void Index::scrub_reindex_doc(nlohmann::json& update_doc, nlohmann::json& del_do
 
         lock.unlock();
 
+        if(reindex_strings && is_impact_ordered(search_field)) {
+            continue;
+        }
+
         // compare values between old and update docs:
         // if they match, we will remove them from both del and update docs
 
@@ -427,12 +486,23 @@ size_t Index::batch_memory_index(Index *index, std::vector<index_record> & iter_
 
     size_t num_indexed = 0;
 
+    // the write lock is held over consecutive documents for up to WRITE_LOCK_BUDGET_US, so that neither the import
+    // has to wait for a gap between searches before every document, nor searches for the whole batch. Searches
+    // never see a document that is half way through an update.
+    std::unique_lock<rw_mutex_t> lock(index->mutex, std::defer_lock);
+    auto lock_begin = std::chrono::steady_clock::now();
+
     for(auto & index_rec: iter_batch) {
         if(!index_rec.indexed.ok()) {
             // some records could have been invalidated upstream
             continue;
         }
 
+        if(lock.owns_lock() && std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::steady_clock::now() - lock_begin).count() >= int64_t(WRITE_LOCK_BUDGET_US)) {
+            lock.unlock();
+        }
+
         if(index_rec.operation != DELETE) {
             Option<uint32_t> validation_op = validate_index_in_memory(index_rec.doc, index_rec.seq_id,
                                                                       default_sorting_field,
@@ -447,16 +517,29 @@ size_t Index::batch_memory_index(Index *index, std::vector<index_record> & iter_
             }
 
             if(index_rec.is_update) {
+                // scrubbing takes the read lock of its own
+                if(lock.owns_lock()) {
+                    lock.unlock();
+                }
+
                 // scrub string fields to reduce delete ops
                 get_doc_changes(index_rec.doc, index_rec.old_doc, index_rec.new_doc, index_rec.del_doc);
                 index->scrub_reindex_doc(index_rec.doc, index_rec.del_doc, index_rec.old_doc);
-                index->remove(index_rec.seq_id, index_rec.del_doc);
+            }
+
+            if(!lock.owns_lock()) {
+                lock.lock();
+                lock_begin = std::chrono::steady_clock::now();
+            }
+
+            if(index_rec.is_update) {
+                index->do_remove(index_rec.seq_id, index_rec.del_doc);
             }
 
             Option<uint32_t> index_mem_op(0);
 
             try {
-                index_mem_op = index->index_in_memory(index_rec.doc, index_rec.seq_id, default_sorting_field);
+                index_mem_op = index->do_index_in_memory(index_rec.doc, index_rec.seq_id, default_sorting_field);
             } catch(const std::exception& e) {
                 const std::string& error_msg = std::string("Fatal error during indexing: ") + e.what();
                 LOG(ERROR) << error_msg << ", document: " << index_rec.doc;
@@ -464,7 +547,7 @@ size_t Index::batch_memory_index(Index *index, std::vector<index_record> & iter_
             }
 
             if(!index_mem_op.ok()) {
-                index->index_in_memory(index_rec.del_doc, index_rec.seq_id, default_sorting_field);
+                index->do_index_in_memory(index_rec.del_doc, index_rec.seq_id, default_sorting_field);
                 index_rec.index_failure(index_mem_op.code(), index_mem_op.error());
                 continue;
             }
@@ -481,7 +564,8 @@ size_t Index::batch_memory_index(Index *index, std::vector<index_record> & iter_
 }
 
 void Index::insert_doc(const int64_t score, art_tree *t, uint32_t seq_id,
-                       const std::unordered_map<std::string, std::vector<uint32_t>> &token_to_offsets) const {
+                       const std::unordered_map<std::string, std::vector<uint32_t>> &token_to_offsets,
+                       typo_index_t* field_typo_index, const bool impact_ordered) const {
     for(auto & kv: token_to_offsets) {
         art_document art_doc;
         art_doc.id = seq_id;
@@ -509,6 +593,23 @@ void Index::insert_doc(const int64_t score, art_tree *t, uint32_t seq_id,
         art_insert(t, key, key_len, &art_doc, num_hits);
         delete [] art_doc.offsets;
         art_doc.offsets = nullptr;
+
+        if(leaf == nullptr && (field_typo_index != nullptr || impact_ordered)) {
+            // a new token was added to the tree
+            leaf = (art_leaf *) art_search(t, key, key_len);
+
+            if(field_typo_index != nullptr) {
+                field_typo_index->insert(leaf);
+            }
+        }
+
+        if(impact_ordered) {
+            if(!leaf->values->impact_ids) {
+                leaf->values->impact_ids.reset(new impact_ids_t);
+            }
+
+            leaf->values->impact_ids->insert(score, seq_id);
+        }
     }
 }
 
@@ -556,7 +657,7 @@ void Index::index_string_field(const std::string & text, const int64_t score, ar
         LOG(INFO) << "field name: " << a_field.name;
     }*/
 
-    insert_doc(score, t, seq_id, token_to_offsets);
+    insert_doc(score, t, seq_id, token_to_offsets, get_typo_index(a_field), is_impact_ordered(a_field));
 
     if(is_facet) {
         facet_hash_values_t fhashvalues;
@@ -567,7 +668,10 @@ void Index::index_string_field(const std::string & text, const int64_t score, ar
             fhashvalues.hashes[i] = facet_hashes[i];
         }
 
-        facet_index_v3[a_field.name]->emplace(seq_id, std::move(fhashvalues));
+        const auto& emplace_result = facet_index_v3[a_field.name]->emplace(seq_id, std::move(fhashvalues));
+        if(emplace_result.second) {
+            add_facet_values(a_field, seq_id, emplace_result.first->second, {text});
+        }
     }
 }
 
@@ -624,58 +728,158 @@ void Index::index_string_array_field(const std::vector<std::string> & strings, c
             fhashvalues.hashes[i] = facet_hashes[i];
         }
 
-        facet_index_v3[a_field.name]->emplace(seq_id, std::move(fhashvalues));
+        const auto& emplace_result = facet_index_v3[a_field.name]->emplace(seq_id, std::move(fhashvalues));
+        if(emplace_result.second) {
+            add_facet_values(a_field, seq_id, emplace_result.first->second, strings);
+        }
     }
 
-    insert_doc(score, t, seq_id, token_positions);
+    insert_doc(score, t, seq_id, token_positions, get_typo_index(a_field), is_impact_ordered(a_field));
 }
 
-void Index::compute_facet_stats(facet &a_facet, uint64_t raw_value, const std::string & field_type) {
-    if(field_type == field_types::INT32 || field_type == field_types::INT32_ARRAY) {
-        int32_t val = raw_value;
-        if (val < a_facet.stats.fvmin) {
-            a_facet.stats.fvmin = val;
+void Index::get_facet_value_hashes(const facet_hash_values_t& fvalues, std::vector<uint64_t>& value_hashes) const {
+    uint64_t combined_hash = 1;
+    size_t field_token_index = -1;
+
+    // same combination of the token hashes as in do_facets()
+    for(size_t j = 0; j < fvalues.size(); j++) {
+        if(fvalues.hashes[j] != FACET_ARRAY_DELIMETER) {
+            field_token_index++;
+            combined_hash *= (1779033703 + 2*fvalues.hashes[j]*(field_token_index+1));
         }
-        if (val > a_facet.stats.fvmax) {
-            a_facet.stats.fvmax = val;
+
+        if(fvalues.hashes[j] == FACET_ARRAY_DELIMETER ||
+           (fvalues.back() != FACET_ARRAY_DELIMETER && j == fvalues.size() - 1)) {
+            value_hashes.push_back(combined_hash);
+            combined_hash = 1;
+            field_token_index = -1;
         }
-        a_facet.stats.fvsum += val;
-        a_facet.stats.fvcount++;
-    } else if(field_type == field_types::INT64 || field_type == field_types::INT64_ARRAY) {
-        int64_t val = raw_value;
-        if(val < a_facet.stats.fvmin) {
-            a_facet.stats.fvmin = val;
+    }
+}
+
+void Index::add_facet_values(const field& a_field, uint32_t seq_id, const facet_hash_values_t& fvalues,
+                             const std::vector<std::string>& values) {
+    const auto dictionary_it = facet_dictionaries.find(a_field.name);
+    if(dictionary_it == facet_dictionaries.end()) {
+        return ;
+    }
+
+    std::vector<uint64_t> value_hashes;
+    get_facet_value_hashes(fvalues, value_hashes);
+
+    std::vector<std::string> display_values;
+    for(const std::string& value: values) {
+        display_values.push_back(get_facet_display_value(a_field, value));
+    }
+
+    dictionary_it->second->add(seq_id, value_hashes, display_values);
+}
+
+std::string Index::get_facet_display_value(const field& a_field, const std::string& text) {
+    std::string value = text;
+
+    if(a_field.is_float()) {
+        value.erase(value.find_last_not_of('0') + 1, std::string::npos);  // remove trailing zeros
+    } else if(a_field.is_bool()) {
+        value = (value == "1") ? "true" : "false";
+    }
+
+    return value;
+}
+
+bool Index::get_facet_value(const std::string& field_name, uint64_t value_hash, std::string& value) const {
+    std::shared_lock lock(mutex);
+
+    const auto dictionary_it = facet_dictionaries.find(field_name);
+    if(dictionary_it == facet_dictionaries.end()) {
+        return false;
+    }
+
+    return dictionary_it->second->get(value_hash, value);
+}
+
+size_t Index::get_facet_dictionary_size(const std::string& field_name) const {
+    std::shared_lock lock(mutex);
+
+    const auto dictionary_it = facet_dictionaries.find(field_name);
+    return (dictionary_it == facet_dictionaries.end()) ? 0 : dictionary_it->second->size();
+}
+
+void Index::compute_facet_stats(facet &a_facet, const uint64_t* raw_values, size_t num_values,
+                                const std::string & field_type) {
+    if(num_values == 0) {
+        return ;
+    }
+
+    if(num_values > FACET_STATS_BLOCK_SIZE) {
+        for(size_t offset = 0; offset < num_values; offset += FACET_STATS_BLOCK_SIZE) {
+            compute_facet_stats(a_facet, raw_values + offset, std::min(FACET_STATS_BLOCK_SIZE, num_values - offset),
+                                field_type);
         }
-        if(val > a_facet.stats.fvmax) {
-            a_facet.stats.fvmax = val;
+        return ;
+    }
+
+    facet_stats_t& stats = a_facet.stats;
+
+    if(field_type == field_types::INT32 || field_type == field_types::INT32_ARRAY) {
+        int32_t values[FACET_STATS_BLOCK_SIZE];
+        for(size_t i = 0; i < num_values; i++) {
+            values[i] = int32_t(raw_values[i]);
         }
-        a_facet.stats.fvsum += val;
-        a_facet.stats.fvcount++;
+
+        int32_t min, max;
+        int64_t sum;
+        ArrayUtils::stats_int32(values, num_values, min, max, sum);
+
+        stats.fvmin = std::min<double>(stats.fvmin, min);
+        stats.fvmax = std::max<double>(stats.fvmax, max);
+        stats.fvsum += sum;
+    } else if(field_type == field_types::INT64 || field_type == field_types::INT64_ARRAY) {
+        int64_t min, max;
+        double sum;
+        ArrayUtils::stats_int64(reinterpret_cast<const int64_t*>(raw_values), num_values, min, max, sum);
+
+        stats.fvmin = std::min<double>(stats.fvmin, min);
+        stats.fvmax = std::max<double>(stats.fvmax, max);
+        stats.fvsum += sum;
     } else if(field_type == field_types::FLOAT || field_type == field_types::FLOAT_ARRAY) {
-        float val = reinterpret_cast<float&>(raw_value);
-        if(val < a_facet.stats.fvmin) {
-            a_facet.stats.fvmin = val;
+        // the float is held in the lower bytes of the raw value
+        float values[FACET_STATS_BLOCK_SIZE];
+        for(size_t i = 0; i < num_values; i++) {
+            const uint32_t float_bits = uint32_t(raw_values[i]);
+            memcpy(&values[i], &float_bits, sizeof(float));
         }
-        if(val > a_facet.stats.fvmax) {
-            a_facet.stats.fvmax = val;
-        }
-        a_facet.stats.fvsum += val;
-        a_facet.stats.fvcount++;
+
+        float min, max;
+        double sum;
+        ArrayUtils::stats_float(values, num_values, min, max, sum);
+
+        stats.fvmin = std::min<double>(stats.fvmin, min);
+        stats.fvmax = std::max<double>(stats.fvmax, max);
+        stats.fvsum += sum;
+    } else {
+        return ;
     }
+
+    stats.fvcount += num_values;
 }
 
 void Index::do_facets(std::vector<facet> & facets, facet_query_t & facet_query,
                       size_t group_limit, const std::vector<std::string>& group_by_fields,
-                      const uint32_t* result_ids, size_t results_size) const {
+                      const uint32_t* result_ids, size_t results_size,
+                      size_t facet_sample_percent, size_t facet_sample_threshold,
+                      ThreadPool* thread_pool) const {
 
-    struct facet_info_t {
-        // facet hash => token position in the query
-        std::unordered_map<uint64_t, token_pos_cost_t> fhash_qtoken_pos;
+    // the groups of grouped results can not be scaled up, so those are always counted in full
+    const bool use_sample = (group_limit == 0 && facet_sample_percent < 100 && results_size > facet_sample_threshold);
+    std::vector<uint32_t> sampled_ids;
+    const size_t all_results_size = results_size;
 
-        bool use_facet_query = false;
-        bool should_compute_stats = false;
-        field facet_field{"", "", false};
-    };
+    if(use_sample) {
+        sample_result_ids(result_ids, results_size, facet_sample_percent, sampled_ids);
+        result_ids = sampled_ids.data();
+        results_size = sampled_ids.size();
+    }
 
     std::vector<facet_info_t> facet_infos(facets.size());
 
@@ -738,122 +942,335 @@ void Index::do_facets(std::vector<facet> & facets, facet_query_t & facet_query,
     }
 
     // assumed that facet fields have already been validated upstream
-    for(size_t findex=0; findex < facets.size(); findex++) {
-        auto& a_facet = facets[findex];
-        const auto& facet_field = facet_infos[findex].facet_field;
-        const bool use_facet_query = facet_infos[findex].use_facet_query;
-        const auto& fhash_qtoken_pos = facet_infos[findex].fhash_qtoken_pos;
-        const bool should_compute_stats = facet_infos[findex].should_compute_stats;
+    if(thread_pool == nullptr || results_size < FACET_PARALLEL_MIN_RESULTS) {
+        for(size_t findex=0; findex < facets.size(); findex++) {
+            compute_facet(facets[findex], facet_infos[findex], group_limit, group_by_fields, result_ids, results_size);
+        }
+    } else {
+        // every field is counted by a task of its own, which in turn counts chunks of the results in parallel
+        const size_t num_chunks = std::min(thread_pool->get_num_threads(),
+                                           results_size / FACET_PARALLEL_MIN_RESULTS);
 
-        const auto& field_facet_mapping_it = facet_index_v3.find(a_facet.field_name);
-        if(field_facet_mapping_it == facet_index_v3.end()) {
-            continue;
+        std::vector<std::future<void>> facet_futures;
+
+        for(size_t findex = 1; findex < facets.size(); findex++) {
+            facet_futures.push_back(thread_pool->enqueue_with_priority(ThreadPool::HIGH, [&, findex]() {
+                compute_facet_chunks(facets[findex], facet_infos[findex], group_limit, group_by_fields,
+                                     result_ids, results_size, num_chunks, thread_pool);
+            }));
         }
 
-        const auto& field_facet_mapping = field_facet_mapping_it->second;
+        if(!facets.empty()) {
+            compute_facet_chunks(facets[0], facet_infos[0], group_limit, group_by_fields,
+                                 result_ids, results_size, num_chunks, thread_pool);
+        }
 
-        for(size_t i = 0; i < results_size; i++) {
-            uint32_t doc_seq_id = result_ids[i];
+        // the index lock is held here, so the wait must only run the facet tasks that this thread enqueued: an
+        // indexing batch of this index would deadlock on the lock
+        for(auto& facet_future: facet_futures) {
+            thread_pool->wait(facet_future);
+        }
+    }
 
-            const auto& facet_hashes_it = field_facet_mapping->find(doc_seq_id);
+    if(use_sample && results_size != 0) {
+        const double scale = double(all_results_size) / results_size;
+        for(auto& a_facet: facets) {
+            scale_facet(a_facet, scale);
+        }
+    }
+}
 
-            if(facet_hashes_it == field_facet_mapping->end()) {
-                continue;
-            }
+void Index::compute_facet(facet& a_facet, const facet_info_t& facet_info,
+                          size_t group_limit, const std::vector<std::string>& group_by_fields,
+                          const uint32_t* result_ids, size_t results_size) const {
+    const auto& facet_field = facet_info.facet_field;
+    const bool use_facet_query = facet_info.use_facet_query;
+    const auto& fhash_qtoken_pos = facet_info.fhash_qtoken_pos;
+    const bool should_compute_stats = facet_info.should_compute_stats;
 
-            // FORMAT OF VALUES
-            // String: h1 h2 h3
-            // String array: h1 h2 h3 0 h1 0 h1 h2 0
-            const auto& facet_hashes = facet_hashes_it->second;
+    const auto& field_facet_mapping_it = facet_index_v3.find(a_facet.field_name);
+    if(field_facet_mapping_it == facet_index_v3.end()) {
+        return ;
+    }
 
-            const uint64_t distinct_id = group_limit ? get_distinct_id(group_by_fields, doc_seq_id) : 0;
+    // plain counts of string and bool values are made over the ordinals of the values
+    const auto& dictionary_it = facet_dictionaries.find(a_facet.field_name);
+    if(!use_facet_query && !group_limit && !should_compute_stats && dictionary_it != facet_dictionaries.end() &&
+       use_facet_ordinals(dictionary_it->second->num_ordinals(), results_size)) {
+        count_facet_ordinals(a_facet, *dictionary_it->second, result_ids, results_size);
+        return ;
+    }
 
-            int array_pos = 0;
-            bool fvalue_found = false;
-            uint64_t combined_hash = 1;  // for hashing the entire facet value (multiple tokens)
+    const auto& field_facet_mapping = field_facet_mapping_it->second;
 
-            std::unordered_map<uint32_t, token_pos_cost_t> query_token_positions;
-            size_t field_token_index = -1;
-            auto fhashes = facet_hashes.hashes;
+    // raw values of numeric fields, whose stats are computed a block at a time
+    uint64_t stats_values[FACET_STATS_BLOCK_SIZE];
+    size_t num_stats_values = 0;
 
-            for(size_t j = 0; j < facet_hashes.size(); j++) {
-                if(fhashes[j] != FACET_ARRAY_DELIMETER) {
-                    uint64_t ftoken_hash = fhashes[j];
-                    field_token_index++;
+    for(size_t i = 0; i < results_size; i++) {
+        uint32_t doc_seq_id = result_ids[i];
 
-                    // reference: https://stackoverflow.com/a/4182771/131050
-                    // we also include token index to maintain orderliness
-                    combined_hash *= (1779033703 + 2*ftoken_hash*(field_token_index+1));
+        const auto& facet_hashes_it = field_facet_mapping->find(doc_seq_id);
 
-                    // ftoken_hash is the raw value for numeric fields
-                    if(should_compute_stats) {
-                        compute_facet_stats(a_facet, ftoken_hash, facet_field.type);
-                    }
+        if(facet_hashes_it == field_facet_mapping->end()) {
+            continue;
+        }
 
-                    const auto fhash_qtoken_pos_it = fhash_qtoken_pos.find(ftoken_hash);
+        // FORMAT OF VALUES
+        // String: h1 h2 h3
+        // String array: h1 h2 h3 0 h1 0 h1 h2 0
+        const auto& facet_hashes = facet_hashes_it->second;
 
-                    // not using facet query or this particular facet value is found in facet filter
-                    if(!use_facet_query || fhash_qtoken_pos_it != fhash_qtoken_pos.end()) {
-                        fvalue_found = true;
+        const uint64_t distinct_id = group_limit ? get_distinct_id(group_by_fields, doc_seq_id) : 0;
 
-                        if(use_facet_query) {
-                            // map token index to query index (used for highlighting later on)
-                            const token_pos_cost_t& qtoken_pos = fhash_qtoken_pos_it->second;
+        int array_pos = 0;
+        bool fvalue_found = false;
+        uint64_t combined_hash = 1;  // for hashing the entire facet value (multiple tokens)
 
-                            // if the query token has already matched another token in the string
-                            // we will replace the position only if the cost is lower
-                            if(query_token_positions.find(qtoken_pos.pos) == query_token_positions.end() ||
-                               query_token_positions[qtoken_pos.pos].cost >= qtoken_pos.cost ) {
-                                token_pos_cost_t ftoken_pos_cost = {field_token_index, qtoken_pos.cost};
-                                query_token_positions[qtoken_pos.pos] = ftoken_pos_cost;
-                            }
-                        }
+        std::unordered_map<uint32_t, token_pos_cost_t> query_token_positions;
+        size_t field_token_index = -1;
+        auto fhashes = facet_hashes.hashes;
+
+        for(size_t j = 0; j < facet_hashes.size(); j++) {
+            if(fhashes[j] != FACET_ARRAY_DELIMETER) {
+                uint64_t ftoken_hash = fhashes[j];
+                field_token_index++;
+
+                // reference: https://stackoverflow.com/a/4182771/131050
+                // we also include token index to maintain orderliness
+                combined_hash *= (1779033703 + 2*ftoken_hash*(field_token_index+1));
+
+                // ftoken_hash is the raw value for numeric fields
+                if(should_compute_stats) {
+                    stats_values[num_stats_values++] = ftoken_hash;
+
+                    if(num_stats_values == FACET_STATS_BLOCK_SIZE) {
+                        compute_facet_stats(a_facet, stats_values, num_stats_values, facet_field.type);
+                        num_stats_values = 0;
                     }
                 }
 
-                // 0 indicates separator, while the second condition checks for non-array string
-                if(fhashes[j] == FACET_ARRAY_DELIMETER || (facet_hashes.back() != FACET_ARRAY_DELIMETER && j == facet_hashes.size() - 1)) {
-                    if(!use_facet_query || fvalue_found) {
-                        uint64_t fhash = combined_hash;
+                const auto fhash_qtoken_pos_it = fhash_qtoken_pos.find(ftoken_hash);
+
+                // not using facet query or this particular facet value is found in facet filter
+                if(!use_facet_query || fhash_qtoken_pos_it != fhash_qtoken_pos.end()) {
+                    fvalue_found = true;
 
-                        if(a_facet.result_map.count(fhash) == 0) {
-                            a_facet.result_map.emplace(fhash, facet_count_t{0, spp::sparse_hash_set<uint64_t>(),
-                                                                            doc_seq_id, 0,
-                                                                            std::unordered_map<uint32_t, token_pos_cost_t>()});
+                    if(use_facet_query) {
+                        // map token index to query index (used for highlighting later on)
+                        const token_pos_cost_t& qtoken_pos = fhash_qtoken_pos_it->second;
+
+                        // if the query token has already matched another token in the string
+                        // we will replace the position only if the cost is lower
+                        if(query_token_positions.find(qtoken_pos.pos) == query_token_positions.end() ||
+                           query_token_positions[qtoken_pos.pos].cost >= qtoken_pos.cost ) {
+                            token_pos_cost_t ftoken_pos_cost = {field_token_index, qtoken_pos.cost};
+                            query_token_positions[qtoken_pos.pos] = ftoken_pos_cost;
                         }
+                    }
+                }
+            }
 
-                        facet_count_t& facet_count = a_facet.result_map[fhash];
+            // 0 indicates separator, while the second condition checks for non-array string
+            if(fhashes[j] == FACET_ARRAY_DELIMETER || (facet_hashes.back() != FACET_ARRAY_DELIMETER && j == facet_hashes.size() - 1)) {
+                if(!use_facet_query || fvalue_found) {
+                    uint64_t fhash = combined_hash;
 
-                        /*LOG(INFO) << "field: " << a_facet.field_name << ", doc id: " << doc_seq_id
-                                  << ", hash: " <<  fhash;*/
+                    if(a_facet.result_map.count(fhash) == 0) {
+                        a_facet.result_map.emplace(fhash, facet_count_t{0, spp::sparse_hash_set<uint64_t>(),
+                                                                        doc_seq_id, 0,
+                                                                        std::unordered_map<uint32_t, token_pos_cost_t>()});
+                    }
 
-                        facet_count.doc_id = doc_seq_id;
-                        facet_count.array_pos = array_pos;
+                    facet_count_t& facet_count = a_facet.result_map[fhash];
 
-                        if(group_limit) {
-                            facet_count.groups.emplace(distinct_id);
-                        } else {
-                            facet_count.count += 1;
-                        }
+                    /*LOG(INFO) << "field: " << a_facet.field_name << ", doc id: " << doc_seq_id
+                              << ", hash: " <<  fhash;*/
 
-                        if(use_facet_query) {
-                            facet_count.query_token_pos = query_token_positions;
-                        }
+                    facet_count.doc_id = doc_seq_id;
+                    facet_count.array_pos = array_pos;
+
+                    if(group_limit) {
+                        facet_count.groups.emplace(distinct_id);
+                    } else {
+                        facet_count.count += 1;
                     }
 
-                    array_pos++;
-                    fvalue_found = false;
-                    combined_hash = 1;
-                    std::unordered_map<uint32_t, token_pos_cost_t>().swap(query_token_positions);
-                    field_token_index = -1;
+                    if(use_facet_query) {
+                        facet_count.query_token_pos = query_token_positions;
+                    }
                 }
+
+                array_pos++;
+                fvalue_found = false;
+                combined_hash = 1;
+                std::unordered_map<uint32_t, token_pos_cost_t>().swap(query_token_positions);
+                field_token_index = -1;
+            }
+        }
+    }
+
+    if(should_compute_stats) {
+        compute_facet_stats(a_facet, stats_values, num_stats_values, facet_field.type);
+    }
+}
+
+void Index::compute_facet_chunks(facet& a_facet, const facet_info_t& facet_info,
+                                 size_t group_limit, const std::vector<std::string>& group_by_fields,
+                                 const uint32_t* result_ids, size_t results_size,
+                                 size_t num_chunks, ThreadPool* thread_pool) const {
+    if(num_chunks <= 1) {
+        compute_facet(a_facet, facet_info, group_limit, group_by_fields, result_ids, results_size);
+        return ;
+    }
+
+    const size_t chunk_size = (results_size + num_chunks - 1) / num_chunks;
+
+    // chunks after the first are counted into facets of their own, which are merged in order afterwards
+    std::vector<facet> chunk_facets;
+    for(size_t chunk = 1; chunk < num_chunks; chunk++) {
+        chunk_facets.emplace_back(a_facet.field_name);
+    }
+
+    std::vector<std::future<void>> chunk_futures;
+
+    for(size_t chunk = 1; chunk < num_chunks; chunk++) {
+        const size_t chunk_start = std::min(results_size, chunk * chunk_size);
+        const size_t chunk_len = std::min(results_size, chunk_start + chunk_size) - chunk_start;
+        facet& chunk_facet = chunk_facets[chunk - 1];
+
+        chunk_futures.push_back(thread_pool->enqueue_with_priority(ThreadPool::HIGH,
+                                                                   [&, chunk_start, chunk_len]() {
+            compute_facet(chunk_facet, facet_info, group_limit, group_by_fields,
+                          result_ids + chunk_start, chunk_len);
+        }));
+    }
+
+    compute_facet(a_facet, facet_info, group_limit, group_by_fields, result_ids, std::min(results_size, chunk_size));
+
+    // like in `do_facets()`, only the chunks enqueued above are run by this thread while it waits
+    for(auto& chunk_future: chunk_futures) {
+        thread_pool->wait(chunk_future);
+    }
+
+    for(facet& chunk_facet: chunk_facets) {
+        merge_facet_counts(a_facet, chunk_facet, group_limit);
+    }
+}
+
+void Index::merge_facet_counts(facet& a_facet, facet& other_facet, size_t group_limit) {
+    // values that are new are added in the order of the other facet, and the representative document of every value
+    // is that of the later results, as when all of the results are counted in one go
+    for(auto& facet_kv: other_facet.result_map) {
+        auto facet_it = a_facet.result_map.find(facet_kv.first);
+
+        if(facet_it == a_facet.result_map.end()) {
+            a_facet.result_map.emplace(facet_kv.first, std::move(facet_kv.second));
+            continue;
+        }
+
+        if(group_limit) {
+            facet_it->second.groups.insert(facet_kv.second.groups.begin(), facet_kv.second.groups.end());
+        } else {
+            facet_it->second.count += facet_kv.second.count;
+        }
+
+        facet_it->second.doc_id = facet_kv.second.doc_id;
+        facet_it->second.array_pos = facet_kv.second.array_pos;
+        facet_it->second.query_token_pos = std::move(facet_kv.second.query_token_pos);
+    }
+
+    if(other_facet.stats.fvcount != 0) {
+        a_facet.stats.fvcount += other_facet.stats.fvcount;
+        a_facet.stats.fvsum += other_facet.stats.fvsum;
+        a_facet.stats.fvmax = std::max(a_facet.stats.fvmax, other_facet.stats.fvmax);
+        a_facet.stats.fvmin = std::min(a_facet.stats.fvmin, other_facet.stats.fvmin);
+    }
+}
+
+void Index::sample_result_ids(const uint32_t* result_ids, size_t results_size, size_t facet_sample_percent,
+                              std::vector<uint32_t>& sampled_ids) {
+    const size_t sample_size = std::max<size_t>(1, (results_size * facet_sample_percent) / 100);
+    sampled_ids.reserve(sample_size);
+
+    // stratified sampling: the ids are split into `sample_size` runs of (almost) equal length, and a random id is
+    // picked from each run. That takes one draw per sampled id instead of one per result, and unlike a fixed stride
+    // it does not line up with values that repeat periodically over the ids.
+    // The generator is seeded on the number of results, so that a search always counts the same sample.
+    std::mt19937 generator(results_size);
+    const double stride = double(results_size) / sample_size;
+
+    for(size_t i = 0; i < sample_size; i++) {
+        const size_t run_start = size_t(i * stride);
+        const size_t run_end = std::min(results_size, std::max(run_start + 1, size_t((i + 1) * stride)));
+        sampled_ids.push_back(result_ids[run_start + generator() % (run_end - run_start)]);
+    }
+}
+
+void Index::scale_facet(facet& a_facet, double scale) {
+    for(auto& facet_kv: a_facet.result_map) {
+        facet_count_t& facet_count = facet_kv.second;
+        facet_count.count = std::max<uint32_t>(1, uint32_t(std::lround(facet_count.count * scale)));
+    }
+
+    // min and max are those of the sample, while the average is unaffected by the scaling
+    a_facet.stats.fvcount *= scale;
+    a_facet.stats.fvsum *= scale;
+    a_facet.sampled = true;
+}
+
+bool Index::use_facet_ordinals(size_t num_ordinals, size_t results_size) {
+    // the count arrays are sized on the ordinals, so fields of many distinct values (or counts over few results)
+    // are better off with the hash map of the counted values
+    return num_ordinals <= MAX_FACET_ORDINALS && num_ordinals <= results_size * FACET_ORDINALS_PER_RESULT;
+}
+
+void Index::count_facet_ordinals(facet& a_facet, const facet_dictionary_t& facet_dictionary,
+                                 const uint32_t* result_ids, size_t results_size) {
+    const size_t num_ordinals = facet_dictionary.num_ordinals();
+
+    std::vector<uint32_t> counts(num_ordinals, 0);
+    std::vector<uint32_t> doc_ids(num_ordinals);
+    std::vector<uint32_t> array_positions(num_ordinals);
+
+    // in the order that they are first found in, which is the order that the hash map path adds values in
+    std::vector<uint32_t> counted_ordinals;
+
+    for(size_t i = 0; i < results_size; i++) {
+        const uint32_t doc_seq_id = result_ids[i];
+        const uint32_t* doc_ordinals = nullptr;
+        uint32_t num_doc_ordinals = 0;
+
+        facet_dictionary.get_ordinals(doc_seq_id, doc_ordinals, num_doc_ordinals);
+
+        for(uint32_t array_pos = 0; array_pos < num_doc_ordinals; array_pos++) {
+            const uint32_t ordinal = doc_ordinals[array_pos];
+
+            if(counts[ordinal]++ == 0) {
+                counted_ordinals.push_back(ordinal);
             }
+
+            doc_ids[ordinal] = doc_seq_id;
+            array_positions[ordinal] = array_pos;
         }
     }
+
+    for(uint32_t ordinal: counted_ordinals) {
+        // the facet already holds the counts of earlier results when curated results are counted
+        const auto& emplace_result = a_facet.result_map.emplace(facet_dictionary.get_value_hash(ordinal),
+                                   facet_count_t{0, spp::sparse_hash_set<uint64_t>(),
+                                                 doc_ids[ordinal], array_positions[ordinal],
+                                                 std::unordered_map<uint32_t, token_pos_cost_t>()});
+
+        facet_count_t& facet_count = emplace_result.first->second;
+        facet_count.count += counts[ordinal];
+        facet_count.doc_id = doc_ids[ordinal];
+        facet_count.array_pos = array_positions[ordinal];
+    }
 }
 
 void Index::search_candidates(const uint8_t & field_id,
-                              uint32_t* filter_ids, size_t filter_ids_length,
+                              uint32_t* filter_ids, size_t filter_ids_length, const id_bitmap_t* filter_bitmap,
                               const uint32_t* exclude_token_ids, size_t exclude_token_ids_size,
                               const std::vector<uint32_t>& curated_ids,
                               const std::vector<sort_by> & sort_fields,
@@ -863,12 +1280,18 @@ void Index::search_candidates(const uint8_t & field_id,
                               uint32_t** all_result_ids, size_t & all_result_ids_len,
                               size_t& field_num_results,
                               const size_t typo_tokens_threshold,
-                              const size_t group_limit, const std::vector<std::string>& group_by_fields) const {
+                              const size_t group_limit, const std::vector<std::string>& group_by_fields,
+                              const bool is_array_field, const std::string& default_sorting_field) const {
     const long long combination_limit = 10;
 
     auto product = []( long long a, token_candidates & b ) { return a*b.candidates.size(); };
     long long int N = std::accumulate(token_candidates_vec.begin(), token_candidates_vec.end(), 1LL, product);
 
+    // the documents of a single token suggestion are then ranked on their points alone, so only the first ids of
+    // the token's impact order that are among the results have to be scored
+    const bool impact_ordered_sort = (group_limit == 0) && is_impact_ordered_sort(sort_fields);
+    std::vector<uint32_t> top_impact_ids;
+
     for(long long n=0; n<N && n<combination_limit; ++n) {
         // every element in `query_suggestion` contains a token and its associated hits
         std::vector<art_leaf*> query_suggestion(token_candidates_vec.size());
@@ -886,22 +1309,44 @@ void Index::search_candidates(const uint8_t & field_id,
                       << actual_query_suggestion[i]->values->ids.getLength() << ", total_cost: " << total_cost;
         }*/
 
-        // initialize results with the starting element (for further intersection)
-        size_t result_size = query_suggestion[0]->values->ids.getLength();
-        if(result_size == 0) {
+        if(query_suggestion[0]->values->ids.getLength() == 0) {
             continue;
         }
 
-        uint32_t* result_ids = query_suggestion[0]->values->ids.uncompress();
+        // matching documents are still counted when none of them can be ranked high enough to be scored
+        const bool score_suggestion = (is_array_field && query_suggestion.size() > 1) ||
+                                      suggestion_can_enter_topster(sort_fields, default_sorting_field,
+                                                                   query_suggestion, total_cost, topster);
+
+        auto score_suggestion_results = [&](const uint32_t* ids, const size_t ids_size) {
+            if(impact_ordered_sort && query_suggestion.size() == 1 &&
+               get_top_impact_ids(query_suggestion[0], ids, ids_size, topster->MAX_SIZE, top_impact_ids)) {
+                score_results(sort_fields, (uint16_t) searched_queries.size(), field_id, total_cost, topster,
+                              query_suggestion, groups_processed, top_impact_ids.data(), top_impact_ids.size(),
+                              group_limit, group_by_fields, token_bits, is_array_field);
+                return ;
+            }
+
+            score_results(sort_fields, (uint16_t) searched_queries.size(), field_id, total_cost, topster,
+                          query_suggestion, groups_processed, ids, ids_size, group_limit, group_by_fields,
+                          token_bits, is_array_field);
+        };
 
         // intersect the document ids for each token to find docs that contain all the tokens (stored in `result_ids`)
-        for(size_t i=1; i < query_suggestion.size(); i++) {
-            uint32_t* out = nullptr;
-            uint32_t* ids = query_suggestion[i]->values->ids.uncompress();
-            result_size = ArrayUtils::and_scalar(ids, query_suggestion[i]->values->ids.getLength(), result_ids, result_size, &out);
+        std::vector<uint32_t*> token_ids(query_suggestion.size());
+        std::vector<size_t> token_ids_lens(query_suggestion.size());
+
+        for(size_t i=0; i < query_suggestion.size(); i++) {
+            token_ids[i] = query_suggestion[i]->values->ids.uncompress();
+            token_ids_lens[i] = query_suggestion[i]->values->ids.getLength();
+        }
+
+        uint32_t* result_ids = nullptr;
+        size_t result_size = ArrayUtils::and_many(token_ids.data(), token_ids_lens.data(), token_ids.size(),
+                                                  &result_ids);
+
+        for(uint32_t* ids: token_ids) {
             delete[] ids;
-            delete[] result_ids;
-            result_ids = out;
         }
 
         if(result_size == 0) {
@@ -912,7 +1357,7 @@ void Index::search_candidates(const uint8_t & field_id,
         // Exclude document IDs associated with excluded tokens from the result set
         if(exclude_token_ids_size != 0) {
             uint32_t *excluded_result_ids = nullptr;
-            result_size = ArrayUtils::exclude_scalar(result_ids, result_size, exclude_token_ids, exclude_token_ids_size,
+            result_size = ArrayUtils::exclude_values(result_ids, result_size, exclude_token_ids, exclude_token_ids_size,
                                                      &excluded_result_ids);
             delete[] result_ids;
             result_ids = excluded_result_ids;
@@ -920,7 +1365,7 @@ void Index::search_candidates(const uint8_t & field_id,
 
         if(!curated_ids.empty()) {
             uint32_t *excluded_result_ids = nullptr;
-            result_size = ArrayUtils::exclude_scalar(result_ids, result_size, &curated_ids[0],
+            result_size = ArrayUtils::exclude_values(result_ids, result_size, &curated_ids[0],
                                                      curated_ids.size(), &excluded_result_ids);
 
             delete [] result_ids;
@@ -936,8 +1381,15 @@ void Index::search_candidates(const uint8_t & field_id,
         if(filter_ids != nullptr) {
             // intersect once again with filter ids
             uint32_t* filtered_result_ids = nullptr;
-            size_t filtered_results_size = ArrayUtils::and_scalar(filter_ids, filter_ids_length, result_ids,
-                                                                  result_size, &filtered_result_ids);
+            size_t filtered_results_size = 0;
+
+            if(filter_bitmap != nullptr) {
+                filtered_result_ids = new uint32_t[result_size];
+                filtered_results_size = filter_bitmap->intersect(result_ids, result_size, filtered_result_ids);
+            } else {
+                filtered_results_size = ArrayUtils::and_values(filter_ids, filter_ids_length, result_ids,
+                                                               result_size, &filtered_result_ids);
+            }
 
             uint32_t* new_all_result_ids = nullptr;
             all_result_ids_len = ArrayUtils::or_scalar(*all_result_ids, all_result_ids_len, filtered_result_ids,
@@ -946,9 +1398,9 @@ void Index::search_candidates(const uint8_t & field_id,
             *all_result_ids = new_all_result_ids;
 
             // go through each matching document id and calculate match score
-            score_results(sort_fields, (uint16_t) searched_queries.size(), field_id, total_cost, topster, query_suggestion,
-                          groups_processed, filtered_result_ids, filtered_results_size,
-                          group_limit, group_by_fields, token_bits);
+            if(score_suggestion) {
+                score_suggestion_results(filtered_result_ids, filtered_results_size);
+            }
 
             field_num_results += filtered_results_size;
 
@@ -965,8 +1417,9 @@ void Index::search_candidates(const uint8_t & field_id,
                 LOG(INFO) << size_t(field_id) << " - " << log_query.str() << ", result_size: " << result_size;
             }*/
 
-            score_results(sort_fields, (uint16_t) searched_queries.size(), field_id, total_cost, topster, query_suggestion,
-                          groups_processed, result_ids, result_size, group_limit, group_by_fields, token_bits);
+            if(score_suggestion) {
+                score_suggestion_results(result_ids, result_size);
+            }
 
             field_num_results += result_size;
 
@@ -982,13 +1435,36 @@ void Index::search_candidates(const uint8_t & field_id,
     }
 }
 
-uint32_t Index::do_filtering(uint32_t** filter_ids_out, const std::vector<filter> & filters) const {
-    //auto begin = std::chrono::high_resolution_clock::now();
-
+uint32_t Index::do_filtering(uint32_t** filter_ids_out, const std::vector<filter> & filters,
+                             id_bitmap_t** filter_bitmap_out, std::vector<filter_explain_t>* filter_explain) const {
     uint32_t* filter_ids = nullptr;
     uint32_t filter_ids_length = 0;
 
-    for(size_t i = 0; i < filters.size(); i++) {
+    // the combination of clauses is cached on its own, so that a repeated filter query skips the intersections too
+    std::string filters_key;
+    std::vector<std::string> filter_field_names;
+    bool filters_cached = false;
+
+    if(filters.size() > 1) {
+        for(const filter& a_filter: filters) {
+            filter_field_names.push_back(a_filter.field_name);
+        }
+
+        filters_key = filter_cache_t::get_key(filters);
+        size_t cached_ids_length = 0;
+        filters_cached = filter_cache.get(filters_key, &filter_ids, cached_ids_length);
+        filter_ids_length = cached_ids_length;
+
+        if(filters_cached && filter_explain != nullptr) {
+            filter_explain->push_back(filter_explain_t{StringUtils::join(filter_field_names, ","), filter_ids_length,
+                                                       "cached", filter_ids_length, 0});
+        }
+    }
+
+    // (estimated number of ids, index of the filter) of every clause on an indexed field
+    std::vector<std::pair<size_t, size_t>> clauses;
+
+    for(size_t i = 0; i < filters.size() && !filters_cached; i++) {
         const filter & a_filter = filters[i];
         bool has_search_index = search_index.count(a_filter.field_name) != 0 ||
                                 numerical_index.count(a_filter.field_name) != 0;
@@ -997,339 +1473,584 @@ uint32_t Index::do_filtering(uint32_t** filter_ids_out, const std::vector<filter
             continue;
         }
 
-        field f = search_schema.at(a_filter.field_name);
+        clauses.emplace_back(estimate_filter(a_filter, search_schema.at(a_filter.field_name)), i);
+    }
+
+    // the most selective clause goes first, so that its ids bound the work of all the clauses after it
+    std::stable_sort(clauses.begin(), clauses.end(),
+                     [](const std::pair<size_t, size_t>& a, const std::pair<size_t, size_t>& b) {
+                         return a.first < b.first;
+                     });
+
+    for(size_t clause_index = 0; clause_index < clauses.size(); clause_index++) {
+        const auto begin = std::chrono::high_resolution_clock::now();
+
+        const size_t estimated_ids = clauses[clause_index].first;
+        const filter & a_filter = filters[clauses[clause_index].second];
+        const field & f = search_schema.at(a_filter.field_name);
 
         uint32_t* result_ids = nullptr;
         size_t result_ids_len = 0;
+        std::string strategy;
 
-        if(f.is_integer()) {
-            auto num_tree = numerical_index.at(a_filter.field_name);
+        const std::string& filter_key = filter_cache_t::get_key(a_filter);
 
-            for(size_t fi=0; fi < a_filter.values.size(); fi++) {
-                const std::string & filter_value = a_filter.values[fi];
-                int64_t value = (int64_t) std::stol(filter_value);
+        if(filter_cache.get(filter_key, &result_ids, result_ids_len)) {
+            strategy = "cached";
+        } else if(clause_index != 0 && size_t(filter_ids_length) * FILTER_PROBE_RATIO <= estimated_ids &&
+                  probe_filter(a_filter, f, filter_ids, filter_ids_length, &result_ids, result_ids_len)) {
+            // only the ids matched so far were checked, so a probed clause is not cached
+            strategy = "probed";
+        } else {
+            strategy = "materialized";
+            evaluate_filter(a_filter, f, &result_ids, result_ids_len);
+            filter_cache.insert(filter_key, {a_filter.field_name}, result_ids, result_ids_len);
+        }
 
-                if(a_filter.comparators[fi] == RANGE_INCLUSIVE && fi+1 < a_filter.values.size()) {
-                    const std::string& next_filter_value = a_filter.values[fi+1];
-                    int64_t range_end_value = (int64_t) std::stol(next_filter_value);
-                    num_tree->range_inclusive_search(value, range_end_value, &result_ids, result_ids_len);
-                    fi++;
-                } else {
-                    num_tree->search(a_filter.comparators[fi], value, &result_ids, result_ids_len);
-                }
+        if(clause_index == 0 || strategy == "probed") {
+            delete [] filter_ids;
+            filter_ids = result_ids;
+            filter_ids_length = result_ids_len;
+        } else {
+            uint32_t* filtered_results = nullptr;
+            filter_ids_length = ArrayUtils::and_values(filter_ids, filter_ids_length, result_ids,
+                                                       result_ids_len, &filtered_results);
+            delete [] result_ids;
+            delete [] filter_ids;
+            filter_ids = filtered_results;
+        }
+
+        if(filter_explain != nullptr) {
+            const uint64_t time_us = std::chrono::duration_cast<std::chrono::microseconds>(
+                    std::chrono::high_resolution_clock::now() - begin).count();
+            filter_explain->push_back(filter_explain_t{a_filter.field_name, estimated_ids, strategy,
+                                                       filter_ids_length, time_us});
+        }
+
+        if(filter_ids_length == 0) {
+            // none of the remaining clauses can match anything
+            break;
+        }
+    }
+
+    if(filters.size() > 1 && !filters_cached) {
+        filter_cache.insert(filters_key, filter_field_names, filter_ids, filter_ids_length);
+    }
+
+    if(filter_bitmap_out != nullptr && id_bitmap_t::is_dense(filter_ids, filter_ids_length)) {
+        *filter_bitmap_out = new id_bitmap_t();
+        (*filter_bitmap_out)->load(filter_ids, filter_ids_length);
+    }
+
+    *filter_ids_out = filter_ids;
+    return filter_ids_length;
+}
+
+int64_t Index::get_filter_value(const field& f, const std::string& filter_value) {
+    if(f.is_float()) {
+        return float_to_in64_t((float) std::atof(filter_value.c_str()));
+    }
+
+    if(f.is_bool()) {
+        return (filter_value == "1") ? 1 : 0;
+    }
+
+    return (int64_t) std::stol(filter_value);
+}
+
+void Index::get_filter_ranges(const filter& a_filter, const field& f,
+                              std::vector<std::pair<int64_t, int64_t>>& ranges) {
+    for(size_t fi=0; fi < a_filter.values.size(); fi++) {
+        const int64_t value = get_filter_value(f, a_filter.values[fi]);
+        int64_t start, end;
+
+        if(!f.is_bool() && a_filter.comparators[fi] == RANGE_INCLUSIVE && fi+1 < a_filter.values.size()) {
+            start = value;
+            end = get_filter_value(f, a_filter.values[fi+1]);
+            fi++;
+        } else if(!num_tree_t::get_range(a_filter.comparators[fi], value, start, end)) {
+            continue;
+        }
+
+        ranges.emplace_back(start, end);
+    }
+}
+
+size_t Index::estimate_filter(const filter& a_filter, const field& f) const {
+    if(f.is_geopoint()) {
+        // the documents of a geo clause are only known once its hexagons are computed, so it goes last
+        return num_documents;
+    }
+
+    size_t estimated_ids = 0;
+
+    if(f.is_integer() || f.is_float() || f.is_bool()) {
+        const num_tree_t* num_tree = numerical_index.at(a_filter.field_name);
+
+        std::vector<std::pair<int64_t, int64_t>> ranges;
+        get_filter_ranges(a_filter, f, ranges);
+
+        for(const auto& range: ranges) {
+            estimated_ids += num_tree->estimate_range(range.first, range.second);
+        }
+    } else if(f.is_string()) {
+        art_tree* t = search_index.at(a_filter.field_name);
+
+        for(const std::string & filter_value: a_filter.values) {
+            // the tokens of a value are ANDed, so the rarest token bounds the value
+            Tokenizer tokenizer(filter_value, true, false, f.locale);
+
+            std::string str_token;
+            size_t token_index = 0;
+            size_t value_ids = std::numeric_limits<size_t>::max();
+
+            while(tokenizer.next(str_token, token_index)) {
+                art_leaf* leaf = (art_leaf *) art_search(t, (const unsigned char*) str_token.c_str(),
+                                                         str_token.length()+1);
+                const size_t token_ids = (leaf == nullptr) ? 0 : leaf->values->ids.getLength();
+                value_ids = std::min(value_ids, token_ids);
+            }
+
+            if(value_ids != std::numeric_limits<size_t>::max()) {
+                estimated_ids += value_ids;
             }
+        }
+    }
 
-        } else if(f.is_float()) {
-            auto num_tree = numerical_index.at(a_filter.field_name);
+    return std::min(estimated_ids, num_documents);
+}
 
-            for(size_t fi=0; fi < a_filter.values.size(); fi++) {
-                const std::string & filter_value = a_filter.values[fi];
-                float value = (float) std::atof(filter_value.c_str());
-                int64_t float_int64 = float_to_in64_t(value);
+void Index::evaluate_filter(const filter& a_filter, const field& f,
+                            uint32_t** result_ids_out, size_t& result_ids_len_out) const {
+    uint32_t* result_ids = nullptr;
+    size_t result_ids_len = 0;
 
-                if(a_filter.comparators[fi] == RANGE_INCLUSIVE && fi+1 < a_filter.values.size()) {
-                    const std::string& next_filter_value = a_filter.values[fi+1];
-                    int64_t range_end_value = float_to_in64_t((float) std::atof(next_filter_value.c_str()));
-                    num_tree->range_inclusive_search(float_int64, range_end_value, &result_ids, result_ids_len);
-                    fi++;
-                } else {
-                    num_tree->search(a_filter.comparators[fi], float_int64, &result_ids, result_ids_len);
-                }
+    if(f.is_integer()) {
+        auto num_tree = numerical_index.at(a_filter.field_name);
+
+        for(size_t fi=0; fi < a_filter.values.size(); fi++) {
+            const std::string & filter_value = a_filter.values[fi];
+            int64_t value = (int64_t) std::stol(filter_value);
+
+            if(a_filter.comparators[fi] == RANGE_INCLUSIVE && fi+1 < a_filter.values.size()) {
+                const std::string& next_filter_value = a_filter.values[fi+1];
+                int64_t range_end_value = (int64_t) std::stol(next_filter_value);
+                num_tree->range_inclusive_search(value, range_end_value, &result_ids, result_ids_len);
+                fi++;
+            } else {
+                num_tree->search(a_filter.comparators[fi], value, &result_ids, result_ids_len);
             }
+        }
+
+    } else if(f.is_float()) {
+        auto num_tree = numerical_index.at(a_filter.field_name);
 
-        } else if(f.is_bool()) {
-            auto num_tree = numerical_index.at(a_filter.field_name);
+        for(size_t fi=0; fi < a_filter.values.size(); fi++) {
+            const std::string & filter_value = a_filter.values[fi];
+            float value = (float) std::atof(filter_value.c_str());
+            int64_t float_int64 = float_to_in64_t(value);
 
-            size_t value_index = 0;
-            for(const std::string & filter_value: a_filter.values) {
-                int64_t bool_int64 = (filter_value == "1") ? 1 : 0;
-                num_tree->search(a_filter.comparators[value_index], bool_int64, &result_ids, result_ids_len);
-                value_index++;
+            if(a_filter.comparators[fi] == RANGE_INCLUSIVE && fi+1 < a_filter.values.size()) {
+                const std::string& next_filter_value = a_filter.values[fi+1];
+                int64_t range_end_value = float_to_in64_t((float) std::atof(next_filter_value.c_str()));
+                num_tree->range_inclusive_search(float_int64, range_end_value, &result_ids, result_ids_len);
+                fi++;
+            } else {
+                num_tree->search(a_filter.comparators[fi], float_int64, &result_ids, result_ids_len);
             }
+        }
 
-        } else if(f.is_geopoint()) {
-            auto num_tree = numerical_index.at(a_filter.field_name);
-            auto record_to_geo = sort_index.at(a_filter.field_name);
+    } else if(f.is_bool()) {
+        auto num_tree = numerical_index.at(a_filter.field_name);
 
-            double indexed_edge_len = edgeLengthM(f.geo_resolution);
+        size_t value_index = 0;
+        for(const std::string & filter_value: a_filter.values) {
+            int64_t bool_int64 = (filter_value == "1") ? 1 : 0;
+            num_tree->search(a_filter.comparators[value_index], bool_int64, &result_ids, result_ids_len);
+            value_index++;
+        }
 
-            for(const std::string& filter_value: a_filter.values) {
-                std::vector<std::string> filter_value_parts;
-                StringUtils::split(filter_value, filter_value_parts, ",");  // x, y, 2 km (or) list of points
+    } else if(f.is_geopoint()) {
+        auto num_tree = numerical_index.at(a_filter.field_name);
+        auto record_to_geo = sort_index.at(a_filter.field_name);
 
-                std::vector<uint32_t> geo_result_ids;
+        double indexed_edge_len = edgeLengthM(f.geo_resolution);
 
-                bool is_polygon = StringUtils::is_float(filter_value_parts.back());
+        for(const std::string& filter_value: a_filter.values) {
+            std::vector<std::string> filter_value_parts;
+            StringUtils::split(filter_value, filter_value_parts, ",");  // x, y, 2 km (or) list of points
 
-                if(is_polygon) {
-                    const int num_verts = int(filter_value_parts.size()) / 2;
-                    GeoCoord* verts = new GeoCoord[num_verts];
+            std::vector<uint32_t> geo_result_ids;
 
-                    for(size_t point_index = 0; point_index < size_t(num_verts); point_index++) {
-                        double lat = degsToRads(std::stod(filter_value_parts[point_index * 2]));
-                        double lon = degsToRads(std::stod(filter_value_parts[point_index * 2 + 1]));
-                        verts[point_index] = {lat, lon};
-                    }
+            bool is_polygon = StringUtils::is_float(filter_value_parts.back());
 
-                    Geofence geo_fence = {num_verts, verts};
-                    GeoPolygon geo_polygon = {geo_fence, 0, nullptr};
-                    double lon_offset = transform_for_180th_meridian(geo_fence);
+            if(is_polygon) {
+                const int num_verts = int(filter_value_parts.size()) / 2;
+                GeoCoord* verts = new GeoCoord[num_verts];
 
-                    size_t num_hexagons = maxPolyfillSize(&geo_polygon, f.geo_resolution);
+                for(size_t point_index = 0; point_index < size_t(num_verts); point_index++) {
+                    double lat = degsToRads(std::stod(filter_value_parts[point_index * 2]));
+                    double lon = degsToRads(std::stod(filter_value_parts[point_index * 2 + 1]));
+                    verts[point_index] = {lat, lon};
+                }
 
-                    H3Index* hexagons = static_cast<H3Index *>(calloc(num_hexagons, sizeof(H3Index)));
+                Geofence geo_fence = {num_verts, verts};
+                GeoPolygon geo_polygon = {geo_fence, 0, nullptr};
+                double lon_offset = transform_for_180th_meridian(geo_fence);
 
-                    polyfill(&geo_polygon, f.geo_resolution, hexagons);
+                size_t num_hexagons = maxPolyfillSize(&geo_polygon, f.geo_resolution);
 
-                    // we will have to expand by kring=1 to ensure that hexagons completely cover the polygon
-                    // see: https://github.com/uber/h3/issues/332
-                    std::set<uint64_t> expanded_hexagons;
+                H3Index* hexagons = static_cast<H3Index *>(calloc(num_hexagons, sizeof(H3Index)));
 
-                    for (size_t hex_index = 0; hex_index < num_hexagons; hex_index++) {
-                        // Some indexes may be 0 to indicate fewer than the maximum number of indexes.
-                        if (hexagons[hex_index] != 0) {
-                            expanded_hexagons.emplace(hexagons[hex_index]);
+                polyfill(&geo_polygon, f.geo_resolution, hexagons);
 
-                            size_t k_rings = 1;
-                            size_t max_neighboring = maxKringSize(k_rings);
-                            H3Index* neighboring_indices = static_cast<H3Index *>(calloc(max_neighboring, sizeof(H3Index)));
-                            kRing(hexagons[hex_index], k_rings, neighboring_indices);
+                // we will have to expand by kring=1 to ensure that hexagons completely cover the polygon
+                // see: https://github.com/uber/h3/issues/332
+                std::set<uint64_t> expanded_hexagons;
 
-                            for (size_t neighbour_index = 0; neighbour_index < max_neighboring; neighbour_index++) {
-                                if (neighboring_indices[neighbour_index] != 0) {
-                                    expanded_hexagons.emplace(neighboring_indices[neighbour_index]);
-                                }
-                            }
+                for (size_t hex_index = 0; hex_index < num_hexagons; hex_index++) {
+                    // Some indexes may be 0 to indicate fewer than the maximum number of indexes.
+                    if (hexagons[hex_index] != 0) {
+                        expanded_hexagons.emplace(hexagons[hex_index]);
+
+                        size_t k_rings = 1;
+                        size_t max_neighboring = maxKringSize(k_rings);
+                        H3Index* neighboring_indices = static_cast<H3Index *>(calloc(max_neighboring, sizeof(H3Index)));
+                        kRing(hexagons[hex_index], k_rings, neighboring_indices);
 
-                            free(neighboring_indices);
+                        for (size_t neighbour_index = 0; neighbour_index < max_neighboring; neighbour_index++) {
+                            if (neighboring_indices[neighbour_index] != 0) {
+                                expanded_hexagons.emplace(neighboring_indices[neighbour_index]);
+                            }
                         }
-                    }
 
-                    for(auto hex_id: expanded_hexagons) {
-                         num_tree->get(hex_id, geo_result_ids);
+                        free(neighboring_indices);
                     }
+                }
 
-                    // we will do an exact filtering again with point-in-poly checks
-                    std::vector<uint32_t> exact_geo_result_ids;
-                    for(auto result_id: geo_result_ids) {
-                        GeoCoord point;
-                        h3ToGeo(record_to_geo->at(result_id), &point);
-                        point.lon = point.lon < 0.0 ? point.lon + lon_offset : point.lon;
+                for(auto hex_id: expanded_hexagons) {
+                     num_tree->get(hex_id, geo_result_ids);
+                }
 
-                        if(is_point_in_polygon(geo_fence, point)) {
-                            exact_geo_result_ids.push_back(result_id);
-                        }
+                // we will do an exact filtering again with point-in-poly checks
+                std::vector<uint32_t> exact_geo_result_ids;
+                for(auto result_id: geo_result_ids) {
+                    GeoCoord point;
+                    h3ToGeo(record_to_geo->get(result_id, 0), &point);
+                    point.lon = point.lon < 0.0 ? point.lon + lon_offset : point.lon;
+
+                    if(is_point_in_polygon(geo_fence, point)) {
+                        exact_geo_result_ids.push_back(result_id);
                     }
-            
-                    std::sort(exact_geo_result_ids.begin(), exact_geo_result_ids.end());
+                }
+        
+                std::sort(exact_geo_result_ids.begin(), exact_geo_result_ids.end());
+
+                uint32_t *out = nullptr;
+                result_ids_len = ArrayUtils::or_scalar(&exact_geo_result_ids[0], exact_geo_result_ids.size(),
+                                                     result_ids, result_ids_len, &out);
 
-                    uint32_t *out = nullptr;
-                    result_ids_len = ArrayUtils::or_scalar(&exact_geo_result_ids[0], exact_geo_result_ids.size(),
-                                                         result_ids, result_ids_len, &out);
+                delete [] result_ids;
+                result_ids = out;
 
-                    delete [] result_ids;
-                    result_ids = out;
+                free(hexagons);
+                delete [] verts;
+            } else {
+                double radius = std::stof(filter_value_parts[2]);
+                const auto& unit = filter_value_parts[3];
 
-                    free(hexagons);
-                    delete [] verts;
+                if(unit == "km") {
+                    radius *= 1000;
                 } else {
-                    double radius = std::stof(filter_value_parts[2]);
-                    const auto& unit = filter_value_parts[3];
+                    // assume "mi" (validated upstream)
+                    radius *= 1609.34;
+                }
 
-                    if(unit == "km") {
-                        radius *= 1000;
-                    } else {
-                        // assume "mi" (validated upstream)
-                        radius *= 1609.34;
+                GeoCoord location;
+                location.lat = degsToRads(std::stod(filter_value_parts[0]));
+                location.lon = degsToRads(std::stod(filter_value_parts[1]));
+                H3Index query_index = geoToH3(&location, f.geo_resolution);
+
+                //LOG(INFO) << "query latlon: " << std::stod(filter_value_parts[0]) << ", " << std::stod(filter_value_parts[1]);
+                //LOG(INFO) << "query h3 index: " << query_index << " at res: " << size_t(f.geo_resolution);
+
+                size_t k_rings = size_t(std::ceil(radius / indexed_edge_len));
+                size_t max_neighboring = maxKringSize(k_rings);
+                H3Index* neighboring_indices = static_cast<H3Index *>(calloc(max_neighboring, sizeof(H3Index)));
+                kRing(query_index, k_rings, neighboring_indices);
+
+                for (size_t hex_index = 0; hex_index < max_neighboring; hex_index++) {
+                    // Some indexes may be 0 to indicate fewer than the maximum number of indexes.
+                    if (neighboring_indices[hex_index] != 0) {
+                        //LOG(INFO) << "Neighbour index: " << neighboring_indices[hex_index];
+                        num_tree->get(neighboring_indices[hex_index], geo_result_ids);
                     }
+                }
 
-                    GeoCoord location;
-                    location.lat = degsToRads(std::stod(filter_value_parts[0]));
-                    location.lon = degsToRads(std::stod(filter_value_parts[1]));
-                    H3Index query_index = geoToH3(&location, f.geo_resolution);
+                free(neighboring_indices);
 
-                    //LOG(INFO) << "query latlon: " << std::stod(filter_value_parts[0]) << ", " << std::stod(filter_value_parts[1]);
-                    //LOG(INFO) << "query h3 index: " << query_index << " at res: " << size_t(f.geo_resolution);
+                // `geo_result_ids` will contain all IDs that are within K-ring hexagons
+                // we still need to do another round of exact filtering on them
 
-                    size_t k_rings = size_t(std::ceil(radius / indexed_edge_len));
-                    size_t max_neighboring = maxKringSize(k_rings);
-                    H3Index* neighboring_indices = static_cast<H3Index *>(calloc(max_neighboring, sizeof(H3Index)));
-                    kRing(query_index, k_rings, neighboring_indices);
+                std::vector<uint32_t> exact_geo_result_ids;
 
-                    for (size_t hex_index = 0; hex_index < max_neighboring; hex_index++) {
-                        // Some indexes may be 0 to indicate fewer than the maximum number of indexes.
-                        if (neighboring_indices[hex_index] != 0) {
-                            //LOG(INFO) << "Neighbour index: " << neighboring_indices[hex_index];
-                            num_tree->get(neighboring_indices[hex_index], geo_result_ids);
-                        }
+                H3Index query_point_index = geoToH3(&location, FINEST_GEO_RESOLUTION);
+                for(auto result_id: geo_result_ids) {
+                    size_t actual_dist_meters = h3Distance(query_point_index, record_to_geo->get(result_id, 0));
+                    if(actual_dist_meters <= radius) {
+                        exact_geo_result_ids.push_back(result_id);
                     }
+                }
 
-                    free(neighboring_indices);
+                std::sort(exact_geo_result_ids.begin(), exact_geo_result_ids.end());
 
-                    // `geo_result_ids` will contain all IDs that are within K-ring hexagons
-                    // we still need to do another round of exact filtering on them
+                uint32_t *out = nullptr;
+                result_ids_len = ArrayUtils::or_scalar(&exact_geo_result_ids[0], exact_geo_result_ids.size(),
+                                                     result_ids, result_ids_len, &out);
 
-                    std::vector<uint32_t> exact_geo_result_ids;
+                delete [] result_ids;
+                result_ids = out;
+            }
+        }
 
-                    H3Index query_point_index = geoToH3(&location, FINEST_GEO_RESOLUTION);
-                    for(auto result_id: geo_result_ids) {
-                        size_t actual_dist_meters = h3Distance(query_point_index, record_to_geo->at(result_id));
-                        if(actual_dist_meters <= radius) {
-                            exact_geo_result_ids.push_back(result_id);
-                        }
-                    }
+    } else if(f.is_string()) {
+        art_tree* t = search_index.at(a_filter.field_name);
 
-                    std::sort(exact_geo_result_ids.begin(), exact_geo_result_ids.end());
+        uint32_t* ids = nullptr;
+        size_t ids_size = 0;
 
-                    uint32_t *out = nullptr;
-                    result_ids_len = ArrayUtils::or_scalar(&exact_geo_result_ids[0], exact_geo_result_ids.size(),
-                                                         result_ids, result_ids_len, &out);
+        for(const std::string & filter_value: a_filter.values) {
+            uint32_t* strt_ids = nullptr;
+            size_t strt_ids_size = 0;
 
-                    delete [] result_ids;
-                    result_ids = out;
+            std::vector<art_leaf *> query_suggestion;
+
+            // there could be multiple tokens in a filter value, which we have to treat as ANDs
+            // e.g. country: South Africa
+
+            Tokenizer tokenizer(filter_value, true, false, f.locale);
+
+            std::string str_token;
+            size_t token_index = 0;
+            std::vector<std::string> str_tokens;
+
+            while(tokenizer.next(str_token, token_index)) {
+                str_tokens.push_back(str_token);
+
+                art_leaf* leaf = (art_leaf *) art_search(t, (const unsigned char*) str_token.c_str(),
+                                                         str_token.length()+1);
+                if(leaf == nullptr) {
+                    continue;
                 }
+
+                query_suggestion.push_back(leaf);
             }
 
-        } else if(f.is_string()) {
-            art_tree* t = search_index.at(a_filter.field_name);
+            if(query_suggestion.size() != str_tokens.size()) {
+                continue;
+            }
 
-            uint32_t* ids = nullptr;
-            size_t ids_size = 0;
+            // do AND for an exact match
+            std::vector<uint32_t*> leaf_ids(query_suggestion.size());
+            std::vector<size_t> leaf_ids_lens(query_suggestion.size());
 
-            for(const std::string & filter_value: a_filter.values) {
-                uint32_t* strt_ids = nullptr;
-                size_t strt_ids_size = 0;
+            for(size_t leaf_index = 0; leaf_index < query_suggestion.size(); leaf_index++) {
+                leaf_ids[leaf_index] = query_suggestion[leaf_index]->values->ids.uncompress();
+                leaf_ids_lens[leaf_index] = query_suggestion[leaf_index]->values->ids.getLength();
+            }
 
-                std::vector<art_leaf *> query_suggestion;
+            strt_ids_size = ArrayUtils::and_many(leaf_ids.data(), leaf_ids_lens.data(), leaf_ids.size(),
+                                                 &strt_ids);
 
-                // there could be multiple tokens in a filter value, which we have to treat as ANDs
-                // e.g. country: South Africa
+            for(uint32_t* ids_of_leaf: leaf_ids) {
+                delete[] ids_of_leaf;
+            }
 
-                Tokenizer tokenizer(filter_value, true, false, f.locale);
+            if(a_filter.comparators[0] == EQUALS && f.is_facet()) {
+                // need to do exact match (unlike CONTAINS) by using the facet index
+                // field being a facet is already enforced upstream
+                uint32_t* exact_strt_ids = new uint32_t[strt_ids_size];
+                size_t exact_strt_size = 0;
+                
+                for(size_t strt_ids_index = 0; strt_ids_index < strt_ids_size; strt_ids_index++) {
+                    uint32_t seq_id = strt_ids[strt_ids_index];
+                    const bool found_filter = is_exact_facet_match(f, seq_id, str_tokens);
 
-                std::string str_token;
-                size_t token_index = 0;
-                std::vector<std::string> str_tokens;
+                    if(found_filter) {
+                        exact_strt_ids[exact_strt_size] = seq_id;
+                        exact_strt_size++;
+                    }
+                }
 
-                while(tokenizer.next(str_token, token_index)) {
-                    str_tokens.push_back(str_token);
+                delete[] strt_ids;
+                strt_ids = exact_strt_ids;
+                strt_ids_size = exact_strt_size;
+            }
 
-                    art_leaf* leaf = (art_leaf *) art_search(t, (const unsigned char*) str_token.c_str(),
-                                                             str_token.length()+1);
-                    if(leaf == nullptr) {
-                        continue;
-                    }
+            // Otherwise, we just ensure that given record contains tokens in the filter query
+            // (NOT implemented) if the query is wrapped by double quotes, ensure phrase match
+            // bool exact_match = (filter_value.front() == '"' && filter_value.back() == '"');
+            uint32_t* out = nullptr;
+            ids_size = ArrayUtils::or_scalar(ids, ids_size, strt_ids, strt_ids_size, &out);
+            delete[] strt_ids;
+            delete[] ids;
+            ids = out;
+        }
 
-                    query_suggestion.push_back(leaf);
-                }
+        result_ids = ids;
+        result_ids_len = ids_size;
+    }
 
-                if(query_suggestion.size() != str_tokens.size()) {
-                    continue;
-                }
+    *result_ids_out = result_ids;
+    result_ids_len_out = result_ids_len;
+}
 
-                for(const auto& leaf: query_suggestion) {
-                    if(strt_ids == nullptr) {
-                        strt_ids = leaf->values->ids.uncompress();
-                        strt_ids_size = leaf->values->ids.getLength();
-                    } else {
-                        // do AND for an exact match
-                        uint32_t* out = nullptr;
-                        uint32_t* leaf_ids = leaf->values->ids.uncompress();
-                        strt_ids_size = ArrayUtils::and_scalar(strt_ids, strt_ids_size, leaf_ids,
-                                                               leaf->values->ids.getLength(), &out);
-                        delete[] leaf_ids;
-                        delete[] strt_ids;
-                        strt_ids = out;
-                    }
+bool Index::probe_filter(const filter& a_filter, const field& f, const uint32_t* ids, size_t ids_len,
+                         uint32_t** result_ids_out, size_t& result_ids_len) const {
+    if(f.is_geopoint() || ids_len == 0) {
+        return false;
+    }
+
+    if(f.is_integer() || f.is_float() || f.is_bool()) {
+        // only single valued fields have a column to look the value of a document up in
+        const auto column_it = sort_index.find(a_filter.field_name);
+        if(f.is_array() || column_it == sort_index.end()) {
+            return false;
+        }
+
+        const sort_column_t* column = column_it->second;
+
+        std::vector<std::pair<int64_t, int64_t>> ranges;
+        get_filter_ranges(a_filter, f, ranges);
+
+        uint32_t* result_ids = new uint32_t[ids_len];
+        result_ids_len = 0;
+
+        for(size_t i = 0; i < ids_len; i++) {
+            if(!column->contains(ids[i])) {
+                continue;
+            }
+
+            const int64_t value = column->get(ids[i], 0);
+
+            for(const auto& range: ranges) {
+                if(value >= range.first && value <= range.second) {
+                    result_ids[result_ids_len++] = ids[i];
+                    break;
                 }
+            }
+        }
 
-                if(a_filter.comparators[0] == EQUALS && f.is_facet()) {
-                    // need to do exact match (unlike CONTAINS) by using the facet index
-                    // field being a facet is already enforced upstream
-                    uint32_t* exact_strt_ids = new uint32_t[strt_ids_size];
-                    size_t exact_strt_size = 0;
-                    
-                    for(size_t strt_ids_index = 0; strt_ids_index < strt_ids_size; strt_ids_index++) {
-                        uint32_t seq_id = strt_ids[strt_ids_index];
-                        const auto& fvalues = facet_index_v3.at(f.name)->at(seq_id);
-                        bool found_filter = false;
-
-                        if(!f.is_array()) {
-                            found_filter = (query_suggestion.size() == fvalues.length);
-                        } else {
-                            uint64_t filter_hash = 1;
-
-                            for(size_t sindex=0; sindex < str_tokens.size(); sindex++) {
-                                auto& this_str_token = str_tokens[sindex];
-                                uint64_t thash = facet_token_hash(f, this_str_token);
-                                filter_hash *= (1779033703 + 2*thash*(sindex+1));
-                            }
+        *result_ids_out = result_ids;
+        return true;
+    }
 
-                            uint64_t all_fvalue_hash = 1;
-                            size_t ftindex = 0;
-
-                            for(size_t findex=0; findex < fvalues.size(); findex++) {
-                                auto fhash = fvalues.hashes[findex];
-                                if(fhash == FACET_ARRAY_DELIMETER) {
-                                    // end of array, check hash
-                                    if(all_fvalue_hash == filter_hash) {
-                                        found_filter = true;
-                                        break;
-                                    }
-                                    all_fvalue_hash = 1;
-                                    ftindex = 0;
-                                } else {
-                                    all_fvalue_hash *= (1779033703 + 2*fhash*(ftindex + 1));
-                                    ftindex++;
-                                }
-                            }
-                        }
+    if(!f.is_string()) {
+        return false;
+    }
 
-                        if(found_filter) {
-                            exact_strt_ids[exact_strt_size] = seq_id;
-                            exact_strt_size++;
-                        }
-                    }
+    art_tree* t = search_index.at(a_filter.field_name);
+    std::vector<bool> id_matched(ids_len, false);
+    std::vector<uint32_t> indices(ids_len);
+
+    for(const std::string & filter_value: a_filter.values) {
+        std::vector<art_leaf *> query_suggestion;
+        std::vector<std::string> str_tokens;
+
+        Tokenizer tokenizer(filter_value, true, false, f.locale);
+
+        std::string str_token;
+        size_t token_index = 0;
+
+        while(tokenizer.next(str_token, token_index)) {
+            str_tokens.push_back(str_token);
+
+            art_leaf* leaf = (art_leaf *) art_search(t, (const unsigned char*) str_token.c_str(),
+                                                     str_token.length()+1);
+            if(leaf == nullptr || leaf->values->ids.getLength() == 0) {
+                continue;
+            }
+
+            query_suggestion.push_back(leaf);
+        }
+
+        if(query_suggestion.empty() || query_suggestion.size() != str_tokens.size()) {
+            continue;
+        }
 
-                    delete[] strt_ids;
-                    strt_ids = exact_strt_ids;
-                    strt_ids_size = exact_strt_size;
+        // an id matches the value when every token of the value has it
+        std::vector<bool> value_matched(ids_len, true);
+
+        for(art_leaf* leaf: query_suggestion) {
+            leaf->values->ids.indexOf(ids, ids_len, indices.data());
+            const uint32_t leaf_ids_len = leaf->values->ids.getLength();
+
+            for(size_t i = 0; i < ids_len; i++) {
+                if(indices[i] == leaf_ids_len) {
+                    value_matched[i] = false;
                 }
+            }
+        }
 
-                // Otherwise, we just ensure that given record contains tokens in the filter query
-                // (NOT implemented) if the query is wrapped by double quotes, ensure phrase match
-                // bool exact_match = (filter_value.front() == '"' && filter_value.back() == '"');
-                uint32_t* out = nullptr;
-                ids_size = ArrayUtils::or_scalar(ids, ids_size, strt_ids, strt_ids_size, &out);
-                delete[] strt_ids;
-                delete[] ids;
-                ids = out;
+        for(size_t i = 0; i < ids_len; i++) {
+            if(!value_matched[i] || id_matched[i]) {
+                continue;
             }
 
-            result_ids = ids;
-            result_ids_len = ids_size;
+            id_matched[i] = (a_filter.comparators[0] != EQUALS || !f.is_facet() ||
+                             is_exact_facet_match(f, ids[i], str_tokens));
         }
+    }
 
-        if(i == 0) {
-            filter_ids = result_ids;
-            filter_ids_length = result_ids_len;
-        } else {
-            uint32_t* filtered_results = nullptr;
-            filter_ids_length = ArrayUtils::and_scalar(filter_ids, filter_ids_length, result_ids,
-                                                       result_ids_len, &filtered_results);
-            delete [] result_ids;
-            delete [] filter_ids;
-            filter_ids = filtered_results;
+    uint32_t* result_ids = new uint32_t[ids_len];
+    result_ids_len = 0;
+
+    for(size_t i = 0; i < ids_len; i++) {
+        if(id_matched[i]) {
+            result_ids[result_ids_len++] = ids[i];
         }
     }
 
-    /*long long int timeMillis =
-            std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::high_resolution_clock::now() - begin).count();
+    *result_ids_out = result_ids;
+    return true;
+}
+
+bool Index::is_exact_facet_match(const field& f, uint32_t seq_id, const std::vector<std::string>& str_tokens) const {
+    const auto& fvalues = facet_index_v3.at(f.name)->at(seq_id);
+    bool found_filter = false;
 
-    LOG(INFO) << "Time taken for filtering: " << timeMillis << "ms";*/
+    if(!f.is_array()) {
+        found_filter = (str_tokens.size() == fvalues.length);
+    } else {
+        uint64_t filter_hash = 1;
 
-    *filter_ids_out = filter_ids;
-    return filter_ids_length;
+        for(size_t sindex=0; sindex < str_tokens.size(); sindex++) {
+            auto& this_str_token = str_tokens[sindex];
+            uint64_t thash = facet_token_hash(f, this_str_token);
+            filter_hash *= (1779033703 + 2*thash*(sindex+1));
+        }
+
+        uint64_t all_fvalue_hash = 1;
+        size_t ftindex = 0;
+
+        for(size_t findex=0; findex < fvalues.size(); findex++) {
+            auto fhash = fvalues.hashes[findex];
+            if(fhash == FACET_ARRAY_DELIMETER) {
+                // end of array, check hash
+                if(all_fvalue_hash == filter_hash) {
+                    found_filter = true;
+                    break;
+                }
+                all_fvalue_hash = 1;
+                ftindex = 0;
+            } else {
+                all_fvalue_hash *= (1779033703 + 2*fhash*(ftindex + 1));
+                ftindex++;
+            }
+        }
+    }
+
+    return found_filter;
 }
 
 void Index::eq_str_filter_plain(const uint32_t *strt_ids, size_t strt_ids_size,
@@ -1399,7 +2120,10 @@ void Index::run_search(search_args* search_params) {
            search_params->raw_result_kvs, search_params->override_result_kvs,
            search_params->typo_tokens_threshold,
            search_params->group_limit, search_params->group_by_fields,
-           search_params->default_sorting_field);
+           search_params->default_sorting_field,
+           search_params->explain_filters ? &search_params->filter_explain : nullptr,
+           search_params->facet_sample_percent, search_params->facet_sample_threshold,
+           search_params->thread_pool);
 }
 
 void Index::collate_included_ids(const std::vector<std::string>& q_included_tokens,
@@ -1490,7 +2214,11 @@ void Index::search(const std::vector<query_tokens_t>& field_query_tokens,
                    const size_t typo_tokens_threshold,
                    const size_t group_limit,
                    const std::vector<std::string>& group_by_fields,
-                   const std::string& default_sorting_field) const {
+                   const std::string& default_sorting_field,
+                   std::vector<filter_explain_t>* filter_explain,
+                   const size_t facet_sample_percent,
+                   const size_t facet_sample_threshold,
+                   ThreadPool* thread_pool) const {
 
     std::shared_lock lock(mutex);
 
@@ -1498,8 +2226,14 @@ void Index::search(const std::vector<query_tokens_t>& field_query_tokens,
 
     // process the filters
 
+    const bool wildcard_query = !field_query_tokens.empty() && !field_query_tokens[0].q_include_tokens.empty() &&
+                                field_query_tokens[0].q_include_tokens[0] == "*";
+
+    // a wildcard query uses the filtered ids as its results, so it has no use for a bitmap
     uint32_t* filter_ids = nullptr;
-    uint32_t filter_ids_length = do_filtering(&filter_ids, filters);
+    id_bitmap_t* filter_bitmap = nullptr;
+    uint32_t filter_ids_length = do_filtering(&filter_ids, filters, wildcard_query ? nullptr : &filter_bitmap,
+                                              filter_explain);
 
     // we will be removing all curated IDs from organic result ids before running topster
     std::set<uint32_t> curated_ids;
@@ -1548,8 +2282,7 @@ void Index::search(const std::vector<query_tokens_t>& field_query_tokens,
 
     std::vector<Topster*> ftopsters;
 
-    if (!field_query_tokens.empty() && !field_query_tokens[0].q_include_tokens.empty() &&
-        field_query_tokens[0].q_include_tokens[0] == "*") {
+    if (wildcard_query) {
         const uint8_t field_id = (uint8_t)(FIELD_LIMIT_NUM - 0);
         const std::string& field = search_fields[0].name;
 
@@ -1559,23 +2292,22 @@ void Index::search(const std::vector<query_tokens_t>& field_query_tokens,
                 filter_ids_length = seq_ids.getLength();
                 filter_ids = seq_ids.uncompress();
             } else {
-                const spp::sparse_hash_map<uint32_t, int64_t> *kvs = sort_index.at(default_sorting_field);
-                filter_ids_length = kvs->size();
-                filter_ids = new uint32_t[filter_ids_length];
+                // documents that have a value for the default sorting field, in seq_id order
+                const sort_column_t *column = sort_index.at(default_sorting_field);
+                filter_ids = seq_ids.uncompress();
+                filter_ids_length = 0;
 
-                size_t i = 0;
-                for(const auto& kv: *kvs) {
-                    filter_ids[i++] = kv.first;
+                for(size_t i = 0; i < seq_ids.getLength(); i++) {
+                    if(column->contains(filter_ids[i])) {
+                        filter_ids[filter_ids_length++] = filter_ids[i];
+                    }
                 }
-
-                // ids populated from hash map will not be sorted, but sorting is required for intersection & other ops
-                std::sort(filter_ids, filter_ids+filter_ids_length);
             }
         }
 
         if(!curated_ids.empty()) {
             uint32_t *excluded_result_ids = nullptr;
-            filter_ids_length = ArrayUtils::exclude_scalar(filter_ids, filter_ids_length, &curated_ids_sorted[0],
+            filter_ids_length = ArrayUtils::exclude_values(filter_ids, filter_ids_length, &curated_ids_sorted[0],
                                                            curated_ids_sorted.size(), &excluded_result_ids);
             delete [] filter_ids;
             filter_ids = excluded_result_ids;
@@ -1584,7 +2316,7 @@ void Index::search(const std::vector<query_tokens_t>& field_query_tokens,
         // Exclude document IDs associated with excluded tokens from the result set
         if(exclude_token_ids_size != 0) {
             uint32_t *excluded_result_ids = nullptr;
-            filter_ids_length = ArrayUtils::exclude_scalar(filter_ids, filter_ids_length, exclude_token_ids,
+            filter_ids_length = ArrayUtils::exclude_values(filter_ids, filter_ids_length, exclude_token_ids,
                                 exclude_token_ids_size, &excluded_result_ids);
             delete[] filter_ids;
             filter_ids = excluded_result_ids;
@@ -1640,10 +2372,10 @@ void Index::search(const std::vector<query_tokens_t>& field_query_tokens,
                 size_t field_num_results = 0;
 
                 search_field(field_id, query_tokens, search_tokens, exclude_token_ids, exclude_token_ids_size, num_tokens_dropped,
-                             field_name, filter_ids, filter_ids_length, curated_ids_sorted, facets, sort_fields_std,
+                             field_name, filter_ids, filter_ids_length, filter_bitmap, curated_ids_sorted, facets, sort_fields_std,
                              num_typos, searched_queries, actual_topster, groups_processed, &all_result_ids, all_result_ids_len,
-                             field_num_results, group_limit, group_by_fields, token_order, prefix,
-                             drop_tokens_threshold, typo_tokens_threshold);
+                             field_num_results, group_limit, group_by_fields, default_sorting_field, token_order,
+                             prefix, drop_tokens_threshold, typo_tokens_threshold);
 
                 // do synonym based searches
                 for(const auto& syn_tokens: q_pos_synonyms) {
@@ -1652,10 +2384,10 @@ void Index::search(const std::vector<query_tokens_t>& field_query_tokens,
                     query_tokens = search_tokens = syn_tokens;
 
                     search_field(field_id, query_tokens, search_tokens, exclude_token_ids, exclude_token_ids_size, num_tokens_dropped,
-                                 field_name, filter_ids, filter_ids_length, curated_ids_sorted, facets, sort_fields_std,
+                                 field_name, filter_ids, filter_ids_length, filter_bitmap, curated_ids_sorted, facets, sort_fields_std,
                                  num_typos, searched_queries, actual_topster, groups_processed, &all_result_ids, all_result_ids_len,
-                                 field_num_results, group_limit, group_by_fields, token_order, prefix,
-                                 drop_tokens_threshold, typo_tokens_threshold);
+                                 field_num_results, group_limit, group_by_fields, default_sorting_field,
+                                 token_order, prefix, drop_tokens_threshold, typo_tokens_threshold);
                 }
 
                 concat_topster_ids(ftopster, topster_ids);
@@ -1786,12 +2518,14 @@ void Index::search(const std::vector<query_tokens_t>& field_query_tokens,
 
     delete [] exclude_token_ids;
 
-    do_facets(facets, facet_query, group_limit, group_by_fields, all_result_ids, all_result_ids_len);
+    do_facets(facets, facet_query, group_limit, group_by_fields, all_result_ids, all_result_ids_len,
+              facet_sample_percent, facet_sample_threshold, thread_pool);
     do_facets(facets, facet_query, group_limit, group_by_fields, &included_ids[0], included_ids.size());
 
     all_result_ids_len += curated_topster->size;
 
     delete [] filter_ids;
+    delete filter_bitmap;
     delete [] all_result_ids;
 
     for(Topster* ftopster: ftopsters) {
@@ -1820,12 +2554,14 @@ void Index::search_field(const uint8_t & field_id,
                          size_t& num_tokens_dropped,
                          const std::string & field,
                          uint32_t *filter_ids, size_t filter_ids_length,
+                         const id_bitmap_t* filter_bitmap,
                          const std::vector<uint32_t>& curated_ids,
                          std::vector<facet> & facets, const std::vector<sort_by> & sort_fields, const int num_typos,
                          std::vector<std::vector<art_leaf*>> & searched_queries,
                          Topster* topster, spp::sparse_hash_set<uint64_t>& groups_processed,
                          uint32_t** all_result_ids, size_t & all_result_ids_len, size_t& field_num_results,
                          const size_t group_limit, const std::vector<std::string>& group_by_fields,
+                         const std::string& default_sorting_field,
                          const token_ordering token_order, const bool prefix, 
                          const size_t drop_tokens_threshold, const size_t typo_tokens_threshold) const {
 
@@ -1892,9 +2628,23 @@ void Index::search_field(const uint8_t & field_id,
 
                 // need less candidates for filtered searches since we already only pick tokens with results
                 const int max_candidates = (filter_ids_length == 0) ? 10 : 3;
-                art_fuzzy_search(search_index.at(field), (const unsigned char *) token.c_str(), token_len,
-                                 costs[token_index], costs[token_index], max_candidates, token_order, prefix_search,
-                                 filter_ids, filter_ids_length, leaves);
+                const auto typo_index_it = typo_index.find(field);
+                const bool use_typo_index = costs[token_index] > 0 && !prefix_search &&
+                                            typo_index_it != typo_index.end() &&
+                                            typo_index_it->second->can_search(token.length(), costs[token_index]);
+
+                if(use_typo_index) {
+                    typo_index_it->second->search((const unsigned char *) token.c_str(), token.length(),
+                                                  costs[token_index], costs[token_index], max_candidates,
+                                                  token_order, filter_ids, filter_ids_length, leaves);
+                } else {
+                    // typo lookups walk a lot of edges, so they go through the compiled levenshtein automaton
+                    const fuzzy_search_engine engine = (costs[token_index] > 0) ? LEVENSHTEIN_AUTOMATON :
+                                                       LEVENSHTEIN_ROWS;
+                    art_fuzzy_search(search_index.at(field), (const unsigned char *) token.c_str(), token_len,
+                                     costs[token_index], costs[token_index], max_candidates, token_order,
+                                     prefix_search, filter_ids, filter_ids_length, leaves, engine);
+                }
 
                 if(!leaves.empty()) {
                     token_cost_cache.emplace(token_cost_hash, leaves);
@@ -1931,10 +2681,12 @@ void Index::search_field(const uint8_t & field_id,
 
         if(!token_candidates_vec.empty()) {
             // If atleast one token is found, go ahead and search for candidates
-            search_candidates(field_id, filter_ids, filter_ids_length, exclude_token_ids, exclude_token_ids_size,
+            search_candidates(field_id, filter_ids, filter_ids_length, filter_bitmap,
+                              exclude_token_ids, exclude_token_ids_size,
                               curated_ids, sort_fields, token_candidates_vec, searched_queries, topster,
                               groups_processed, all_result_ids, all_result_ids_len, field_num_results,
-                              typo_tokens_threshold, group_limit, group_by_fields);
+                              typo_tokens_threshold, group_limit, group_by_fields,
+                              search_schema.at(field).is_array(), default_sorting_field);
         }
 
         resume_typo_loop:
@@ -1970,10 +2722,10 @@ void Index::search_field(const uint8_t & field_id,
         }
 
         return search_field(field_id, query_tokens, truncated_tokens, exclude_token_ids, exclude_token_ids_size,
-                            num_tokens_dropped, field, filter_ids, filter_ids_length, curated_ids,facets,
+                            num_tokens_dropped, field, filter_ids, filter_ids_length, filter_bitmap, curated_ids,facets,
                             sort_fields, num_typos,searched_queries, topster, groups_processed, all_result_ids,
                             all_result_ids_len, field_num_results, group_limit, group_by_fields,
-                            token_order, prefix);
+                            default_sorting_field, token_order, prefix);
     }
 }
 
@@ -1998,32 +2750,64 @@ void Index::log_leaves(const int cost, const std::string &token, const std::vect
     }
 }
 
+bool Index::suggestion_can_enter_topster(const std::vector<sort_by>& sort_fields,
+                                         const std::string& default_sorting_field,
+                                         const std::vector<art_leaf*>& query_suggestion, const uint32_t total_cost,
+                                         const Topster* topster) const {
+    if(topster->size < topster->MAX_SIZE || topster->distinct != 0 || query_suggestion.empty()) {
+        return true;
+    }
+
+    // Upper bound of the sort scores that score_results() can give to a document matching every leaf of the
+    // suggestion: the text match is at most a window of all the tokens, and the default sorting field points of
+    // the document are at most the `max_score` of each leaf that holds it. Other sort fields are not bounded.
+    int64_t bound_scores[3] = {0};
+
+    for(size_t i = 0; i < sort_fields.size() && i < 2; i++) {
+        const bool is_desc = (sort_fields[i].order != sort_field_const::asc);
+
+        if(sort_fields[i].name == sort_field_const::text_match) {
+            bound_scores[i] = is_desc ? Match::get_match_score(query_suggestion.size(), total_cost, 0) : 0;
+        } else if(is_desc && sort_fields[i].name == default_sorting_field &&
+                  sort_schema.at(default_sorting_field).is_single_integer()) {
+            bound_scores[i] = INT64_MAX;
+            for(const art_leaf* leaf: query_suggestion) {
+                bound_scores[i] = std::min(bound_scores[i], leaf->max_score);
+            }
+        } else {
+            bound_scores[i] = INT64_MAX;
+        }
+    }
+
+    if(sort_fields.size() > 2) {
+        bound_scores[2] = INT64_MAX;
+    }
+
+    const KV bound_kv(0, 0, 0, 0, 0, 0, bound_scores);
+    return !Topster::is_smaller(&bound_kv, topster->kvs[0]);
+}
+
 void Index::score_results(const std::vector<sort_by> & sort_fields, const uint16_t & query_index,
                           const uint8_t & field_id, const uint32_t total_cost, Topster* topster,
                           const std::vector<art_leaf *> &query_suggestion,
                           spp::sparse_hash_set<uint64_t>& groups_processed,
                           const uint32_t *result_ids, const size_t result_size,
                           const size_t group_limit, const std::vector<std::string>& group_by_fields,
-                          uint32_t token_bits) const {
-
-    std::vector<uint32_t *> leaf_to_indices;
-    for (art_leaf *token_leaf: query_suggestion) {
-        uint32_t *indices = new uint32_t[result_size];
-        token_leaf->values->ids.indexOf(result_ids, result_size, indices);
-        leaf_to_indices.push_back(indices);
-    }
+                          uint32_t token_bits, const bool is_array_field) const {
 
     Match single_token_match = Match(1, 0);
     const uint64_t single_token_match_score = single_token_match.get_match_score(total_cost);
 
     int sort_order[3]; // 1 or -1 based on DESC or ASC respectively
-    spp::sparse_hash_map<uint32_t, int64_t>* field_values[3];
+    const sort_column_t* field_values[3];
 
-    spp::sparse_hash_map<uint32_t, int64_t> geopoint_distances[3];
+    // distances of the results (in `result_ids` order) from the geopoint of a sort field
+    std::vector<int64_t> geopoint_distances[3];
 
-    spp::sparse_hash_map<uint32_t, int64_t> text_match_sentinel_value, seq_id_sentinel_value;
-    spp::sparse_hash_map<uint32_t, int64_t> *TEXT_MATCH_SENTINEL = &text_match_sentinel_value;
-    spp::sparse_hash_map<uint32_t, int64_t> *SEQ_ID_SENTINEL = &seq_id_sentinel_value;
+    sort_column_t text_match_sentinel_value, seq_id_sentinel_value, geopoint_sentinel_value;
+    const sort_column_t *TEXT_MATCH_SENTINEL = &text_match_sentinel_value;
+    const sort_column_t *SEQ_ID_SENTINEL = &seq_id_sentinel_value;
+    const sort_column_t *GEOPOINT_SENTINEL = &geopoint_sentinel_value;
 
     for (size_t i = 0; i < sort_fields.size(); i++) {
         sort_order[i] = 1;
@@ -2037,16 +2821,16 @@ void Index::score_results(const std::vector<sort_by> & sort_fields, const uint16
             field_values[i] = SEQ_ID_SENTINEL;
         } else if (sort_schema.at(sort_fields[i].name).is_geopoint()) {
             // we have to populate distances that will be used for match scoring
-            spp::sparse_hash_map<uint32_t, int64_t> *geopoints = sort_index.at(sort_fields[i].name);
+            const sort_column_t *geopoints = sort_index.at(sort_fields[i].name);
+            geopoint_distances[i].resize(result_size);
 
             for (size_t rindex = 0; rindex < result_size; rindex++) {
                 const uint32_t seq_id = result_ids[rindex];
-                auto it = geopoints->find(seq_id);
-                int64_t dist = (it == geopoints->end()) ? INT32_MAX : h3Distance(sort_fields[i].geopoint, it->second);
-                geopoint_distances[i].emplace(seq_id, dist);
+                geopoint_distances[i][rindex] = !geopoints->contains(seq_id) ? INT32_MAX :
+                                                h3Distance(sort_fields[i].geopoint, geopoints->get(seq_id, 0));
             }
 
-            field_values[i] = &geopoint_distances[i];
+            field_values[i] = GEOPOINT_SENTINEL;
         } else {
             field_values[i] = sort_index.at(sort_fields[i].name);
         }
@@ -2054,41 +2838,10 @@ void Index::score_results(const std::vector<sort_by> & sort_fields, const uint16
 
     //auto begin = std::chrono::high_resolution_clock::now();
 
-    for (size_t i = 0; i < result_size; i++) {
-        const uint32_t seq_id = result_ids[i];
-
-        uint64_t match_score = 0;
-
-        if (query_suggestion.size() <= 1) {
-            match_score = single_token_match_score;
-        } else {
-            std::unordered_map<size_t, std::vector<std::vector<uint16_t>>> array_token_positions;
-            populate_token_positions(query_suggestion, leaf_to_indices, i, array_token_positions);
-
-            for (const auto& kv: array_token_positions) {
-                const std::vector<std::vector<uint16_t>> &token_positions = kv.second;
-                if (token_positions.empty()) {
-                    continue;
-                }
-                const Match &match = Match(seq_id, token_positions, false);
-                uint64_t this_match_score = match.get_match_score(total_cost);
-
-                match_score += this_match_score;
-
-                /*std::ostringstream os;
-                os << name << ", total_cost: " << (255 - total_cost)
-                   << ", words_present: " << match.words_present
-                   << ", match_score: " << match_score
-                   << ", match.distance: " << match.distance
-                   << ", seq_id: " << seq_id << std::endl;
-                LOG(INFO) << os.str();*/
-            }
-        }
-
-        const int64_t default_score = INT64_MIN;  // to handle field that doesn't exist in document (e.g. optional)
-        int64_t scores[3] = {0};
-        size_t match_score_index = 0;
+    const int64_t default_score = INT64_MIN;  // to handle field that doesn't exist in document (e.g. optional)
 
+    auto compute_scores = [&](const uint32_t seq_id, const size_t result_index, const uint64_t match_score,
+                              int64_t* scores, size_t& match_score_index) {
         // avoiding loop
         if (sort_fields.size() > 0) {
             if (field_values[0] == TEXT_MATCH_SENTINEL) {
@@ -2096,9 +2849,10 @@ void Index::score_results(const std::vector<sort_by> & sort_fields, const uint16
                 match_score_index = 0;
             } else if (field_values[0] == SEQ_ID_SENTINEL) {
                 scores[0] = seq_id;
+            } else if (field_values[0] == GEOPOINT_SENTINEL) {
+                scores[0] = geopoint_distances[0][result_index];
             } else {
-                auto it = field_values[0]->find(seq_id);
-                scores[0] = (it == field_values[0]->end()) ? default_score : it->second;
+                scores[0] = field_values[0]->get(seq_id, default_score);
             }
             if (sort_order[0] == -1) {
                 scores[0] = -scores[0];
@@ -2112,9 +2866,10 @@ void Index::score_results(const std::vector<sort_by> & sort_fields, const uint16
                 match_score_index = 1;
             } else if (field_values[1] == SEQ_ID_SENTINEL) {
                 scores[1] = seq_id;
+            } else if (field_values[1] == GEOPOINT_SENTINEL) {
+                scores[1] = geopoint_distances[1][result_index];
             } else {
-                auto it = field_values[1]->find(seq_id);
-                scores[1] = (it == field_values[1]->end()) ? default_score : it->second;
+                scores[1] = field_values[1]->get(seq_id, default_score);
             }
 
             if (sort_order[1] == -1) {
@@ -2128,15 +2883,96 @@ void Index::score_results(const std::vector<sort_by> & sort_fields, const uint16
                 match_score_index = 2;
             } else if (field_values[2] == SEQ_ID_SENTINEL) {
                 scores[2] = seq_id;
+            } else if (field_values[2] == GEOPOINT_SENTINEL) {
+                scores[2] = geopoint_distances[2][result_index];
             } else {
-                auto it = field_values[2]->find(seq_id);
-                scores[2] = (it == field_values[2]->end()) ? default_score : it->second;
+                scores[2] = field_values[2]->get(seq_id, default_score);
             }
 
             if(sort_order[2] == -1) {
                 scores[2] = -scores[2];
             }
         }
+    };
+
+    // Once the topster is full, a result whose best possible scores are below its smallest entry is skipped before
+    // its token positions are matched. Every match score lies within [0, max_match_score], so the largest of each
+    // score over both ends of that range bounds it. Array fields add up the match scores of all matching elements,
+    // and distinct topsters take in smaller results of existing groups, so neither of them can be pruned this way.
+    const bool prune_results = !is_array_field && query_suggestion.size() > 1 &&
+                               group_limit == 0 && topster->distinct == 0;
+    const uint64_t max_match_score = Match::get_match_score(query_suggestion.size(), total_cost, 0);
+
+    auto is_below_topster = [&](const uint32_t seq_id, const size_t result_index) {
+        int64_t bound_scores[3] = {0};
+        int64_t min_match_scores[3] = {0};
+        size_t bound_match_score_index = 0;
+
+        compute_scores(seq_id, result_index, max_match_score, bound_scores, bound_match_score_index);
+        compute_scores(seq_id, result_index, 0, min_match_scores, bound_match_score_index);
+
+        for (size_t j = 0; j < 3; j++) {
+            bound_scores[j] = std::max(bound_scores[j], min_match_scores[j]);
+        }
+
+        KV bound_kv(field_id, query_index, token_bits, seq_id, seq_id, bound_match_score_index, bound_scores);
+        return Topster::is_smaller(&bound_kv, topster->kvs[0]);
+    };
+
+    // When the topster is already full, results that are below it are dropped before they are looked up in the
+    // token leaves, and only the remaining ones (at `candidate_positions` of `result_ids`) are scored.
+    const bool prefilter_results = prune_results && topster->size >= topster->MAX_SIZE;
+    std::vector<uint32_t> candidate_positions;
+    std::vector<uint32_t> candidate_ids;
+
+    if (prefilter_results) {
+        for (size_t i = 0; i < result_size; i++) {
+            if (!is_below_topster(result_ids[i], i)) {
+                candidate_positions.push_back(i);
+                candidate_ids.push_back(result_ids[i]);
+            }
+        }
+    }
+
+    const uint32_t* scored_ids = prefilter_results ? candidate_ids.data() : result_ids;
+    const size_t scored_size = prefilter_results ? candidate_ids.size() : result_size;
+
+    std::vector<uint32_t *> leaf_to_indices;
+    for (art_leaf *token_leaf: query_suggestion) {
+        uint32_t *indices = new uint32_t[scored_size];
+        token_leaf->values->ids.indexOf(scored_ids, scored_size, indices);
+        leaf_to_indices.push_back(indices);
+    }
+
+    // reused across calls made by the same search thread
+    thread_local token_positions_buffer_t positions_buffer;
+
+    for (size_t k = 0; k < scored_size; k++) {
+        const uint32_t seq_id = scored_ids[k];
+        const size_t i = prefilter_results ? candidate_positions[k] : k;
+
+        if (k + SORT_PREFETCH_DISTANCE < scored_size) {
+            for (size_t j = 0; j < sort_fields.size(); j++) {
+                field_values[j]->prefetch(scored_ids[k + SORT_PREFETCH_DISTANCE]);
+            }
+        }
+
+        if (prune_results && topster->size >= topster->MAX_SIZE && is_below_topster(seq_id, i)) {
+            continue;
+        }
+
+        uint64_t match_score = 0;
+
+        if (query_suggestion.size() <= 1) {
+            match_score = single_token_match_score;
+        } else {
+            populate_token_positions(query_suggestion, leaf_to_indices, k, positions_buffer);
+            match_score = get_match_score(positions_buffer, total_cost);
+        }
+
+        int64_t scores[3] = {0};
+        size_t match_score_index = 0;
+        compute_scores(seq_id, i, match_score, scores, match_score_index);
 
         uint64_t distinct_id = seq_id;
 
@@ -2260,6 +3096,91 @@ void Index::populate_token_positions(const std::vector<art_leaf *>& query_sugges
     }
 }
 
+void Index::populate_token_positions(const std::vector<art_leaf *>& query_suggestion,
+                                     const std::vector<uint32_t*>& leaf_to_indices,
+                                     const size_t result_index,
+                                     token_positions_buffer_t& positions_buffer) {
+    positions_buffer.clear();
+
+    // same offset storage format as above, but the positions of every (array element, token) pair are appended
+    // to a single buffer instead of being copied into vectors of their own
+
+    for(size_t i = 0; i < query_suggestion.size(); i++) {
+        const art_leaf* token_leaf = query_suggestion[i];
+        uint32_t doc_index = leaf_to_indices[i][result_index];
+
+        if(doc_index == token_leaf->values->ids.getLength()) {
+            continue;
+        }
+
+        uint32_t start_offset = token_leaf->values->offset_index.at(doc_index);
+        uint32_t end_offset = (doc_index == token_leaf->values->ids.getLength() - 1) ?
+                              token_leaf->values->offsets.getLength() :
+                              token_leaf->values->offset_index.at(doc_index+1);
+
+        uint32_t run_start = positions_buffer.positions.size();
+        int prev_pos = -1;
+
+        while(start_offset < end_offset) {
+            int pos = token_leaf->values->offsets.at(start_offset);
+            start_offset++;
+
+            if(pos == prev_pos) {  // indicates end of array index
+                if(run_start != positions_buffer.positions.size()) {
+                    uint32_t array_index = token_leaf->values->offsets.at(start_offset);
+                    positions_buffer.runs.push_back({array_index, uint32_t(i), run_start,
+                                                     uint32_t(positions_buffer.positions.size())});
+                    run_start = positions_buffer.positions.size();
+                }
+
+                start_offset++;  // skip current value which is the array index
+                prev_pos = -1;
+                continue;
+            }
+
+            prev_pos = pos;
+            positions_buffer.positions.push_back((uint16_t)pos);
+        }
+
+        if(run_start != positions_buffer.positions.size()) {
+            // for plain string fields
+            positions_buffer.runs.push_back({0, uint32_t(i), run_start, uint32_t(positions_buffer.positions.size())});
+        }
+    }
+
+    // runs of plain string fields are already in order
+    std::sort(positions_buffer.runs.begin(), positions_buffer.runs.end(),
+              [](const token_positions_buffer_t::run_t& a, const token_positions_buffer_t::run_t& b) {
+                  return std::tie(a.array_index, a.token_index) < std::tie(b.array_index, b.token_index);
+              });
+}
+
+uint64_t Index::get_match_score(const token_positions_buffer_t& positions_buffer, const uint32_t total_cost) {
+    uint64_t match_score = 0;
+    size_t run_index = 0;
+
+    while(run_index < positions_buffer.runs.size()) {
+        const uint32_t array_index = positions_buffer.runs[run_index].array_index;
+
+        // Match only looks at the first WINDOW_SIZE tokens
+        token_positions_t token_positions[WINDOW_SIZE];
+        size_t num_tokens = 0;
+
+        for(; run_index < positions_buffer.runs.size() &&
+              positions_buffer.runs[run_index].array_index == array_index; run_index++) {
+            const auto& run = positions_buffer.runs[run_index];
+            if(num_tokens < WINDOW_SIZE) {
+                token_positions[num_tokens++] = {positions_buffer.positions.data() + run.start, run.end - run.start};
+            }
+        }
+
+        const Match match(token_positions, num_tokens);
+        match_score += match.get_match_score(total_cost);
+    }
+
+    return match_score;
+}
+
 inline uint32_t Index::next_suggestion(const std::vector<token_candidates> &token_candidates_vec,
                                    long long int n,
                                    std::vector<art_leaf *>& actual_query_suggestion,
@@ -2327,6 +3248,21 @@ void Index::remove_and_shift_offset_index(sorted_array& offset_index, const uint
 
 Option<uint32_t> Index::remove(const uint32_t seq_id, const nlohmann::json & document) {
     std::unique_lock lock(mutex);
+    do_remove(seq_id, document);
+    return Option<uint32_t>(seq_id);
+}
+
+void Index::invalidate_filter_cache(const nlohmann::json& document) {
+    for(auto it = document.begin(); it != document.end(); ++it) {
+        filter_cache.invalidate(it.key());
+    }
+}
+
+void Index::do_remove(const uint32_t seq_id, const nlohmann::json & document) {
+    invalidate_filter_cache(document);
+
+    // looked up before the sort column of the default sorting field gets updated
+    const int64_t impact_points = impact_sorting_field.empty() ? 0 : get_impact_points(seq_id);
 
     for(auto it = document.begin(); it != document.end(); ++it) {
         const std::string& field_name = it.key();
@@ -2370,6 +3306,10 @@ Option<uint32_t> Index::remove(const uint32_t seq_id, const nlohmann::json & doc
                     leaf->values->offsets.remove_index(start_offset, end_offset);
                     leaf->values->ids.remove_value(seq_id);
 
+                    if(leaf->values->impact_ids) {
+                        leaf->values->impact_ids->remove(impact_points, seq_id);
+                    }
+
                     /*len = leaf->values->offset_index.getLength();
                     for(auto i=0; i<len; i++) {
                         LOG(INFO) << "i: " << i << ", val: " << leaf->values->offset_index.at(i);
@@ -2377,8 +3317,17 @@ Option<uint32_t> Index::remove(const uint32_t seq_id, const nlohmann::json & doc
                     LOG(INFO) << "----";*/
 
                     if (leaf->values->ids.getLength() == 0) {
-                        art_values *values = (art_values *) art_delete(search_index.at(field_name), key, key_len);
-                        delete values;
+                        typo_index_t* field_typo_index = get_typo_index(search_field);
+                        if(field_typo_index != nullptr) {
+                            field_typo_index->remove(leaf);
+                        }
+
+                        // searches that are still running could hold the leaf
+                        art_tree* t = search_index.at(field_name);
+                        art_leaf* detached_leaf = art_detach(t, key, key_len);
+                        reclaimer.retire([t, detached_leaf]() {
+                            art_free_leaf(t, detached_leaf);
+                        });
                     }
                 }
             }
@@ -2425,6 +3374,7 @@ Option<uint32_t> Index::remove(const uint32_t seq_id, const nlohmann::json & doc
         if(field_facets_it != facet_index_v3.end()) {
             const auto& fvalues_it = field_facets_it->second->find(seq_id);
             if(fvalues_it != field_facets_it->second->end()) {
+                facet_dictionaries.at(field_name)->remove(seq_id);
                 field_facets_it->second->erase(fvalues_it);
             }
         }
@@ -2439,7 +3389,7 @@ Option<uint32_t> Index::remove(const uint32_t seq_id, const nlohmann::json & doc
         seq_ids.remove_value(seq_id);
     }
 
-    return Option<uint32_t>(seq_id);
+    reclaimer.reclaim();
 }
 
 void Index::tokenize_string_field(const nlohmann::json& document, const field& search_field,
@@ -2463,10 +3413,207 @@ art_leaf* Index::get_token_leaf(const std::string & field_name, const unsigned c
     return (art_leaf*) art_search(t, token, (int) token_len);
 }
 
+bool Index::populate_highlight_positions(const std::string& field_name,
+                                         const std::vector<std::string>& searched_tokens,
+                                         const std::vector<std::string>& q_tokens, const uint32_t seq_id,
+                                         std::unordered_map<size_t, std::vector<std::vector<uint16_t>>>& array_token_positions) const {
+    std::shared_lock lock(mutex);
+
+    const art_tree *t = search_index.at(field_name);
+
+    std::vector<uint32_t> leaf_indices;
+    std::vector<art_leaf*> query_suggestion;
+    std::set<std::string> query_suggestion_tokens;
+
+    for(const std::string& token: searched_tokens) {
+        // the searched token comes from the best matched field and need not be present in this field of the document
+        art_leaf *actual_leaf = (art_leaf *) art_search(t, (const unsigned char *) token.c_str(), token.size() + 1);
+
+        if(actual_leaf != nullptr) {
+            query_suggestion.push_back(actual_leaf);
+            query_suggestion_tokens.insert(token);
+            leaf_indices.push_back(actual_leaf->values->ids.indexOf(seq_id));
+        }
+    }
+
+    if(query_suggestion.size() != q_tokens.size()) {
+        // can happen for compound query matched across 2 fields when some tokens are dropped
+        for(const std::string& q_token: q_tokens) {
+            if(query_suggestion_tokens.count(q_token) != 0) {
+                continue;
+            }
+
+            art_leaf *actual_leaf = (art_leaf *) art_search(t, (const unsigned char *) q_token.c_str(),
+                                                            q_token.size() + 1);
+            if(actual_leaf != nullptr) {
+                uint32_t doc_index = actual_leaf->values->ids.indexOf(seq_id);
+                if(doc_index != actual_leaf->values->ids.getLength()) {
+                    leaf_indices.push_back(doc_index);
+                    query_suggestion.push_back(actual_leaf);
+                }
+            }
+        }
+    }
+
+    if(query_suggestion.empty()) {
+        return false;
+    }
+
+    std::vector<uint32_t*> leaf_to_indices;
+    for(uint32_t& leaf_index: leaf_indices) {
+        leaf_to_indices.push_back(&leaf_index);
+    }
+
+    populate_token_positions(query_suggestion, leaf_to_indices, 0, array_token_positions);
+    return true;
+}
+
+epoch_reclaimer_t::guard_t Index::enter_epoch() {
+    return epoch_reclaimer_t::guard_t(&reclaimer);
+}
+
+const filter_cache_t& Index::get_filter_cache() const {
+    return filter_cache;
+}
+
+uint32_t Index::do_filtering_with_lock(uint32_t** filter_ids_out, const std::vector<filter> & filters) const {
+    std::shared_lock lock(mutex);
+    return do_filtering(filter_ids_out, filters);
+}
+
 const spp::sparse_hash_map<std::string, art_tree *> &Index::_get_search_index() const {
     return search_index;
 }
 
+void Index::get_memory_stats(nlohmann::json& stats) const {
+    std::shared_lock lock(mutex);
+
+    nlohmann::json& arena_bytes = stats["art_arena_bytes"];
+
+    for(const auto& kv: search_index) {
+        uint64_t field_bytes = arena_bytes.count(kv.first) != 0 ? arena_bytes[kv.first].get<uint64_t>() : 0;
+        arena_bytes[kv.first] = field_bytes + art_arena_bytes(kv.second);
+    }
+
+    if(!impact_sorting_field.empty()) {
+        nlohmann::json& impact_ids_bytes = stats["impact_ordered_ids_bytes"];
+
+        for(const auto& kv: search_index) {
+            const auto field_it = search_schema.find(kv.first);
+            if(field_it == search_schema.end() || !is_impact_ordered(field_it->second)) {
+                continue;
+            }
+
+            uint64_t field_bytes = impact_ids_bytes.count(kv.first) != 0 ? impact_ids_bytes[kv.first].get<uint64_t>() : 0;
+
+            art_iter(kv.second, [](void *data, const unsigned char*, uint32_t, void *value) {
+                const art_values* values = (const art_values*) value;
+                if(values->impact_ids) {
+                    *((uint64_t*) data) += values->impact_ids->memory_bytes();
+                }
+                return 0;
+            }, &field_bytes);
+
+            impact_ids_bytes[kv.first] = field_bytes;
+        }
+    }
+
+    if(typo_index.empty()) {
+        return ;
+    }
+
+    nlohmann::json& typo_index_bytes = stats["typo_index_bytes"];
+
+    for(const auto& kv: typo_index) {
+        uint64_t field_bytes = typo_index_bytes.count(kv.first) != 0 ? typo_index_bytes[kv.first].get<uint64_t>() : 0;
+        typo_index_bytes[kv.first] = field_bytes + kv.second->memory_bytes();
+    }
+}
+
+typo_index_t* Index::get_typo_index(const field& a_field) const {
+    if(!a_field.typo_index) {
+        return nullptr;
+    }
+
+    const auto it = typo_index.find(a_field.name);
+    return (it == typo_index.end()) ? nullptr : it->second;
+}
+
+bool Index::is_impact_ordered(const field& a_field) const {
+    return !impact_sorting_field.empty() && a_field.is_string();
+}
+
+bool Index::is_impact_ordered_sort(const std::vector<sort_by>& sort_fields) const {
+    if(impact_sorting_field.empty()) {
+        return false;
+    }
+
+    // the text match of the documents of a single token is the same for all of them
+    bool sorts_on_points = false;
+
+    for(const sort_by& sort_field: sort_fields) {
+        if(sort_field.name == impact_sorting_field && sort_field.order != sort_field_const::asc) {
+            sorts_on_points = true;
+        } else if(sort_field.name != sort_field_const::text_match) {
+            return false;
+        }
+    }
+
+    return sorts_on_points;
+}
+
+bool Index::get_top_impact_ids(const art_leaf* leaf, const uint32_t* result_ids, const size_t result_size,
+                               const size_t max_ids, std::vector<uint32_t>& top_ids) {
+    const impact_ids_t* impact_ids = leaf->values->impact_ids.get();
+    if(impact_ids == nullptr) {
+        return false;
+    }
+
+    top_ids.clear();
+
+    if(result_size == impact_ids->size()) {
+        // every id of the leaf is valid
+        impact_ids->for_each([&](uint32_t id) {
+            top_ids.push_back(id);
+            return top_ids.size() < max_ids;
+        });
+    } else {
+        impact_ids->for_each([&](uint32_t id) {
+            if(std::binary_search(result_ids, result_ids + result_size, id)) {
+                top_ids.push_back(id);
+            }
+            return top_ids.size() < max_ids;
+        });
+    }
+
+    std::sort(top_ids.begin(), top_ids.end());
+    return true;
+}
+
+int64_t Index::get_impact_points(const uint32_t seq_id) const {
+    const auto sort_column_it = sort_index.find(impact_sorting_field);
+    if(sort_column_it == sort_index.end() || !sort_column_it->second->contains(seq_id)) {
+        return INT64_MIN;
+    }
+
+    const int64_t value = sort_column_it->second->get(seq_id, INT64_MIN);
+
+    if(!sort_schema.at(impact_sorting_field).is_float()) {
+        return value;
+    }
+
+    // sort columns hold floats in the encoding of float_to_in64_t(), while art leaves use the one of
+    // get_points_from_doc()
+    int32_t i = int32_t(value);
+    if(i < 0) {
+        i ^= INT32_MAX;
+    }
+
+    float f;
+    memcpy(&f, &i, sizeof f);
+    return float_to_points(f);
+}
+
 const spp::sparse_hash_map<std::string, num_tree_t*>& Index::_get_numerical_index() const {
     return numerical_index;
 }
@@ -2483,6 +3630,10 @@ void Index::refresh_schemas(const std::vector<field>& new_fields) {
                 art_tree *t = new art_tree;
                 art_tree_init(t);
                 search_index.emplace(new_field.name, t);
+
+                if(new_field.typo_index) {
+                    typo_index.emplace(new_field.name, new typo_index_t);
+                }
             } else {
                 num_tree_t* num_tree = new num_tree_t;
                 numerical_index.emplace(new_field.name, num_tree);
@@ -2494,6 +3645,7 @@ void Index::refresh_schemas(const std::vector<field>& new_fields) {
 
             spp::sparse_hash_map<uint32_t, facet_hash_values_t> *doc_to_values = new spp::sparse_hash_map<uint32_t, facet_hash_values_t>();
             facet_index_v3.emplace(new_field.name, doc_to_values);
+            facet_dictionaries.emplace(new_field.name, new facet_dictionary_t(num_memory_shards));
 
             // initialize for non-string facet fields
             if(!new_field.is_string()) {
@@ -2504,8 +3656,7 @@ void Index::refresh_schemas(const std::vector<field>& new_fields) {
         }
 
         if(sort_index.count(new_field.name) == 0) {
-            spp::sparse_hash_map<uint32_t, int64_t> * doc_to_score = new spp::sparse_hash_map<uint32_t, int64_t>();
-            sort_index.emplace(new_field.name, doc_to_score);
+            sort_index.emplace(new_field.name, new sort_column_t(num_memory_shards));
         }
     }
 }
@@ -8,9 +8,12 @@
 #include <unordered_map>
 #include <queue>
 #include <ctime>
+#include <functional>
+#include <limits>
 #include "collection.h"
 #include "string_utils.h"
 #include "collection_manager.h"
+#include "array_utils.h"
 
 using namespace std;
 
@@ -21,7 +24,7 @@ std::string get_query(StringUtils & string_utils, std::string & text) {
 
     for(uint32_t i=0; i<tokens.size(); i++) {
         auto token = tokens[i];
-        string_utils.unicode_normalize(token);
+        StringUtils::tolowercase(token);
         normalized_tokens.push_back(token);
     }
 
@@ -167,6 +170,229 @@ void benchmark_reactjs_pages(char* file_path) {
     std::cout << "Results total: " << results_total << std::endl;
 }
 
+void benchmark_art_lookups(char* file_path) {
+    // file is expected to contain one token per line
+    std::ifstream infile(file_path);
+    std::vector<std::string> tokens;
+    std::string token;
+
+    art_tree t;
+    art_tree_init(&t);
+
+    while (std::getline(infile, token)) {
+        art_document document;
+        document.score = 0;
+        document.id = tokens.size();
+        document.offsets = new uint32_t[1]{0};
+        document.offsets_len = 1;
+
+        art_insert(&t, (const unsigned char *) token.c_str(), token.size() + 1, &document, 1);
+        delete [] document.offsets;
+        tokens.push_back(token);
+    }
+
+    infile.close();
+
+    std::shuffle(tokens.begin(), tokens.end(), std::mt19937(42));
+
+    const size_t num_rounds = 10;
+    const art_simd_level default_level = art_get_simd_level();
+
+    for(art_simd_level level: {ART_SIMD_SCALAR, ART_SIMD_SSE2}) {
+        art_set_simd_level(level);
+        size_t num_found = 0;  // to prevent no-op optimization!
+
+        auto begin = std::chrono::high_resolution_clock::now();
+
+        for(size_t round = 0; round < num_rounds; round++) {
+            for(const std::string& token: tokens) {
+                num_found += (art_search(&t, (const unsigned char *) token.c_str(), token.size() + 1) != nullptr);
+            }
+        }
+
+        long long int timeMicros = std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::high_resolution_clock::now() - begin).count();
+
+        std::cout << "Kernel: " << (level == ART_SIMD_SCALAR ? "scalar" : "sse2") << std::endl;
+        std::cout << "Lookups per second: " << (num_rounds * tokens.size() * 1000000.0 / timeMicros) << std::endl;
+        std::cout << "Tokens found: " << num_found << std::endl;
+    }
+
+    art_set_simd_level(default_level);
+    art_tree_destroy(&t);
+}
+
+void benchmark_array_intersection() {
+    std::mt19937 gen(42);
+
+    // posting lists of similar sizes, and a short list against a long one
+    const std::vector<std::pair<size_t, size_t>> sizes = {{100000, 100000}, {100000, 20000}, {100000, 1000}};
+    const size_t num_rounds = 100;
+    const ArrayUtils::simd_level_t default_level = ArrayUtils::get_simd_level();
+    const char* level_names[] = {"scalar", "sse4.1", "avx2"};
+
+    for(const auto& size: sizes) {
+        std::vector<uint32_t> a, b;
+        std::uniform_int_distribution<uint32_t> dist(0, 4 * size.first);
+
+        for(size_t i = 0; i < size.first; i++) {
+            a.push_back(dist(gen));
+        }
+
+        for(size_t i = 0; i < size.second; i++) {
+            b.push_back(dist(gen));
+        }
+
+        std::sort(a.begin(), a.end());
+        a.erase(std::unique(a.begin(), a.end()), a.end());
+        std::sort(b.begin(), b.end());
+        b.erase(std::unique(b.begin(), b.end()), b.end());
+
+        std::cout << "Sizes: " << a.size() << " x " << b.size() << std::endl;
+
+        for(ArrayUtils::simd_level_t level: {ArrayUtils::SCALAR, ArrayUtils::SSE41, ArrayUtils::AVX2}) {
+            ArrayUtils::set_simd_level(level);
+            size_t num_found = 0;  // to prevent no-op optimization!
+
+            auto begin = std::chrono::high_resolution_clock::now();
+
+            for(size_t round = 0; round < num_rounds; round++) {
+                uint32_t* out = nullptr;
+                num_found += ArrayUtils::and_values(a.data(), a.size(), b.data(), b.size(), &out);
+                delete [] out;
+            }
+
+            long long int timeMicros = std::chrono::duration_cast<std::chrono::microseconds>(
+                    std::chrono::high_resolution_clock::now() - begin).count();
+
+            std::cout << "Kernel: " << level_names[ArrayUtils::get_simd_level()] << ", time per intersection: "
+                      << (timeMicros / num_rounds) << "us, found: " << num_found << std::endl;
+        }
+
+        auto begin = std::chrono::high_resolution_clock::now();
+        size_t num_found = 0;
+
+        for(size_t round = 0; round < num_rounds; round++) {
+            uint32_t* out = nullptr;
+            num_found += ArrayUtils::and_scalar(a.data(), a.size(), b.data(), b.size(), &out);
+            delete [] out;
+        }
+
+        long long int timeMicros = std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::high_resolution_clock::now() - begin).count();
+
+        std::cout << "and_scalar, time per intersection: " << (timeMicros / num_rounds) << "us, found: "
+                  << num_found << std::endl;
+    }
+
+    ArrayUtils::set_simd_level(default_level);
+}
+
+void benchmark_facet_stats() {
+    std::mt19937 gen(42);
+
+    const size_t num_values = 1000000;
+    const size_t num_rounds = 20;
+    const ArrayUtils::simd_level_t default_level = ArrayUtils::get_simd_level();
+    const char* level_names[] = {"scalar", "sse4.1", "avx2"};
+
+    std::uniform_int_distribution<int32_t> int_dist(-1000000, 1000000);
+    std::uniform_real_distribution<float> float_dist(-1000.0f, 1000.0f);
+
+    std::vector<int32_t> int32_values(num_values);
+    std::vector<int64_t> int64_values(num_values);
+    std::vector<float> float_values(num_values);
+
+    for(size_t i = 0; i < num_values; i++) {
+        int32_values[i] = int_dist(gen);
+        int64_values[i] = int_dist(gen);
+        float_values[i] = float_dist(gen);
+    }
+
+    // the kernels are run over blocks of values, as facet stats are computed
+    const size_t block_size = Index::FACET_STATS_BLOCK_SIZE;
+
+    auto run_rounds = [&](const std::string& name, const std::function<double()>& round) {
+        double sum = 0;
+        auto begin = std::chrono::high_resolution_clock::now();
+
+        for(size_t r = 0; r < num_rounds; r++) {
+            sum += round();
+        }
+
+        long long int timeMicros = std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::high_resolution_clock::now() - begin).count();
+
+        std::cout << name << ", time per round: " << (timeMicros / num_rounds) << "us, sum: " << sum << std::endl;
+    };
+
+    std::cout << "Values: " << num_values << std::endl;
+
+    // one value at a time, as the stats used to be computed
+    run_rounds("Per value, int32", [&]() {
+        double min = std::numeric_limits<double>::max(), max = -std::numeric_limits<double>::max(), sum = 0;
+        for(int32_t value: int32_values) {
+            min = std::min<double>(min, value);
+            max = std::max<double>(max, value);
+            sum += value;
+        }
+        return sum + min + max;
+    });
+
+    run_rounds("Per value, float", [&]() {
+        double min = std::numeric_limits<double>::max(), max = -std::numeric_limits<double>::max(), sum = 0;
+        for(float value: float_values) {
+            min = std::min<double>(min, value);
+            max = std::max<double>(max, value);
+            sum += value;
+        }
+        return sum + min + max;
+    });
+
+    for(ArrayUtils::simd_level_t level: {ArrayUtils::SCALAR, ArrayUtils::SSE41, ArrayUtils::AVX2}) {
+        ArrayUtils::set_simd_level(level);
+        const std::string kernel = level_names[ArrayUtils::get_simd_level()];
+
+        run_rounds("Columnar, int32, kernel: " + kernel, [&]() {
+            double total = 0;
+            for(size_t offset = 0; offset < num_values; offset += block_size) {
+                int32_t min, max;
+                int64_t sum;
+                ArrayUtils::stats_int32(int32_values.data() + offset, std::min(block_size, num_values - offset),
+                                        min, max, sum);
+                total += sum;
+            }
+            return total;
+        });
+
+        run_rounds("Columnar, int64, kernel: " + kernel, [&]() {
+            double total = 0;
+            for(size_t offset = 0; offset < num_values; offset += block_size) {
+                int64_t min, max;
+                double sum;
+                ArrayUtils::stats_int64(int64_values.data() + offset, std::min(block_size, num_values - offset),
+                                        min, max, sum);
+                total += sum;
+            }
+            return total;
+        });
+
+        run_rounds("Columnar, float, kernel: " + kernel, [&]() {
+            double total = 0;
+            for(size_t offset = 0; offset < num_values; offset += block_size) {
+                float min, max;
+                double sum;
+                ArrayUtils::stats_float(float_values.data() + offset, std::min(block_size, num_values - offset),
+                                        min, max, sum);
+                total += sum;
+            }
+            return total;
+        });
+    }
+
+    ArrayUtils::set_simd_level(default_level);
+}
+
 void generate_word_freq() {
     std::ifstream infile("/tmp/unigram_freq.jsonl");
     std::ofstream outfile("/tmp/eng_words.jsonl", std::ios_base::app);
@@ -193,6 +419,9 @@ int main(int argc, char* argv[]) {
 
 //    benchmark_hn_titles(argv[1]);
 //    benchmark_reactjs_pages(argv[1]);
+//    benchmark_art_lookups(argv[1]);
+//    benchmark_array_intersection();
+//    benchmark_facet_stats();
 
     generate_word_freq();
 
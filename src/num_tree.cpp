@@ -1,32 +1,101 @@
 #include "num_tree.h"
+#include <limits>
 
-void num_tree_t::insert(int64_t value, uint32_t id) {
-    if (int64map.count(value) == 0) {
-        int64map.emplace(value, new sorted_array);
+size_t num_tree_t::page_of(int64_t value) const {
+    return std::lower_bound(page_max_values.begin(), page_max_values.end(), value) - page_max_values.begin();
+}
+
+void num_tree_t::load_page_ids(page_t* page) {
+    std::vector<uint32_t> ids;
+
+    for(const sorted_array* arr: page->value_ids) {
+        const size_t num_ids = ids.size();
+        ids.resize(num_ids + arr->getLength());
+        arr->uncompress(ids.data() + num_ids);
     }
 
-    if (!int64map[value]->contains(id)) {
-        int64map[value]->append(id);
+    std::sort(ids.begin(), ids.end());
+    ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+
+    page->ids.load(ids.data(), ids.size());
+}
+
+void num_tree_t::split_page(size_t page_index) {
+    page_t* lower = pages[page_index];
+    page_t* upper = new page_t;
+    const size_t half = lower->values.size() / 2;
+
+    upper->values.assign(lower->values.begin() + half, lower->values.end());
+    upper->value_ids.assign(lower->value_ids.begin() + half, lower->value_ids.end());
+    lower->values.resize(half);
+    lower->value_ids.resize(half);
+
+    load_page_ids(lower);
+    load_page_ids(upper);
+
+    pages.insert(pages.begin() + page_index + 1, upper);
+    page_max_values[page_index] = lower->values.back();
+    page_max_values.insert(page_max_values.begin() + page_index + 1, upper->values.back());
+}
+
+void num_tree_t::collect_range(int64_t start, int64_t end, std::vector<uint32_t>& ids) const {
+    for(size_t page_index = page_of(start); page_index < pages.size(); page_index++) {
+        const page_t* page = pages[page_index];
+
+        if(page->values.front() > end) {
+            break;
+        }
+
+        if(page->values.front() >= start && page->values.back() <= end) {
+            // whole page is within the range
+            const size_t num_ids = ids.size();
+            ids.resize(num_ids + page->ids.getLength());
+            page->ids.uncompress(ids.data() + num_ids);
+            continue;
+        }
+
+        auto value_it = std::lower_bound(page->values.begin(), page->values.end(), start);
+
+        while(value_it != page->values.end() && *value_it <= end) {
+            const sorted_array* arr = page->value_ids[value_it - page->values.begin()];
+            const size_t num_ids = ids.size();
+            ids.resize(num_ids + arr->getLength());
+            arr->uncompress(ids.data() + num_ids);
+            value_it++;
+        }
     }
 }
 
-void num_tree_t::range_inclusive_search(int64_t start, int64_t end, uint32_t** ids, size_t& ids_len) {
-    if(int64map.empty()) {
+void num_tree_t::merge_ids(std::vector<uint32_t>& consolidated_ids, uint32_t** ids, size_t& ids_len) {
+    if(consolidated_ids.empty()) {
         return ;
     }
 
-    auto it_start = int64map.lower_bound(start);  // iter values will be >= start
+    const auto min_max = std::minmax_element(consolidated_ids.begin(), consolidated_ids.end());
+    const uint32_t min_id = *min_max.first;
+    const uint64_t id_range = uint64_t(*min_max.second) - min_id + 1;
 
-    std::vector<uint32_t> consolidated_ids;
-    while(it_start != int64map.end() && it_start->first <= end) {
-        for(size_t i = 0; i < it_start->second->getLength(); i++) {
-            consolidated_ids.push_back(it_start->second->at(i));
+    if(id_range <= consolidated_ids.size() * 16) {
+        // dense ids (e.g. a wide range filter) are sorted and de-duplicated by marking them in a bit map
+        std::vector<uint64_t> id_bits((id_range + 63) / 64, 0);
+        for(uint32_t id: consolidated_ids) {
+            id_bits[(id - min_id) >> 6] |= (uint64_t(1) << ((id - min_id) & 63));
         }
 
-        it_start++;
-    }
+        consolidated_ids.clear();
 
-    std::sort(consolidated_ids.begin(), consolidated_ids.end());
+        for(size_t word_index = 0; word_index < id_bits.size(); word_index++) {
+            uint64_t word = id_bits[word_index];
+            while(word != 0) {
+                consolidated_ids.push_back(min_id + word_index * 64 + __builtin_ctzll(word));
+                word &= (word - 1);
+            }
+        }
+    } else {
+        std::sort(consolidated_ids.begin(), consolidated_ids.end());
+        consolidated_ids.erase(std::unique(consolidated_ids.begin(), consolidated_ids.end()),
+                               consolidated_ids.end());
+    }
 
     uint32_t *out = nullptr;
     ids_len = ArrayUtils::or_scalar(&consolidated_ids[0], consolidated_ids.size(),
@@ -36,112 +105,187 @@ void num_tree_t::range_inclusive_search(int64_t start, int64_t end, uint32_t** i
     *ids = out;
 }
 
-size_t num_tree_t::get(int64_t value, std::vector<uint32_t>& geo_result_ids) {
-    const auto& it = int64map.find(value);
-    if(it == int64map.end()) {
-        return 0;
+void num_tree_t::insert(int64_t value, uint32_t id) {
+    if(pages.empty()) {
+        pages.push_back(new page_t);
+        page_max_values.push_back(value);
     }
 
-    uint32_t* ids = it->second->uncompress();
-    for(size_t i = 0; i < it->second->getLength(); i++) {
-        geo_result_ids.push_back(ids[i]);
+    // values larger than every other value go to the last page
+    const size_t page_index = std::min(page_of(value), pages.size() - 1);
+    page_t* page = pages[page_index];
+
+    auto value_it = std::lower_bound(page->values.begin(), page->values.end(), value);
+    const size_t value_index = value_it - page->values.begin();
+
+    if(value_it == page->values.end() || *value_it != value) {
+        page->values.insert(value_it, value);
+        page->value_ids.insert(page->value_ids.begin() + value_index, new sorted_array);
+        page_max_values[page_index] = page->values.back();
+        num_values++;
     }
 
-    delete [] ids;
+    sorted_array* arr = page->value_ids[value_index];
+
+    if(!arr->contains(id)) {
+        arr->append(id);
+
+        if(!page->ids.contains(id)) {
+            page->ids.append(id);
+        }
+    }
 
-    return it->second->getLength();
+    if(page->values.size() > MAX_PAGE_VALUES) {
+        split_page(page_index);
+    }
 }
 
-void num_tree_t::search(NUM_COMPARATOR comparator, int64_t value, uint32_t** ids, size_t& ids_len) {
-    if(int64map.empty()) {
-        return ;
+void num_tree_t::range_inclusive_search(int64_t start, int64_t end, uint32_t** ids, size_t& ids_len) {
+    std::vector<uint32_t> consolidated_ids;
+    collect_range(start, end, consolidated_ids);
+    merge_ids(consolidated_ids, ids, ids_len);
+}
+
+size_t num_tree_t::get(int64_t value, std::vector<uint32_t>& geo_result_ids) {
+    const size_t page_index = page_of(value);
+    if(page_index == pages.size()) {
+        return 0;
+    }
+
+    const page_t* page = pages[page_index];
+    const auto value_it = std::lower_bound(page->values.begin(), page->values.end(), value);
+    if(value_it == page->values.end() || *value_it != value) {
+        return 0;
     }
 
+    const sorted_array* arr = page->value_ids[value_it - page->values.begin()];
+    const size_t num_ids = geo_result_ids.size();
+    geo_result_ids.resize(num_ids + arr->getLength());
+    arr->uncompress(geo_result_ids.data() + num_ids);
+
+    return arr->getLength();
+}
+
+bool num_tree_t::get_range(NUM_COMPARATOR comparator, int64_t value, int64_t& start, int64_t& end) {
     if(comparator == EQUALS) {
-        const auto& it = int64map.find(value);
-        if(it != int64map.end()) {
-            uint32_t *out = nullptr;
-            uint32_t* val_ids = it->second->uncompress();
-            ids_len = ArrayUtils::or_scalar(val_ids, it->second->getLength(),
-                                            *ids, ids_len, &out);
-            delete[] *ids;
-            *ids = out;
-            delete[] val_ids;
-        }
+        start = end = value;
     } else if(comparator == GREATER_THAN || comparator == GREATER_THAN_EQUALS) {
-        // iter entries will be >= value, or end() if all entries are before value
-        auto iter_ge_value = int64map.lower_bound(value);
-
-        if(iter_ge_value == int64map.end()) {
-            return ;
+        if(comparator == GREATER_THAN && value == std::numeric_limits<int64_t>::max()) {
+            return false;
         }
 
-        if(comparator == GREATER_THAN && iter_ge_value->first == value) {
-            iter_ge_value++;
+        start = (comparator == GREATER_THAN) ? value + 1 : value;
+        end = std::numeric_limits<int64_t>::max();
+    } else if(comparator == LESS_THAN || comparator == LESS_THAN_EQUALS) {
+        if(comparator == LESS_THAN && value == std::numeric_limits<int64_t>::min()) {
+            return false;
         }
 
-        std::vector<uint32_t> consolidated_ids;
-        while(iter_ge_value != int64map.end()) {
-            for(size_t i = 0; i < iter_ge_value->second->getLength(); i++) {
-                consolidated_ids.push_back(iter_ge_value->second->at(i));
-            }
-            iter_ge_value++;
-        }
+        start = std::numeric_limits<int64_t>::min();
+        end = (comparator == LESS_THAN) ? value - 1 : value;
+    } else {
+        return false;
+    }
 
-        std::sort(consolidated_ids.begin(), consolidated_ids.end());
-        consolidated_ids.erase(unique(consolidated_ids.begin(), consolidated_ids.end()), consolidated_ids.end());
+    return true;
+}
 
-        uint32_t *out = nullptr;
-        ids_len = ArrayUtils::or_scalar(&consolidated_ids[0], consolidated_ids.size(),
-                                        *ids, ids_len, &out);
+void num_tree_t::search(NUM_COMPARATOR comparator, int64_t value, uint32_t** ids, size_t& ids_len) {
+    int64_t start, end;
+    if(!get_range(comparator, value, start, end)) {
+        return ;
+    }
 
-        delete [] *ids;
-        *ids = out;
+    std::vector<uint32_t> consolidated_ids;
+    collect_range(start, end, consolidated_ids);
+    merge_ids(consolidated_ids, ids, ids_len);
+}
 
-    } else if(comparator == LESS_THAN || comparator == LESS_THAN_EQUALS) {
-        // iter entries will be >= value, or end() if all entries are before value
-        auto iter_ge_value = int64map.lower_bound(value);
+size_t num_tree_t::count_range(int64_t start, int64_t end) const {
+    size_t count = 0;
 
-        std::vector<uint32_t> consolidated_ids;
-        auto it = int64map.begin();
+    for(size_t page_index = page_of(start); page_index < pages.size(); page_index++) {
+        const page_t* page = pages[page_index];
 
-        while(it != iter_ge_value) {
-            for(size_t i = 0; i < it->second->getLength(); i++) {
-                consolidated_ids.push_back(it->second->at(i));
-            }
-            it++;
+        if(page->values.front() > end) {
+            break;
         }
 
-        // for LESS_THAN_EQUALS, check if last iter entry is equal to value
-        if(it != int64map.end() && comparator == LESS_THAN_EQUALS && it->first == value) {
-            for(size_t i = 0; i < it->second->getLength(); i++) {
-                consolidated_ids.push_back(it->second->at(i));
-            }
+        if(page->values.front() >= start && page->values.back() <= end) {
+            count += page->ids.getLength();
+            continue;
         }
 
-        std::sort(consolidated_ids.begin(), consolidated_ids.end());
-        consolidated_ids.erase(unique(consolidated_ids.begin(), consolidated_ids.end()), consolidated_ids.end());
+        auto value_it = std::lower_bound(page->values.begin(), page->values.end(), start);
 
-        uint32_t *out = nullptr;
-        ids_len = ArrayUtils::or_scalar(&consolidated_ids[0], consolidated_ids.size(),
-                                        *ids, ids_len, &out);
-
-        delete [] *ids;
-        *ids = out;
+        while(value_it != page->values.end() && *value_it <= end) {
+            count += page->value_ids[value_it - page->values.begin()]->getLength();
+            value_it++;
+        }
     }
+
+    return count;
+}
+
+size_t num_tree_t::estimate_range(int64_t start, int64_t end) const {
+    return count_range(start, end);
 }
 
 void num_tree_t::remove(uint64_t value, uint32_t id) {
-    if(int64map.count(value) != 0) {
-        sorted_array* arr = int64map[value];
-        arr->remove_value(id);
-        if(arr->getLength() == 0) {
-            delete arr;
-            int64map.erase(value);
+    const size_t page_index = page_of(value);
+    if(page_index == pages.size()) {
+        return ;
+    }
+
+    page_t* page = pages[page_index];
+    const auto value_it = std::lower_bound(page->values.begin(), page->values.end(), int64_t(value));
+    if(value_it == page->values.end() || *value_it != int64_t(value)) {
+        return ;
+    }
+
+    const size_t value_index = value_it - page->values.begin();
+    sorted_array* arr = page->value_ids[value_index];
+    const uint32_t arr_len = arr->getLength();
+
+    arr->remove_value(id);
+
+    if(arr->getLength() == arr_len) {
+        return ;
+    }
+
+    if(arr->getLength() == 0) {
+        delete arr;
+        page->values.erase(page->values.begin() + value_index);
+        page->value_ids.erase(page->value_ids.begin() + value_index);
+        num_values--;
+    }
+
+    // the document could still hold another value of the same page (e.g. in an array field)
+    bool id_in_page = false;
+    for(sorted_array* value_ids: page->value_ids) {
+        if(value_ids->contains(id)) {
+            id_in_page = true;
+            break;
         }
     }
+
+    if(!id_in_page) {
+        page->ids.remove_value(id);
+    }
+
+    if(page->values.empty()) {
+        delete page;
+        pages.erase(pages.begin() + page_index);
+        page_max_values.erase(page_max_values.begin() + page_index);
+    } else {
+        page_max_values[page_index] = page->values.back();
+    }
 }
 
 size_t num_tree_t::size() {
-    return int64map.size();
-}
\ No newline at end of file
+    return num_values;
+}
+
+size_t num_tree_t::num_pages() const {
+    return pages.size();
+}
@@ -0,0 +1,153 @@
+#include "request_scheduler.h"
+#include <chrono>
+
+schedule_slot_t::~schedule_slot_t() {
+    scheduler->release(schedule_class);
+}
+
+RequestScheduler::RequestScheduler(ThreadPool* thread_pool,
+                                   const std::array<schedule_limits_t, NUM_SCHEDULE_CLASSES>& limits):
+                                   thread_pool(thread_pool) {
+    for(size_t i = 0; i < NUM_SCHEDULE_CLASSES; i++) {
+        states[i].limits = limits[i];
+    }
+}
+
+uint64_t RequestScheduler::now_us() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+bool RequestScheduler::submit(schedule_class_t schedule_class, std::function<void()> task) {
+    return submit_with_slot(schedule_class, [task = std::move(task)](std::unique_ptr<schedule_slot_t>&) {
+        task();
+    });
+}
+
+bool RequestScheduler::submit_with_slot(schedule_class_t schedule_class, slot_task_t task) {
+    {
+        std::unique_lock lock(mutex);
+        class_state_t& state = states[schedule_class];
+
+        if(state.num_running >= state.limits.max_concurrency) {
+            if(state.queue.size() >= state.limits.max_queue_depth) {
+                state.num_rejected++;
+                return false;
+            }
+
+            state.queue.push_back(queued_task_t{std::move(task), now_us()});
+            return true;
+        }
+
+        state.num_running++;
+        state.num_started++;
+    }
+
+    dispatch(schedule_class, std::move(task));
+    return true;
+}
+
+void RequestScheduler::dispatch(schedule_class_t schedule_class, slot_task_t&& task) {
+    const ThreadPool::priority_t priority = (schedule_class == INTERACTIVE) ? ThreadPool::HIGH : ThreadPool::NORMAL;
+
+    thread_pool->enqueue_with_priority(priority, [this, schedule_class, task = std::move(task)]() {
+        // the slot hands the class over to its next queued task once it is freed
+        auto slot = std::make_unique<schedule_slot_t>(this, schedule_class);
+        task(slot);
+    });
+}
+
+void RequestScheduler::on_task_done(schedule_class_t schedule_class) {
+    slot_task_t next_task;
+
+    {
+        std::unique_lock lock(mutex);
+        class_state_t& state = states[schedule_class];
+        state.num_running--;
+
+        if(state.queue.empty() || state.num_running >= state.limits.max_concurrency) {
+            return ;
+        }
+
+        queued_task_t& queued_task = state.queue.front();
+        state.total_wait_us += (now_us() - queued_task.enqueued_us);
+        next_task = std::move(queued_task.task);
+        state.queue.pop_front();
+
+        state.num_running++;
+        state.num_started++;
+    }
+
+    dispatch(schedule_class, std::move(next_task));
+}
+
+std::unique_ptr<schedule_slot_t> RequestScheduler::acquire(schedule_class_t schedule_class) {
+    std::unique_lock lock(mutex);
+    class_state_t& state = states[schedule_class];
+
+    // the holders of slots wait elsewhere, so the queue depth cap applies to the number of them beyond the
+    // concurrency limit
+    if(state.num_running >= state.limits.max_concurrency + state.limits.max_queue_depth) {
+        state.num_rejected++;
+        return nullptr;
+    }
+
+    state.num_running++;
+    state.num_started++;
+
+    return std::make_unique<schedule_slot_t>(this, schedule_class);
+}
+
+void RequestScheduler::release(schedule_class_t schedule_class) {
+    on_task_done(schedule_class);
+}
+
+size_t RequestScheduler::get_num_running(schedule_class_t schedule_class) const {
+    std::unique_lock lock(mutex);
+    return states[schedule_class].num_running;
+}
+
+size_t RequestScheduler::get_queue_depth(schedule_class_t schedule_class) const {
+    std::unique_lock lock(mutex);
+    return states[schedule_class].queue.size();
+}
+
+void RequestScheduler::get_metrics(nlohmann::json& result) const {
+    std::unique_lock lock(mutex);
+
+    for(size_t i = 0; i < NUM_SCHEDULE_CLASSES; i++) {
+        const class_state_t& state = states[i];
+        const std::string prefix = "typesense_scheduler_" + get_schedule_class_name(schedule_class_t(i)) + "_";
+
+        const double avg_wait_ms = (state.num_started == 0) ? 0 :
+                                   (double(state.total_wait_us) / state.num_started) / 1000;
+
+        result[prefix + "queue_depth"] = std::to_string(state.queue.size());
+        result[prefix + "running"] = std::to_string(state.num_running);
+        result[prefix + "rejected"] = std::to_string(state.num_rejected);
+        result[prefix + "avg_wait_ms"] = std::to_string(avg_wait_ms);
+    }
+}
+
+schedule_class_t RequestScheduler::get_schedule_class(const std::vector<std::string>& path_parts, bool is_write) {
+    const std::string& root_resource = path_parts.empty() ? "" : path_parts[0];
+
+    if(root_resource == "operations" || (!path_parts.empty() && path_parts.back() == "export")) {
+        return BACKGROUND;
+    }
+
+    return is_write ? BULK_WRITE : INTERACTIVE;
+}
+
+std::string RequestScheduler::get_schedule_class_name(schedule_class_t schedule_class) {
+    switch(schedule_class) {
+        case INTERACTIVE:
+            return "interactive";
+        case BULK_WRITE:
+            return "bulk_write";
+        case BACKGROUND:
+            return "background";
+    }
+
+    return "";
+}
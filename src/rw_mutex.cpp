@@ -0,0 +1,60 @@
+#include "rw_mutex.h"
+
+void rw_mutex_t::lock() {
+    std::unique_lock<std::mutex> lock(mutex);
+    num_waiting_writers++;
+
+    writers_cv.wait(lock, [this]() {
+        return !writer && num_readers == 0 && num_admitted_readers == 0;
+    });
+
+    num_waiting_writers--;
+    writer = true;
+}
+
+void rw_mutex_t::unlock() {
+    bool admit_readers;
+
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        writer = false;
+        num_admitted_readers = num_waiting_readers;
+        admit_readers = (num_admitted_readers != 0);
+    }
+
+    if(admit_readers) {
+        readers_cv.notify_all();
+    } else {
+        writers_cv.notify_one();
+    }
+}
+
+void rw_mutex_t::lock_shared() {
+    std::unique_lock<std::mutex> lock(mutex);
+    num_waiting_readers++;
+
+    readers_cv.wait(lock, [this]() {
+        return !writer && (num_waiting_writers == 0 || num_admitted_readers != 0);
+    });
+
+    num_waiting_readers--;
+    num_readers++;
+
+    if(num_admitted_readers != 0) {
+        num_admitted_readers--;
+    }
+}
+
+void rw_mutex_t::unlock_shared() {
+    bool notify_writer;
+
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        num_readers--;
+        notify_writer = (num_readers == 0 && num_admitted_readers == 0 && num_waiting_writers != 0);
+    }
+
+    if(notify_writer) {
+        writers_cv.notify_one();
+    }
+}
@@ -0,0 +1,146 @@
+#include "search_cache.h"
+#include <chrono>
+
+// per entry bookkeeping: the list node, the map node and the two copies of the key
+static constexpr size_t ENTRY_OVERHEAD_BYTES = sizeof(void*) * 8;
+
+// a node of the map that backs a JSON object: the tree links and the colour, followed by the key and the value
+static constexpr size_t OBJECT_NODE_BYTES = sizeof(void*) * 4 + sizeof(std::string) + sizeof(nlohmann::json);
+
+SearchCache::SearchCache(): max_bytes(0), num_bytes(0), ttl_ms(0), num_hits(0), num_misses(0) {
+
+}
+
+uint64_t SearchCache::now_ms() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void SearchCache::evict_until_within_limit() {
+    while(num_bytes > max_bytes) {
+        num_bytes -= entries.back().num_bytes;
+        entry_map.erase(entries.back().key);
+        entries.pop_back();
+    }
+}
+
+void SearchCache::set_limits(size_t max_bytes, uint64_t ttl_ms) {
+    std::unique_lock lock(mutex);
+    this->max_bytes = max_bytes;
+    this->ttl_ms = ttl_ms;
+    evict_until_within_limit();
+}
+
+bool SearchCache::is_enabled() const {
+    std::unique_lock lock(mutex);
+    return max_bytes != 0;
+}
+
+bool SearchCache::get(const std::string& key, uint64_t generation, nlohmann::json& value) {
+    std::unique_lock lock(mutex);
+
+    auto entry_it = entry_map.find(key);
+    if(entry_it == entry_map.end()) {
+        num_misses++;
+        return false;
+    }
+
+    auto list_it = entry_it->second;
+
+    if(list_it->generation != generation || now_ms() - list_it->inserted_ms >= ttl_ms) {
+        // the collection has since been written to, or the entry has expired
+        num_bytes -= list_it->num_bytes;
+        entries.erase(list_it);
+        entry_map.erase(entry_it);
+        num_misses++;
+        return false;
+    }
+
+    entries.splice(entries.begin(), entries, list_it);
+    value = list_it->value;
+    num_hits++;
+    return true;
+}
+
+void SearchCache::insert(const std::string& key, uint64_t generation, const nlohmann::json& value) {
+    const size_t entry_num_bytes = ENTRY_OVERHEAD_BYTES + key.size() * 2 + get_num_bytes(value);
+
+    std::unique_lock lock(mutex);
+
+    if(entry_num_bytes > max_bytes) {
+        return ;
+    }
+
+    auto entry_it = entry_map.find(key);
+    if(entry_it != entry_map.end()) {
+        num_bytes -= entry_it->second->num_bytes;
+        entries.erase(entry_it->second);
+        entry_map.erase(entry_it);
+    }
+
+    entries.push_front(entry_t{key, generation, now_ms(), value, entry_num_bytes});
+    entry_map.emplace(key, entries.begin());
+    num_bytes += entry_num_bytes;
+
+    evict_until_within_limit();
+}
+
+void SearchCache::clear() {
+    std::unique_lock lock(mutex);
+    entries.clear();
+    entry_map.clear();
+    num_bytes = 0;
+}
+
+size_t SearchCache::size() const {
+    std::unique_lock lock(mutex);
+    return entries.size();
+}
+
+size_t SearchCache::size_bytes() const {
+    std::unique_lock lock(mutex);
+    return num_bytes;
+}
+
+void SearchCache::get_metrics(nlohmann::json& result) const {
+    result["typesense_search_cache_hits"] = std::to_string(num_hits.load());
+    result["typesense_search_cache_misses"] = std::to_string(num_misses.load());
+    result["typesense_search_cache_entries"] = std::to_string(size());
+    result["typesense_search_cache_bytes"] = std::to_string(size_bytes());
+}
+
+std::string SearchCache::get_key(uint32_t collection_id, const std::map<std::string, std::string>& params) {
+    std::string key = std::to_string(collection_id);
+
+    for(const auto& kv: params) {
+        key += ":" + std::to_string(kv.first.size()) + ":" + kv.first;
+        key += ":" + std::to_string(kv.second.size()) + ":" + kv.second;
+    }
+
+    return key;
+}
+
+size_t SearchCache::get_num_bytes(const nlohmann::json& value) {
+    size_t value_num_bytes = sizeof(nlohmann::json);
+
+    // strings, arrays and objects are held through a pointer, and the values nested in them are counted in place
+    if(value.is_string()) {
+        value_num_bytes += sizeof(std::string) + value.get_ref<const std::string&>().capacity();
+    } else if(value.is_array()) {
+        const auto& elements = value.get_ref<const nlohmann::json::array_t&>();
+        value_num_bytes += sizeof(nlohmann::json::array_t) + elements.capacity() * sizeof(nlohmann::json);
+
+        for(const auto& element: elements) {
+            value_num_bytes += get_num_bytes(element) - sizeof(nlohmann::json);
+        }
+    } else if(value.is_object()) {
+        value_num_bytes += sizeof(nlohmann::json::object_t);
+
+        for(const auto& kv: value.get_ref<const nlohmann::json::object_t&>()) {
+            value_num_bytes += OBJECT_NODE_BYTES + kv.first.capacity() + get_num_bytes(kv.second) -
+                               sizeof(nlohmann::json);
+        }
+    }
+
+    return value_num_bytes;
+}
@@ -0,0 +1,33 @@
+#include "sort_column.h"
+
+void sort_column_t::set(uint32_t seq_id, int64_t value) {
+    const uint32_t slot = seq_id / stride;
+    const size_t word = slot >> 6;
+
+    if(word >= present.size()) {
+        present.resize(word + 1, 0);
+        values.resize(present.size() * 64, 0);
+    }
+
+    const uint64_t bit = uint64_t(1) << (slot & 63);
+    num_values += ((present[word] & bit) == 0);
+    present[word] |= bit;
+    values[slot] = value;
+}
+
+void sort_column_t::erase(uint32_t seq_id) {
+    const uint32_t slot = seq_id / stride;
+    const size_t word = slot >> 6;
+
+    if(word >= present.size()) {
+        return ;
+    }
+
+    const uint64_t bit = uint64_t(1) << (slot & 63);
+    num_values -= ((present[word] & bit) != 0);
+    present[word] &= ~bit;
+}
+
+size_t sort_column_t::size() const {
+    return num_values;
+}
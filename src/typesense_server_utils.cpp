@@ -17,6 +17,7 @@
 #include "typesense_server_utils.h"
 #include "file_utils.h"
 #include "threadpool.h"
+#include "request_scheduler.h"
 #include "jemalloc.h"
 
 #include "stackprinter.h"
@@ -88,6 +89,17 @@ void init_cmdline_options(cmdline::parser & options, int argc, char **argv) {
 
     options.add<uint32_t>("thread-pool-size", '\0', "Number of threads used for handling concurrent requests.", false, 4);
 
+    options.add<uint32_t>("interactive-concurrency", '\0', "Number of searches and other reads that are processed concurrently.", false, 0);
+    options.add<uint32_t>("interactive-queue-depth", '\0', "Number of reads that can wait for processing, beyond which reads are rejected.", false, 1000);
+    options.add<uint32_t>("bulk-write-concurrency", '\0', "Number of writes and imports that are processed concurrently.", false, 0);
+    options.add<uint32_t>("bulk-write-queue-depth", '\0', "Number of writes that can wait for processing, beyond which writes are rejected.", false, 1000);
+    options.add<uint32_t>("background-concurrency", '\0', "Number of exports and operations that are processed concurrently.", false, 0);
+    options.add<uint32_t>("background-queue-depth", '\0', "Number of exports and operations that can wait for processing, beyond which they are rejected.", false, 100);
+
+    options.add<uint32_t>("cache-size-mb", '\0', "Memory in MB that cached search results can take up, 0 (the default) disables the cache.", false, 0);
+    options.add<uint32_t>("cache-ttl-seconds", '\0', "Duration for which a cached search result is served.", false, 60);
+    options.add<uint32_t>("filter-cache-size-mb", '\0', "Memory in MB that the cached filter results of each collection can take up, 0 disables the cache.", false, 16);
+
     options.add<std::string>("log-dir", '\0', "Path to the log directory.", false, "");
 
     options.add<std::string>("config", '\0', "Path to the configuration file.", false, "");
@@ -359,6 +371,19 @@ int run_server(const Config & config, const std::string & version, void (*master
     ThreadPool app_thread_pool(num_threads);
     ThreadPool server_thread_pool(num_threads);
 
+    const size_t interactive_concurrency = config.get_interactive_concurrency() == 0 ?
+                                           num_threads : config.get_interactive_concurrency();
+    const size_t bulk_write_concurrency = config.get_bulk_write_concurrency() == 0 ?
+                                          num_threads : config.get_bulk_write_concurrency();
+    const size_t background_concurrency = config.get_background_concurrency() == 0 ?
+                                          std::max<size_t>(1, num_threads / 8) : config.get_background_concurrency();
+
+    RequestScheduler request_scheduler(&server_thread_pool, {
+        schedule_limits_t{interactive_concurrency, config.get_interactive_queue_depth()},
+        schedule_limits_t{bulk_write_concurrency, config.get_bulk_write_queue_depth()},
+        schedule_limits_t{background_concurrency, config.get_background_queue_depth()},
+    });
+
     // primary DB used for storing the documents: we will not use WAL since Raft provides that
     Store store(db_dir);
 
@@ -367,6 +392,9 @@ int run_server(const Config & config, const std::string & version, void (*master
 
     CollectionManager & collectionManager = CollectionManager::get_instance();
     collectionManager.init(&store, &app_thread_pool, config.get_max_memory_ratio(), config.get_api_key());
+    collectionManager.get_search_cache().set_limits(config.get_cache_size_mb() * 1024 * 1024,
+                                                    config.get_cache_ttl_seconds() * 1000);
+    collectionManager.set_filter_cache_max_bytes(config.get_filter_cache_size_mb() * 1024 * 1024);
 
     curl_global_init(CURL_GLOBAL_SSL);
     HttpClient & httpClient = HttpClient::get_instance();
@@ -384,6 +412,7 @@ int run_server(const Config & config, const std::string & version, void (*master
     );
 
     server->set_auth_handler(handle_authentication);
+    server->set_request_scheduler(&request_scheduler);
 
     server->on(HttpServer::STREAM_RESPONSE_MESSAGE, HttpServer::on_stream_response_message);
     server->on(HttpServer::REQUEST_PROCEED_MESSAGE, HttpServer::on_request_proceed_message);
@@ -0,0 +1,190 @@
+#include "typo_index.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <string>
+#include "string_utils.h"
+
+void typo_index_t::get_variants(const unsigned char* token, size_t token_len, int max_deletes,
+                                std::vector<uint64_t>& variant_hashes) {
+    std::vector<std::string> variants = {std::string((const char*) token, token_len)};
+    size_t level_start = 0;
+
+    for(int deletes = 1; deletes <= max_deletes; deletes++) {
+        const size_t level_end = variants.size();
+
+        for(size_t i = level_start; i < level_end; i++) {
+            for(size_t pos = 0; pos < variants[i].size(); pos++) {
+                std::string variant = variants[i];
+                variant.erase(pos, 1);
+                variants.push_back(std::move(variant));
+            }
+        }
+
+        level_start = level_end;
+    }
+
+    variant_hashes.clear();
+
+    for(const std::string& variant: variants) {
+        variant_hashes.push_back(StringUtils::hash_wy(variant.data(), variant.size()));
+    }
+
+    std::sort(variant_hashes.begin(), variant_hashes.end());
+    variant_hashes.erase(std::unique(variant_hashes.begin(), variant_hashes.end()), variant_hashes.end());
+}
+
+// Optimal string alignment distance, the measure art_fuzzy_search() computes: bails out once `max_cost` is exceeded
+static int bounded_osa_distance(const unsigned char* a, const int a_len, const unsigned char* b, const int b_len,
+                                const int max_cost) {
+    if(std::abs(a_len - b_len) > max_cost) {
+        return max_cost + 1;
+    }
+
+    std::vector<int> irow(b_len + 1), jrow(b_len + 1), krow(b_len + 1);
+
+    for(int col = 0; col <= b_len; col++) {
+        jrow[col] = col;
+    }
+
+    for(int row = 1; row <= a_len; row++) {
+        krow[0] = row;
+        int row_min = krow[0];
+
+        for(int col = 1; col <= b_len; col++) {
+            const int cost = (a[row-1] == b[col-1]) ? 0 : 1;
+            krow[col] = std::min(std::min(krow[col-1] + 1, jrow[col] + 1), jrow[col-1] + cost);
+
+            if(row > 1 && col > 1 && a[row-1] == b[col-2] && a[row-2] == b[col-1]) {
+                krow[col] = std::min(krow[col], irow[col-2] + 1);
+            }
+
+            row_min = std::min(row_min, krow[col]);
+        }
+
+        if(row_min > max_cost) {
+            return max_cost + 1;
+        }
+
+        std::swap(irow, jrow);
+        std::swap(jrow, krow);
+    }
+
+    return jrow[b_len];
+}
+
+void typo_index_t::insert(art_leaf* leaf) {
+    const size_t token_len = leaf->key_len - 1;
+    if(token_len > MAX_TOKEN_LEN) {
+        return ;
+    }
+
+    std::vector<uint64_t> variant_hashes;
+    get_variants(leaf->key, token_len, MAX_COST, variant_hashes);
+
+    for(uint64_t variant_hash: variant_hashes) {
+        variant_leaves[variant_hash].push_back(leaf);
+    }
+
+    num_postings += variant_hashes.size();
+}
+
+void typo_index_t::remove(const art_leaf* leaf) {
+    const size_t token_len = leaf->key_len - 1;
+    if(token_len > MAX_TOKEN_LEN) {
+        return ;
+    }
+
+    std::vector<uint64_t> variant_hashes;
+    get_variants(leaf->key, token_len, MAX_COST, variant_hashes);
+
+    for(uint64_t variant_hash: variant_hashes) {
+        const auto it = variant_leaves.find(variant_hash);
+        if(it == variant_leaves.end()) {
+            continue;
+        }
+
+        std::vector<art_leaf*>& leaves = it->second;
+        const auto leaf_it = std::find(leaves.begin(), leaves.end(), leaf);
+
+        if(leaf_it != leaves.end()) {
+            leaves.erase(leaf_it);
+            num_postings--;
+        }
+
+        if(leaves.empty()) {
+            variant_leaves.erase(it);
+        }
+    }
+}
+
+bool typo_index_t::can_search(int term_len, int max_cost) const {
+    // every token within `max_cost` of the term must have been short enough to be indexed
+    return max_cost >= 0 && max_cost <= MAX_COST && term_len >= 0 && size_t(term_len + max_cost) <= MAX_TOKEN_LEN;
+}
+
+bool typo_index_t::search(const unsigned char* term, int term_len, int min_cost, int max_cost, size_t max_words,
+                          token_ordering token_order, const uint32_t* filter_ids, size_t filter_ids_length,
+                          std::vector<art_leaf*>& results) const {
+    if(!can_search(term_len, max_cost)) {
+        return false;
+    }
+
+    std::vector<uint64_t> variant_hashes;
+    get_variants(term, term_len, max_cost, variant_hashes);
+
+    std::vector<art_leaf*> candidates;
+
+    for(uint64_t variant_hash: variant_hashes) {
+        const auto it = variant_leaves.find(variant_hash);
+        if(it != variant_leaves.end()) {
+            candidates.insert(candidates.end(), it->second.begin(), it->second.end());
+        }
+    }
+
+    std::sort(candidates.begin(), candidates.end());
+    candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+
+    std::vector<art_leaf*> leaves;
+
+    for(art_leaf* leaf: candidates) {
+        // hash collisions and variants shared by distant tokens are weeded out here
+        const int cost = bounded_osa_distance(term, term_len, leaf->key, leaf->key_len - 1, max_cost);
+        if(cost < min_cost || cost > max_cost) {
+            continue;
+        }
+
+        if(filter_ids_length != 0 && leaf->values->ids.numFoundOf(filter_ids, filter_ids_length) == 0) {
+            continue;
+        }
+
+        leaves.push_back(leaf);
+    }
+
+    // art_fuzzy_search() walks the tree in descending order of keys and keeps the first `max_words` matches
+    if(leaves.size() > max_words) {
+        std::partial_sort(leaves.begin(), leaves.begin() + max_words, leaves.end(),
+                          [](const art_leaf* a, const art_leaf* b) {
+            return compare_art_leaf_key(b, a);
+        });
+        leaves.resize(max_words);
+    }
+
+    if(token_order == FREQUENCY) {
+        std::sort(leaves.begin(), leaves.end(), compare_art_leaf_frequency);
+    } else {
+        std::sort(leaves.begin(), leaves.end(), compare_art_leaf_score);
+    }
+
+    results.insert(results.end(), leaves.begin(), leaves.end());
+    return true;
+}
+
+size_t typo_index_t::size() const {
+    return variant_leaves.size();
+}
+
+uint64_t typo_index_t::memory_bytes() const {
+    return variant_leaves.size() * (sizeof(uint64_t) + sizeof(std::vector<art_leaf*>)) +
+           num_postings * sizeof(art_leaf*);
+}
@@ -1,4 +1,7 @@
 #include <gtest/gtest.h>
+#include <algorithm>
+#include <numeric>
+#include <random>
 #include "array_utils.h"
 #include "logger.h"
 
@@ -172,4 +175,156 @@ TEST(SortedArrayTest, FilterArray) {
     delete[] arr2;
     delete[] arr1;
     delete[] results;
-}
\ No newline at end of file
+}
+static std::vector<uint32_t> random_sorted_ids(std::mt19937& gen, size_t len, uint32_t max_id) {
+    std::vector<uint32_t> ids;
+    std::uniform_int_distribution<uint32_t> dist(0, max_id);
+
+    for(size_t i = 0; i < len; i++) {
+        ids.push_back(dist(gen));
+    }
+
+    std::sort(ids.begin(), ids.end());
+    ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+    return ids;
+}
+
+TEST(SortedArrayTest, SimdKernelsMatchScalar) {
+    std::mt19937 gen(137723);
+    const ArrayUtils::simd_level_t default_level = ArrayUtils::get_simd_level();
+
+    // equal sizes, skewed sizes (galloping) and lengths that leave tails behind the SIMD blocks
+    const std::vector<std::pair<size_t, size_t>> sizes = {
+        {0, 10}, {1, 1}, {3, 5}, {7, 9}, {33, 47}, {100, 100}, {1000, 1200}, {10, 5000}, {5000, 10}, {257, 31}
+    };
+
+    for(ArrayUtils::simd_level_t level: {ArrayUtils::SCALAR, ArrayUtils::SSE41, ArrayUtils::AVX2}) {
+        ArrayUtils::set_simd_level(level);
+
+        for(const auto& size: sizes) {
+            for(uint32_t max_id: {uint32_t(size.first + size.second), uint32_t(20 * (size.first + size.second))}) {
+                const std::vector<uint32_t> a = random_sorted_ids(gen, size.first, max_id);
+                const std::vector<uint32_t> b = random_sorted_ids(gen, size.second, max_id);
+
+                uint32_t* expected = nullptr;
+                uint32_t* actual = nullptr;
+                size_t expected_len = ArrayUtils::and_scalar(a.data(), a.size(), b.data(), b.size(), &expected);
+                size_t actual_len = ArrayUtils::and_values(a.data(), a.size(), b.data(), b.size(), &actual);
+
+                ASSERT_EQ(expected_len, actual_len);
+                for(size_t i = 0; i < expected_len; i++) {
+                    ASSERT_EQ(expected[i], actual[i]);
+                }
+
+                delete [] expected;
+                delete [] actual;
+                expected = actual = nullptr;
+
+                expected_len = ArrayUtils::exclude_scalar(a.data(), a.size(), b.data(), b.size(), &expected);
+                actual_len = ArrayUtils::exclude_values(a.data(), a.size(), b.data(), b.size(), &actual);
+
+                ASSERT_EQ(expected_len, actual_len);
+                for(size_t i = 0; i < expected_len; i++) {
+                    ASSERT_EQ(expected[i], actual[i]);
+                }
+
+                delete [] expected;
+                delete [] actual;
+            }
+        }
+    }
+
+    ArrayUtils::set_simd_level(default_level);
+}
+
+TEST(SortedArrayTest, AndMany) {
+    std::mt19937 gen(42);
+    const std::vector<uint32_t> a = random_sorted_ids(gen, 2000, 4000);
+    const std::vector<uint32_t> b = random_sorted_ids(gen, 300, 4000);
+    const std::vector<uint32_t> c = random_sorted_ids(gen, 3000, 4000);
+    const std::vector<uint32_t> d = random_sorted_ids(gen, 40, 4000);
+
+    const uint32_t* lists[] = {a.data(), b.data(), c.data(), d.data()};
+    const size_t lens[] = {a.size(), b.size(), c.size(), d.size()};
+
+    for(size_t num_lists = 1; num_lists <= 4; num_lists++) {
+        std::vector<uint32_t> expected = a;
+        for(size_t k = 1; k < num_lists; k++) {
+            std::vector<uint32_t> intersection;
+            std::set_intersection(expected.begin(), expected.end(), lists[k], lists[k] + lens[k],
+                                  std::back_inserter(intersection));
+            expected = intersection;
+        }
+
+        uint32_t* results = nullptr;
+        size_t results_size = ArrayUtils::and_many(lists, lens, num_lists, &results);
+
+        ASSERT_EQ(expected.size(), results_size);
+        for(size_t i = 0; i < results_size; i++) {
+            ASSERT_EQ(expected[i], results[i]);
+        }
+
+        delete [] results;
+    }
+
+    // an empty list empties the intersection
+    const size_t empty_lens[] = {a.size(), 0, c.size()};
+    uint32_t* results = nullptr;
+    ASSERT_EQ(0, ArrayUtils::and_many(lists, empty_lens, 3, &results));
+    ASSERT_EQ(nullptr, results);
+}
+
+TEST(SortedArrayTest, StatsKernelsMatchScalar) {
+    std::mt19937 gen(2417);
+    const ArrayUtils::simd_level_t default_level = ArrayUtils::get_simd_level();
+
+    std::uniform_int_distribution<int32_t> int32_dist(std::numeric_limits<int32_t>::min(),
+                                                      std::numeric_limits<int32_t>::max());
+    // small enough for all partial sums to be exact as doubles
+    std::uniform_int_distribution<int64_t> int64_dist(-(int64_t(1) << 40), int64_t(1) << 40);
+    std::uniform_real_distribution<float> float_dist(-1000.0f, 1000.0f);
+
+    // lengths that leave tails behind the SIMD blocks, or that have no full block at all
+    for(size_t len: {1, 3, 4, 7, 8, 9, 31, 100, 1001}) {
+        std::vector<int32_t> int32_values(len);
+        std::vector<int64_t> int64_values(len);
+        std::vector<float> float_values(len);
+
+        for(size_t i = 0; i < len; i++) {
+            int32_values[i] = int32_dist(gen);
+            int64_values[i] = int64_dist(gen);
+            float_values[i] = float_dist(gen);
+        }
+
+        const int64_t int32_sum = std::accumulate(int32_values.begin(), int32_values.end(), int64_t(0));
+
+        for(ArrayUtils::simd_level_t level: {ArrayUtils::SCALAR, ArrayUtils::SSE41, ArrayUtils::AVX2}) {
+            ArrayUtils::set_simd_level(level);
+
+            int32_t int32_min, int32_max;
+            int64_t sum;
+            ArrayUtils::stats_int32(int32_values.data(), len, int32_min, int32_max, sum);
+
+            ASSERT_EQ(*std::min_element(int32_values.begin(), int32_values.end()), int32_min);
+            ASSERT_EQ(*std::max_element(int32_values.begin(), int32_values.end()), int32_max);
+            ASSERT_EQ(int32_sum, sum);
+
+            int64_t int64_min, int64_max;
+            double double_sum;
+            ArrayUtils::stats_int64(int64_values.data(), len, int64_min, int64_max, double_sum);
+
+            ASSERT_EQ(*std::min_element(int64_values.begin(), int64_values.end()), int64_min);
+            ASSERT_EQ(*std::max_element(int64_values.begin(), int64_values.end()), int64_max);
+            ASSERT_EQ(std::accumulate(int64_values.begin(), int64_values.end(), 0.0), double_sum);
+
+            float float_min, float_max;
+            ArrayUtils::stats_float(float_values.data(), len, float_min, float_max, double_sum);
+
+            ASSERT_EQ(*std::min_element(float_values.begin(), float_values.end()), float_min);
+            ASSERT_EQ(*std::max_element(float_values.begin(), float_values.end()), float_max);
+            ASSERT_NEAR(std::accumulate(float_values.begin(), float_values.end(), 0.0), double_sum, 0.01);
+        }
+    }
+
+    ArrayUtils::set_simd_level(default_level);
+}
@@ -211,6 +211,101 @@ TEST(ArtTest, test_art_insert_delete) {
     ASSERT_TRUE(res == 0);
 }
 
+TEST(ArtTest, test_art_arena_reuses_freed_blocks) {
+    art_tree t;
+    int res = art_tree_init(&t);
+    ASSERT_TRUE(res == 0);
+    ASSERT_EQ(0, art_arena_bytes(&t));
+
+    std::vector<std::string> keys;
+    for(size_t i = 0; i < 5000; i++) {
+        keys.push_back("token" + std::to_string(i * 7919));
+    }
+
+    // a leaf that is too large for the slabs
+    keys.push_back(std::string(4000, 'x'));
+
+    for(size_t i = 0; i < keys.size(); i++) {
+        art_document doc = get_document(i);
+        ASSERT_TRUE(NULL == art_insert(&t, (unsigned char*)keys[i].c_str(), keys[i].size()+1, &doc, 1));
+        delete [] doc.offsets;
+    }
+
+    const uint64_t arena_bytes = art_arena_bytes(&t);
+    ASSERT_GT(arena_bytes, 5000 * sizeof(art_leaf));
+
+    for(size_t i = 0; i < keys.size(); i++) {
+        art_values* values = (art_values*) art_delete(&t, (unsigned char*)keys[i].c_str(), keys[i].size()+1);
+        ASSERT_EQ(i, values->ids.at(0));
+        delete values;
+    }
+
+    ASSERT_EQ(0, art_size(&t));
+    ASSERT_LT(art_arena_bytes(&t), arena_bytes);
+
+    // freed nodes and leaves must be recycled instead of growing the arena
+    for(size_t i = 0; i < keys.size(); i++) {
+        art_document doc = get_document(i);
+        ASSERT_TRUE(NULL == art_insert(&t, (unsigned char*)keys[i].c_str(), keys[i].size()+1, &doc, 1));
+        delete [] doc.offsets;
+    }
+
+    ASSERT_EQ(arena_bytes, art_arena_bytes(&t));
+
+    for(size_t i = 0; i < keys.size(); i++) {
+        art_leaf* l = (art_leaf *) art_search(&t, (unsigned char*)keys[i].c_str(), keys[i].size()+1);
+        ASSERT_TRUE(l != NULL);
+        ASSERT_EQ(i, l->values->ids.at(0));
+    }
+
+    res = art_tree_destroy(&t);
+    ASSERT_TRUE(res == 0);
+    ASSERT_EQ(0, art_arena_bytes(&t));
+}
+
+TEST(ArtTest, test_art_simd_and_scalar_lookups_match) {
+    art_tree t;
+    int res = art_tree_init(&t);
+    ASSERT_TRUE(res == 0);
+
+    // shared prefixes of varying lengths produce all node types and long partial prefixes
+    std::vector<std::string> keys;
+    for(size_t i = 0; i < 3000; i++) {
+        keys.push_back("prefix" + std::to_string(i % 7) + "common" + std::to_string(i * 37));
+        keys.push_back(std::to_string(i % 300) + "x");
+    }
+
+    for(size_t i = 0; i < keys.size(); i++) {
+        art_document doc = get_document(i);
+        art_insert(&t, (unsigned char*)keys[i].c_str(), keys[i].size()+1, &doc, 1);
+        delete [] doc.offsets;
+    }
+
+    std::vector<std::string> queries = keys;
+    for(size_t i = 0; i < 500; i++) {
+        queries.push_back("prefix" + std::to_string(i % 7) + "commo");
+        queries.push_back("prefix" + std::to_string(i % 7) + "common" + std::to_string(i * 37 + 1));
+        queries.push_back(std::to_string(i % 300) + "y");
+    }
+
+    const art_simd_level default_level = art_get_simd_level();
+
+    for(const std::string& query: queries) {
+        art_set_simd_level(ART_SIMD_SCALAR);
+        art_leaf* scalar_leaf = (art_leaf *) art_search(&t, (unsigned char*)query.c_str(), query.size()+1);
+
+        art_set_simd_level(ART_SIMD_SSE2);
+        art_leaf* simd_leaf = (art_leaf *) art_search(&t, (unsigned char*)query.c_str(), query.size()+1);
+
+        ASSERT_EQ(scalar_leaf, simd_leaf);
+    }
+
+    art_set_simd_level(default_level);
+
+    res = art_tree_destroy(&t);
+    ASSERT_TRUE(res == 0);
+}
+
 int iter_cb(void *data, const unsigned char* key, uint32_t key_len, void *val) {
     uint64_t *out = (uint64_t*)data;
     uintptr_t line = ((art_values*)val)->ids.at(0);
@@ -725,6 +820,60 @@ TEST(ArtTest, test_art_fuzzy_search) {
     ASSERT_TRUE(res == 0);
 }
 
+TEST(ArtTest, test_art_fuzzy_search_engines_match) {
+    art_tree t;
+    int res = art_tree_init(&t);
+    ASSERT_TRUE(res == 0);
+
+    int len;
+    char buf[512];
+    FILE *f = fopen(words_file_path, "r");
+    std::vector<std::string> words;
+
+    uintptr_t line = 1;
+    while (fgets(buf, sizeof buf, f)) {
+        len = strlen(buf);
+        buf[len-1] = '\0';
+        art_document doc = get_document((uint32_t) line);
+        art_insert(&t, (unsigned char*)buf, len, &doc, 1);
+        if(line % 499 == 0) {
+            words.push_back(buf);
+        }
+        line++;
+    }
+
+    fclose(f);
+
+    for(size_t i = 0; i < words.size(); i++) {
+        // exercise substitution, deletion, insertion and transposition typos in various positions
+        std::string term = words[i];
+        const size_t pos = i % std::max<size_t>(term.size(), 1);
+        switch(i % 4) {
+            case 0: term[pos] = 'e'; break;
+            case 1: term.erase(pos, 1); break;
+            case 2: term.insert(pos, 1, 'a'); break;
+            case 3: if(pos + 1 < term.size()) std::swap(term[pos], term[pos+1]); break;
+        }
+
+        for(int max_cost = 0; max_cost <= 2; max_cost++) {
+            for(bool prefix: {false, true}) {
+                const int term_len = prefix ? term.size() : term.size() + 1;
+                std::vector<art_leaf*> row_leaves, dfa_leaves;
+
+                art_fuzzy_search(&t, (const unsigned char *) term.c_str(), term_len, 0, max_cost, 10, MAX_SCORE,
+                                 prefix, nullptr, 0, row_leaves, LEVENSHTEIN_ROWS);
+                art_fuzzy_search(&t, (const unsigned char *) term.c_str(), term_len, 0, max_cost, 10, MAX_SCORE,
+                                 prefix, nullptr, 0, dfa_leaves, LEVENSHTEIN_AUTOMATON);
+
+                ASSERT_EQ(row_leaves, dfa_leaves) << term << ", max_cost: " << max_cost << ", prefix: " << prefix;
+            }
+        }
+    }
+
+    res = art_tree_destroy(&t);
+    ASSERT_TRUE(res == 0);
+}
+
 TEST(ArtTest, test_art_fuzzy_search_unicode_chars) {
     art_tree t;
     int res = art_tree_init(&t);
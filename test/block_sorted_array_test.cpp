@@ -0,0 +1,169 @@
+#include <gtest/gtest.h>
+#include "block_sorted_array.h"
+#include <algorithm>
+#include <random>
+#include <vector>
+
+static void assert_same_contents(block_sorted_array& arr, const std::vector<uint32_t>& expected) {
+    ASSERT_EQ(expected.size(), arr.getLength());
+
+    uint32_t* ids = arr.uncompress();
+    for(size_t i = 0; i < expected.size(); i++) {
+        ASSERT_EQ(expected[i], ids[i]);
+        ASSERT_EQ(expected[i], arr.at(i));
+    }
+
+    delete [] ids;
+}
+
+TEST(BlockSortedArrayTest, Append) {
+    block_sorted_array arr;
+    const int SIZE = 10 * 1000;
+
+    EXPECT_EQ(arr.getLength(), 0);
+    EXPECT_EQ(arr.indexOf(100), 0);  // when not found must be equal to length (0 in this case)
+    EXPECT_FALSE(arr.contains(100));
+
+    for(uint32_t i=0; i < SIZE; i++) {
+        size_t appended_index = arr.append(i);
+        ASSERT_EQ(i, appended_index);
+    }
+
+    EXPECT_EQ(arr.getLength(), SIZE);
+    EXPECT_EQ((SIZE + block_sorted_array::BLOCK_SIZE - 1) / block_sorted_array::BLOCK_SIZE, arr.num_blocks());
+
+    for(uint32_t i=0; i < SIZE; i++) {
+        EXPECT_EQ(arr.at(i), i);
+        EXPECT_EQ(arr.indexOf(i), i);
+        EXPECT_EQ(arr.contains(i), true);
+    }
+
+    EXPECT_EQ(arr.contains(SIZE), false);
+    EXPECT_EQ(arr.indexOf(SIZE), SIZE);
+    EXPECT_EQ(arr.indexOf(SIZE+1), SIZE);
+}
+
+TEST(BlockSortedArrayTest, AppendOutOfOrderSplitsBlocks) {
+    block_sorted_array arr;
+    std::vector<uint32_t> expected;
+
+    for(uint32_t i = 0; i < 2000; i++) {
+        arr.append(i * 2);
+        expected.push_back(i * 2);
+    }
+
+    // fill the gaps in the first blocks so that they overflow and get split
+    for(uint32_t i = 0; i < 600; i++) {
+        const uint32_t value = i * 2 + 1;
+        const auto pos = std::lower_bound(expected.begin(), expected.end(), value) - expected.begin();
+        expected.insert(expected.begin() + pos, value);
+        ASSERT_EQ(pos, arr.append(value));
+    }
+
+    assert_same_contents(arr, expected);
+    ASSERT_GT(arr.num_blocks(), (expected.size() + block_sorted_array::BLOCK_SIZE - 1) / block_sorted_array::BLOCK_SIZE);
+
+    for(size_t i = 0; i < expected.size(); i++) {
+        ASSERT_EQ(i, arr.indexOf(expected[i]));
+    }
+}
+
+TEST(BlockSortedArrayTest, InsertAtIndex) {
+    block_sorted_array arr;
+    std::vector<uint32_t> expected;
+
+    for(uint32_t i = 0; i < 1000; i++) {
+        arr.append(i * 10);
+        expected.push_back(i * 10);
+    }
+
+    ASSERT_FALSE(arr.insert(1000, 20000));
+
+    for(uint32_t i = 0; i < 300; i++) {
+        const size_t index = (i * 7) % expected.size();
+        const uint32_t value = expected[index] - 1;
+        ASSERT_TRUE(arr.insert(index, value));
+        expected.insert(expected.begin() + index, value);
+    }
+
+    assert_same_contents(arr, expected);
+}
+
+TEST(BlockSortedArrayTest, LoadAndRemove) {
+    std::vector<uint32_t> expected;
+    for(uint32_t i = 0; i < 5000; i++) {
+        expected.push_back(i * 3);
+    }
+
+    block_sorted_array arr;
+    arr.load(&expected[0], expected.size());
+    assert_same_contents(arr, expected);
+
+    // removing a missing value is a no-op
+    arr.remove_value(1);
+    assert_same_contents(arr, expected);
+
+    std::vector<uint32_t> to_remove;
+    for(size_t i = 0; i < expected.size(); i++) {
+        // drops whole blocks, so that sparse neighbours get merged
+        if(i < 1000 || i % 3 == 0) {
+            to_remove.push_back(expected[i]);
+        }
+    }
+
+    arr.remove_value(to_remove[0]);
+    arr.remove_values(&to_remove[1], to_remove.size() - 1);
+
+    std::vector<uint32_t> remaining;
+    std::set_difference(expected.begin(), expected.end(), to_remove.begin(), to_remove.end(),
+                        std::back_inserter(remaining));
+
+    assert_same_contents(arr, remaining);
+
+    for(uint32_t value: to_remove) {
+        ASSERT_FALSE(arr.contains(value));
+        ASSERT_EQ(remaining.size(), arr.indexOf(value));
+    }
+
+    arr.remove_values(&remaining[0], remaining.size());
+    ASSERT_EQ(0, arr.getLength());
+    ASSERT_EQ(0, arr.num_blocks());
+}
+
+TEST(BlockSortedArrayTest, BulkIndexOfAndNumFoundOf) {
+    std::mt19937 rng(1234);
+    std::vector<uint32_t> expected;
+
+    block_sorted_array arr;
+
+    for(uint32_t i = 0; i < 3000; i++) {
+        const uint32_t value = rng() % 20000;
+        arr.append(value);
+        expected.insert(std::upper_bound(expected.begin(), expected.end(), value), value);
+    }
+
+    expected.erase(std::unique(expected.begin(), expected.end()), expected.end());
+    arr.load(&expected[0], expected.size());
+
+    std::vector<uint32_t> search_ids;
+    for(uint32_t value = 0; value < 21000; value += 7) {
+        search_ids.push_back(value);
+    }
+
+    std::vector<uint32_t> indices(search_ids.size());
+    arr.indexOf(&search_ids[0], search_ids.size(), &indices[0]);
+
+    size_t expected_found = 0;
+
+    for(size_t i = 0; i < search_ids.size(); i++) {
+        const auto it = std::lower_bound(expected.begin(), expected.end(), search_ids[i]);
+        if(it != expected.end() && *it == search_ids[i]) {
+            ASSERT_EQ(it - expected.begin(), indices[i]);
+            expected_found++;
+        } else {
+            ASSERT_EQ(expected.size(), indices[i]);
+        }
+    }
+
+    ASSERT_EQ(expected_found, arr.numFoundOf(&search_ids[0], search_ids.size()));
+}
@@ -3,6 +3,8 @@
 #include <vector>
 #include <fstream>
 #include <algorithm>
+#include <atomic>
+#include <thread>
 #include <collection_manager.h>
 #include "collection.h"
 
@@ -642,3 +644,482 @@ TEST_F(CollectionFacetingTest, FacetCountOnSimilarStrings) {
 
     collectionManager.drop_collection("coll1");
 }
+
+TEST_F(CollectionFacetingTest, ResultsOfManyShardsMergeLikeThoseOfOne) {
+    std::vector<field> fields = {field("title", field_types::STRING, false),
+                                 field("color", field_types::STRING, true),
+                                 field("sizes", field_types::STRING_ARRAY, true),
+                                 field("points", field_types::INT32, true)};
+
+    std::vector<sort_by> sort_fields = {sort_by("points", "DESC")};
+
+    Collection* coll_one_shard = collectionManager.create_collection("coll_one_shard", 1, fields, "points").get();
+    Collection* coll_many_shards = collectionManager.create_collection("coll_many_shards", 7, fields, "points").get();
+
+    const std::vector<std::string> colors = {"red", "blue", "green", "black", "white"};
+    const std::vector<std::string> sizes = {"small", "medium", "large"};
+
+    for(size_t i = 0; i < 300; i++) {
+        nlohmann::json doc;
+        doc["id"] = std::to_string(i);
+        doc["title"] = (i % 3 == 0) ? "Cotton Shirt" : "Linen Shirt";
+        doc["color"] = colors[i % colors.size()];
+        doc["sizes"] = {sizes[i % sizes.size()], sizes[(i / 7) % sizes.size()]};
+        doc["points"] = int32_t(i % 40);
+
+        ASSERT_TRUE(coll_one_shard->add(doc.dump()).ok());
+        ASSERT_TRUE(coll_many_shards->add(doc.dump()).ok());
+    }
+
+    auto facet_counts = [](const nlohmann::json& results) {
+        std::map<std::string, std::map<std::string, size_t>> counts;
+        for(const auto& facet_count: results["facet_counts"]) {
+            for(const auto& count: facet_count["counts"]) {
+                counts[facet_count["field_name"]][count["value"]] = count["count"];
+            }
+        }
+        return counts;
+    };
+
+    auto hit_ids = [](const nlohmann::json& results, const std::string& hits_key) {
+        std::vector<std::string> ids;
+        for(const auto& hit: results[hits_key]) {
+            if(hits_key == "hits") {
+                ids.push_back(hit["document"]["id"]);
+            } else {
+                ids.push_back(hit["hits"][0]["document"]["id"]);
+            }
+        }
+        return ids;
+    };
+
+    const std::vector<std::string> facet_fields = {"color", "sizes", "points"};
+
+    for(const std::string& query: {"shirt", "cotton", "*"}) {
+        auto one_results = coll_one_shard->search(query, {"title"}, "", facet_fields, sort_fields, 0, 50, 2,
+                                                  FREQUENCY, false).get();
+        auto many_results = coll_many_shards->search(query, {"title"}, "", facet_fields, sort_fields, 0, 50, 2,
+                                                     FREQUENCY, false).get();
+
+        ASSERT_EQ(one_results["found"], many_results["found"]);
+        ASSERT_EQ(hit_ids(one_results, "hits"), hit_ids(many_results, "hits"));
+        ASSERT_EQ(facet_counts(one_results), facet_counts(many_results));
+        ASSERT_EQ(one_results["facet_counts"][2]["stats"], many_results["facet_counts"][2]["stats"]);
+    }
+
+    // grouped results and facets
+    auto one_results = coll_one_shard->search("shirt", {"title"}, "", facet_fields, sort_fields, 0, 10, 1,
+                                              FREQUENCY, false, Index::DROP_TOKENS_THRESHOLD,
+                                              spp::sparse_hash_set<std::string>(),
+                                              spp::sparse_hash_set<std::string>(), 10, "", 30, 4, "", 40, {}, {},
+                                              {"color"}, 2).get();
+    auto many_results = coll_many_shards->search("shirt", {"title"}, "", facet_fields, sort_fields, 0, 10, 1,
+                                                 FREQUENCY, false, Index::DROP_TOKENS_THRESHOLD,
+                                                 spp::sparse_hash_set<std::string>(),
+                                                 spp::sparse_hash_set<std::string>(), 10, "", 30, 4, "", 40, {}, {},
+                                                 {"color"}, 2).get();
+
+    ASSERT_EQ(5, many_results["found"].get<size_t>());
+    ASSERT_EQ(one_results["found"], many_results["found"]);
+    ASSERT_EQ(hit_ids(one_results, "grouped_hits"), hit_ids(many_results, "grouped_hits"));
+    ASSERT_EQ(facet_counts(one_results), facet_counts(many_results));
+
+    collectionManager.drop_collection("coll_one_shard");
+    collectionManager.drop_collection("coll_many_shards");
+}
+
+TEST_F(CollectionFacetingTest, FacetValuesAreLabelledFromTheDictionary) {
+    std::vector<field> fields = {field("title", field_types::STRING, false),
+                                 field("brand", field_types::STRING, true),
+                                 field("tags", field_types::STRING_ARRAY, true),
+                                 field("rating", field_types::FLOAT, true),
+                                 field("in_stock", field_types::BOOL, true),
+                                 field("points", field_types::INT32, false)};
+
+    Collection* coll1 = collectionManager.create_collection("coll1", 1, fields, "points").get();
+
+    nlohmann::json doc;
+    doc["id"] = "0";
+    doc["title"] = "Running Shoe";
+    doc["brand"] = "Nike Air";
+    doc["tags"] = {"sports wear", "shoes"};
+    doc["rating"] = 4.5;
+    doc["in_stock"] = true;
+    doc["points"] = 10;
+    ASSERT_TRUE(coll1->add(doc.dump()).ok());
+
+    doc["id"] = "1";
+    doc["brand"] = "Adidas";
+    doc["tags"] = {"shoes"};
+    doc["in_stock"] = false;
+    ASSERT_TRUE(coll1->add(doc.dump()).ok());
+
+    const Index* index = coll1->_get_indexes()[0];
+    ASSERT_EQ(2, index->get_facet_dictionary_size("brand"));
+    ASSERT_EQ(2, index->get_facet_dictionary_size("tags"));
+    ASSERT_EQ(1, index->get_facet_dictionary_size("rating"));
+    ASSERT_EQ(0, index->get_facet_dictionary_size("title"));
+
+    auto results = coll1->search("*", {}, "", {"brand", "tags", "rating", "in_stock"}, {}, 0, 10, 1,
+                                 FREQUENCY, false).get();
+
+    auto facet_values = [&results](size_t facet_index) {
+        std::set<std::string> values;
+        for(const auto& count: results["facet_counts"][facet_index]["counts"]) {
+            values.insert(count["value"].get<std::string>());
+        }
+        return values;
+    };
+
+    ASSERT_EQ(std::set<std::string>({"Nike Air", "Adidas"}), facet_values(0));
+
+    ASSERT_EQ("shoes", results["facet_counts"][1]["counts"][0]["value"].get<std::string>());
+    ASSERT_EQ(2, results["facet_counts"][1]["counts"][0]["count"].get<size_t>());
+    ASSERT_EQ("sports wear", results["facet_counts"][1]["counts"][1]["value"].get<std::string>());
+
+    ASSERT_EQ("4.5", results["facet_counts"][2]["counts"][0]["value"].get<std::string>());
+    ASSERT_EQ(std::set<std::string>({"true", "false"}), facet_values(3));
+
+    // values are dropped once no document holds them anymore
+    ASSERT_TRUE(coll1->remove("0").ok());
+    ASSERT_EQ(1, index->get_facet_dictionary_size("brand"));
+    ASSERT_EQ(1, index->get_facet_dictionary_size("tags"));
+    ASSERT_EQ(1, index->get_facet_dictionary_size("rating"));
+
+    ASSERT_TRUE(coll1->remove("1").ok());
+    ASSERT_EQ(0, index->get_facet_dictionary_size("brand"));
+    ASSERT_EQ(0, index->get_facet_dictionary_size("rating"));
+
+    collectionManager.drop_collection("coll1");
+}
+
+TEST_F(CollectionFacetingTest, FacetValuesAreLabelledWithASpellingThatADocumentHolds) {
+    std::vector<field> fields = {field("brand", field_types::STRING, true),
+                                 field("points", field_types::INT32, false)};
+
+    Collection* coll1 = collectionManager.create_collection("coll1", 1, fields, "points").get();
+
+    // all of the spellings are counted as the same value
+    std::vector<std::string> brands = {"Apple", "apple", "APPLE!"};
+
+    for(size_t i = 0; i < brands.size(); i++) {
+        nlohmann::json doc;
+        doc["id"] = std::to_string(i);
+        doc["brand"] = brands[i];
+        doc["points"] = int32_t(i);
+        ASSERT_TRUE(coll1->add(doc.dump()).ok());
+    }
+
+    auto search = [&]() {
+        return coll1->search("*", {}, "", {"brand"}, {}, 0, 10, 1, FREQUENCY, false).get();
+    };
+
+    auto results = search();
+    ASSERT_EQ(1, results["facet_counts"][0]["counts"].size());
+    ASSERT_EQ(3, results["facet_counts"][0]["counts"][0]["count"].get<size_t>());
+    ASSERT_EQ("Apple", results["facet_counts"][0]["counts"][0]["value"].get<std::string>());
+
+    // the first spelling is no longer held by any document
+    ASSERT_TRUE(coll1->remove("0").ok());
+
+    results = search();
+    ASSERT_EQ(2, results["facet_counts"][0]["counts"][0]["count"].get<size_t>());
+    ASSERT_EQ("apple", results["facet_counts"][0]["counts"][0]["value"].get<std::string>());
+
+    ASSERT_TRUE(coll1->remove("1").ok());
+
+    results = search();
+    ASSERT_EQ(1, results["facet_counts"][0]["counts"][0]["count"].get<size_t>());
+    ASSERT_EQ("APPLE!", results["facet_counts"][0]["counts"][0]["value"].get<std::string>());
+
+    collectionManager.drop_collection("coll1");
+}
+
+TEST_F(CollectionFacetingTest, OrdinalCountsMatchTheCountsOfTheDocuments) {
+    std::vector<field> fields = {field("title", field_types::STRING, false),
+                                 field("brand", field_types::STRING, true),
+                                 field("tags", field_types::STRING_ARRAY, true),
+                                 field("in_stock", field_types::BOOL, true),
+                                 field("points", field_types::INT32, false)};
+
+    Collection* coll1 = collectionManager.create_collection("coll1", 4, fields, "points").get();
+
+    for(size_t i = 0; i < 300; i++) {
+        nlohmann::json doc;
+        doc["id"] = std::to_string(i);
+        doc["title"] = "Title " + std::to_string(i);
+        doc["brand"] = "brand " + std::to_string(i % 7);
+        doc["tags"] = {"tag" + std::to_string(i % 5), "tag" + std::to_string(i % 3)};
+        doc["in_stock"] = (i % 2 == 0);
+        doc["points"] = i;
+        ASSERT_TRUE(coll1->add(doc.dump()).ok());
+    }
+
+    auto get_counts = [](const nlohmann::json& facet_counts) {
+        std::map<std::string, size_t> counts;
+        for(const auto& count: facet_counts["counts"]) {
+            counts[count["value"].get<std::string>()] = count["count"].get<size_t>();
+        }
+        return counts;
+    };
+
+    auto assert_counts = [&](const std::vector<size_t>& doc_ids) {
+        std::map<std::string, size_t> brand_counts, tag_counts, in_stock_counts;
+        for(size_t i: doc_ids) {
+            brand_counts["brand " + std::to_string(i % 7)]++;
+            tag_counts["tag" + std::to_string(i % 5)]++;
+            tag_counts["tag" + std::to_string(i % 3)]++;
+            in_stock_counts[(i % 2 == 0) ? "true" : "false"]++;
+        }
+
+        auto results = coll1->search("*", {}, "", {"brand", "tags", "in_stock"}, {}, 0, 10, 1,
+                                     FREQUENCY, false, Index::DROP_TOKENS_THRESHOLD,
+                                     spp::sparse_hash_set<std::string>(),
+                                     spp::sparse_hash_set<std::string>(), 20).get();
+
+        ASSERT_EQ(doc_ids.size(), results["found"].get<size_t>());
+        ASSERT_EQ(brand_counts, get_counts(results["facet_counts"][0]));
+        ASSERT_EQ(tag_counts, get_counts(results["facet_counts"][1]));
+        ASSERT_EQ(in_stock_counts, get_counts(results["facet_counts"][2]));
+
+        // same count as when the values are matched against a facet query
+        results = coll1->search("*", {}, "", {"tags"}, {}, 0, 10, 1, FREQUENCY, false,
+                                Index::DROP_TOKENS_THRESHOLD, spp::sparse_hash_set<std::string>(),
+                                spp::sparse_hash_set<std::string>(), 20, "tags: tag2").get();
+
+        ASSERT_EQ(tag_counts["tag2"], get_counts(results["facet_counts"][0])["tag2"]);
+    };
+
+    std::vector<size_t> doc_ids;
+    for(size_t i = 0; i < 300; i++) {
+        doc_ids.push_back(i);
+    }
+
+    assert_counts(doc_ids);
+
+    // removed documents are no longer counted
+    std::vector<size_t> remaining_doc_ids;
+    for(size_t i: doc_ids) {
+        if(i % 3 == 0 || i % 7 == 3) {
+            ASSERT_TRUE(coll1->remove(std::to_string(i)).ok());
+        } else {
+            remaining_doc_ids.push_back(i);
+        }
+    }
+
+    assert_counts(remaining_doc_ids);
+
+    collectionManager.drop_collection("coll1");
+}
+
+TEST_F(CollectionFacetingTest, FacetsOfManyResultsAreCountedOverASample) {
+    std::vector<field> fields = {field("title", field_types::STRING, false),
+                                 field("brand", field_types::STRING, true),
+                                 field("rating", field_types::INT32, true),
+                                 field("points", field_types::INT32, false)};
+
+    Collection* coll1 = collectionManager.create_collection("coll1", 2, fields, "points").get();
+
+    for(size_t i = 0; i < 4000; i++) {
+        nlohmann::json doc;
+        doc["id"] = std::to_string(i);
+        doc["title"] = "Title " + std::to_string(i);
+        doc["brand"] = (i % 4 == 0) ? "rare" : "common";
+        doc["rating"] = int32_t(i % 10);
+        doc["points"] = int32_t(i);
+        ASSERT_TRUE(coll1->add(doc.dump()).ok());
+    }
+
+    auto search = [&](size_t facet_sample_percent, size_t facet_sample_threshold) {
+        return coll1->search("*", {}, "", {"brand", "rating"}, {}, 0, 10, 1, FREQUENCY, false,
+                             Index::DROP_TOKENS_THRESHOLD, spp::sparse_hash_set<std::string>(),
+                             spp::sparse_hash_set<std::string>(), 10, "", 30, 4, "", 40, {}, {}, {}, 0,
+                             "<mark>", "</mark>", {}, UINT32_MAX, false,
+                             facet_sample_percent, facet_sample_threshold);
+    };
+
+    auto get_counts = [](const nlohmann::json& facet_counts) {
+        std::map<std::string, size_t> counts;
+        for(const auto& count: facet_counts["counts"]) {
+            counts[count["value"].get<std::string>()] = count["count"].get<size_t>();
+        }
+        return counts;
+    };
+
+    // results of every index are below the threshold, so the counts are exact
+    auto results = search(10, 2000).get();
+    ASSERT_EQ(4000, results["found"].get<size_t>());
+    ASSERT_EQ(0, results["facet_counts"][0].count("sampled"));
+    ASSERT_EQ(1000, get_counts(results["facet_counts"][0])["rare"]);
+    ASSERT_EQ(3000, get_counts(results["facet_counts"][0])["common"]);
+    ASSERT_EQ(0, results["facet_counts"][1].count("sampled"));
+    ASSERT_FLOAT_EQ(4.5, results["facet_counts"][1]["stats"]["avg"].get<double>());
+
+    results = search(10, 100).get();
+    ASSERT_EQ(4000, results["found"].get<size_t>());
+    ASSERT_TRUE(results["facet_counts"][0]["sampled"].get<bool>());
+    ASSERT_TRUE(results["facet_counts"][1]["sampled"].get<bool>());
+
+    auto brand_counts = get_counts(results["facet_counts"][0]);
+    ASSERT_EQ(2, brand_counts.size());
+    ASSERT_NEAR(1000, brand_counts["rare"], 250);
+    ASSERT_NEAR(3000, brand_counts["common"], 250);
+    ASSERT_NEAR(4000, brand_counts["rare"] + brand_counts["common"], 5);
+
+    auto rating_counts = get_counts(results["facet_counts"][1]);
+    ASSERT_EQ(10, rating_counts.size());
+    for(const auto& rating_count: rating_counts) {
+        ASSERT_NEAR(400, rating_count.second, 150);
+    }
+
+    ASSERT_NEAR(4.5, results["facet_counts"][1]["stats"]["avg"].get<double>(), 1);
+    ASSERT_NEAR(18000, results["facet_counts"][1]["stats"]["sum"].get<double>(), 4000);
+
+    // the same sample is counted every time
+    ASSERT_EQ(results["facet_counts"].dump(), search(10, 100).get()["facet_counts"].dump());
+
+    auto res_op = search(0, 100);
+    ASSERT_FALSE(res_op.ok());
+    ASSERT_EQ("Value of `facet_sample_percent` must be between 1 and 100.", res_op.error());
+
+    collectionManager.drop_collection("coll1");
+}
+
+TEST_F(CollectionFacetingTest, FacetsOfLargeResultSetsAreCountedInParallelChunks) {
+    std::vector<field> fields = {field("brand", field_types::STRING, true),
+                                 field("rating", field_types::INT32, true),
+                                 field("points", field_types::INT32, false)};
+
+    Collection* coll1 = collectionManager.create_collection("coll1", 1, fields, "points").get();
+
+    // enough results for the facets of every field to be counted in several chunks
+    const size_t num_docs = Index::FACET_PARALLEL_MIN_RESULTS * 2 + 500;
+
+    std::map<std::string, size_t> brand_counts, rating_counts;
+    double rating_sum = 0;
+
+    for(size_t i = 0; i < num_docs; i++) {
+        nlohmann::json doc;
+        doc["id"] = std::to_string(i);
+        doc["brand"] = "brand " + std::to_string(i % 13);
+        doc["rating"] = int32_t(i % 10);
+        doc["points"] = int32_t(i);
+        ASSERT_TRUE(coll1->add(doc.dump()).ok());
+
+        brand_counts["brand " + std::to_string(i % 13)]++;
+        rating_counts[std::to_string(i % 10)]++;
+        rating_sum += (i % 10);
+    }
+
+    auto get_counts = [](const nlohmann::json& facet_counts) {
+        std::map<std::string, size_t> counts;
+        for(const auto& count: facet_counts["counts"]) {
+            counts[count["value"].get<std::string>()] = count["count"].get<size_t>();
+        }
+        return counts;
+    };
+
+    auto results = coll1->search("*", {}, "", {"brand", "rating"}, {}, 0, 10, 1, FREQUENCY, false,
+                                 Index::DROP_TOKENS_THRESHOLD, spp::sparse_hash_set<std::string>(),
+                                 spp::sparse_hash_set<std::string>(), 20).get();
+
+    ASSERT_EQ(num_docs, results["found"].get<size_t>());
+    ASSERT_EQ(brand_counts, get_counts(results["facet_counts"][0]));
+    ASSERT_EQ(rating_counts, get_counts(results["facet_counts"][1]));
+
+    ASSERT_EQ(0, results["facet_counts"][1]["stats"]["min"].get<double>());
+    ASSERT_EQ(9, results["facet_counts"][1]["stats"]["max"].get<double>());
+    ASSERT_EQ(rating_sum, results["facet_counts"][1]["stats"]["sum"].get<double>());
+
+    // values matched by a facet query are counted over all of the chunks too: every value holds the token "brand"
+    results = coll1->search("*", {}, "", {"brand"}, {}, 0, 10, 1, FREQUENCY, false,
+                            Index::DROP_TOKENS_THRESHOLD, spp::sparse_hash_set<std::string>(),
+                            spp::sparse_hash_set<std::string>(), 20, "brand: brand").get();
+
+    ASSERT_EQ(brand_counts, get_counts(results["facet_counts"][0]));
+    ASSERT_EQ("<mark>brand</mark> 0", results["facet_counts"][0]["counts"][0]["highlighted"].get<std::string>());
+
+    collectionManager.drop_collection("coll1");
+}
+
+TEST_F(CollectionFacetingTest, FacetsOfLargeResultSetsAreCountedDuringAnImport) {
+    std::vector<field> fields = {field("brand", field_types::STRING, true),
+                                 field("rating", field_types::INT32, true),
+                                 field("points", field_types::INT32, false)};
+
+    Collection* coll1 = collectionManager.create_collection("coll1", 1, fields, "points").get();
+
+    const size_t num_docs = Index::FACET_PARALLEL_MIN_RESULTS * 2 + 500;
+
+    auto make_doc = [](size_t i) {
+        nlohmann::json doc;
+        doc["id"] = std::to_string(i);
+        doc["brand"] = "brand " + std::to_string(i % 13);
+        doc["rating"] = int32_t(i % 10);
+        doc["points"] = int32_t(i);
+        return doc.dump();
+    };
+
+    for(size_t i = 0; i < num_docs; i++) {
+        ASSERT_TRUE(coll1->add(make_doc(i)).ok());
+    }
+
+    // the batches of the import are indexed by the same pool that counts the facets of the searches, while the
+    // searches hold the lock of the index that the batches write to
+    const size_t num_imported = 1000;
+    std::vector<std::string> import_records;
+    for(size_t i = num_docs; i < num_docs + num_imported; i++) {
+        import_records.push_back(make_doc(i));
+    }
+
+    std::atomic<bool> imported(false);
+    nlohmann::json import_response;
+
+    std::thread importer([&]() {
+        nlohmann::json document;
+        import_response = coll1->add_many(import_records, document);
+        imported = true;
+    });
+
+    // searches that always overlap each other must not starve the import
+    const size_t num_searchers = 4;
+    std::vector<size_t> min_found(num_searchers, num_docs + num_imported);
+    std::vector<size_t> min_rating_count(num_searchers, num_docs + num_imported);
+    std::vector<std::thread> searchers;
+
+    for(size_t searcher = 0; searcher < num_searchers; searcher++) {
+        searchers.emplace_back([&, searcher]() {
+            size_t num_searches = 0;
+
+            while(!imported || num_searches == 0) {
+                auto results = coll1->search("*", {}, "", {"brand", "rating"}, {}, 0, 10, 1, FREQUENCY, false).get();
+                min_found[searcher] = std::min(min_found[searcher], results["found"].get<size_t>());
+
+                size_t rating_count = 0;
+                for(const auto& count: results["facet_counts"][1]["counts"]) {
+                    rating_count += count["count"].get<size_t>();
+                }
+
+                min_rating_count[searcher] = std::min(min_rating_count[searcher], rating_count);
+                num_searches++;
+            }
+        });
+    }
+
+    for(auto& searcher: searchers) {
+        searcher.join();
+    }
+
+    importer.join();
+
+    for(size_t searcher = 0; searcher < num_searchers; searcher++) {
+        ASSERT_LE(num_docs, min_found[searcher]);
+        ASSERT_LE(num_docs, min_rating_count[searcher]);
+    }
+
+    ASSERT_TRUE(import_response["success"].get<bool>());
+    ASSERT_EQ(num_imported, import_response["num_imported"].get<size_t>());
+    ASSERT_EQ(num_docs + num_imported, coll1->get_num_documents());
+
+    collectionManager.drop_collection("coll1");
+}
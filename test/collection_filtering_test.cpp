@@ -1290,4 +1290,213 @@ TEST_F(CollectionFilteringTest, NumericalFilteringWithArray) {
     ASSERT_EQ(4, results["hits"].size());
 
     collectionManager.drop_collection("coll1");
-}
\ No newline at end of file
+}
+TEST_F(CollectionFilteringTest, FilteringWithDenseResults) {
+    Collection *coll1;
+
+    std::vector<field> fields = {field("title", field_types::STRING, false),
+                                 field("in_stock", field_types::BOOL, false),
+                                 field("points", field_types::INT32, false),};
+
+    coll1 = collectionManager.get_collection("coll1").get();
+    if (coll1 == nullptr) {
+        coll1 = collectionManager.create_collection("coll1", 1, fields, "points").get();
+    }
+
+    // enough matching documents for the filter results to be held in a bitmap
+    const size_t num_docs = 3 * id_bitmap_t::MIN_BITMAP_IDS;
+
+    for(size_t i = 0; i < num_docs; i++) {
+        nlohmann::json doc;
+        doc["id"] = std::to_string(i);
+        doc["title"] = (i % 5 == 0) ? "Blue Shirt" : "Red Shirt";
+        doc["in_stock"] = (i % 3 != 0);
+        doc["points"] = int32_t(i);
+
+        ASSERT_TRUE(coll1->add(doc.dump()).ok());
+    }
+
+    size_t expected_found = 0;
+    for(size_t i = 0; i < num_docs; i++) {
+        expected_found += (i % 5 == 0 && i % 3 != 0 && i >= 100);
+    }
+
+    auto results = coll1->search("blue", {"title"}, "in_stock:true && points:>=100",
+                                 {}, {}, 0, 10, 1, FREQUENCY, false).get();
+
+    ASSERT_EQ(expected_found, results["found"].get<size_t>());
+    ASSERT_EQ(10, results["hits"].size());
+
+    for(const auto& hit: results["hits"]) {
+        size_t id = std::stoul(hit["document"]["id"].get<std::string>());
+        ASSERT_TRUE(id % 5 == 0 && id % 3 != 0 && id >= 100);
+    }
+
+    results = coll1->search("shirt", {"title"}, "in_stock:false",
+                            {}, {}, 0, 10, 1, FREQUENCY, false).get();
+
+    ASSERT_EQ(num_docs / 3, results["found"].get<size_t>());
+
+    collectionManager.drop_collection("coll1");
+}
+
+TEST_F(CollectionFilteringTest, RepeatedFiltersAreServedFromCacheUntilTheirFieldsChange) {
+    Collection *coll1;
+
+    std::vector<field> fields = {field("title", field_types::STRING, false),
+                                 field("status", field_types::STRING, true),
+                                 field("points", field_types::INT32, false),};
+
+    coll1 = collectionManager.get_collection("coll1").get();
+    if (coll1 == nullptr) {
+        coll1 = collectionManager.create_collection("coll1", 1, fields, "points").get();
+    }
+
+    for(size_t i = 0; i < 10; i++) {
+        nlohmann::json doc;
+        doc["id"] = std::to_string(i);
+        doc["title"] = "Shirt " + std::to_string(i);
+        doc["status"] = (i % 2 == 0) ? "active" : "archived";
+        doc["points"] = int32_t(i);
+        ASSERT_TRUE(coll1->add(doc.dump()).ok());
+    }
+
+    const filter_cache_t& filter_cache = coll1->_get_indexes()[0]->get_filter_cache();
+
+    auto results = coll1->search("shirt", {"title"}, "status:=active && points:>=4",
+                                 {}, {}, 0, 10, 1, FREQUENCY, false).get();
+    ASSERT_EQ(3, results["found"].get<size_t>());
+
+    // both clauses and their combination
+    ASSERT_EQ(3, filter_cache.size());
+    ASSERT_EQ(0, filter_cache.get_num_hits());
+
+    results = coll1->search("shirt", {"title"}, "status:=active && points:>=4",
+                            {}, {}, 0, 10, 1, FREQUENCY, false).get();
+    ASSERT_EQ(3, results["found"].get<size_t>());
+    ASSERT_EQ(1, filter_cache.get_num_hits());
+
+    // clauses are reused across combinations
+    results = coll1->search("shirt", {"title"}, "status:=active",
+                            {}, {}, 0, 10, 1, FREQUENCY, false).get();
+    ASSERT_EQ(5, results["found"].get<size_t>());
+    ASSERT_EQ(2, filter_cache.get_num_hits());
+
+    // a new document with values for the fields drops their entries
+    nlohmann::json doc;
+    doc["id"] = "10";
+    doc["title"] = "Shirt 10";
+    doc["status"] = "active";
+    doc["points"] = 10;
+    ASSERT_TRUE(coll1->add(doc.dump()).ok());
+    ASSERT_EQ(0, filter_cache.size());
+
+    results = coll1->search("shirt", {"title"}, "status:=active && points:>=4",
+                            {}, {}, 0, 10, 1, FREQUENCY, false).get();
+    ASSERT_EQ(4, results["found"].get<size_t>());
+
+    ASSERT_TRUE(coll1->remove("4").ok());
+    results = coll1->search("shirt", {"title"}, "status:=active && points:>=4",
+                            {}, {}, 0, 10, 1, FREQUENCY, false).get();
+    ASSERT_EQ(3, results["found"].get<size_t>());
+
+    // updates drop the entries of the fields whose values change
+    results = coll1->search("shirt", {"title"}, "status:=archived",
+                            {}, {}, 0, 10, 1, FREQUENCY, false).get();
+    ASSERT_EQ(5, results["found"].get<size_t>());
+
+    doc["status"] = "archived";
+    ASSERT_TRUE(coll1->add(doc.dump(), UPDATE).ok());
+
+    results = coll1->search("shirt", {"title"}, "status:=archived",
+                            {}, {}, 0, 10, 1, FREQUENCY, false).get();
+    ASSERT_EQ(6, results["found"].get<size_t>());
+
+    collectionManager.drop_collection("coll1");
+}
+
+TEST_F(CollectionFilteringTest, FilterClausesAreEvaluatedFromTheMostSelective) {
+    Collection *coll1;
+
+    std::vector<field> fields = {field("title", field_types::STRING, false),
+                                 field("tags", field_types::STRING_ARRAY, true),
+                                 field("status", field_types::STRING, true),
+                                 field("points", field_types::INT32, false),
+                                 field("rating", field_types::FLOAT, false),};
+
+    coll1 = collectionManager.get_collection("coll1").get();
+    if (coll1 == nullptr) {
+        coll1 = collectionManager.create_collection("coll1", 1, fields, "points").get();
+    }
+
+    for(size_t i = 0; i < 100; i++) {
+        nlohmann::json doc;
+        doc["id"] = std::to_string(i);
+        doc["title"] = "Shirt " + std::to_string(i);
+        doc["tags"] = (i % 25 == 0) ? std::vector<std::string>{"rare", "blue"} : std::vector<std::string>{"blue"};
+        doc["status"] = (i % 2 == 0) ? "active" : "active archived";
+        doc["points"] = int32_t(i);
+        doc["rating"] = float(i % 10);
+        ASSERT_TRUE(coll1->add(doc.dump()).ok());
+    }
+
+    auto search = [&](const std::string& filter_query) {
+        return coll1->search("*", {}, filter_query, {}, {}, 0, 100, 1, FREQUENCY, false, 1000,
+                             spp::sparse_hash_set<std::string>(), spp::sparse_hash_set<std::string>(), 10, "", 30, 4,
+                             "", 40, {}, {}, {}, 0, "<mark>", "</mark>", {}, UINT32_MAX, true).get();
+    };
+
+    // the rare tag is evaluated first, and the wide range is only checked for the ids of the rare tag
+    auto results = search("points:>=10 && tags:rare");
+    ASSERT_EQ(3, results["found"].get<size_t>());
+
+    ASSERT_EQ(1, results["filter_explain"].size());
+    auto clauses = results["filter_explain"][0];
+    ASSERT_EQ(2, clauses.size());
+    ASSERT_EQ("tags", clauses[0]["field"].get<std::string>());
+    ASSERT_EQ(4, clauses[0]["estimated_ids"].get<size_t>());
+    ASSERT_EQ("materialized", clauses[0]["strategy"].get<std::string>());
+    ASSERT_EQ(4, clauses[0]["num_ids"].get<size_t>());
+    ASSERT_EQ("points", clauses[1]["field"].get<std::string>());
+    ASSERT_EQ(90, clauses[1]["estimated_ids"].get<size_t>());
+    ASSERT_EQ("probed", clauses[1]["strategy"].get<std::string>());
+    ASSERT_EQ(3, clauses[1]["num_ids"].get<size_t>());
+    ASSERT_EQ(1, clauses[1].count("time_us"));
+
+    // string clauses are probed too, exact matches included
+    results = search("status:=active && points:<10 && rating:[2..3]");
+    ASSERT_EQ(1, results["found"].get<size_t>());
+    ASSERT_EQ("2", results["hits"][0]["document"]["id"].get<std::string>());
+
+    clauses = results["filter_explain"][0];
+    ASSERT_EQ(3, clauses.size());
+    ASSERT_EQ("points", clauses[0]["field"].get<std::string>());
+    ASSERT_EQ("rating", clauses[1]["field"].get<std::string>());
+    ASSERT_EQ("materialized", clauses[1]["strategy"].get<std::string>());
+    ASSERT_EQ("status", clauses[2]["field"].get<std::string>());
+    ASSERT_EQ("probed", clauses[2]["strategy"].get<std::string>());
+
+    // probed clauses give the same ids as materialized ones
+    results = search("status:=active && points:<10");
+    ASSERT_EQ(5, results["found"].get<size_t>());
+    results = search("status:active && points:<10");
+    ASSERT_EQ(10, results["found"].get<size_t>());
+    results = search("tags:=blue && points:>=10 && rating:<1");
+    ASSERT_EQ(9, results["found"].get<size_t>());
+    ASSERT_EQ("probed", results["filter_explain"][0][2]["strategy"].get<std::string>());
+
+    // the remaining clauses are skipped once nothing matches
+    results = search("points:[1..9] && tags:rare && rating:>5");
+    ASSERT_EQ(0, results["found"].get<size_t>());
+    ASSERT_EQ(2, results["filter_explain"][0].size());
+
+    // a repeated combination of clauses is served from the cache in one go
+    results = search("status:=active && points:<10");
+    ASSERT_EQ(5, results["found"].get<size_t>());
+    clauses = results["filter_explain"][0];
+    ASSERT_EQ(1, clauses.size());
+    ASSERT_EQ("status,points", clauses[0]["field"].get<std::string>());
+    ASSERT_EQ("cached", clauses[0]["strategy"].get<std::string>());
+
+    collectionManager.drop_collection("coll1");
+}
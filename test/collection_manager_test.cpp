@@ -617,4 +617,86 @@ TEST_F(CollectionManagerTest, ParseSortByClause) {
     sort_by_parsed = CollectionManager::parse_sort_by_str(",,", sort_fields);
     ASSERT_FALSE(sort_by_parsed);
 
-}
\ No newline at end of file
+}
+TEST_F(CollectionManagerTest, SearchResultsAreCachedUntilTheCollectionChanges) {
+    SearchCache& search_cache = collectionManager.get_search_cache();
+    search_cache.set_limits(1024 * 1024, 60 * 1000);
+
+    nlohmann::json doc;
+    doc["id"] = "0";
+    doc["title"] = "The Dark Knight";
+    doc["starring"] = "Christian Bale";
+    doc["cast"] = {"Heath Ledger"};
+    doc["points"] = 100;
+    ASSERT_TRUE(collection1->add(doc.dump()).ok());
+
+    std::map<std::string, std::string> req_params = {
+        {"collection", "collection1"},
+        {"q", "dark"},
+        {"query_by", "title"},
+    };
+
+    auto search = [&](std::map<std::string, std::string> params) {
+        std::string results_json_str;
+        Option<bool> search_op = CollectionManager::do_search(params, results_json_str);
+        EXPECT_TRUE(search_op.ok());
+        return nlohmann::json::parse(results_json_str);
+    };
+
+    nlohmann::json results = search(req_params);
+    ASSERT_EQ(1, results["found"].get<size_t>());
+    ASSERT_EQ(1, results.count("search_time_ms"));
+    ASSERT_EQ(1, search_cache.size());
+
+    // same search, with the defaults spelled out, is served from the cache
+    std::map<std::string, std::string> explicit_params = req_params;
+    explicit_params["page"] = "1";
+    explicit_params["per_page"] = "10";
+
+    nlohmann::json cached_results = search(explicit_params);
+    ASSERT_EQ(1, cached_results.count("search_time_ms"));
+    ASSERT_EQ(1, search_cache.size());
+
+    // apart from the search time, which is set on every response
+    results.erase("search_time_ms");
+    cached_results.erase("search_time_ms");
+    ASSERT_EQ(results, cached_results);
+
+    // a new document makes the cached results stale
+    doc["id"] = "1";
+    doc["title"] = "Dark Waters";
+    ASSERT_TRUE(collection1->add(doc.dump()).ok());
+    ASSERT_EQ(2, search(req_params)["found"].get<size_t>());
+
+    ASSERT_TRUE(collection1->remove("1").ok());
+    ASSERT_EQ(1, search(req_params)["found"].get<size_t>());
+
+    // so do synonyms
+    req_params["q"] = "gloomy";
+    ASSERT_EQ(0, search(req_params)["found"].get<size_t>());
+
+    synonym_t synonym("syn-1", {}, {{"dark"}, {"gloomy"}});
+    ASSERT_TRUE(collection1->add_synonym(synonym).ok());
+    ASSERT_EQ(1, search(req_params)["found"].get<size_t>());
+
+    ASSERT_TRUE(collection1->remove_synonym("syn-1").ok());
+    ASSERT_EQ(0, search(req_params)["found"].get<size_t>());
+
+    // and the cache can be bypassed per request
+    req_params["q"] = "dark";
+    req_params["use_cache"] = "false";
+    ASSERT_EQ(1, search(req_params)["found"].get<size_t>());
+
+    req_params["use_cache"] = "maybe";
+    std::string results_json_str;
+    Option<bool> search_op = CollectionManager::do_search(req_params, results_json_str);
+    ASSERT_FALSE(search_op.ok());
+    ASSERT_EQ("Parameter `use_cache` must be a boolean.", search_op.error());
+
+    nlohmann::json metrics;
+    search_cache.get_metrics(metrics);
+    ASSERT_EQ("1", metrics["typesense_search_cache_hits"].get<std::string>());
+
+    search_cache.set_limits(0, 0);
+    search_cache.clear();
+}
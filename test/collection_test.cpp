@@ -3,6 +3,9 @@
 #include <vector>
 #include <fstream>
 #include <algorithm>
+#include <random>
+#include <thread>
+#include <atomic>
 #include <collection_manager.h>
 #include "collection.h"
 
@@ -3431,6 +3434,296 @@ TEST_F(CollectionTest, HighlightWithAccentedCharacters) {
     collectionManager.drop_collection("coll1");
 }
 
+TEST_F(CollectionTest, SearchFieldWithTypoIndex) {
+    std::vector<field> fields = {field("title", field_types::STRING, false),
+                                 field("points", field_types::INT32, false),};
+
+    std::vector<field> typo_index_fields = {field("title", field_types::STRING, false, false, true,
+                                                  DEFAULT_GEO_RESOLUTION, "", true),
+                                            field("points", field_types::INT32, false),};
+
+    Collection* coll1 = collectionManager.create_collection("coll1", 4, fields, "points").get();
+    Collection* coll2 = collectionManager.create_collection("coll2", 4, typo_index_fields, "points").get();
+
+    std::vector<std::string> titles = {"The quick brown fox", "Jumped over the lazy dog", "A brown dog barked",
+                                       "Quiet foxes jump", "Lazy afternoons", "Brownies for the dogs"};
+
+    for(size_t i = 0; i < titles.size(); i++) {
+        nlohmann::json doc;
+        doc["id"] = std::to_string(i);
+        doc["title"] = titles[i];
+        doc["points"] = i;
+
+        ASSERT_TRUE(coll1->add(doc.dump()).ok());
+        ASSERT_TRUE(coll2->add(doc.dump()).ok());
+    }
+
+    ASSERT_TRUE(coll2->get_memory_stats_json()["typo_index_bytes"]["title"].get<uint64_t>() > 0);
+    ASSERT_EQ(0, coll1->get_memory_stats_json().count("typo_index_bytes"));
+
+    for(const std::string query: {"brwn", "lazzy dgo", "quik fix", "jmup"}) {
+        auto results1 = coll1->search(query, {"title"}, "", {}, {}, 2, 10, 1, FREQUENCY, false).get();
+        auto results2 = coll2->search(query, {"title"}, "", {}, {}, 2, 10, 1, FREQUENCY, false).get();
+
+        ASSERT_LT(0, results1["found"].get<size_t>());
+        ASSERT_EQ(results1["found"].get<size_t>(), results2["found"].get<size_t>()) << query;
+
+        for(size_t i = 0; i < results1["hits"].size(); i++) {
+            ASSERT_EQ(results1["hits"][i]["document"]["id"], results2["hits"][i]["document"]["id"]) << query;
+        }
+    }
+
+    // deleted tokens must no longer be suggested
+    ASSERT_TRUE(coll2->remove("3").ok());
+    auto results = coll2->search("jmup", {"title"}, "", {}, {}, 2, 10, 1, FREQUENCY, false).get();
+    ASSERT_EQ(0, results["found"].get<size_t>());
+
+    ASSERT_EQ(true, coll2->get_summary_json()["fields"][0]["typo_index"].get<bool>());
+
+    collectionManager.drop_collection("coll1");
+    collectionManager.drop_collection("coll2");
+}
+
+TEST_F(CollectionTest, RankingWhenTopsterIsFull) {
+    // more matching documents than the topster can hold, so that results are pruned once it fills up
+    std::vector<field> fields = {field("title", field_types::STRING, false),
+                                 field("points", field_types::INT32, false),};
+
+    Collection* coll1 = collectionManager.create_collection("coll1", 1, fields, "points").get();
+
+    const size_t num_docs = 600;
+
+    for(size_t i = 0; i < num_docs; i++) {
+        nlohmann::json doc;
+        doc["id"] = std::to_string(i);
+        doc["title"] = (i % 3 == 0) ? "alpha beta gamma" : "alpha gamma delta epsilon beta";
+        doc["points"] = (i * 7) % num_docs;
+        ASSERT_TRUE(coll1->add(doc.dump()).ok());
+    }
+
+    // sorted on points first: match scores do not matter
+    std::vector<sort_by> sort_fields = { sort_by("points", "DESC") };
+    auto results = coll1->search("alpha beta", {"title"}, "", {}, sort_fields, 0, 10, 1, FREQUENCY, false).get();
+
+    ASSERT_EQ(num_docs, results["found"].get<size_t>());
+    ASSERT_EQ(10, results["hits"].size());
+
+    for(size_t i = 0; i < results["hits"].size(); i++) {
+        ASSERT_EQ(num_docs - 1 - i, results["hits"][i]["document"]["points"].get<size_t>());
+    }
+
+    // sorted on text match first: only the documents with adjacent tokens can make it to the top
+    sort_fields = { sort_by(sort_field_const::text_match, "DESC"), sort_by("points", "DESC") };
+    results = coll1->search("alpha beta", {"title"}, "", {}, sort_fields, 0, 10, 1, FREQUENCY, false).get();
+
+    ASSERT_EQ(num_docs, results["found"].get<size_t>());
+    ASSERT_EQ(10, results["hits"].size());
+
+    std::vector<size_t> expected_points;
+    for(size_t i = 0; i < num_docs; i += 3) {
+        expected_points.push_back((i * 7) % num_docs);
+    }
+
+    std::sort(expected_points.begin(), expected_points.end(), std::greater<size_t>());
+
+    for(size_t i = 0; i < results["hits"].size(); i++) {
+        ASSERT_STREQ("alpha beta gamma", results["hits"][i]["document"]["title"].get<std::string>().c_str());
+        ASSERT_EQ(expected_points[i], results["hits"][i]["document"]["points"].get<size_t>());
+    }
+
+    collectionManager.drop_collection("coll1");
+}
+
+TEST_F(CollectionTest, CountsSuggestionsThatCannotEnterTopster) {
+    std::vector<field> fields = {field("title", field_types::STRING, false),
+                                 field("points", field_types::INT32, false),};
+
+    Collection* coll1 = collectionManager.create_collection("coll1", 1, fields, "points").get();
+
+    // once the documents of the exact suggestion fill the topster, the typo suggestion has lower points
+    const size_t num_docs = 600;
+
+    for(size_t i = 0; i < num_docs; i++) {
+        nlohmann::json doc;
+        doc["id"] = std::to_string(i);
+        doc["title"] = (i < num_docs / 2) ? "alpha beta" : "alpha betx";
+        doc["points"] = (i < num_docs / 2) ? (1000 + i) : i;
+        ASSERT_TRUE(coll1->add(doc.dump()).ok());
+    }
+
+    std::vector<std::vector<sort_by>> sort_fields_list = {
+        { sort_by("points", "DESC") },
+        { sort_by(sort_field_const::text_match, "DESC"), sort_by("points", "DESC") },
+    };
+
+    for(const auto& sort_fields: sort_fields_list) {
+        auto results = coll1->search("alpha beta", {"title"}, "", {}, sort_fields, 1, 10, 1,
+                                     token_ordering::FREQUENCY, false, 1000, spp::sparse_hash_set<std::string>(),
+                                     spp::sparse_hash_set<std::string>(), 10, "", 30, 4, "", 1000).get();
+
+        ASSERT_EQ(num_docs, results["found"].get<size_t>());
+        ASSERT_EQ(10, results["hits"].size());
+
+        for(size_t i = 0; i < results["hits"].size(); i++) {
+            ASSERT_EQ(1000 + num_docs / 2 - 1 - i, results["hits"][i]["document"]["points"].get<size_t>());
+        }
+    }
+
+    collectionManager.drop_collection("coll1");
+}
+
+TEST_F(CollectionTest, ImpactOrderedIds) {
+    std::vector<field> fields = {field("title", field_types::STRING, false),
+                                 field("points", field_types::INT32, false),};
+
+    // impact ordering needs a default sorting field
+    auto coll_op = collectionManager.create_collection("coll0", 1, fields, "", 0, "", true);
+    ASSERT_FALSE(coll_op.ok());
+    ASSERT_EQ(400, coll_op.code());
+
+    Collection* coll1 = collectionManager.create_collection("coll1", 2, fields, "points").get();
+    Collection* coll2 = collectionManager.create_collection("coll2", 2, fields, "points", 0, "", true).get();
+
+    ASSERT_EQ(0, coll1->get_summary_json().count("impact_ordered_ids"));
+    ASSERT_TRUE(coll2->get_summary_json()["impact_ordered_ids"].get<bool>());
+
+    const std::vector<std::string> words = {"alpha", "alpine", "bravo", "charlie", "delta"};
+    const size_t num_docs = 1000;
+
+    std::mt19937 gen(42);
+
+    for(size_t i = 0; i < num_docs; i++) {
+        nlohmann::json doc;
+        doc["id"] = std::to_string(i);
+        doc["title"] = words[gen() % words.size()] + " " + words[gen() % words.size()];
+        doc["points"] = (i * 37) % num_docs;
+
+        ASSERT_TRUE(coll1->add(doc.dump()).ok());
+        ASSERT_TRUE(coll2->add(doc.dump()).ok());
+    }
+
+    ASSERT_LT(0, coll2->get_memory_stats_json()["impact_ordered_ids_bytes"]["title"].get<uint64_t>());
+    ASSERT_EQ(0, coll1->get_memory_stats_json().count("impact_ordered_ids_bytes"));
+
+    auto assert_same_results = [&]() {
+        for(const std::string filter: {"", "points:>500"}) {
+            for(const std::string query: {"alpha", "alp", "bravo"}) {
+                for(size_t page = 1; page <= 3; page++) {
+                    auto results1 = coll1->search(query, {"title"}, filter, {}, {}, 0, 10, page,
+                                                  FREQUENCY, true).get();
+                    auto results2 = coll2->search(query, {"title"}, filter, {}, {}, 0, 10, page,
+                                                  FREQUENCY, true).get();
+
+                    ASSERT_LT(0, results1["found"].get<size_t>());
+                    ASSERT_EQ(results1["found"].get<size_t>(), results2["found"].get<size_t>());
+                    ASSERT_EQ(results1["hits"].size(), results2["hits"].size());
+
+                    for(size_t i = 0; i < results1["hits"].size(); i++) {
+                        ASSERT_EQ(results1["hits"][i]["document"]["id"], results2["hits"][i]["document"]["id"])
+                                                    << query << ", " << filter;
+                    }
+                }
+            }
+        }
+    };
+
+    assert_same_results();
+
+    // points changing without the title changing must reorder the ids of the title tokens
+    std::vector<std::string> updates;
+    for(size_t i = 0; i < num_docs; i += 7) {
+        nlohmann::json doc;
+        doc["id"] = std::to_string(i);
+        doc["points"] = num_docs + i;
+        updates.push_back(doc.dump());
+    }
+
+    nlohmann::json document;
+    std::vector<std::string> updates2 = updates;
+    coll1->add_many(updates, document, UPDATE);
+    coll2->add_many(updates2, document, UPDATE);
+
+    assert_same_results();
+
+    for(size_t i = 0; i < num_docs; i += 5) {
+        ASSERT_TRUE(coll1->remove(std::to_string(i)).ok());
+        ASSERT_TRUE(coll2->remove(std::to_string(i)).ok());
+    }
+
+    assert_same_results();
+
+    collectionManager.drop_collection("coll1");
+    collectionManager.drop_collection("coll2");
+}
+
+TEST_F(CollectionTest, SearchWhileImporting) {
+    std::vector<field> fields = {field("title", field_types::STRING, false),
+                                 field("points", field_types::INT32, false),};
+
+    Collection* coll1 = collectionManager.create_collection("coll1", 2, fields, "points").get();
+
+    const size_t num_docs = 200;
+    const size_t num_rounds = 20;
+
+    for(size_t i = 0; i < num_docs; i++) {
+        nlohmann::json doc;
+        doc["id"] = std::to_string(i);
+        doc["title"] = "alpha bravo";
+        doc["points"] = i;
+        ASSERT_TRUE(coll1->add(doc.dump()).ok());
+    }
+
+    // every round replaces a token of every document, so that tokens of the previous round leave the index
+    std::atomic<bool> done(false);
+    std::thread writer([&]() {
+        for(size_t round = 0; round < num_rounds; round++) {
+            std::vector<std::string> updates;
+            for(size_t i = 0; i < num_docs; i++) {
+                nlohmann::json doc;
+                doc["id"] = std::to_string(i);
+                doc["title"] = "alpha " + std::string(round % 2 == 0 ? "charlie" : "bravo") +
+                               " extra" + std::to_string(round);
+                doc["points"] = i + round;
+                updates.push_back(doc.dump());
+            }
+
+            nlohmann::json document;
+            coll1->add_many(updates, document, UPDATE);
+        }
+
+        done.store(true);
+    });
+
+    size_t num_searches = 0;
+    size_t num_incomplete = 0;
+
+    while(!done.load()) {
+        // documents are never seen half way through an update
+        auto results = coll1->search("alpha", {"title"}, "", {}, {}, 0, 10, 1, FREQUENCY, false).get();
+        if(results["found"].get<size_t>() != num_docs || results["hits"].size() != 10) {
+            num_incomplete++;
+        }
+
+        // highlights the prefixed tokens of earlier rounds, which concurrent updates remove from the index
+        coll1->search("extra", {"title"}, "", {}, {}, 0, 10, 1, FREQUENCY, true);
+        num_searches++;
+    }
+
+    writer.join();
+
+    ASSERT_LT(0, num_searches);
+    ASSERT_EQ(0, num_incomplete);
+
+    auto results = coll1->search("extra", {"title"}, "", {}, {}, 0, 10, 1, FREQUENCY, true).get();
+    ASSERT_EQ(num_docs, results["found"].get<size_t>());
+    ASSERT_EQ("alpha bravo <mark>extra19</mark>", results["hits"][0]["highlights"][0]["snippet"].get<std::string>());
+
+    results = coll1->search("charlie", {"title"}, "", {}, {}, 0, 10, 1, FREQUENCY, false).get();
+    ASSERT_EQ(0, results["found"].get<size_t>());
+
+    collectionManager.drop_collection("coll1");
+}
+
 TEST_F(CollectionTest, DISABLED_SearchingForRecordsWithSpecialChars) {
     Collection *coll1;
 
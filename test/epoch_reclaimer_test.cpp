@@ -0,0 +1,112 @@
+#include <gtest/gtest.h>
+#include "epoch_reclaimer.h"
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+TEST(EpochReclaimerTest, ReclaimsOnlyWhatNoReaderCanHold) {
+    epoch_reclaimer_t reclaimer;
+    std::vector<int> reclaimed;
+
+    reclaimer.retire([&]() { reclaimed.push_back(0); });
+
+    {
+        epoch_reclaimer_t::guard_t guard(&reclaimer);
+
+        // retired before the reader entered
+        ASSERT_EQ(1, reclaimer.reclaim());
+        ASSERT_EQ(std::vector<int>({0}), reclaimed);
+
+        reclaimer.retire([&]() { reclaimed.push_back(1); });
+
+        {
+            epoch_reclaimer_t::guard_t inner_guard(&reclaimer);
+            reclaimer.retire([&]() { reclaimed.push_back(2); });
+        }
+
+        // both could have been found by the outer reader
+        ASSERT_EQ(0, reclaimer.reclaim());
+        ASSERT_EQ(2, reclaimer.num_retired());
+    }
+
+    ASSERT_EQ(2, reclaimer.reclaim());
+    ASSERT_EQ(std::vector<int>({0, 1, 2}), reclaimed);
+    ASSERT_EQ(0, reclaimer.num_retired());
+}
+
+TEST(EpochReclaimerTest, OlderReaderHoldsBackLaterRetirements) {
+    epoch_reclaimer_t reclaimer;
+    std::vector<int> reclaimed;
+
+    auto older_guard = std::make_unique<epoch_reclaimer_t::guard_t>(&reclaimer);
+    reclaimer.retire([&]() { reclaimed.push_back(0); });
+
+    epoch_reclaimer_t::guard_t newer_guard(&reclaimer);
+    reclaimer.retire([&]() { reclaimed.push_back(1); });
+
+    ASSERT_EQ(0, reclaimer.reclaim());
+
+    // the newer reader entered after the first retirement, but not after the second one
+    older_guard.reset();
+    ASSERT_EQ(1, reclaimer.reclaim());
+    ASSERT_EQ(std::vector<int>({0}), reclaimed);
+
+    // readers are not waited for
+    reclaimer.reclaim_all();
+    ASSERT_EQ(std::vector<int>({0, 1}), reclaimed);
+}
+
+TEST(EpochReclaimerTest, ConcurrentReadersNeverSeeReclaimedObjects) {
+    epoch_reclaimer_t reclaimer;
+
+    const size_t num_objects = 20000;
+    std::vector<std::atomic<int*>> slots(4);
+    for(auto& slot: slots) {
+        slot.store(new int(0));
+    }
+
+    std::atomic<bool> done(false);
+    std::atomic<size_t> num_reads(0);
+
+    std::vector<std::thread> readers;
+    for(size_t i = 0; i < 4; i++) {
+        readers.emplace_back([&]() {
+            while(!done.load()) {
+                epoch_reclaimer_t::guard_t guard(&reclaimer);
+                for(auto& slot: slots) {
+                    // a reclaimed object would have been overwritten with -1 before being freed
+                    EXPECT_NE(-1, *slot.load());
+                }
+                num_reads++;
+            }
+        });
+    }
+
+    while(num_reads.load() == 0) {
+        std::this_thread::yield();
+    }
+
+    for(size_t i = 0; i < num_objects; i++) {
+        auto& slot = slots[i % slots.size()];
+        int* old_object = slot.exchange(new int(i));
+        reclaimer.retire([old_object]() {
+            *old_object = -1;
+            delete old_object;
+        });
+
+        reclaimer.reclaim();
+    }
+
+    done.store(true);
+    for(auto& reader: readers) {
+        reader.join();
+    }
+
+    reclaimer.reclaim();
+    ASSERT_EQ(0, reclaimer.num_retired());
+
+    for(auto& slot: slots) {
+        delete slot.load();
+    }
+}
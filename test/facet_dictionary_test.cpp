@@ -0,0 +1,136 @@
+#include <gtest/gtest.h>
+#include "facet_dictionary.h"
+
+TEST(FacetDictionaryTest, DocumentsAreHeldAsOrdinalsOfTheirValues) {
+    facet_dictionary_t dictionary(2);
+
+    dictionary.add(0, {100, 200}, {"red", "blue"});
+    dictionary.add(2, {200}, {"blue"});
+    dictionary.add(6, {300, 100}, {"green", "red"});
+
+    ASSERT_EQ(3, dictionary.size());
+    ASSERT_EQ(3, dictionary.num_ordinals());
+
+    const uint32_t* doc_ordinals = nullptr;
+    uint32_t num_doc_ordinals = 0;
+
+    dictionary.get_ordinals(6, doc_ordinals, num_doc_ordinals);
+    ASSERT_EQ(2, num_doc_ordinals);
+    ASSERT_EQ(300, dictionary.get_value_hash(doc_ordinals[0]));
+    ASSERT_EQ(100, dictionary.get_value_hash(doc_ordinals[1]));
+
+    // slots that hold no document
+    dictionary.get_ordinals(4, doc_ordinals, num_doc_ordinals);
+    ASSERT_EQ(0, num_doc_ordinals);
+    dictionary.get_ordinals(100, doc_ordinals, num_doc_ordinals);
+    ASSERT_EQ(0, num_doc_ordinals);
+
+    std::string value;
+    ASSERT_TRUE(dictionary.get(200, value));
+    ASSERT_EQ("blue", value);
+
+    // the value is held until its last document is removed
+    dictionary.remove(0);
+    ASSERT_TRUE(dictionary.get(200, value));
+    ASSERT_TRUE(dictionary.get(100, value));
+
+    dictionary.remove(2);
+    ASSERT_FALSE(dictionary.get(200, value));
+    ASSERT_EQ(2, dictionary.size());
+
+    // the ordinal of the removed value is reused
+    dictionary.add(8, {400}, {"black"});
+    ASSERT_EQ(3, dictionary.num_ordinals());
+    ASSERT_TRUE(dictionary.get(400, value));
+    ASSERT_EQ("black", value);
+
+    dictionary.get_ordinals(8, doc_ordinals, num_doc_ordinals);
+    ASSERT_EQ(1, num_doc_ordinals);
+    ASSERT_EQ(400, dictionary.get_value_hash(doc_ordinals[0]));
+}
+
+TEST(FacetDictionaryTest, ReaddingADocumentReplacesItsValues) {
+    facet_dictionary_t dictionary;
+
+    dictionary.add(0, {100}, {"red"});
+    dictionary.add(0, {200}, {"blue"});
+
+    std::string value;
+    ASSERT_FALSE(dictionary.get(100, value));
+    ASSERT_EQ(1, dictionary.size());
+
+    const uint32_t* doc_ordinals = nullptr;
+    uint32_t num_doc_ordinals = 0;
+    dictionary.get_ordinals(0, doc_ordinals, num_doc_ordinals);
+    ASSERT_EQ(1, num_doc_ordinals);
+    ASSERT_EQ(200, dictionary.get_value_hash(doc_ordinals[0]));
+}
+
+TEST(FacetDictionaryTest, SpellingsOfAValueAreCountedOnTheirOwn) {
+    facet_dictionary_t dictionary;
+
+    // values that normalize to the same tokens share a hash
+    dictionary.add(0, {100}, {"Apple"});
+    dictionary.add(1, {100}, {"apple"});
+    dictionary.add(2, {100}, {"APPLE!"});
+    dictionary.add(3, {100}, {"apple"});
+    ASSERT_EQ(1, dictionary.size());
+
+    std::string value;
+    ASSERT_TRUE(dictionary.get(100, value));
+    ASSERT_EQ("Apple", value);
+
+    dictionary.remove(0);
+    ASSERT_TRUE(dictionary.get(100, value));
+    ASSERT_EQ("apple", value);
+
+    // the spelling is still held by another document
+    dictionary.remove(1);
+    ASSERT_TRUE(dictionary.get(100, value));
+    ASSERT_EQ("apple", value);
+
+    dictionary.remove(3);
+    ASSERT_TRUE(dictionary.get(100, value));
+    ASSERT_EQ("APPLE!", value);
+
+    // a spelling that is added again takes a free slot
+    dictionary.add(4, {100}, {"aPPle"});
+    ASSERT_TRUE(dictionary.get(100, value));
+    ASSERT_EQ("aPPle", value);
+
+    dictionary.remove(4);
+    dictionary.remove(2);
+    ASSERT_FALSE(dictionary.get(100, value));
+    ASSERT_EQ(0, dictionary.size());
+}
+
+TEST(FacetDictionaryTest, OrdinalsOfRemovedDocumentsAreCompactedAway) {
+    facet_dictionary_t dictionary;
+
+    for(uint32_t seq_id = 0; seq_id < 5000; seq_id++) {
+        dictionary.add(seq_id, {seq_id % 10, 100 + seq_id % 3}, {"a", "b"});
+    }
+
+    for(uint32_t seq_id = 0; seq_id < 5000; seq_id++) {
+        if(seq_id % 4 != 0) {
+            dictionary.remove(seq_id);
+        }
+    }
+
+    ASSERT_EQ(8, dictionary.size());
+
+    for(uint32_t seq_id = 0; seq_id < 5000; seq_id++) {
+        const uint32_t* doc_ordinals = nullptr;
+        uint32_t num_doc_ordinals = 0;
+        dictionary.get_ordinals(seq_id, doc_ordinals, num_doc_ordinals);
+
+        if(seq_id % 4 != 0) {
+            ASSERT_EQ(0, num_doc_ordinals);
+            continue;
+        }
+
+        ASSERT_EQ(2, num_doc_ordinals);
+        ASSERT_EQ(seq_id % 10, dictionary.get_value_hash(doc_ordinals[0]));
+        ASSERT_EQ(100 + seq_id % 3, dictionary.get_value_hash(doc_ordinals[1]));
+    }
+}
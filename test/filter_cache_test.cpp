@@ -0,0 +1,111 @@
+#include <gtest/gtest.h>
+#include "filter_cache.h"
+
+TEST(FilterCacheTest, InvalidatesEntriesOfAField) {
+    filter_cache_t cache;
+
+    std::vector<uint32_t> ids = {1, 5, 9, 200};
+    cache.insert("status", {"status"}, ids.data(), ids.size());
+    cache.insert("points", {"points"}, ids.data(), 2);
+    cache.insert("status&points", {"status", "points"}, ids.data(), 1);
+    ASSERT_EQ(3, cache.size());
+
+    uint32_t* cached_ids = nullptr;
+    size_t cached_ids_len = 0;
+    ASSERT_TRUE(cache.get("status", &cached_ids, cached_ids_len));
+    ASSERT_EQ(ids, std::vector<uint32_t>(cached_ids, cached_ids + cached_ids_len));
+    delete [] cached_ids;
+
+    cache.invalidate("status");
+    ASSERT_EQ(1, cache.size());
+    ASSERT_FALSE(cache.get("status", &cached_ids, cached_ids_len));
+    ASSERT_FALSE(cache.get("status&points", &cached_ids, cached_ids_len));
+
+    ASSERT_TRUE(cache.get("points", &cached_ids, cached_ids_len));
+    ASSERT_EQ(2, cached_ids_len);
+    delete [] cached_ids;
+
+    // empty results are cached too
+    cache.insert("region", {"region"}, nullptr, 0);
+    ASSERT_TRUE(cache.get("region", &cached_ids, cached_ids_len));
+    ASSERT_EQ(nullptr, cached_ids);
+    ASSERT_EQ(0, cached_ids_len);
+
+    ASSERT_EQ(3, cache.get_num_hits());
+}
+
+TEST(FilterCacheTest, EvictsLeastRecentlyUsed) {
+    uint32_t ids[] = {1, 2, 3};
+
+    filter_cache_t sizing_cache;
+    sizing_cache.insert("a", {"a"}, ids, 3);
+    const size_t entry_num_bytes = sizing_cache.size_bytes();
+
+    // room for two entries of the same size
+    filter_cache_t cache(entry_num_bytes * 2);
+
+    cache.insert("a", {"a"}, ids, 3);
+    cache.insert("b", {"b"}, ids, 3);
+    ASSERT_EQ(entry_num_bytes * 2, cache.size_bytes());
+
+    uint32_t* cached_ids = nullptr;
+    size_t cached_ids_len = 0;
+    ASSERT_TRUE(cache.get("a", &cached_ids, cached_ids_len));
+    delete [] cached_ids;
+
+    cache.insert("c", {"b"}, ids, 3);
+    ASSERT_EQ(2, cache.size());
+    ASSERT_FALSE(cache.get("b", &cached_ids, cached_ids_len));
+
+    // the evicted entry no longer depends on the field
+    cache.invalidate("b");
+    ASSERT_EQ(1, cache.size());
+    ASSERT_TRUE(cache.get("a", &cached_ids, cached_ids_len));
+    delete [] cached_ids;
+}
+
+TEST(FilterCacheTest, IsBoundedByTheCompressedSizeOfTheIds) {
+    std::vector<uint32_t> narrow_ids = {1, 2, 3};
+
+    // a broad clause
+    std::vector<uint32_t> broad_ids;
+    for(uint32_t i = 0; i < 100000; i++) {
+        broad_ids.push_back(i * 7);
+    }
+
+    filter_cache_t cache(64 * 1024);
+
+    // ids that do not fit in the cache on their own are not cached
+    cache.insert("broad", {"points"}, broad_ids.data(), broad_ids.size());
+    ASSERT_EQ(0, cache.size());
+    ASSERT_EQ(0, cache.size_bytes());
+
+    for(size_t i = 0; i < 10000; i++) {
+        cache.insert(std::to_string(i), {"points"}, narrow_ids.data(), narrow_ids.size());
+        ASSERT_GE(64 * 1024, cache.size_bytes());
+    }
+
+    ASSERT_LT(1, cache.size());
+    ASSERT_GT(10000, cache.size());
+
+    cache.invalidate("points");
+    ASSERT_EQ(0, cache.size());
+    ASSERT_EQ(0, cache.size_bytes());
+
+    // a size of 0 disables the cache
+    filter_cache_t disabled_cache(0);
+    disabled_cache.insert("narrow", {"points"}, narrow_ids.data(), narrow_ids.size());
+    ASSERT_EQ(0, disabled_cache.size());
+}
+
+TEST(FilterCacheTest, KeysDependOnFieldComparatorsAndValues) {
+    filter a_filter{"points", {"10"}, {GREATER_THAN}};
+    filter b_filter{"points", {"10"}, {LESS_THAN}};
+    filter c_filter{"points", {"100"}, {GREATER_THAN}};
+
+    ASSERT_NE(filter_cache_t::get_key(a_filter), filter_cache_t::get_key(b_filter));
+    ASSERT_NE(filter_cache_t::get_key(a_filter), filter_cache_t::get_key(c_filter));
+    ASSERT_EQ(filter_cache_t::get_key(a_filter), filter_cache_t::get_key(filter{"points", {"10"}, {GREATER_THAN}}));
+
+    ASSERT_NE(filter_cache_t::get_key({a_filter, b_filter}), filter_cache_t::get_key({b_filter, a_filter}));
+}
@@ -0,0 +1,105 @@
+#include <gtest/gtest.h>
+#include "id_bitmap.h"
+#include <algorithm>
+#include <random>
+#include <vector>
+
+static void assert_same_ids(const id_bitmap_t& bitmap, const std::vector<uint32_t>& ids, uint32_t max_id) {
+    ASSERT_EQ(ids.size(), bitmap.size());
+
+    for(uint32_t id = 0; id <= max_id; id++) {
+        ASSERT_EQ(std::binary_search(ids.begin(), ids.end(), id), bitmap.contains(id));
+    }
+}
+
+TEST(IdBitmapTest, ContainersOfDifferentDensities) {
+    std::vector<uint32_t> ids;
+
+    // sparse partition
+    for(uint32_t id = 0; id < 65536; id += 100) {
+        ids.push_back(id);
+    }
+
+    // dense partition
+    std::mt19937 gen(42);
+    for(uint32_t id = 65536; id < 2 * 65536; id++) {
+        if(gen() % 2 == 0) {
+            ids.push_back(id);
+        }
+    }
+
+    // partition made of a few runs
+    for(uint32_t id = 2 * 65536 + 10; id < 2 * 65536 + 30000; id++) {
+        ids.push_back(id);
+    }
+
+    for(uint32_t id = 2 * 65536 + 40000; id < 3 * 65536; id++) {
+        ids.push_back(id);
+    }
+
+    // partitions without any ids are skipped
+    ids.push_back(5 * 65536 + 7);
+
+    id_bitmap_t bitmap;
+    bitmap.load(ids.data(), ids.size());
+
+    ASSERT_EQ(4, bitmap.num_containers());
+    assert_same_ids(bitmap, ids, 6 * 65536);
+
+    // runs are much smaller than the ids they hold
+    ASSERT_LT(bitmap.memory_bytes(), ids.size() * sizeof(uint32_t) / 2);
+}
+
+TEST(IdBitmapTest, Intersect) {
+    std::mt19937 gen(137723);
+    std::vector<uint32_t> filter_ids, result_ids;
+
+    for(uint32_t id = 0; id < 500000; id++) {
+        if(gen() % 3 == 0) {
+            filter_ids.push_back(id);
+        }
+
+        if(gen() % 50 == 0) {
+            result_ids.push_back(id);
+        }
+    }
+
+    id_bitmap_t bitmap;
+    bitmap.load(filter_ids.data(), filter_ids.size());
+
+    std::vector<uint32_t> expected;
+    std::set_intersection(filter_ids.begin(), filter_ids.end(), result_ids.begin(), result_ids.end(),
+                          std::back_inserter(expected));
+
+    std::vector<uint32_t> out(result_ids.size());
+    size_t out_len = bitmap.intersect(result_ids.data(), result_ids.size(), out.data());
+
+    ASSERT_EQ(expected.size(), out_len);
+    for(size_t i = 0; i < out_len; i++) {
+        ASSERT_EQ(expected[i], out[i]);
+    }
+
+    ASSERT_EQ(0, bitmap.intersect(nullptr, 0, out.data()));
+}
+
+TEST(IdBitmapTest, IsDense) {
+    std::vector<uint32_t> ids;
+
+    for(uint32_t id = 0; id < id_bitmap_t::MIN_BITMAP_IDS - 1; id++) {
+        ids.push_back(id);
+    }
+
+    // too few ids
+    ASSERT_FALSE(id_bitmap_t::is_dense(ids.data(), ids.size()));
+
+    ids.push_back(ids.size());
+    ASSERT_TRUE(id_bitmap_t::is_dense(ids.data(), ids.size()));
+
+    // too sparse
+    for(uint32_t& id: ids) {
+        id *= (id_bitmap_t::MAX_SPARSITY + 1);
+    }
+
+    ASSERT_FALSE(id_bitmap_t::is_dense(ids.data(), ids.size()));
+    ASSERT_FALSE(id_bitmap_t::is_dense(nullptr, 0));
+}
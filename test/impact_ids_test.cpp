@@ -0,0 +1,96 @@
+#include <gtest/gtest.h>
+#include "impact_ids.h"
+#include <algorithm>
+#include <random>
+#include <vector>
+
+static std::vector<uint32_t> get_ids(const impact_ids_t& impact_ids) {
+    std::vector<uint32_t> ids;
+    impact_ids.for_each([&](uint32_t id) {
+        ids.push_back(id);
+        return true;
+    });
+    return ids;
+}
+
+TEST(ImpactIdsTest, OrderedOnPointsThenIds) {
+    impact_ids_t impact_ids;
+
+    impact_ids.insert(10, 1);
+    impact_ids.insert(30, 2);
+    impact_ids.insert(10, 3);
+    impact_ids.insert(-5, 4);
+    impact_ids.insert(INT64_MIN, 5);
+    impact_ids.insert(30, 0);
+
+    ASSERT_EQ(6, impact_ids.size());
+    ASSERT_EQ(std::vector<uint32_t>({2, 0, 3, 1, 4, 5}), get_ids(impact_ids));
+
+    // iteration stops when asked to
+    std::vector<uint32_t> first_ids;
+    impact_ids.for_each([&](uint32_t id) {
+        first_ids.push_back(id);
+        return first_ids.size() < 3;
+    });
+
+    ASSERT_EQ(std::vector<uint32_t>({2, 0, 3}), first_ids);
+
+    impact_ids.remove(10, 3);
+    impact_ids.remove(30, 2);
+
+    // points that do not match the stored ones fall back to a scan
+    impact_ids.remove(0, 4);
+
+    // missing ids are ignored
+    impact_ids.remove(10, 100);
+
+    ASSERT_EQ(3, impact_ids.size());
+    ASSERT_EQ(std::vector<uint32_t>({0, 1, 5}), get_ids(impact_ids));
+}
+
+TEST(ImpactIdsTest, InsertAndRemoveAcrossBlocks) {
+    impact_ids_t impact_ids;
+    std::vector<std::pair<int64_t, uint32_t>> entries;
+
+    std::mt19937 gen(42);
+
+    for(uint32_t id = 0; id < 5000; id++) {
+        const int64_t points = gen() % 300;
+        impact_ids.insert(points, id);
+        entries.emplace_back(points, id);
+    }
+
+    // remove every third entry in a random order
+    std::vector<std::pair<int64_t, uint32_t>> removed;
+    std::shuffle(entries.begin(), entries.end(), gen);
+
+    for(size_t i = 0; i < entries.size(); i += 3) {
+        impact_ids.remove(entries[i].first, entries[i].second);
+        removed.push_back(entries[i]);
+    }
+
+    std::vector<std::pair<int64_t, uint32_t>> expected;
+    for(size_t i = 0; i < entries.size(); i++) {
+        if(i % 3 != 0) {
+            expected.push_back(entries[i]);
+        }
+    }
+
+    std::sort(expected.begin(), expected.end(), std::greater<std::pair<int64_t, uint32_t>>());
+
+    std::vector<uint32_t> expected_ids;
+    for(const auto& entry: expected) {
+        expected_ids.push_back(entry.second);
+    }
+
+    ASSERT_EQ(expected_ids.size(), impact_ids.size());
+    ASSERT_EQ(expected_ids, get_ids(impact_ids));
+    ASSERT_LT(0, impact_ids.memory_bytes());
+
+    for(const auto& entry: expected) {
+        impact_ids.remove(entry.first, entry.second);
+    }
+
+    ASSERT_EQ(0, impact_ids.size());
+    ASSERT_TRUE(get_ids(impact_ids).empty());
+}
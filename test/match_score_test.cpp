@@ -1,4 +1,7 @@
 #include <chrono>
+#include <random>
+#include <set>
+#include <unordered_map>
 #include <gtest/gtest.h>
 #include <match_score.h>
 
@@ -85,4 +88,94 @@ TEST(MatchTest, MatchScoreV2) {
             std::chrono::high_resolution_clock::now() - begin).count();
     LOG(INFO) << "Time taken: " << timeNanos;
     LOG(INFO) << total_distance << ", " << words_present << ", " << offset_sum;*/
-}
\ No newline at end of file
+}
+TEST(MatchTest, FlatPositionsMatchVectorPositions) {
+    std::mt19937 rng(42);
+
+    for(size_t iter = 0; iter < 2000; iter++) {
+        const size_t num_tokens = 2 + (rng() % 12);
+        std::vector<std::vector<uint16_t>> token_offsets(num_tokens);
+
+        for(auto& offsets: token_offsets) {
+            const size_t num_offsets = 1 + (rng() % 6);
+            std::set<uint16_t> unique_offsets;
+            while(unique_offsets.size() < num_offsets) {
+                unique_offsets.insert(rng() % 80);
+            }
+            offsets.assign(unique_offsets.begin(), unique_offsets.end());
+        }
+
+        std::vector<token_positions_t> token_positions;
+        for(const auto& offsets: token_offsets) {
+            token_positions.push_back({offsets.data(), offsets.size()});
+        }
+
+        const Match expected(100, token_offsets, false);
+        const Match actual(token_positions.data(), token_positions.size());
+
+        ASSERT_EQ(expected.words_present, actual.words_present);
+        ASSERT_EQ(expected.distance, actual.distance);
+        ASSERT_EQ(0, actual.offsets.size());
+    }
+}
+
+TEST(MatchTest, BenchmarkScoringThroughput) {
+    // positions of 3 query tokens in each of `num_docs` documents
+    const size_t num_docs = 100 * 1000;
+    const size_t num_tokens = 3;
+
+    std::mt19937 rng(42);
+    std::vector<uint16_t> all_positions;
+    std::vector<uint32_t> token_starts;
+
+    for(size_t i = 0; i < num_docs * num_tokens; i++) {
+        token_starts.push_back(all_positions.size());
+        uint16_t pos = rng() % 20;
+        for(size_t j = 0, num_positions = 1 + rng() % 4; j < num_positions; j++) {
+            all_positions.push_back(pos);
+            pos += 1 + rng() % 20;
+        }
+    }
+
+    token_starts.push_back(all_positions.size());
+
+    uint64_t vector_score_sum = 0;
+    auto begin = std::chrono::high_resolution_clock::now();
+
+    for(size_t doc = 0; doc < num_docs; doc++) {
+        std::unordered_map<size_t, std::vector<std::vector<uint16_t>>> array_token_positions;
+        for(size_t t = doc * num_tokens; t < (doc + 1) * num_tokens; t++) {
+            array_token_positions[0].emplace_back(all_positions.begin() + token_starts[t],
+                                                  all_positions.begin() + token_starts[t + 1]);
+        }
+
+        const Match match(doc, array_token_positions[0], false);
+        vector_score_sum += match.get_match_score(0);
+    }
+
+    const uint64_t vector_micros = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::high_resolution_clock::now() - begin).count();
+
+    uint64_t flat_score_sum = 0;
+    begin = std::chrono::high_resolution_clock::now();
+
+    for(size_t doc = 0; doc < num_docs; doc++) {
+        token_positions_t token_positions[num_tokens];
+        for(size_t t = 0; t < num_tokens; t++) {
+            const size_t token_index = doc * num_tokens + t;
+            token_positions[t] = {all_positions.data() + token_starts[token_index],
+                                  token_starts[token_index + 1] - token_starts[token_index]};
+        }
+
+        const Match match(token_positions, num_tokens);
+        flat_score_sum += match.get_match_score(0);
+    }
+
+    const uint64_t flat_micros = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::high_resolution_clock::now() - begin).count();
+
+    ASSERT_EQ(vector_score_sum, flat_score_sum);
+
+    LOG(INFO) << "Scored docs per second with position vectors: " << (num_docs * 1000000 / (vector_micros + 1))
+              << ", with flat positions: " << (num_docs * 1000000 / (flat_micros + 1));
+}
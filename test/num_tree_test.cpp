@@ -1,5 +1,9 @@
 #include <gtest/gtest.h>
 #include <art.h>
+#include <limits>
+#include <map>
+#include <random>
+#include <set>
 #include "num_tree.h"
 
 TEST(NumTreeTest, Searches) {
@@ -42,3 +46,114 @@ TEST(NumTreeTest, Searches) {
     delete [] ids;
     ids = nullptr;
 }
+
+TEST(NumTreeTest, SearchesAcrossPages) {
+    num_tree_t tree;
+    std::map<int64_t, std::set<uint32_t>> expected_map;
+    std::mt19937 gen(42);
+
+    // array fields: a document can hold several values
+    for(uint32_t id = 0; id < 2000; id++) {
+        for(size_t i = 0; i < 1 + (id % 3); i++) {
+            const int64_t value = int64_t(gen() % 1000) - 500;
+            tree.insert(value, id);
+            expected_map[value].insert(id);
+        }
+    }
+
+    // remove some of the values of some of the documents, emptying a few values
+    for(uint32_t id = 0; id < 2000; id += 7) {
+        for(auto& kv: expected_map) {
+            if(kv.second.count(id) != 0 && (kv.first % 2 == 0 || kv.first < -400)) {
+                tree.remove(kv.first, id);
+                kv.second.erase(id);
+            }
+        }
+    }
+
+    for(auto it = expected_map.begin(); it != expected_map.end(); ) {
+        it = it->second.empty() ? expected_map.erase(it) : std::next(it);
+    }
+
+    ASSERT_EQ(expected_map.size(), tree.size());
+    ASSERT_LT(1, tree.num_pages());
+
+    auto expected_range = [&](int64_t start, int64_t end) {
+        std::set<uint32_t> ids;
+        for(auto it = expected_map.lower_bound(start); it != expected_map.end() && it->first <= end; it++) {
+            ids.insert(it->second.begin(), it->second.end());
+        }
+        return std::vector<uint32_t>(ids.begin(), ids.end());
+    };
+
+    auto assert_ids = [](const std::vector<uint32_t>& expected, uint32_t* ids, size_t ids_len) {
+        ASSERT_EQ(expected.size(), ids_len);
+        for(size_t i = 0; i < ids_len; i++) {
+            ASSERT_EQ(expected[i], ids[i]);
+        }
+    };
+
+    const std::vector<std::pair<int64_t, int64_t>> ranges = {{-600, 600}, {-10, 10}, {-500, -500}, {100, 350},
+                                                             {499, 700}, {-1000, -501}, {20, 10}};
+
+    for(const auto& range: ranges) {
+        uint32_t* ids = nullptr;
+        size_t ids_len = 0;
+        tree.range_inclusive_search(range.first, range.second, &ids, ids_len);
+        assert_ids(expected_range(range.first, range.second), ids, ids_len);
+        delete [] ids;
+    }
+
+    for(int64_t value: {-500, -401, -3, 0, 123, 499}) {
+        uint32_t* ids = nullptr;
+        size_t ids_len = 0;
+
+        tree.search(NUM_COMPARATOR::EQUALS, value, &ids, ids_len);
+        assert_ids(expected_range(value, value), ids, ids_len);
+        delete [] ids;
+        ids = nullptr;
+        ids_len = 0;
+
+        tree.search(NUM_COMPARATOR::GREATER_THAN, value, &ids, ids_len);
+        assert_ids(expected_range(value + 1, INT64_MAX), ids, ids_len);
+        delete [] ids;
+        ids = nullptr;
+        ids_len = 0;
+
+        tree.search(NUM_COMPARATOR::LESS_THAN_EQUALS, value, &ids, ids_len);
+        assert_ids(expected_range(INT64_MIN, value), ids, ids_len);
+        delete [] ids;
+
+        std::vector<uint32_t> value_ids;
+        tree.get(value, value_ids);
+        assert_ids(expected_range(value, value), value_ids.data(), value_ids.size());
+    }
+}
+
+TEST(NumTreeTest, EstimatesAreAnUpperBoundOfTheSearchResults) {
+    num_tree_t tree;
+
+    for(uint32_t id = 0; id < 1000; id++) {
+        tree.insert(id % 200, id);
+    }
+
+    ASSERT_LT(1, tree.num_pages());
+
+    // every value holds 5 ids
+    ASSERT_EQ(5, tree.estimate_range(10, 10));
+    ASSERT_EQ(0, tree.estimate_range(500, 500));
+    ASSERT_EQ(50, tree.estimate_range(std::numeric_limits<int64_t>::min(), 9));
+    ASSERT_EQ(945, tree.estimate_range(11, std::numeric_limits<int64_t>::max()));
+    ASSERT_EQ(1000, tree.estimate_range(-10, std::numeric_limits<int64_t>::max()));
+    ASSERT_EQ(505, tree.estimate_range(50, 150));
+    ASSERT_EQ(0, tree.estimate_range(150, 50));
+
+    // a document with several values of a page is counted once
+    num_tree_t array_tree;
+    array_tree.insert(1, 0);
+    array_tree.insert(2, 0);
+    array_tree.insert(2, 1);
+
+    ASSERT_EQ(2, array_tree.estimate_range(1, 2));
+    ASSERT_EQ(2, array_tree.estimate_range(2, 2));
+}
@@ -0,0 +1,156 @@
+#include <gtest/gtest.h>
+#include "request_scheduler.h"
+#include <atomic>
+#include <future>
+#include <thread>
+
+class RequestSchedulerTest : public ::testing::Test {
+protected:
+    ThreadPool* thread_pool;
+    RequestScheduler* scheduler;
+
+    virtual void SetUp() {
+        thread_pool = new ThreadPool(4);
+        scheduler = new RequestScheduler(thread_pool, {
+            schedule_limits_t{2, 2},
+            schedule_limits_t{1, 1},
+            schedule_limits_t{1, 0},
+        });
+    }
+
+    virtual void TearDown() {
+        thread_pool->shutdown();
+        delete scheduler;
+        delete thread_pool;
+    }
+
+    void wait_until_idle(schedule_class_t schedule_class) {
+        while(scheduler->get_num_running(schedule_class) != 0 || scheduler->get_queue_depth(schedule_class) != 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+};
+
+TEST_F(RequestSchedulerTest, QueuesBeyondConcurrencyAndRejectsBeyondQueueDepth) {
+    std::promise<void> release;
+    std::shared_future<void> released = release.get_future().share();
+    std::atomic<size_t> num_done(0);
+
+    auto blocking_task = [released, &num_done]() {
+        released.wait();
+        num_done++;
+    };
+
+    ASSERT_TRUE(scheduler->submit(INTERACTIVE, blocking_task));
+    ASSERT_TRUE(scheduler->submit(INTERACTIVE, blocking_task));
+    ASSERT_EQ(2, scheduler->get_num_running(INTERACTIVE));
+    ASSERT_EQ(0, scheduler->get_queue_depth(INTERACTIVE));
+
+    ASSERT_TRUE(scheduler->submit(INTERACTIVE, blocking_task));
+    ASSERT_TRUE(scheduler->submit(INTERACTIVE, blocking_task));
+    ASSERT_EQ(2, scheduler->get_queue_depth(INTERACTIVE));
+
+    // saturated
+    ASSERT_FALSE(scheduler->submit(INTERACTIVE, blocking_task));
+
+    // other classes are not affected
+    std::promise<void> background_done;
+    ASSERT_TRUE(scheduler->submit(BACKGROUND, [&background_done]() { background_done.set_value(); }));
+    background_done.get_future().get();
+    wait_until_idle(BACKGROUND);
+
+    release.set_value();
+    wait_until_idle(INTERACTIVE);
+    ASSERT_EQ(4, num_done.load());
+
+    nlohmann::json metrics;
+    scheduler->get_metrics(metrics);
+    ASSERT_EQ("0", metrics["typesense_scheduler_interactive_queue_depth"].get<std::string>());
+    ASSERT_EQ("0", metrics["typesense_scheduler_interactive_running"].get<std::string>());
+    ASSERT_EQ("1", metrics["typesense_scheduler_interactive_rejected"].get<std::string>());
+    ASSERT_EQ("0", metrics["typesense_scheduler_background_rejected"].get<std::string>());
+    ASSERT_EQ(1, metrics.count("typesense_scheduler_bulk_write_avg_wait_ms"));
+}
+
+TEST_F(RequestSchedulerTest, QueuedTasksRunInOrder) {
+    std::promise<void> release;
+    std::shared_future<void> released = release.get_future().share();
+
+    std::mutex order_mutex;
+    std::vector<size_t> order;
+
+    ASSERT_TRUE(scheduler->submit(BULK_WRITE, [released]() { released.wait(); }));
+    ASSERT_TRUE(scheduler->submit(BULK_WRITE, [&order_mutex, &order]() {
+        std::unique_lock lock(order_mutex);
+        order.push_back(1);
+    }));
+    ASSERT_FALSE(scheduler->submit(BULK_WRITE, []() {}));
+
+    release.set_value();
+    wait_until_idle(BULK_WRITE);
+
+    ASSERT_EQ(std::vector<size_t>({1}), order);
+
+    // background class has no queue at all
+    std::promise<void> background_release;
+    std::shared_future<void> background_released = background_release.get_future().share();
+    ASSERT_TRUE(scheduler->submit(BACKGROUND, [background_released]() { background_released.wait(); }));
+    ASSERT_FALSE(scheduler->submit(BACKGROUND, []() {}));
+    background_release.set_value();
+    wait_until_idle(BACKGROUND);
+}
+
+TEST_F(RequestSchedulerTest, SlotsCountAgainstTheLimitsUntilReleased) {
+    // concurrency of 1 and queue depth of 1
+    auto slot1 = scheduler->acquire(BULK_WRITE);
+    auto slot2 = scheduler->acquire(BULK_WRITE);
+    ASSERT_NE(nullptr, slot1);
+    ASSERT_NE(nullptr, slot2);
+    ASSERT_EQ(nullptr, scheduler->acquire(BULK_WRITE));
+    ASSERT_EQ(2, scheduler->get_num_running(BULK_WRITE));
+
+    slot1.reset();
+    ASSERT_EQ(1, scheduler->get_num_running(BULK_WRITE));
+
+    auto slot3 = scheduler->acquire(BULK_WRITE);
+    ASSERT_NE(nullptr, slot3);
+
+    slot2.reset();
+    slot3.reset();
+    ASSERT_EQ(0, scheduler->get_num_running(BULK_WRITE));
+}
+
+TEST_F(RequestSchedulerTest, TasksCanKeepTheirSlotAfterReturning) {
+    // like an export, which returns after its first chunk and streams the rest of the response later
+    std::promise<std::unique_ptr<schedule_slot_t>> kept;
+    ASSERT_TRUE(scheduler->submit_with_slot(BACKGROUND, [&kept](std::unique_ptr<schedule_slot_t>& slot) {
+        kept.set_value(std::move(slot));
+    }));
+
+    std::unique_ptr<schedule_slot_t> slot = kept.get_future().get();
+    ASSERT_NE(nullptr, slot);
+    ASSERT_EQ(1, scheduler->get_num_running(BACKGROUND));
+
+    // concurrency of 1 and no queue
+    ASSERT_FALSE(scheduler->submit(BACKGROUND, []() {}));
+
+    slot.reset();
+    ASSERT_EQ(0, scheduler->get_num_running(BACKGROUND));
+
+    std::promise<void> background_done;
+    ASSERT_TRUE(scheduler->submit(BACKGROUND, [&background_done]() { background_done.set_value(); }));
+    background_done.get_future().get();
+    wait_until_idle(BACKGROUND);
+}
+
+TEST_F(RequestSchedulerTest, ClassifiesRequests) {
+    ASSERT_EQ(INTERACTIVE, RequestScheduler::get_schedule_class({"collections", ":collection", "documents", "search"},
+                                                                false));
+    ASSERT_EQ(INTERACTIVE, RequestScheduler::get_schedule_class({"multi_search"}, false));
+    ASSERT_EQ(BULK_WRITE, RequestScheduler::get_schedule_class({"collections", ":collection", "documents", "import"},
+                                                               true));
+    ASSERT_EQ(BULK_WRITE, RequestScheduler::get_schedule_class({"collections", ":collection", "documents"}, true));
+    ASSERT_EQ(BACKGROUND, RequestScheduler::get_schedule_class({"collections", ":collection", "documents", "export"},
+                                                               false));
+    ASSERT_EQ(BACKGROUND, RequestScheduler::get_schedule_class({"operations", "snapshot"}, false));
+}
@@ -0,0 +1,102 @@
+#include <gtest/gtest.h>
+#include "rw_mutex.h"
+#include <atomic>
+#include <chrono>
+#include <shared_mutex>
+#include <thread>
+#include <vector>
+
+TEST(RwMutexTest, WritersExcludeReadersAndWriters) {
+    rw_mutex_t mutex;
+    size_t value = 0;
+    std::atomic<bool> torn(false);
+
+    std::vector<std::thread> threads;
+
+    for(size_t t = 0; t < 4; t++) {
+        threads.emplace_back([&]() {
+            for(size_t i = 0; i < 10000; i++) {
+                std::unique_lock lock(mutex);
+                value++;
+                value++;
+            }
+        });
+
+        threads.emplace_back([&]() {
+            for(size_t i = 0; i < 10000; i++) {
+                std::shared_lock lock(mutex);
+                if(value % 2 != 0) {
+                    torn = true;
+                }
+            }
+        });
+    }
+
+    for(auto& thread: threads) {
+        thread.join();
+    }
+
+    ASSERT_FALSE(torn.load());
+    ASSERT_EQ(4 * 10000 * 2, value);
+}
+
+TEST(RwMutexTest, OverlappingReadersDoNotStarveAWriter) {
+    rw_mutex_t mutex;
+    std::atomic<bool> written(false);
+    std::atomic<size_t> num_reads_after_write(0);
+
+    // every reader takes the lock again right after releasing it, so the readers always overlap each other
+    std::vector<std::thread> readers;
+
+    for(size_t t = 0; t < 4; t++) {
+        readers.emplace_back([&]() {
+            while(num_reads_after_write < 100) {
+                std::shared_lock lock(mutex);
+                std::this_thread::sleep_for(std::chrono::microseconds(200));
+
+                if(written) {
+                    num_reads_after_write++;
+                }
+            }
+        });
+    }
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+    for(size_t i = 0; i < 100; i++) {
+        std::unique_lock lock(mutex);
+        written = true;
+    }
+
+    for(auto& reader: readers) {
+        reader.join();
+    }
+
+    ASSERT_TRUE(written.load());
+}
+
+TEST(RwMutexTest, WritersTakingTurnsDoNotStarveReaders) {
+    rw_mutex_t mutex;
+    std::atomic<bool> stop(false);
+
+    std::vector<std::thread> writers;
+
+    for(size_t t = 0; t < 2; t++) {
+        writers.emplace_back([&]() {
+            while(!stop) {
+                std::unique_lock lock(mutex);
+                std::this_thread::sleep_for(std::chrono::microseconds(200));
+            }
+        });
+    }
+
+    for(size_t i = 0; i < 100; i++) {
+        std::shared_lock lock(mutex);
+    }
+
+    stop = true;
+
+    for(auto& writer: writers) {
+        writer.join();
+    }
+}
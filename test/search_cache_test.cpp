@@ -0,0 +1,113 @@
+#include <gtest/gtest.h>
+#include "search_cache.h"
+#include <thread>
+
+TEST(SearchCacheTest, EvictsLeastRecentlyUsed) {
+    SearchCache cache;
+    cache.set_limits(1024 * 1024, 60 * 1000);
+
+    cache.insert("a", 1, "A");
+    const size_t entry_num_bytes = cache.size_bytes();
+    ASSERT_LT(0, entry_num_bytes);
+
+    // room for two entries of the same size
+    cache.set_limits(entry_num_bytes * 2, 60 * 1000);
+    cache.insert("b", 1, "B");
+    ASSERT_EQ(entry_num_bytes * 2, cache.size_bytes());
+
+    nlohmann::json value;
+    ASSERT_TRUE(cache.get("a", 1, value));
+    ASSERT_EQ("A", value);
+
+    // "b" is now the least recently used entry
+    cache.insert("c", 1, "C");
+    ASSERT_EQ(2, cache.size());
+    ASSERT_FALSE(cache.get("b", 1, value));
+    ASSERT_TRUE(cache.get("a", 1, value));
+    ASSERT_TRUE(cache.get("c", 1, value));
+    ASSERT_EQ("C", value);
+
+    nlohmann::json metrics;
+    cache.get_metrics(metrics);
+    ASSERT_EQ("3", metrics["typesense_search_cache_hits"].get<std::string>());
+    ASSERT_EQ("1", metrics["typesense_search_cache_misses"].get<std::string>());
+    ASSERT_EQ("2", metrics["typesense_search_cache_entries"].get<std::string>());
+    ASSERT_EQ(std::to_string(entry_num_bytes * 2), metrics["typesense_search_cache_bytes"].get<std::string>());
+
+    // shrinking drops the least recently used entries
+    cache.set_limits(entry_num_bytes, 60 * 1000);
+    ASSERT_EQ(1, cache.size());
+    ASSERT_TRUE(cache.get("c", 1, value));
+
+    cache.set_limits(0, 60 * 1000);
+    ASSERT_FALSE(cache.is_enabled());
+    cache.insert("d", 1, "D");
+    ASSERT_EQ(0, cache.size());
+    ASSERT_EQ(0, cache.size_bytes());
+}
+
+TEST(SearchCacheTest, IsBoundedByTheMemoryOfTheResults) {
+    SearchCache cache;
+    ASSERT_FALSE(cache.is_enabled());
+
+    nlohmann::json small_result;
+    small_result["hits"] = nlohmann::json::array();
+    small_result["found"] = 0;
+
+    nlohmann::json large_result;
+    large_result["hits"] = nlohmann::json::array();
+    for(size_t i = 0; i < 100; i++) {
+        large_result["hits"].push_back({{"document", {{"title", std::string(100, 'a')}}}});
+    }
+
+    // the values nested in the result are counted
+    ASSERT_LT(100 * 100, SearchCache::get_num_bytes(large_result));
+    ASSERT_LT(SearchCache::get_num_bytes(small_result) * 10, SearchCache::get_num_bytes(large_result));
+
+    cache.set_limits(SearchCache::get_num_bytes(large_result), 60 * 1000);
+
+    // a result that does not fit in the cache on its own is not cached
+    cache.insert("large", 1, large_result);
+    ASSERT_EQ(0, cache.size());
+
+    for(size_t i = 0; i < 1000; i++) {
+        cache.insert(std::to_string(i), 1, small_result);
+        ASSERT_GE(SearchCache::get_num_bytes(large_result), cache.size_bytes());
+    }
+
+    ASSERT_LT(1, cache.size());
+    ASSERT_GT(1000, cache.size());
+
+    // replacing an entry releases the memory of the old value
+    const size_t num_bytes = cache.size_bytes();
+    cache.insert("999", 2, small_result);
+    ASSERT_EQ(num_bytes, cache.size_bytes());
+
+    cache.clear();
+    ASSERT_EQ(0, cache.size_bytes());
+}
+
+TEST(SearchCacheTest, StaleEntriesAreNotServed) {
+    SearchCache cache;
+    cache.set_limits(1024 * 1024, 60 * 1000);
+
+    nlohmann::json value;
+    cache.insert("a", 1, "A");
+    ASSERT_FALSE(cache.get("a", 2, value));
+
+    // and are dropped
+    ASSERT_EQ(0, cache.size());
+
+    cache.set_limits(1024 * 1024, 5);
+    cache.insert("a", 2, "A");
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    ASSERT_FALSE(cache.get("a", 2, value));
+}
+
+TEST(SearchCacheTest, KeysAreUnambiguous) {
+    ASSERT_EQ(SearchCache::get_key(1, {{"q", "a"}, {"page", "1"}}),
+              SearchCache::get_key(1, {{"page", "1"}, {"q", "a"}}));
+
+    ASSERT_NE(SearchCache::get_key(1, {{"q", "a"}}), SearchCache::get_key(2, {{"q", "a"}}));
+    ASSERT_NE(SearchCache::get_key(1, {{"q", "a:1:b"}}), SearchCache::get_key(1, {{"q", "a"}, {"b", ""}}));
+}
@@ -0,0 +1,56 @@
+#include <gtest/gtest.h>
+#include "sort_column.h"
+
+TEST(SortColumnTest, SetGetErase) {
+    sort_column_t column;
+
+    ASSERT_EQ(0, column.size());
+    ASSERT_FALSE(column.contains(0));
+    ASSERT_EQ(INT64_MIN, column.get(1000, INT64_MIN));
+
+    column.set(0, -10);
+    column.set(63, 20);
+    column.set(64, 30);
+    column.set(10000, INT64_MAX);
+
+    ASSERT_EQ(4, column.size());
+    ASSERT_EQ(-10, column.get(0, 0));
+    ASSERT_EQ(20, column.get(63, 0));
+    ASSERT_EQ(30, column.get(64, 0));
+    ASSERT_EQ(INT64_MAX, column.get(10000, 0));
+    ASSERT_FALSE(column.contains(1));
+    ASSERT_FALSE(column.contains(9999));
+    ASSERT_EQ(-1, column.get(9999, -1));
+
+    // overwriting a value does not change the count
+    column.set(63, 21);
+    ASSERT_EQ(4, column.size());
+    ASSERT_EQ(21, column.get(63, 0));
+
+    column.erase(63);
+    column.erase(63);
+    column.erase(50000);
+
+    ASSERT_EQ(3, column.size());
+    ASSERT_FALSE(column.contains(63));
+    ASSERT_EQ(INT64_MIN, column.get(63, INT64_MIN));
+    ASSERT_EQ(30, column.get(64, 0));
+}
+
+TEST(SortColumnTest, Stride) {
+    // an index of a collection with 4 shards only holds seq_ids with the same remainder
+    sort_column_t column(4);
+
+    for(uint32_t seq_id = 3; seq_id < 4000; seq_id += 4) {
+        column.set(seq_id, seq_id * 2);
+    }
+
+    ASSERT_EQ(1000, column.size());
+
+    for(uint32_t seq_id = 3; seq_id < 4000; seq_id += 4) {
+        ASSERT_TRUE(column.contains(seq_id));
+        ASSERT_EQ(seq_id * 2, column.get(seq_id, 0));
+    }
+
+    ASSERT_FALSE(column.contains(4003));
+}
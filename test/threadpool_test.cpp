@@ -0,0 +1,214 @@
+#include <gtest/gtest.h>
+#include "threadpool.h"
+#include <atomic>
+#include <mutex>
+#include <set>
+#include <string>
+#include <vector>
+
+TEST(ThreadPoolTest, EnqueueReturnsResults) {
+    ThreadPool pool(4);
+
+    std::vector<std::future<size_t>> futures;
+    for(size_t i = 0; i < 1000; i++) {
+        futures.push_back(pool.enqueue([](size_t a, size_t b) { return a * b; }, i, 2));
+    }
+
+    for(size_t i = 0; i < futures.size(); i++) {
+        ASSERT_EQ(i * 2, futures[i].get());
+    }
+
+    pool.shutdown();
+}
+
+TEST(ThreadPoolTest, NestedForkJoinDoesNotTieUpWorkers) {
+    // with blocking waits, every worker would wait on children that no worker is left to run
+    ThreadPool pool(2);
+    std::atomic<size_t> num_leaves(0);
+
+    std::vector<std::future<void>> parents;
+    for(size_t i = 0; i < 8; i++) {
+        parents.push_back(pool.enqueue([&pool, &num_leaves]() {
+            std::vector<std::future<void>> children;
+            for(size_t j = 0; j < 16; j++) {
+                children.push_back(pool.enqueue([&num_leaves]() {
+                    num_leaves++;
+                }));
+            }
+
+            for(auto& child: children) {
+                pool.wait(child);
+            }
+        }));
+    }
+
+    for(auto& parent: parents) {
+        pool.wait(parent);
+    }
+
+    ASSERT_EQ(8 * 16, num_leaves.load());
+    pool.shutdown();
+}
+
+TEST(ThreadPoolTest, WaitOnlyRunsTheTasksOfTheWaitingThread) {
+    ThreadPool pool(1);
+
+    std::mutex order_mutex;
+    std::vector<std::string> order;
+
+    std::promise<void> unrelated_queued;
+    std::shared_future<void> queued = unrelated_queued.get_future().share();
+
+    auto parent = pool.enqueue([&pool, &order_mutex, &order, queued]() {
+        queued.wait();
+
+        auto child = pool.enqueue([&order_mutex, &order]() {
+            std::unique_lock lock(order_mutex);
+            order.push_back("child");
+        });
+
+        // the unrelated task is ahead of the child on the deque of the only worker, but must not be run here
+        pool.wait(child);
+
+        std::unique_lock lock(order_mutex);
+        order.push_back("parent");
+    });
+
+    auto unrelated = pool.enqueue([&order_mutex, &order]() {
+        std::unique_lock lock(order_mutex);
+        order.push_back("unrelated");
+    });
+
+    unrelated_queued.set_value();
+    parent.get();
+    unrelated.get();
+
+    ASSERT_EQ(std::vector<std::string>({"child", "parent", "unrelated"}), order);
+    pool.shutdown();
+}
+
+TEST(ThreadPoolTest, WaitBlocksOnTasksThatAWorkerRuns) {
+    ThreadPool pool(1);
+
+    std::promise<void> started;
+    std::promise<void> release;
+    std::shared_future<void> released = release.get_future().share();
+
+    auto task = pool.enqueue([&started, released]() {
+        started.set_value();
+        released.wait();
+        return 42;
+    });
+
+    // the task is claimed by the worker, so the waiter has nothing of its own left to run
+    started.get_future().get();
+
+    std::thread releaser([&release]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        release.set_value();
+    });
+
+    pool.wait(task);
+    ASSERT_EQ(42, task.get());
+
+    releaser.join();
+    pool.shutdown();
+}
+
+TEST(ThreadPoolTest, HighPriorityTasksRunFirst) {
+    ThreadPool pool(1);
+
+    // keeps the only worker busy while the other tasks are enqueued
+    std::promise<void> release;
+    std::shared_future<void> released = release.get_future().share();
+    auto blocker = pool.enqueue([released]() { released.wait(); });
+
+    std::mutex order_mutex;
+    std::vector<std::string> order;
+    std::vector<std::future<void>> futures;
+
+    for(size_t i = 0; i < 3; i++) {
+        futures.push_back(pool.enqueue([&order_mutex, &order, i]() {
+            std::unique_lock lock(order_mutex);
+            order.push_back("normal" + std::to_string(i));
+        }));
+    }
+
+    for(size_t i = 0; i < 2; i++) {
+        futures.push_back(pool.enqueue_with_priority(ThreadPool::HIGH, [&order_mutex, &order, i]() {
+            std::unique_lock lock(order_mutex);
+            order.push_back("high" + std::to_string(i));
+        }));
+    }
+
+    release.set_value();
+    blocker.get();
+
+    for(auto& future: futures) {
+        future.get();
+    }
+
+    ASSERT_EQ(std::vector<std::string>({"high0", "high1", "normal0", "normal1", "normal2"}), order);
+    pool.shutdown();
+}
+
+TEST(ThreadPoolTest, IdleWorkersStealTasks) {
+    ThreadPool pool(4);
+
+    std::mutex ids_mutex;
+    std::set<std::thread::id> thread_ids;
+
+    // all the children are enqueued on the deque of the worker that runs the parent
+    auto parent = pool.enqueue([&]() {
+        std::vector<std::future<void>> children;
+        for(size_t i = 0; i < 64; i++) {
+            children.push_back(pool.enqueue([&]() {
+                std::this_thread::sleep_for(std::chrono::milliseconds(2));
+                std::unique_lock lock(ids_mutex);
+                thread_ids.insert(std::this_thread::get_id());
+            }));
+        }
+
+        for(auto& child: children) {
+            child.get();
+        }
+    });
+
+    parent.get();
+
+    ASSERT_LT(1, thread_ids.size());
+    pool.shutdown();
+}
+
+TEST(ThreadPoolTest, ShutdownRunsPendingTasks) {
+    ThreadPool pool(2);
+
+    std::promise<void> release;
+    std::shared_future<void> released = release.get_future().share();
+    std::atomic<size_t> num_run(0);
+
+    std::vector<std::future<void>> futures;
+    for(size_t i = 0; i < 2; i++) {
+        futures.push_back(pool.enqueue([released, &num_run]() {
+            released.wait();
+            num_run++;
+        }));
+    }
+
+    for(size_t i = 0; i < 100; i++) {
+        futures.push_back(pool.enqueue([&num_run]() { num_run++; }));
+    }
+
+    std::thread releaser([&release]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        release.set_value();
+    });
+
+    pool.shutdown();
+    releaser.join();
+
+    ASSERT_EQ(102, num_run.load());
+    for(auto& future: futures) {
+        future.get();  // throws on a broken promise
+    }
+}
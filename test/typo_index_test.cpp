@@ -0,0 +1,159 @@
+#include <gtest/gtest.h>
+#include <string>
+#include <art.h>
+#include "typo_index.h"
+
+static art_leaf* insert_token(art_tree* t, const std::string& token, uint32_t id) {
+    art_document doc;
+    uint32_t offsets[1] = {0};
+    doc.id = id;
+    doc.score = id;
+    doc.offsets_len = 1;
+    doc.offsets = offsets;
+
+    art_insert(t, (const unsigned char *) token.c_str(), token.size() + 1, &doc, 1);
+    return (art_leaf *) art_search(t, (const unsigned char *) token.c_str(), token.size() + 1);
+}
+
+static std::vector<std::string> leaf_keys(const std::vector<art_leaf*>& leaves) {
+    std::vector<std::string> keys;
+    for(const art_leaf* leaf: leaves) {
+        keys.emplace_back((const char*) leaf->key);
+    }
+
+    std::sort(keys.begin(), keys.end());
+    return keys;
+}
+
+TEST(TypoIndexTest, FindsTokensWithinCost) {
+    art_tree t;
+    art_tree_init(&t);
+    typo_index_t typo_index;
+
+    std::vector<std::string> tokens = {"the", "then", "they", "them", "theme", "other", "hello", "help", "thme",
+                                       "apple", "maple", "ample", "applesauce"};
+
+    for(size_t i = 0; i < tokens.size(); i++) {
+        typo_index.insert(insert_token(&t, tokens[i], i));
+    }
+
+    std::vector<art_leaf*> leaves;
+
+    ASSERT_TRUE(typo_index.search((const unsigned char *) "them", 4, 1, 1, 100, FREQUENCY, nullptr, 0, leaves));
+    ASSERT_EQ(std::vector<std::string>({"the", "theme", "then", "they", "thme"}), leaf_keys(leaves));
+
+    // transpositions count as a single edit, as they do in art_fuzzy_search()
+    leaves.clear();
+    ASSERT_TRUE(typo_index.search((const unsigned char *) "aplpe", 5, 1, 1, 100, FREQUENCY, nullptr, 0, leaves));
+    ASSERT_EQ(std::vector<std::string>({"apple"}), leaf_keys(leaves));
+
+    leaves.clear();
+    ASSERT_TRUE(typo_index.search((const unsigned char *) "thm", 3, 2, 2, 100, FREQUENCY, nullptr, 0, leaves));
+    ASSERT_EQ(std::vector<std::string>({"theme", "then", "they"}), leaf_keys(leaves));
+
+    // results must agree with a fuzzy search on the tree
+    for(const std::string term: {"them", "thm", "aplpe", "aple", "hepl", "oter"}) {
+        for(int cost = 1; cost <= 2; cost++) {
+            std::vector<art_leaf*> index_leaves, tree_leaves;
+            ASSERT_TRUE(typo_index.search((const unsigned char *) term.c_str(), term.size(), cost, cost, 100,
+                                          FREQUENCY, nullptr, 0, index_leaves));
+            art_fuzzy_search(&t, (const unsigned char *) term.c_str(), term.size() + 1, cost, cost, 100,
+                             FREQUENCY, false, nullptr, 0, tree_leaves);
+            ASSERT_EQ(leaf_keys(tree_leaves), leaf_keys(index_leaves)) << term << ", cost: " << cost;
+        }
+    }
+
+    // lookups that can reach tokens which are too long to be indexed are refused
+    leaves.clear();
+    ASSERT_FALSE(typo_index.search((const unsigned char *) "applesauc", 9, 2, 2, 100, FREQUENCY, nullptr, 0, leaves));
+    ASSERT_FALSE(typo_index.can_search(4, 3));
+
+    art_tree_destroy(&t);
+}
+
+TEST(TypoIndexTest, ReturnsTheSameLeavesInTheSameOrderAsTheTree) {
+    art_tree t;
+    art_tree_init(&t);
+    typo_index_t typo_index;
+
+    // "then" and "they" tie on their number of documents, as do "the" and "thme"
+    std::vector<std::pair<std::string, size_t>> token_docs = {{"then", 3}, {"they", 3}, {"the", 1}, {"thme", 1},
+                                                              {"theme", 2}, {"them", 5}};
+    uint32_t id = 0;
+
+    for(const auto& token_doc: token_docs) {
+        art_leaf* leaf = nullptr;
+        for(size_t i = 0; i < token_doc.second; i++) {
+            leaf = insert_token(&t, token_doc.first, id++);
+        }
+
+        typo_index.insert(leaf);
+    }
+
+    auto ordered_keys = [](const std::vector<art_leaf*>& leaves) {
+        std::vector<std::string> keys;
+        for(const art_leaf* leaf: leaves) {
+            keys.emplace_back((const char*) leaf->key);
+        }
+        return keys;
+    };
+
+    for(token_ordering token_order: {FREQUENCY, MAX_SCORE}) {
+        for(size_t max_words: {2, 100}) {
+            std::vector<art_leaf*> index_leaves, tree_leaves, dfa_leaves;
+            ASSERT_TRUE(typo_index.search((const unsigned char *) "them", 4, 1, 1, max_words, token_order, nullptr, 0,
+                                          index_leaves));
+            art_fuzzy_search(&t, (const unsigned char *) "them", 5, 1, 1, max_words, token_order, false,
+                             nullptr, 0, tree_leaves);
+            art_fuzzy_search(&t, (const unsigned char *) "them", 5, 1, 1, max_words, token_order, false,
+                             nullptr, 0, dfa_leaves, LEVENSHTEIN_AUTOMATON);
+
+            ASSERT_EQ(std::min<size_t>(5, max_words), index_leaves.size());
+            ASSERT_EQ(ordered_keys(tree_leaves), ordered_keys(index_leaves));
+            ASSERT_EQ(ordered_keys(tree_leaves), ordered_keys(dfa_leaves));
+        }
+    }
+
+    // ties on the number of documents are broken on the key
+    std::vector<art_leaf*> leaves;
+    ASSERT_TRUE(typo_index.search((const unsigned char *) "them", 4, 1, 1, 100, FREQUENCY, nullptr, 0, leaves));
+    ASSERT_EQ(std::vector<std::string>({"then", "they", "theme", "the", "thme"}), ordered_keys(leaves));
+
+    // max_words keeps the matches that come first in the tree, which are the last ones by key
+    leaves.clear();
+    ASSERT_TRUE(typo_index.search((const unsigned char *) "them", 4, 1, 1, 2, FREQUENCY, nullptr, 0, leaves));
+    ASSERT_EQ(std::vector<std::string>({"they", "thme"}), ordered_keys(leaves));
+
+    art_tree_destroy(&t);
+}
+
+TEST(TypoIndexTest, FilterAndRemove) {
+    art_tree t;
+    art_tree_init(&t);
+    typo_index_t typo_index;
+
+    art_leaf* then_leaf = insert_token(&t, "then", 10);
+    typo_index.insert(then_leaf);
+    typo_index.insert(insert_token(&t, "they", 20));
+
+    const size_t num_variants = typo_index.size();
+    ASSERT_LT(0, typo_index.memory_bytes());
+
+    std::vector<art_leaf*> leaves;
+    uint32_t filter_ids[1] = {20};
+    ASSERT_TRUE(typo_index.search((const unsigned char *) "them", 4, 1, 1, 100, FREQUENCY, filter_ids, 1, leaves));
+    ASSERT_EQ(std::vector<std::string>({"they"}), leaf_keys(leaves));
+
+    typo_index.remove(then_leaf);
+    ASSERT_GT(num_variants, typo_index.size());
+
+    leaves.clear();
+    ASSERT_TRUE(typo_index.search((const unsigned char *) "them", 4, 1, 1, 100, FREQUENCY, nullptr, 0, leaves));
+    ASSERT_EQ(std::vector<std::string>({"they"}), leaf_keys(leaves));
+
+    typo_index.remove(leaves[0]);
+    ASSERT_EQ(0, typo_index.size());
+    ASSERT_EQ(0, typo_index.memory_bytes());
+
+    art_tree_destroy(&t);
+}